@@ -184,6 +184,35 @@ public:
         return reinterpret_cast<Traits::data_ptr_t*>(&m_data);
     }
 
+    // Changes the number of elements, keeping the existing ones.  The memory
+    // is reallocated in place where possible, so an array can be grown
+    // geometrically while it is filled in and then handed out with Detach
+    // without copying it into a new array.
+    void Resize(size_t newSize)
+    {
+        assert(newSize <= UINT_MAX);
+        auto size = static_cast<uint32_t>(newSize);
+
+        if (size < m_size)
+        {
+            Traits::ReleaseElements(m_data + size, m_size - size);
+            m_size = size;
+        }
+
+        // Always keep some memory allocated, so empty arrays have non-null data.
+        auto newData = static_cast<T*>(CoTaskMemRealloc(m_data, std::max<size_t>(newSize, 1) * sizeof(T)));
+        if (!newData)
+            ThrowHR(E_OUTOFMEMORY);
+
+        m_data = newData;
+
+        if (size > m_size)
+        {
+            Traits::InitializeElements(m_data + m_size, size - m_size);
+            m_size = size;
+        }
+    }
+
     void Detach(uint32_t* size, typename Traits::data_ptr_t* data)
     {
         *size = m_size;
@@ -525,6 +525,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         , m_dxgiDevice(dxgiDevice)
         , m_sharedState(SharedDeviceState::GetInstance())
         , m_deviceContextPool(d2dDevice)
+        , m_stagingBitmapPool(&m_deviceContextPool)
+        , m_frameArenaPool(m_sharedState->GetDebugLevel() == CanvasDebugLevel::Information)
         , m_spriteBatchQuirk(SpriteBatchQuirk::NeedsCheck)
     {
         if (!dxgiDevice)
@@ -859,6 +861,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return ExceptionBoundary(
             [&]
             {
+                m_frameArenaPool.Close();
+                m_stagingBitmapPool.Close();
                 m_deviceContextPool.Close();
                 ThrowIfFailed(this->ResourceWrapper::Close()); // 'this->' is workaround for VS2013 calling with bad 'this' pointer
 
@@ -1158,6 +1162,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                 auto& d2dDevice = GetResource();
                 auto& dxgiDevice = m_dxgiDevice.EnsureNotClosed();
 
+                m_stagingBitmapPool.Trim();
+                m_frameArenaPool.Trim();
+
                 D2DResourceLock lock(d2dDevice.Get());
 
                 d2dDevice->ClearResources();
@@ -1449,6 +1456,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return m_deviceContextPool.TakeLease();
     }
 
+    StagingBitmapLease CanvasDevice::LeaseStagingBitmap(D2D1_SIZE_U const& size, D2D1_PIXEL_FORMAT const& format)
+    {
+        return m_stagingBitmapPool.TakeLease(size, format);
+    }
+
+    FrameArenaLease CanvasDevice::LeaseFrameArena()
+    {
+        return m_frameArenaPool.TakeLease();
+    }
+
     void CanvasDevice::InitializePrimaryOutput(IDXGIDevice3* dxgiDevice)
     {
         D2DResourceLock lock(GetResource().Get());
@@ -1558,6 +1575,22 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         return gradientMesh;
     }
 
+    ComPtr<ID2D1SpriteBatch> CanvasDevice::CreateSpriteBatch()
+    {
+        auto deviceContext = GetResourceCreationDeviceContext();
+
+        auto deviceContext3 = MaybeAs<ID2D1DeviceContext3>(deviceContext.Get());
+
+        if (!deviceContext3)
+            ThrowHR(E_NOTIMPL, Strings::SpriteBatchNotAvailable);
+
+        ComPtr<ID2D1SpriteBatch> spriteBatch;
+
+        ThrowIfFailed(deviceContext3->CreateSpriteBatch(&spriteBatch));
+
+        return spriteBatch;
+    }
+
     bool CanvasDevice::IsSpriteBatchQuirkRequired()
     {
         //
@@ -5,6 +5,8 @@
 #pragma once
 
 #include "DeviceContextPool.h"
+#include "FrameArena.h"
+#include "StagingBitmapPool.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
@@ -160,6 +162,10 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         virtual DeviceContextLease GetResourceCreationDeviceContext() = 0;
 
+        virtual StagingBitmapLease LeaseStagingBitmap(D2D1_SIZE_U const& size, D2D1_PIXEL_FORMAT const& format) = 0;
+
+        virtual FrameArenaLease LeaseFrameArena() = 0;
+
         virtual ComPtr<IDXGIOutput> GetPrimaryDisplayOutput() = 0;
 
         virtual void ThrowIfCreateSurfaceFailed(HRESULT hr, wchar_t const* typeName, uint32_t width, uint32_t height) = 0;
@@ -175,6 +181,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         virtual ComPtr<ID2D1GradientMesh> CreateGradientMesh(D2D1_GRADIENT_MESH_PATCH const* patches, uint32_t patchCount) = 0;
 
+        virtual ComPtr<ID2D1SpriteBatch> CreateSpriteBatch() = 0;
+
         virtual bool IsSpriteBatchQuirkRequired() = 0;
 
         virtual ComPtr<ID2D1SvgDocument> CreateSvgDocument(IStream* inputXmlStream) = 0;
@@ -214,6 +222,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         std::shared_ptr<SharedDeviceState> m_sharedState;
 
         DeviceContextPool m_deviceContextPool;
+        StagingBitmapPool m_stagingBitmapPool;
+        FrameArenaPool m_frameArenaPool;
 
         ComPtr<ID2D1Effect> m_histogramEffect;
         ComPtr<ID2D1Effect> m_atlasEffect;
@@ -373,6 +383,10 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         virtual DeviceContextLease GetResourceCreationDeviceContext() override final;
 
+        virtual StagingBitmapLease LeaseStagingBitmap(D2D1_SIZE_U const& size, D2D1_PIXEL_FORMAT const& format) override;
+
+        virtual FrameArenaLease LeaseFrameArena() override;
+
         virtual ComPtr<IDXGIOutput> GetPrimaryDisplayOutput() override;
 
         virtual void ThrowIfCreateSurfaceFailed(HRESULT hr, wchar_t const* typeName, uint32_t width, uint32_t height) override;
@@ -382,6 +396,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         virtual ComPtr<ID2D1GradientMesh> CreateGradientMesh(D2D1_GRADIENT_MESH_PATCH const* patches, uint32_t patchCount) override;
 
+        virtual ComPtr<ID2D1SpriteBatch> CreateSpriteBatch() override;
+
         virtual bool IsSpriteBatchQuirkRequired() override;
 
         virtual ComPtr<ID2D1SvgDocument> CreateSvgDocument(IStream* inputXmlStream) override;
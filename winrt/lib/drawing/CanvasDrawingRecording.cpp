@@ -0,0 +1,250 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "CanvasDrawingRecording.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas;
+using ABI::Windows::UI::Color;
+
+
+//
+// CanvasDrawingRecordingFactory
+//
+
+IFACEMETHODIMP CanvasDrawingRecordingFactory::ActivateInstance(IInspectable** object)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckAndClearOutPointer(object);
+
+            auto recording = Make<CanvasDrawingRecording>();
+            CheckMakeResult(recording);
+
+            ThrowIfFailed(recording.CopyTo(object));
+        });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecordingFactory::CreateFromBytes(
+    uint32_t byteCount,
+    BYTE* bytes,
+    ICanvasDrawingRecording** recording)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(bytes);
+            CheckAndClearOutPointer(recording);
+
+            auto newRecording = Make<CanvasDrawingRecording>();
+            CheckMakeResult(newRecording);
+
+            newRecording->Load(bytes, byteCount);
+
+            ThrowIfFailed(newRecording.CopyTo(recording));
+        });
+}
+
+
+//
+// CanvasDrawingRecording
+//
+
+CanvasDrawingRecording::CanvasDrawingRecording()
+    : m_closed(false)
+{
+}
+
+
+void CanvasDrawingRecording::ThrowIfClosed()
+{
+    if (m_closed)
+        ThrowHR(RO_E_CLOSED);
+}
+
+
+template<typename FN>
+HRESULT CanvasDrawingRecording::Record(FN&& fn)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            Lock lock(m_mutex);
+            ThrowIfClosed();
+
+            fn();
+        });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::get_Transform(Matrix3x2* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+
+            Lock lock(m_mutex);
+            ThrowIfClosed();
+
+            *value = *ReinterpretAs<Matrix3x2 const*>(&m_stream.GetTransform());
+        });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::put_Transform(Matrix3x2 value)
+{
+    return Record([&] { m_stream.SetTransform(*ReinterpretAs<D2D1_MATRIX_3X2_F const*>(&value)); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::get_CommandCount(int32_t* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+
+            Lock lock(m_mutex);
+            ThrowIfClosed();
+
+            *value = static_cast<int32_t>(m_stream.GetCommandCount());
+        });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::get_Bounds(Rect* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+
+            Lock lock(m_mutex);
+            ThrowIfClosed();
+
+            *value = FromD2DRect(m_stream.GetBounds());
+        });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::FillRectangle(Rect rect, Color color)
+{
+    return Record([&] { m_stream.FillRectangle(ToD2DRect(rect), color); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::DrawRectangle(Rect rect, Color color, float strokeWidth)
+{
+    return Record([&] { m_stream.DrawRectangle(ToD2DRect(rect), color, strokeWidth); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::FillRoundedRectangle(Rect rect, float radiusX, float radiusY, Color color)
+{
+    return Record([&] { m_stream.FillRoundedRectangle(ToD2DRoundedRect(rect, radiusX, radiusY), color); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::DrawRoundedRectangle(Rect rect, float radiusX, float radiusY, Color color, float strokeWidth)
+{
+    return Record([&] { m_stream.DrawRoundedRectangle(ToD2DRoundedRect(rect, radiusX, radiusY), color, strokeWidth); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::FillEllipse(Vector2 centerPoint, float radiusX, float radiusY, Color color)
+{
+    return Record([&] { m_stream.FillEllipse(ToD2DEllipse(centerPoint, radiusX, radiusY), color); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::DrawEllipse(Vector2 centerPoint, float radiusX, float radiusY, Color color, float strokeWidth)
+{
+    return Record([&] { m_stream.DrawEllipse(ToD2DEllipse(centerPoint, radiusX, radiusY), color, strokeWidth); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::DrawLine(Vector2 point0, Vector2 point1, Color color, float strokeWidth)
+{
+    return Record([&] { m_stream.DrawLine(ToD2DPoint(point0), ToD2DPoint(point1), color, strokeWidth); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::DrawPolyline(uint32_t pointCount, Vector2* points, Color color, float strokeWidth)
+{
+    return Record(
+        [&]
+        {
+            if (pointCount > 0)
+                CheckInPointer(points);
+
+            m_stream.DrawPolyline(pointCount, ReinterpretAs<D2D1_POINT_2F const*>(points), color, strokeWidth);
+        });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::Clear()
+{
+    return Record([&] { m_stream.Clear(); });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::GetBytes(uint32_t* valueCount, BYTE** valueElements)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(valueCount);
+            CheckAndClearOutPointer(valueElements);
+
+            Lock lock(m_mutex);
+            ThrowIfClosed();
+
+            auto bytes = m_stream.Save();
+
+            ComArray<uint8_t> array(bytes.begin(), bytes.end());
+            array.Detach(valueCount, valueElements);
+        });
+}
+
+
+IFACEMETHODIMP CanvasDrawingRecording::Close()
+{
+    Lock lock(m_mutex);
+
+    // Clear alone keeps the buffer around for reuse, but once closed we never will.
+    m_stream.Clear();
+    m_stream.ShrinkToFit();
+    m_closed = true;
+
+    return S_OK;
+}
+
+
+DrawingCommandStream::DrawStatistics CanvasDrawingRecording::DrawTo(
+    ID2D1DeviceContext1* deviceContext,
+    SolidColorBrushCache& brushes,
+    D2D1_RECT_F const* cullRect,
+    uint32_t startIndex,
+    uint32_t commandCount)
+{
+    Lock lock(m_mutex);
+    ThrowIfClosed();
+
+    return m_stream.Draw(deviceContext, brushes, cullRect, startIndex, commandCount);
+}
+
+
+void CanvasDrawingRecording::Load(uint8_t const* bytes, size_t byteCount)
+{
+    Lock lock(m_mutex);
+
+    m_stream.Load(bytes, byteCount);
+}
+
+
+ActivatableClassWithFactory(CanvasDrawingRecording, CanvasDrawingRecordingFactory);
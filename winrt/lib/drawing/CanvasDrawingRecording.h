@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include "DrawingCommandStream.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    class __declspec(uuid("C5FA7750-FDEE-4DB5-A75A-46634931D23E"))
+    ICanvasDrawingRecordingInternal : public IUnknown
+    {
+    public:
+        // cullRect is in the coordinate space of the recorded commands.
+        virtual DrawingCommandStream::DrawStatistics DrawTo(
+            ID2D1DeviceContext1* deviceContext,
+            SolidColorBrushCache& brushes,
+            D2D1_RECT_F const* cullRect,
+            uint32_t startIndex,
+            uint32_t commandCount) = 0;
+    };
+
+
+    class CanvasDrawingRecordingFactory
+        : public AgileActivationFactory<ICanvasDrawingRecordingStatics>
+        , private LifespanTracker<CanvasDrawingRecordingFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasDrawingRecording, BaseTrust);
+
+    public:
+        IFACEMETHOD(ActivateInstance)(IInspectable** object) override;
+
+        IFACEMETHOD(CreateFromBytes)(
+            uint32_t byteCount,
+            BYTE* bytes,
+            ICanvasDrawingRecording** recording) override;
+    };
+
+
+    //
+    // Records drawing commands into a DrawingCommandStream, so they can be
+    // replayed later with CanvasDrawingSession.DrawRecording.  Recording
+    // doesn't need a device, so can happen on any thread (eg. building the
+    // next frame's scene while the current one is drawn).
+    //
+    class CanvasDrawingRecording : public RuntimeClass<
+                                       ICanvasDrawingRecording,
+                                       IClosable,
+                                       CloakedIid<ICanvasDrawingRecordingInternal>>,
+                                   private LifespanTracker<CanvasDrawingRecording>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasDrawingRecording, BaseTrust);
+
+        std::mutex m_mutex;
+        DrawingCommandStream m_stream;
+        bool m_closed;
+
+    public:
+        CanvasDrawingRecording();
+
+        //
+        // ICanvasDrawingRecording
+        //
+
+        IFACEMETHOD(get_Transform)(Matrix3x2* value) override;
+        IFACEMETHOD(put_Transform)(Matrix3x2 value) override;
+
+        IFACEMETHOD(get_CommandCount)(int32_t* value) override;
+
+        IFACEMETHOD(get_Bounds)(Rect* value) override;
+
+        IFACEMETHOD(FillRectangle)(
+            Rect rect,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(DrawRectangle)(
+            Rect rect,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        IFACEMETHOD(FillRoundedRectangle)(
+            Rect rect,
+            float radiusX,
+            float radiusY,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(DrawRoundedRectangle)(
+            Rect rect,
+            float radiusX,
+            float radiusY,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        IFACEMETHOD(FillEllipse)(
+            Vector2 centerPoint,
+            float radiusX,
+            float radiusY,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(DrawEllipse)(
+            Vector2 centerPoint,
+            float radiusX,
+            float radiusY,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        IFACEMETHOD(DrawLine)(
+            Vector2 point0,
+            Vector2 point1,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        IFACEMETHOD(DrawPolyline)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth) override;
+
+        IFACEMETHOD(Clear)() override;
+
+        IFACEMETHOD(GetBytes)(uint32_t* valueCount, BYTE** valueElements) override;
+
+        //
+        // IClosable
+        //
+
+        IFACEMETHOD(Close)() override;
+
+        //
+        // ICanvasDrawingRecordingInternal
+        //
+
+        virtual DrawingCommandStream::DrawStatistics DrawTo(
+            ID2D1DeviceContext1* deviceContext,
+            SolidColorBrushCache& brushes,
+            D2D1_RECT_F const* cullRect,
+            uint32_t startIndex,
+            uint32_t commandCount) override;
+
+        void Load(uint8_t const* bytes, size_t byteCount);
+
+    private:
+        void ThrowIfClosed();
+
+        template<typename FN>
+        HRESULT Record(FN&& fn);
+    };
+}}}}
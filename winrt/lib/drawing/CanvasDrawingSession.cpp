@@ -5,6 +5,8 @@
 #include "pch.h"
 
 #include "CanvasActiveLayer.h"
+#include "CanvasDrawingRecording.h"
+#include "CanvasRetainedSpriteBatch.h"
 #include "CanvasSpriteBatch.h"
 #include "text/CanvasTextFormat.h"
 #include "text/CanvasTextRenderingParameters.h"
@@ -14,6 +16,7 @@
 #include "text/InternalDWriteTextRenderer.h"
 #include "text/DrawGlyphRunHelper.h"
 #include "svg/CanvasSvgDocument.h"
+#include "geometry/Polyline.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
@@ -137,7 +140,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         , m_targetHasActiveDrawingSession(std::move(targetHasActiveDrawingSession))
         , m_offset(offset)
         , m_nextLayerId(0)
+        , m_foldColorEffects(false)
         , m_owner(owner)
+        , m_frameArenaStatistics{}
     {
         if (m_targetHasActiveDrawingSession)
             *m_targetHasActiveDrawingSession = true;
@@ -178,8 +183,17 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                     adapter->EndDraw(deviceContext.Get());
                 }
 
-                m_solidColorBrush.Reset();
+                m_colorBrushes.Clear();
                 m_defaultTextFormat.Reset();
+
+                // The arena keeps its blocks for the next session on this
+                // device; only the statistics stay with this one.
+                if (m_frameArena)
+                {
+                    m_frameArenaStatistics = m_frameArena->GetStatistics();
+                    m_frameArena = FrameArenaLease();
+                }
+
                 m_owner.Reset();
 #if WINUI3_SUPPORTS_INKING
                 m_inkD2DRenderer.Reset();
@@ -429,13 +443,14 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         Rect* m_sourceRect;
         float m_opacity;
         CanvasImageInterpolation m_interpolation;
+        WIN2D_GET_D2D_IMAGE_FLAGS m_flags;
 
         D2D1_RECT_F m_d2dSourceRect;
         ComPtr<ID2D1Image> m_opacityEffectOutput;
         ComPtr<ID2D1Image> m_borderEffectOutput;
 
     public:
-        DrawImageWorker(ICanvasDevice* canvasDevice, ID2D1DeviceContext1* deviceContext, Vector2* offset, Rect* destinationRect, Rect* sourceRect, float opacity, CanvasImageInterpolation interpolation)
+        DrawImageWorker(ICanvasDevice* canvasDevice, ID2D1DeviceContext1* deviceContext, Vector2* offset, Rect* destinationRect, Rect* sourceRect, float opacity, CanvasImageInterpolation interpolation, WIN2D_GET_D2D_IMAGE_FLAGS flags = WIN2D_GET_D2D_IMAGE_FLAGS_READ_DPI_FROM_DEVICE_CONTEXT)
             : m_canvasDevice(canvasDevice)
             , m_deviceContext(deviceContext)
             , m_offset(offset)
@@ -443,6 +458,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             , m_sourceRect(sourceRect)
             , m_opacity(opacity)
             , m_interpolation(interpolation)
+            , m_flags(flags)
         {
             assert(m_offset || m_destinationRect);
 
@@ -470,7 +486,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             {
                 // If DrawBitmap cannot handle this request, we must use the DrawImage slow path.
 
-                ComPtr<ID2D1Image> d2dImage = ICanvasImageInternal::GetD2DImageFromInternalOrInteropSource(image, m_canvasDevice, m_deviceContext);
+                ComPtr<ID2D1Image> d2dImage = ICanvasImageInternal::GetD2DImageFromInternalOrInteropSource(image, m_canvasDevice, m_deviceContext, m_flags);
 
                 auto d2dInterpolationMode = static_cast<D2D1_INTERPOLATION_MODE>(m_interpolation);
                 auto d2dCompositeMode = composite ? static_cast<D2D1_COMPOSITE_MODE>(*composite)
@@ -732,7 +748,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             auto& deviceContext = GetResource();
             CheckInPointer(image);
 
-            DrawImageWorker(GetDevice().Get(), deviceContext.Get(), offset, destinationRect, sourceRect, opacity, interpolation).DrawImage(image, composite);
+            auto flags = WIN2D_GET_D2D_IMAGE_FLAGS_READ_DPI_FROM_DEVICE_CONTEXT;
+
+            if (m_foldColorEffects)
+                flags |= WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS;
+
+            DrawImageWorker(GetDevice().Get(), deviceContext.Get(), offset, destinationRect, sourceRect, opacity, interpolation, flags).DrawImage(image, composite);
         });
 
     }
@@ -3380,17 +3401,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     ID2D1SolidColorBrush* CanvasDrawingSession::GetColorBrush(Color const& color)
     {
-        if (m_solidColorBrush)
-        {
-            m_solidColorBrush->SetColor(ToD2DColor(color));
-        }
-        else
-        {
-            auto& deviceContext = GetResource();
-            ThrowIfFailed(deviceContext->CreateSolidColorBrush(ToD2DColor(color), &m_solidColorBrush));
-        }
+        auto& deviceContext = GetResource();
 
-        return m_solidColorBrush.Get();
+        return m_colorBrushes.GetBrush(deviceContext.Get(), color);
     }
 
 
@@ -3711,6 +3724,30 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     }
 
 
+    IFACEMETHODIMP CanvasDrawingSession::get_FoldColorEffects(boolean* value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+                CheckInPointer(value);
+
+                *value = m_foldColorEffects;
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::put_FoldColorEffects(boolean value)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                GetResource();
+
+                m_foldColorEffects = !!value;
+            });
+    }
+
+
     IFACEMETHODIMP CanvasDrawingSession::get_Device(ICanvasDevice** value)
     {
         using namespace ::Microsoft::WRL::Wrappers;
@@ -3936,6 +3973,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                 CheckInPointer(glyphs);
                 CheckInPointer(brush);
 
+                auto& frameArena = GetFrameArena();
+                auto rewindWarden = MakeScopeWarden([&] { frameArena.Rewind(); });
+
                 DrawGlyphRunHelper helper(
                     fontFace, 
                     fontSize, 
@@ -3950,7 +3990,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                     clusterMapIndicesCount, 
                     clusterMapIndices, 
                     textPosition,
-                    deviceContext);
+                    deviceContext,
+                    &frameArena);
 
                 auto d2dBrush = MaybeAs<ID2D1Brush>(helper.ClientDrawingEffect);
 
@@ -4124,28 +4165,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
     {
         return ExceptionBoundary([&]
         {
-            // Validate interpolation mode
-            switch (interpolation)
-            {
-            case CanvasImageInterpolation::NearestNeighbor:
-            case CanvasImageInterpolation::Linear:
-                break;
-
-            default:
-                // We have a special message for this case since there are
-                // various, valid looking, CanvasImageInterpolation modes that
-                // are not valid to use with this API.
-                ThrowHR(E_INVALIDARG, Strings::SpriteBatchInvalidInterpolation);
-            }
-
-            // Validate options
-            auto const validOptions = CanvasSpriteOptions::ClampToSourceRect;
-            if ((static_cast<uint32_t>(options) & ~static_cast<uint32_t>(validOptions)) != 0)
-            {
-                // no special message for this since this can't happen unless
-                // the app is doing casting.
-                ThrowHR(E_INVALIDARG);
-            }
+            CanvasSpriteBatch::ValidateSortMode(sortMode);
+            CanvasSpriteBatch::ValidateInterpolationAndOptions(interpolation, options);
 
             CheckAndClearOutPointer(spriteBatch);
             
@@ -4165,6 +4186,728 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         });
     }
 
+    IFACEMETHODIMP CanvasDrawingSession::DrawRetainedSpriteBatch(
+        ICanvasRetainedSpriteBatch* spriteBatch)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(spriteBatch);
+
+            int32_t spriteCount;
+            ThrowIfFailed(spriteBatch->get_SpriteCount(&spriteCount));
+
+            ThrowIfFailed(DrawRetainedSpriteBatchRange(spriteBatch, 0, spriteCount));
+        });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawRetainedSpriteBatchRange(
+        ICanvasRetainedSpriteBatch* spriteBatch,
+        int32_t startIndex,
+        int32_t spriteCount)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(spriteBatch);
+
+            if (startIndex < 0 || spriteCount < 0)
+                ThrowHR(E_INVALIDARG);
+
+            auto deviceContext3 = MaybeAs<ID2D1DeviceContext3>(GetResource());
+
+            if (!deviceContext3)
+                ThrowHR(E_NOTIMPL, Strings::SpriteBatchNotAvailable);
+
+            // The D2D sprite batch and its bitmap belong to the device the
+            // retained batch was created on, so can't be drawn anywhere else.
+            ResourceManager::ValidateDevice(As<ICanvasResourceWrapperWithDevice>(spriteBatch).Get(), GetDevice().Get());
+
+            As<ICanvasRetainedSpriteBatchInternal>(spriteBatch)->DrawTo(
+                deviceContext3.Get(),
+                static_cast<uint32_t>(startIndex),
+                static_cast<uint32_t>(spriteCount));
+        });
+    }
+
+    //
+    // Batched primitives
+    //
+    // FillRectangles, DrawLines and FillCircles validate their arguments, resolve
+    // the brush and realize the stroke style once per call, rather than once per
+    // primitive as happens when calling FillRectangle etc. in a loop.
+    //
+
+    CanvasDrawingSession::BatchBrush::BatchBrush(ComPtr<ID2D1Brush>&& brush)
+        : m_drawingSession(nullptr)
+        , m_brush(std::move(brush))
+        , m_colorCount(0)
+        , m_colors(nullptr)
+        , m_currentColor{}
+    {
+    }
+
+
+    CanvasDrawingSession::BatchBrush::BatchBrush(CanvasDrawingSession* drawingSession, uint32_t colorCount, Color const* colors)
+        : m_drawingSession(drawingSession)
+        , m_colorCount(colorCount)
+        , m_colors(colors)
+        , m_currentColor{}
+    {
+    }
+
+
+    void CanvasDrawingSession::BatchBrush::Validate(uint32_t primitiveCount) const
+    {
+        if (!m_drawingSession)
+        {
+            CheckInPointer(m_brush.Get());
+            return;
+        }
+
+        if (m_colorCount != primitiveCount)
+        {
+            WinStringBuilder message;
+            message.Format(Strings::WrongNamedArrayLength, L"colors", primitiveCount, m_colorCount);
+            ThrowHR(E_INVALIDARG, message.Get());
+        }
+
+        if (m_colorCount)
+            CheckInPointer(m_colors);
+    }
+
+
+    ID2D1Brush* CanvasDrawingSession::BatchBrush::Get(uint32_t index)
+    {
+        if (m_drawingSession)
+        {
+            auto& color = m_colors[index];
+
+            if (!m_brush ||
+                color.A != m_currentColor.A ||
+                color.R != m_currentColor.R ||
+                color.G != m_currentColor.G ||
+                color.B != m_currentColor.B)
+            {
+                m_brush = m_drawingSession->GetColorBrush(color);
+                m_currentColor = color;
+            }
+        }
+
+        return m_brush.Get();
+    }
+
+
+    static void CheckBatchArray(uint32_t count, void const* values)
+    {
+        // Empty arrays can be passed as null.
+        if (count)
+            CheckInPointer(values);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::FillRectanglesWithBrush(
+        uint32_t rectCount,
+        Rect* rects,
+        ICanvasBrush* brush)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(ToD2DBrush(brush));
+
+                FillRectanglesImpl(rectCount, rects, batchBrush);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::FillRectanglesWithColor(
+        uint32_t rectCount,
+        Rect* rects,
+        Color color)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(GetColorBrush(color));
+
+                FillRectanglesImpl(rectCount, rects, batchBrush);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::FillRectanglesWithColors(
+        uint32_t rectCount,
+        Rect* rects,
+        uint32_t colorCount,
+        Color* colors)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(this, colorCount, colors);
+
+                FillRectanglesImpl(rectCount, rects, batchBrush);
+            });
+    }
+
+
+    void CanvasDrawingSession::FillRectanglesImpl(
+        uint32_t rectCount,
+        Rect const* rects,
+        BatchBrush& brush)
+    {
+        auto& deviceContext = GetResource();
+
+        CheckBatchArray(rectCount, rects);
+        brush.Validate(rectCount);
+
+        for (uint32_t i = 0; i < rectCount; i++)
+        {
+            auto d2dRect = ToD2DRect(rects[i]);
+
+            deviceContext->FillRectangle(&d2dRect, brush.Get(i));
+        }
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawLinesWithBrush(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush)
+    {
+        return DrawLinesWithBrushAndStrokeWidthAndStrokeStyle(pointCount, points, brush, 1.0f, nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawLinesWithColor(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color)
+    {
+        return DrawLinesWithColorAndStrokeWidthAndStrokeStyle(pointCount, points, color, 1.0f, nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawLinesWithColors(
+        uint32_t pointCount,
+        Vector2* points,
+        uint32_t colorCount,
+        Color* colors)
+    {
+        return DrawLinesWithColorsAndStrokeWidthAndStrokeStyle(pointCount, points, colorCount, colors, 1.0f, nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawLinesWithBrushAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(ToD2DBrush(brush));
+
+                DrawLinesImpl(pointCount, points, batchBrush, strokeWidth, strokeStyle);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawLinesWithColorAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(GetColorBrush(color));
+
+                DrawLinesImpl(pointCount, points, batchBrush, strokeWidth, strokeStyle);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawLinesWithColorsAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        uint32_t colorCount,
+        Color* colors,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(this, colorCount, colors);
+
+                DrawLinesImpl(pointCount, points, batchBrush, strokeWidth, strokeStyle);
+            });
+    }
+
+
+    void CanvasDrawingSession::DrawLinesImpl(
+        uint32_t pointCount,
+        Vector2 const* points,
+        BatchBrush& brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        auto& deviceContext = GetResource();
+
+        CheckBatchArray(pointCount, points);
+
+        if (pointCount % 2 != 0)
+        {
+            WinStringBuilder message;
+            message.Format(Strings::DrawLinesOddPointCount, pointCount);
+            ThrowHR(E_INVALIDARG, message.Get());
+        }
+
+        auto lineCount = pointCount / 2;
+
+        brush.Validate(lineCount);
+
+        auto d2dStrokeStyle = ToD2DStrokeStyle(strokeStyle, deviceContext.Get());
+
+        for (uint32_t i = 0; i < lineCount; i++)
+        {
+            deviceContext->DrawLine(
+                ToD2DPoint(points[i * 2]),
+                ToD2DPoint(points[i * 2 + 1]),
+                brush.Get(i),
+                strokeWidth,
+                d2dStrokeStyle.Get());
+        }
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::FillCirclesWithBrush(
+        uint32_t centerCount,
+        Vector2* centers,
+        uint32_t radiusCount,
+        float* radii,
+        ICanvasBrush* brush)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(ToD2DBrush(brush));
+
+                FillCirclesImpl(centerCount, centers, radiusCount, radii, batchBrush);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::FillCirclesWithColor(
+        uint32_t centerCount,
+        Vector2* centers,
+        uint32_t radiusCount,
+        float* radii,
+        Color color)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(GetColorBrush(color));
+
+                FillCirclesImpl(centerCount, centers, radiusCount, radii, batchBrush);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::FillCirclesWithColors(
+        uint32_t centerCount,
+        Vector2* centers,
+        uint32_t radiusCount,
+        float* radii,
+        uint32_t colorCount,
+        Color* colors)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                BatchBrush batchBrush(this, colorCount, colors);
+
+                FillCirclesImpl(centerCount, centers, radiusCount, radii, batchBrush);
+            });
+    }
+
+
+    void CanvasDrawingSession::FillCirclesImpl(
+        uint32_t centerCount,
+        Vector2 const* centers,
+        uint32_t radiusCount,
+        float const* radii,
+        BatchBrush& brush)
+    {
+        auto& deviceContext = GetResource();
+
+        CheckBatchArray(centerCount, centers);
+
+        // Either one radius per circle, or a single radius shared by all of them.
+        if (radiusCount != centerCount && radiusCount != 1)
+        {
+            WinStringBuilder message;
+            message.Format(Strings::FillCirclesWrongRadiusCount, centerCount, radiusCount);
+            ThrowHR(E_INVALIDARG, message.Get());
+        }
+
+        CheckBatchArray(radiusCount, radii);
+
+        brush.Validate(centerCount);
+
+        auto radiusStride = (radiusCount == 1) ? 0 : 1;
+
+        for (uint32_t i = 0; i < centerCount; i++)
+        {
+            auto radius = radii[i * radiusStride];
+
+            auto d2dEllipse = ToD2DEllipse(centers[i], radius, radius);
+
+            deviceContext->FillEllipse(&d2dEllipse, brush.Get(i));
+        }
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithBrush(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush)
+    {
+        return DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(pointCount, points, brush, 1.0f, nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithColor(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color)
+    {
+        return DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(pointCount, points, color, 1.0f, nullptr);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return DrawPolylineWithBrushAndStrokeWidthAndStrokeStyleAndDecimation(pointCount, points, brush, strokeWidth, strokeStyle, true);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle)
+    {
+        return DrawPolylineWithColorAndStrokeWidthAndStrokeStyleAndDecimation(pointCount, points, color, strokeWidth, strokeStyle, true);
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithBrushAndStrokeWidthAndStrokeStyleAndDecimation(
+        uint32_t pointCount,
+        Vector2* points,
+        ICanvasBrush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle,
+        boolean allowDecimation)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawPolylineImpl(pointCount, points, ToD2DBrush(brush).Get(), strokeWidth, strokeStyle, !!allowDecimation);
+            });
+    }
+
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawPolylineWithColorAndStrokeWidthAndStrokeStyleAndDecimation(
+        uint32_t pointCount,
+        Vector2* points,
+        Color color,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle,
+        boolean allowDecimation)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawPolylineImpl(pointCount, points, GetColorBrush(color), strokeWidth, strokeStyle, !!allowDecimation);
+            });
+    }
+
+
+    // Decimating in columns one device pixel wide leaves the same pixels covered.
+    // Geometry columns only line up with pixel columns under an axis aligned transform,
+    // so anything rotated or skewed is drawn without decimation.
+    struct PolylineColumns
+    {
+        float Width;        // Zero to disable decimation.
+        float Origin;
+    };
+
+    static PolylineColumns GetPolylineColumns(ID2D1DeviceContext* deviceContext)
+    {
+        D2D1_MATRIX_3X2_F transform;
+        deviceContext->GetTransform(&transform);
+
+        if (transform._12 != 0 || transform._21 != 0)
+            return PolylineColumns{};
+
+        auto pixelsPerUnit = fabs(transform._11);
+
+        if (deviceContext->GetUnitMode() == D2D1_UNIT_MODE_DIPS)
+        {
+            float dpiX, dpiY;
+            deviceContext->GetDpi(&dpiX, &dpiY);
+
+            pixelsPerUnit *= dpiX / DEFAULT_DPI;
+        }
+
+        if (!(pixelsPerUnit > 0) || !std::isfinite(pixelsPerUnit))
+            return PolylineColumns{};
+
+        // The translation moves pixel boundaries relative to the points, so
+        // columns start wherever the transform puts device X = 0.
+        auto origin = transform._31 / transform._11;
+
+        if (!std::isfinite(origin))
+            return PolylineColumns{};
+
+        return PolylineColumns{ 1.0f / pixelsPerUnit, origin };
+    }
+
+
+    // Dashes are laid out along the full length of the line, so removing
+    // points would move them.  Only solid lines can be decimated.
+    static bool IsSolidStrokeStyle(ICanvasStrokeStyle* strokeStyle)
+    {
+        if (!strokeStyle)
+            return true;
+
+        ComArray<float> customDashes;
+        ThrowIfFailed(strokeStyle->get_CustomDashStyle(customDashes.GetAddressOfSize(), customDashes.GetAddressOfData()));
+
+        if (customDashes.GetSize() > 0)
+            return false;
+
+        CanvasDashStyle dashStyle;
+        ThrowIfFailed(strokeStyle->get_DashStyle(&dashStyle));
+
+        return dashStyle == CanvasDashStyle::Solid;
+    }
+
+
+    FrameArena& CanvasDrawingSession::GetFrameArena()
+    {
+        if (!m_frameArena)
+        {
+            if (m_owner)
+                m_frameArena = As<ICanvasDeviceInternal>(m_owner)->LeaseFrameArena();
+            else
+                m_frameArena = FrameArenaLease(std::make_unique<FrameArena>());
+        }
+
+        return *m_frameArena.Get();
+    }
+
+
+    void CanvasDrawingSession::DrawPolylineImpl(
+        uint32_t pointCount,
+        Vector2 const* points,
+        ID2D1Brush* brush,
+        float strokeWidth,
+        ICanvasStrokeStyle* strokeStyle,
+        bool allowDecimation)
+    {
+        auto& deviceContext = GetResource();
+
+        CheckBatchArray(pointCount, points);
+        CheckInPointer(brush);
+
+        if (pointCount == 0)
+            return;
+
+        ComPtr<ID2D1Factory> d2dFactory;
+        deviceContext->GetFactory(&d2dFactory);
+
+        ComPtr<ID2D1PathGeometry1> pathGeometry;
+        ThrowIfFailed(As<ID2D1Factory1>(d2dFactory)->CreatePathGeometry(&pathGeometry));
+
+        ComPtr<ID2D1GeometrySink> geometrySink;
+        ThrowIfFailed(pathGeometry->Open(&geometrySink));
+
+        PolylineColumns columns{};
+
+        if (allowDecimation && IsSolidStrokeStyle(strokeStyle))
+            columns = GetPolylineColumns(deviceContext.Get());
+
+        FrameArena* frameArena = nullptr;
+        D2D1_POINT_2F* scratch = nullptr;
+
+        if (columns.Width > 0)
+        {
+            frameArena = &GetFrameArena();
+            scratch = frameArena->Allocate<D2D1_POINT_2F>(pointCount);
+        }
+
+        auto rewindWarden = MakeScopeWarden([&] { if (frameArena) frameArena->Rewind(); });
+
+        AddPolylineToSink(geometrySink.Get(), pointCount, points, false, columns.Width, columns.Origin, scratch);
+
+        ThrowIfFailed(geometrySink->Close());
+
+        deviceContext->DrawGeometry(
+            pathGeometry.Get(),
+            brush,
+            strokeWidth,
+            ToD2DStrokeStyle(strokeStyle, deviceContext.Get()).Get());
+    }
+
+    //
+    // DrawRecording
+    //
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawRecording(
+        ICanvasDrawingRecording* recording)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                DrawRecordingImpl(recording, nullptr, 0, AllRecordedCommands);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawRecordingInRegion(
+        ICanvasDrawingRecording* recording,
+        Rect region)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                auto d2dRegion = ToD2DRect(region);
+
+                DrawRecordingImpl(recording, &d2dRegion, 0, AllRecordedCommands);
+            });
+    }
+
+    IFACEMETHODIMP CanvasDrawingSession::DrawRecordingRange(
+        ICanvasDrawingRecording* recording,
+        int32_t startIndex,
+        int32_t commandCount)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                if (startIndex < 0 || commandCount < 0)
+                    ThrowHR(E_INVALIDARG);
+
+                DrawRecordingImpl(recording, nullptr, static_cast<uint32_t>(startIndex), static_cast<uint32_t>(commandCount));
+            });
+    }
+
+    //
+    // Returns the part of the render target that is visible through the
+    // current transform, in the coordinates that drawing commands are
+    // specified in.  Not known for command lists (which have no fixed size)
+    // or when the transform can't be inverted.
+    //
+    static bool GetVisibleTargetRect(ID2D1DeviceContext1* deviceContext, D2D1_RECT_F* rect)
+    {
+        ComPtr<ID2D1Image> target;
+        deviceContext->GetTarget(&target);
+
+        auto targetBitmap = MaybeAs<ID2D1Bitmap>(target);
+
+        if (!targetBitmap)
+            return false;
+
+        // Local bounds are in the current unit mode, but ignore the transform.
+        D2D1_RECT_F targetBounds;
+        if (FAILED(deviceContext->GetImageLocalBounds(targetBitmap.Get(), &targetBounds)))
+            return false;
+
+        D2D1::Matrix3x2F inverseTransform;
+        deviceContext->GetTransform(&inverseTransform);
+
+        if (!inverseTransform.Invert())
+            return false;
+
+        D2D1_POINT_2F corners[] =
+        {
+            inverseTransform.TransformPoint(D2D1::Point2F(targetBounds.left,  targetBounds.top)),
+            inverseTransform.TransformPoint(D2D1::Point2F(targetBounds.right, targetBounds.top)),
+            inverseTransform.TransformPoint(D2D1::Point2F(targetBounds.left,  targetBounds.bottom)),
+            inverseTransform.TransformPoint(D2D1::Point2F(targetBounds.right, targetBounds.bottom)),
+        };
+
+        *rect = D2D1_RECT_F{ corners[0].x, corners[0].y, corners[0].x, corners[0].y };
+
+        for (auto& corner : corners)
+        {
+            rect->left   = std::min(rect->left,   corner.x);
+            rect->top    = std::min(rect->top,    corner.y);
+            rect->right  = std::max(rect->right,  corner.x);
+            rect->bottom = std::max(rect->bottom, corner.y);
+        }
+
+        return true;
+    }
+
+    void CanvasDrawingSession::DrawRecordingImpl(
+        ICanvasDrawingRecording* recording,
+        D2D1_RECT_F const* region,
+        uint32_t startIndex,
+        uint32_t commandCount)
+    {
+        auto& deviceContext = GetResource();
+
+        CheckInPointer(recording);
+
+        if (commandCount == AllRecordedCommands)
+        {
+            int32_t recordedCount;
+            ThrowIfFailed(recording->get_CommandCount(&recordedCount));
+
+            commandCount = static_cast<uint32_t>(recordedCount);
+        }
+
+        D2D1_RECT_F cullRect;
+        bool hasCullRect = GetVisibleTargetRect(deviceContext.Get(), &cullRect);
+
+        if (region)
+        {
+            if (hasCullRect)
+            {
+                // An empty intersection (left > right) culls everything, which is what we want.
+                cullRect.left   = std::max(cullRect.left,   region->left);
+                cullRect.top    = std::max(cullRect.top,    region->top);
+                cullRect.right  = std::min(cullRect.right,  region->right);
+                cullRect.bottom = std::min(cullRect.bottom, region->bottom);
+            }
+            else
+            {
+                cullRect = *region;
+                hasCullRect = true;
+            }
+        }
+
+        As<ICanvasDrawingRecordingInternal>(recording)->DrawTo(
+            deviceContext.Get(),
+            m_colorBrushes,
+            hasCullRect ? &cullRect : nullptr,
+            startIndex,
+            commandCount);
+    }
+
     IFACEMETHODIMP CanvasDrawingSession::DrawSvgAtOrigin(ICanvasSvgDocument *svgDocument, Size viewportSize)
     {
         return DrawSvgAtCoords(svgDocument, viewportSize, 0, 0);
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include "FrameArena.h"
+#include "SolidColorBrushCache.h"
+
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
     using namespace ABI::Microsoft::Graphics::Canvas::Geometry;
@@ -60,12 +63,14 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         std::shared_ptr<bool> m_targetHasActiveDrawingSession;
         D2D1_POINT_2F const m_offset;
         
-        ComPtr<ID2D1SolidColorBrush> m_solidColorBrush;
+        SolidColorBrushCache m_colorBrushes;
         ComPtr<ICanvasTextFormat> m_defaultTextFormat;
 
         std::vector<int> m_activeLayerIds;
         int m_nextLayerId;
 
+        bool m_foldColorEffects;
+
         //
         // Contract:
         //     Drawing sessions created conventionally initialize this member.
@@ -79,6 +84,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         //
         ComPtr<ICanvasDevice> m_owner;
 
+        // Scratch memory for temporaries that don't outlive a single call,
+        // leased from m_owner on first use (see GetFrameArena) and handed back
+        // on Close.  Declared after m_owner so that it is returned before the
+        // device holding the pool can be released.
+        FrameArenaLease m_frameArena;
+        FrameArena::Statistics m_frameArenaStatistics;
+
 #if WINUI3_SUPPORTS_INKING
         ComPtr<IInkD2DRenderer> m_inkD2DRenderer;
         ComPtr<ID2D1DrawingStateBlock1> m_inkStateBlock;
@@ -102,6 +114,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         virtual ~CanvasDrawingSession();
 
+        // How much scratch memory this session has used, and how much of it
+        // needed a heap allocation.  Still valid after Close.
+        FrameArena::Statistics GetFrameArenaStatistics()
+        {
+            return m_frameArena ? m_frameArena->GetStatistics() : m_frameArenaStatistics;
+        }
+
         // IClosable
 
         IFACEMETHOD(Close)() override;
@@ -1216,6 +1235,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         IFACEMETHOD(get_EffectTileSize)(BitmapSize* value) override;
         IFACEMETHOD(put_EffectTileSize)(BitmapSize value) override;
 
+        IFACEMETHOD(get_FoldColorEffects)(boolean* value) override;
+        IFACEMETHOD(put_FoldColorEffects)(boolean value) override;
+
         //
         // CreateLayer
         //
@@ -1329,6 +1351,166 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             CanvasSpriteOptions options,
             ICanvasSpriteBatch** spriteBatch) override;
 
+        //
+        // DrawRetainedSpriteBatch
+        //
+
+        IFACEMETHOD(DrawRetainedSpriteBatch)(
+            ICanvasRetainedSpriteBatch* spriteBatch) override;
+
+        IFACEMETHOD(DrawRetainedSpriteBatchRange)(
+            ICanvasRetainedSpriteBatch* spriteBatch,
+            int32_t startIndex,
+            int32_t spriteCount) override;
+
+        //
+        // FillRectangles
+        //
+
+        IFACEMETHOD(FillRectanglesWithBrush)(
+            uint32_t rectCount,
+            Rect* rects,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(FillRectanglesWithColor)(
+            uint32_t rectCount,
+            Rect* rects,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(FillRectanglesWithColors)(
+            uint32_t rectCount,
+            Rect* rects,
+            uint32_t colorCount,
+            ABI::Windows::UI::Color* colors) override;
+
+        //
+        // DrawLines
+        //
+
+        IFACEMETHOD(DrawLinesWithBrush)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(DrawLinesWithColor)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(DrawLinesWithColors)(
+            uint32_t pointCount,
+            Vector2* points,
+            uint32_t colorCount,
+            ABI::Windows::UI::Color* colors) override;
+
+        IFACEMETHOD(DrawLinesWithBrushAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        IFACEMETHOD(DrawLinesWithColorAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        IFACEMETHOD(DrawLinesWithColorsAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            uint32_t colorCount,
+            ABI::Windows::UI::Color* colors,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        //
+        // FillCircles
+        //
+
+        IFACEMETHOD(FillCirclesWithBrush)(
+            uint32_t centerCount,
+            Vector2* centers,
+            uint32_t radiusCount,
+            float* radii,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(FillCirclesWithColor)(
+            uint32_t centerCount,
+            Vector2* centers,
+            uint32_t radiusCount,
+            float* radii,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(FillCirclesWithColors)(
+            uint32_t centerCount,
+            Vector2* centers,
+            uint32_t radiusCount,
+            float* radii,
+            uint32_t colorCount,
+            ABI::Windows::UI::Color* colors) override;
+
+        //
+        // DrawPolyline
+        //
+
+        IFACEMETHOD(DrawPolylineWithBrush)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush) override;
+
+        IFACEMETHOD(DrawPolylineWithColor)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color) override;
+
+        IFACEMETHOD(DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        IFACEMETHOD(DrawPolylineWithColorAndStrokeWidthAndStrokeStyle)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle) override;
+
+        IFACEMETHOD(DrawPolylineWithBrushAndStrokeWidthAndStrokeStyleAndDecimation)(
+            uint32_t pointCount,
+            Vector2* points,
+            ICanvasBrush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle,
+            boolean allowDecimation) override;
+
+        IFACEMETHOD(DrawPolylineWithColorAndStrokeWidthAndStrokeStyleAndDecimation)(
+            uint32_t pointCount,
+            Vector2* points,
+            ABI::Windows::UI::Color color,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle,
+            boolean allowDecimation) override;
+
+        //
+        // DrawRecording
+        //
+
+        IFACEMETHOD(DrawRecording)(
+            ICanvasDrawingRecording* recording) override;
+
+        IFACEMETHOD(DrawRecordingInRegion)(
+            ICanvasDrawingRecording* recording,
+            Rect region) override;
+
+        IFACEMETHOD(DrawRecordingRange)(
+            ICanvasDrawingRecording* recording,
+            int32_t startIndex,
+            int32_t commandCount) override;
+
         //
         // ICanvasResourceCreator
         //
@@ -1345,6 +1527,71 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         IFACEMETHODIMP ConvertDipsToPixels(float dips, CanvasDpiRounding dpiRounding, int* pixels) override;
 
     private:
+        //
+        // Brush for the batched FillRectangles, DrawLines and FillCircles
+        // methods, which take either a single brush or color, or one color per
+        // primitive.  Per-primitive colors only go through the brush cache when
+        // the color changes, so a run of one color is drawn with the same brush.
+        //
+        class BatchBrush
+        {
+            CanvasDrawingSession* m_drawingSession;
+            ComPtr<ID2D1Brush> m_brush;
+            uint32_t m_colorCount;
+            ABI::Windows::UI::Color const* m_colors;
+            ABI::Windows::UI::Color m_currentColor;
+
+        public:
+            explicit BatchBrush(ComPtr<ID2D1Brush>&& brush);
+
+            BatchBrush(CanvasDrawingSession* drawingSession, uint32_t colorCount, ABI::Windows::UI::Color const* colors);
+
+            void Validate(uint32_t primitiveCount) const;
+
+            ID2D1Brush* Get(uint32_t index);
+        };
+
+        void FillRectanglesImpl(
+            uint32_t rectCount,
+            Rect const* rects,
+            BatchBrush& brush);
+
+        void DrawLinesImpl(
+            uint32_t pointCount,
+            Vector2 const* points,
+            BatchBrush& brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle);
+
+        void FillCirclesImpl(
+            uint32_t centerCount,
+            Vector2 const* centers,
+            uint32_t radiusCount,
+            float const* radii,
+            BatchBrush& brush);
+
+        // Leases an arena from the owning device if this session doesn't
+        // have one yet.  Sessions created through interop have no owner, so
+        // get an arena of their own.
+        FrameArena& GetFrameArena();
+
+        void DrawPolylineImpl(
+            uint32_t pointCount,
+            Vector2 const* points,
+            ID2D1Brush* brush,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle,
+            bool allowDecimation);
+
+        // Passed as DrawRecordingImpl's commandCount to draw everything.
+        static const uint32_t AllRecordedCommands = UINT32_MAX;
+
+        void DrawRecordingImpl(
+            ICanvasDrawingRecording* recording,
+            D2D1_RECT_F const* region,
+            uint32_t startIndex,
+            uint32_t commandCount);
+
         void DrawLineImpl(
             Vector2 const& p0,
             Vector2 const& p1,
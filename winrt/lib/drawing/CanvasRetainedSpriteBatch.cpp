@@ -0,0 +1,414 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "CanvasRetainedSpriteBatch.h"
+#include "CanvasSpriteBatch.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas;
+
+
+static void ValidateSpriteArray(wchar_t const* name, uint32_t spriteCount, uint32_t actualCount, void const* values)
+{
+    if (actualCount == 0)
+        return;
+
+    if (actualCount != spriteCount)
+    {
+        WinStringBuilder message;
+        message.Format(Strings::WrongNamedArrayLength, name, spriteCount, actualCount);
+        ThrowHR(E_INVALIDARG, message.Get());
+    }
+
+    CheckInPointer(values);
+}
+
+
+//
+// CanvasRetainedSpriteBatchFactory
+//
+
+IFACEMETHODIMP CanvasRetainedSpriteBatchFactory::Create(
+    ICanvasResourceCreator* resourceCreator,
+    ICanvasBitmap* bitmap,
+    ICanvasRetainedSpriteBatch** spriteBatch)
+{
+    return CreateWithInterpolationAndOptions(
+        resourceCreator,
+        bitmap,
+        CanvasImageInterpolation::Linear,
+        CanvasSpriteOptions::None,
+        spriteBatch);
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatchFactory::CreateWithInterpolationAndOptions(
+    ICanvasResourceCreator* resourceCreator,
+    ICanvasBitmap* bitmap,
+    CanvasImageInterpolation interpolation,
+    CanvasSpriteOptions options,
+    ICanvasRetainedSpriteBatch** spriteBatch)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(resourceCreator);
+            CheckInPointer(bitmap);
+            CheckAndClearOutPointer(spriteBatch);
+
+            auto newSpriteBatch = CanvasRetainedSpriteBatch::CreateNew(resourceCreator, bitmap, interpolation, options);
+
+            ThrowIfFailed(newSpriteBatch.CopyTo(spriteBatch));
+        });
+}
+
+
+//
+// CanvasRetainedSpriteBatch
+//
+
+ComPtr<CanvasRetainedSpriteBatch> CanvasRetainedSpriteBatch::CreateNew(
+    ICanvasResourceCreator* resourceCreator,
+    ICanvasBitmap* bitmap,
+    CanvasImageInterpolation interpolation,
+    CanvasSpriteOptions options)
+{
+    CanvasSpriteBatch::ValidateInterpolationAndOptions(interpolation, options);
+
+    ComPtr<ICanvasDevice> device;
+    ThrowIfFailed(resourceCreator->get_Device(&device));
+
+    auto d2dSpriteBatch = As<ICanvasDeviceInternal>(device)->CreateSpriteBatch();
+
+    auto spriteBatch = Make<CanvasRetainedSpriteBatch>(
+        device.Get(),
+        d2dSpriteBatch.Get(),
+        bitmap,
+        static_cast<D2D1_BITMAP_INTERPOLATION_MODE>(interpolation),
+        static_cast<D2D1_SPRITE_OPTIONS>(options));
+    CheckMakeResult(spriteBatch);
+
+    return spriteBatch;
+}
+
+
+CanvasRetainedSpriteBatch::CanvasRetainedSpriteBatch(
+    ICanvasDevice* canvasDevice,
+    ID2D1SpriteBatch* d2dSpriteBatch,
+    ICanvasBitmap* bitmap,
+    D2D1_BITMAP_INTERPOLATION_MODE interpolation,
+    D2D1_SPRITE_OPTIONS options)
+    : ResourceWrapper(d2dSpriteBatch)
+    , m_canvasDevice(canvasDevice)
+    , m_bitmap(bitmap)
+    , m_d2dBitmap(GetWrappedResource<ID2D1Bitmap>(bitmap, canvasDevice))
+    , m_bitmapSizeInPixels(m_d2dBitmap->GetPixelSize())
+    , m_bitmapDpi(DEFAULT_DPI)
+    , m_interpolationMode(interpolation)
+    , m_spriteOptions(options)
+{
+    ThrowIfFailed(As<ICanvasResourceCreatorWithDpi>(bitmap)->get_Dpi(&m_bitmapDpi));
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatch::get_Bitmap(ICanvasBitmap** value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckAndClearOutPointer(value);
+
+            ThrowIfFailed(m_bitmap.EnsureNotClosed().CopyTo(value));
+        });
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatch::get_SpriteCount(int32_t* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+
+            *value = static_cast<int32_t>(GetResource()->GetSpriteCount());
+        });
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatch::AddSprites(
+    uint32_t destRectCount,
+    Rect* destRects,
+    uint32_t sourceRectCount,
+    Rect* sourceRects,
+    uint32_t tintCount,
+    Vector4* tints,
+    uint32_t transformCount,
+    Matrix3x2* transforms,
+    uint32_t flipCount,
+    CanvasSpriteFlip* flips)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            auto& d2dSpriteBatch = GetResource();
+
+            ValidateSpriteArray(L"destRects", destRectCount, destRectCount, destRects);
+            ValidateSpriteArray(L"sourceRects", destRectCount, sourceRectCount, sourceRects);
+            ValidateSpriteArray(L"tints", destRectCount, tintCount, tints);
+            ValidateSpriteArray(L"transforms", destRectCount, transformCount, transforms);
+            ValidateSpriteArray(L"flips", destRectCount, flipCount, flips);
+
+            if (destRectCount == 0)
+                return;
+
+            std::vector<D2D1_RECT_F> d2dDestRects(destRectCount);
+            std::transform(destRects, destRects + destRectCount, d2dDestRects.begin(), ToD2DRect);
+
+            auto d2dSourceRects = MakeSourceRects(destRectCount, sourceRectCount, sourceRects, flipCount, flips);
+
+            // Any array that wasn't provided is passed to D2D as null, which
+            // gives the default for that value (the whole bitmap, white, or
+            // the identity transform).
+            ThrowIfFailed(d2dSpriteBatch->AddSprites(
+                destRectCount,
+                d2dDestRects.data(),
+                d2dSourceRects.empty() ? nullptr : d2dSourceRects.data(),
+                ReinterpretAs<D2D1_COLOR_F const*>(tints),
+                ReinterpretAs<D2D1_MATRIX_3X2_F const*>(transforms),
+                sizeof(D2D1_RECT_F),
+                sizeof(D2D1_RECT_U),
+                sizeof(D2D1_COLOR_F),
+                sizeof(D2D1_MATRIX_3X2_F)));
+        });
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatch::SetSprites(
+    int32_t startIndex,
+    uint32_t destRectCount,
+    Rect* destRects,
+    uint32_t sourceRectCount,
+    Rect* sourceRects,
+    uint32_t tintCount,
+    Vector4* tints,
+    uint32_t transformCount,
+    Matrix3x2* transforms,
+    uint32_t flipCount,
+    CanvasSpriteFlip* flips)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            auto& d2dSpriteBatch = GetResource();
+
+            // Each array may be empty, meaning that attribute is left as it
+            // was, so the number of sprites being updated is the length of
+            // whichever arrays were provided.
+            auto spriteCount = std::max({ destRectCount, sourceRectCount, tintCount, transformCount, flipCount });
+
+            ValidateSpriteArray(L"destRects", spriteCount, destRectCount, destRects);
+            ValidateSpriteArray(L"sourceRects", spriteCount, sourceRectCount, sourceRects);
+            ValidateSpriteArray(L"tints", spriteCount, tintCount, tints);
+            ValidateSpriteArray(L"transforms", spriteCount, transformCount, transforms);
+            ValidateSpriteArray(L"flips", spriteCount, flipCount, flips);
+
+            auto currentSpriteCount = d2dSpriteBatch->GetSpriteCount();
+
+            if (startIndex < 0 || static_cast<uint64_t>(startIndex) + spriteCount > currentSpriteCount)
+                ThrowHR(E_BOUNDS);
+
+            if (spriteCount == 0)
+                return;
+
+            std::vector<D2D1_RECT_F> d2dDestRects(destRectCount);
+            if (destRectCount != 0)
+                std::transform(destRects, destRects + destRectCount, d2dDestRects.begin(), ToD2DRect);
+
+            // Updating only source rects or only flips must keep the other
+            // part of the sprites' current source rects.
+            std::vector<D2D1_RECT_U> currentSourceRects;
+
+            if ((sourceRectCount == 0) != (flipCount == 0))
+            {
+                currentSourceRects.resize(spriteCount);
+                ThrowIfFailed(d2dSpriteBatch->GetSprites(static_cast<uint32_t>(startIndex), spriteCount, nullptr, currentSourceRects.data(), nullptr, nullptr));
+            }
+
+            auto d2dSourceRects = MakeSourceRects(
+                spriteCount,
+                sourceRectCount,
+                sourceRects,
+                flipCount,
+                flips,
+                currentSourceRects.empty() ? nullptr : currentSourceRects.data());
+
+            // Arrays that weren't provided are passed as null, so D2D leaves
+            // those attributes untouched and only uploads what changed.
+            ThrowIfFailed(d2dSpriteBatch->SetSprites(
+                static_cast<uint32_t>(startIndex),
+                spriteCount,
+                d2dDestRects.empty() ? nullptr : d2dDestRects.data(),
+                d2dSourceRects.empty() ? nullptr : d2dSourceRects.data(),
+                ReinterpretAs<D2D1_COLOR_F const*>(tints),
+                ReinterpretAs<D2D1_MATRIX_3X2_F const*>(transforms),
+                sizeof(D2D1_RECT_F),
+                sizeof(D2D1_RECT_U),
+                sizeof(D2D1_COLOR_F),
+                sizeof(D2D1_MATRIX_3X2_F)));
+        });
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatch::Clear()
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            GetResource()->Clear();
+        });
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatch::get_Device(ICanvasDevice** value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckAndClearOutPointer(value);
+
+            ThrowIfFailed(m_canvasDevice.EnsureNotClosed().CopyTo(value));
+        });
+}
+
+
+IFACEMETHODIMP CanvasRetainedSpriteBatch::Close()
+{
+    m_d2dBitmap.Reset();
+    m_bitmap.Close();
+    m_canvasDevice.Close();
+    return ResourceWrapper::Close();
+}
+
+
+void CanvasRetainedSpriteBatch::DrawTo(ID2D1DeviceContext3* deviceContext, uint32_t startIndex, uint32_t spriteCount)
+{
+    auto& d2dSpriteBatch = GetResource();
+
+    auto totalSpriteCount = d2dSpriteBatch->GetSpriteCount();
+
+    if (static_cast<uint64_t>(startIndex) + spriteCount > totalSpriteCount)
+        ThrowHR(E_BOUNDS);
+
+    if (spriteCount == 0)
+        return;
+
+    //
+    // Get the device context into the right state.  Source rects were
+    // converted to pixels using the bitmap DPI, so the batch is always drawn
+    // in DIPs.
+    //
+
+    auto originalAntialiasMode = deviceContext->GetAntialiasMode();
+
+    if (originalAntialiasMode == D2D1_ANTIALIAS_MODE_PER_PRIMITIVE)
+        deviceContext->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+
+    auto originalUnitMode = deviceContext->GetUnitMode();
+    if (originalUnitMode != D2D1_UNIT_MODE_DIPS)
+        deviceContext->SetUnitMode(D2D1_UNIT_MODE_DIPS);
+
+    auto restoreStateWarden = MakeScopeWarden(
+        [&]
+        {
+            if (originalUnitMode != D2D1_UNIT_MODE_DIPS)
+                deviceContext->SetUnitMode(originalUnitMode);
+
+            if (originalAntialiasMode == D2D1_ANTIALIAS_MODE_PER_PRIMITIVE)
+                deviceContext->SetAntialiasMode(originalAntialiasMode);
+        });
+
+    //
+    // All the sprites share a bitmap, so this is a single DrawSpriteBatch
+    // call unless the device needs the sprite batch size quirk (see
+    // CanvasSpriteBatch::Close).
+    //
+
+    bool quirked = As<ICanvasDeviceInternal>(m_canvasDevice.EnsureNotClosed())->IsSpriteBatchQuirkRequired();
+    uint32_t maxSpritesPerBatch = quirked ? 256 : spriteCount;
+
+    for (uint32_t offset = 0; offset < spriteCount; offset += maxSpritesPerBatch)
+    {
+        deviceContext->DrawSpriteBatch(
+            d2dSpriteBatch.Get(),
+            startIndex + offset,
+            std::min(maxSpritesPerBatch, spriteCount - offset),
+            m_d2dBitmap.Get(),
+            m_interpolationMode,
+            m_spriteOptions);
+
+        if (quirked)
+            deviceContext->Flush();
+    }
+}
+
+
+static CanvasSpriteFlip GetSourceRectFlip(D2D1_RECT_U const& sourceRect)
+{
+    bool horizontal = sourceRect.left > sourceRect.right;
+    bool vertical = sourceRect.top > sourceRect.bottom;
+
+    if (horizontal && vertical)
+        return CanvasSpriteFlip::Both;
+    else if (horizontal)
+        return CanvasSpriteFlip::Horizontal;
+    else if (vertical)
+        return CanvasSpriteFlip::Vertical;
+    else
+        return CanvasSpriteFlip::None;
+}
+
+
+std::vector<D2D1_RECT_U> CanvasRetainedSpriteBatch::MakeSourceRects(
+    uint32_t spriteCount,
+    uint32_t sourceRectCount,
+    Rect* sourceRects,
+    uint32_t flipCount,
+    CanvasSpriteFlip* flips,
+    D2D1_RECT_U const* currentSourceRects)
+{
+    std::vector<D2D1_RECT_U> d2dSourceRects;
+
+    // Flipping is done by reversing the source rect, so if there are flips but
+    // no source rects we need to generate source rects for them.
+    if (sourceRectCount == 0 && flipCount == 0)
+        return d2dSourceRects;
+
+    d2dSourceRects.reserve(spriteCount);
+
+    for (uint32_t i = 0; i < spriteCount; ++i)
+    {
+        if (sourceRectCount != 0)
+        {
+            auto flip = (flipCount != 0)    ? flips[i] :
+                        currentSourceRects  ? GetSourceRectFlip(currentSourceRects[i]) :
+                                              CanvasSpriteFlip::None;
+
+            d2dSourceRects.push_back(CanvasSpriteBatch::MakeFlippedSourceRect(flip, m_bitmapDpi, sourceRects[i]));
+        }
+        else if (currentSourceRects)
+        {
+            d2dSourceRects.push_back(CanvasSpriteBatch::MakeFlippedSourceRect(flips[i], currentSourceRects[i]));
+        }
+        else
+        {
+            d2dSourceRects.push_back(CanvasSpriteBatch::MakeFlippedSourceRect(flips[i], m_bitmapSizeInPixels));
+        }
+    }
+
+    return d2dSourceRects;
+}
+
+
+ActivatableClassWithFactory(CanvasRetainedSpriteBatch, CanvasRetainedSpriteBatchFactory);
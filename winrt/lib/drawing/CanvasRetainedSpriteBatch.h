@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    class __declspec(uuid("1895D215-1398-4F76-9829-25BB06F4D0E0"))
+    ICanvasRetainedSpriteBatchInternal : public IUnknown
+    {
+    public:
+        virtual void DrawTo(ID2D1DeviceContext3* deviceContext, uint32_t startIndex, uint32_t spriteCount) = 0;
+    };
+
+
+    class CanvasRetainedSpriteBatchFactory
+        : public AgileActivationFactory<ICanvasRetainedSpriteBatchFactory>
+        , private LifespanTracker<CanvasRetainedSpriteBatchFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasRetainedSpriteBatch, BaseTrust);
+
+    public:
+        IFACEMETHOD(Create)(
+            ICanvasResourceCreator* resourceCreator,
+            ICanvasBitmap* bitmap,
+            ICanvasRetainedSpriteBatch** spriteBatch) override;
+
+        IFACEMETHOD(CreateWithInterpolationAndOptions)(
+            ICanvasResourceCreator* resourceCreator,
+            ICanvasBitmap* bitmap,
+            CanvasImageInterpolation interpolation,
+            CanvasSpriteOptions options,
+            ICanvasRetainedSpriteBatch** spriteBatch) override;
+    };
+
+
+    //
+    // A sprite batch that lives for as long as the app wants it to, rather
+    // than for a single drawing session.  The ID2D1SpriteBatch is created once
+    // from the device, and AddSprites / SetSprites forward straight to it, so
+    // only the sprites that actually change are ever uploaded.  Drawing it is
+    // a DrawSpriteBatch call per 'batch' of sprites.
+    //
+    class CanvasRetainedSpriteBatch : RESOURCE_WRAPPER_RUNTIME_CLASS(
+        ID2D1SpriteBatch,
+        CanvasRetainedSpriteBatch,
+        ICanvasRetainedSpriteBatch,
+        CloakedIid<ICanvasRetainedSpriteBatchInternal>,
+        CloakedIid<ICanvasResourceWrapperWithDevice>)
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasRetainedSpriteBatch, BaseTrust);
+
+        ClosablePtr<ICanvasDevice> m_canvasDevice;
+        ClosablePtr<ICanvasBitmap> m_bitmap;
+        ComPtr<ID2D1Bitmap> m_d2dBitmap;
+        D2D1_SIZE_U m_bitmapSizeInPixels;
+        float m_bitmapDpi;
+        D2D1_BITMAP_INTERPOLATION_MODE m_interpolationMode;
+        D2D1_SPRITE_OPTIONS m_spriteOptions;
+
+    public:
+        static ComPtr<CanvasRetainedSpriteBatch> CreateNew(
+            ICanvasResourceCreator* resourceCreator,
+            ICanvasBitmap* bitmap,
+            CanvasImageInterpolation interpolation,
+            CanvasSpriteOptions options);
+
+        CanvasRetainedSpriteBatch(
+            ICanvasDevice* canvasDevice,
+            ID2D1SpriteBatch* d2dSpriteBatch,
+            ICanvasBitmap* bitmap,
+            D2D1_BITMAP_INTERPOLATION_MODE interpolation,
+            D2D1_SPRITE_OPTIONS options);
+
+        //
+        // ICanvasRetainedSpriteBatch
+        //
+
+        IFACEMETHOD(get_Bitmap)(ICanvasBitmap** value) override;
+
+        IFACEMETHOD(get_SpriteCount)(int32_t* value) override;
+
+        IFACEMETHOD(AddSprites)(
+            uint32_t destRectCount,
+            Rect* destRects,
+            uint32_t sourceRectCount,
+            Rect* sourceRects,
+            uint32_t tintCount,
+            Vector4* tints,
+            uint32_t transformCount,
+            Matrix3x2* transforms,
+            uint32_t flipCount,
+            CanvasSpriteFlip* flips) override;
+
+        IFACEMETHOD(SetSprites)(
+            int32_t startIndex,
+            uint32_t destRectCount,
+            Rect* destRects,
+            uint32_t sourceRectCount,
+            Rect* sourceRects,
+            uint32_t tintCount,
+            Vector4* tints,
+            uint32_t transformCount,
+            Matrix3x2* transforms,
+            uint32_t flipCount,
+            CanvasSpriteFlip* flips) override;
+
+        IFACEMETHOD(Clear)() override;
+
+        IFACEMETHOD(get_Device)(ICanvasDevice** value) override;
+
+        //
+        // IClosable
+        //
+
+        IFACEMETHOD(Close)() override;
+
+        //
+        // ICanvasRetainedSpriteBatchInternal
+        //
+
+        virtual void DrawTo(ID2D1DeviceContext3* deviceContext, uint32_t startIndex, uint32_t spriteCount) override;
+
+    private:
+        // Flips are applied by reversing the source rect, so to update only
+        // one of the two the other comes from currentSourceRects.  When that
+        // is null, missing source rects are the whole bitmap and missing flips
+        // are None.
+        std::vector<D2D1_RECT_U> MakeSourceRects(
+            uint32_t spriteCount,
+            uint32_t sourceRectCount,
+            Rect* sourceRects,
+            uint32_t flipCount,
+            CanvasSpriteFlip* flips,
+            D2D1_RECT_U const* currentSourceRects = nullptr);
+    };
+
+}}}}
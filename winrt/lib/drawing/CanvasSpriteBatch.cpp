@@ -75,13 +75,19 @@ static D2D1_RECT_U MakeSourceRect(ComPtr<ID2D1Bitmap> const& d2dBitmap, CanvasSp
 }
 
 
-static D2D1_RECT_U MakeSourceRect(CanvasSpriteFlip flip, D2D1_UNIT_MODE unitMode, ICanvasBitmap* bitmap, Rect sourceRect)
+static float GetSourceRectDpi(D2D1_UNIT_MODE unitMode, ICanvasBitmap* bitmap)
 {
     float dpi = 96.0f;
 
     if (unitMode == D2D1_UNIT_MODE_DIPS)
         ThrowIfFailed(As<ICanvasResourceCreatorWithDpi>(bitmap)->get_Dpi(&dpi));
-    
+
+    return dpi;
+}
+
+
+static D2D1_RECT_U MakeSourceRect(CanvasSpriteFlip flip, float dpi, Rect const& sourceRect)
+{
     auto sourceLeft   = DipsToPixels(sourceRect.X,      dpi, CanvasDpiRounding::Round);
     auto sourceTop    = DipsToPixels(sourceRect.Y,      dpi, CanvasDpiRounding::Round);
     auto sourceWidth  = DipsToPixels(sourceRect.Width,  dpi, CanvasDpiRounding::Round);
@@ -99,6 +105,26 @@ static D2D1_RECT_U MakeSourceRect(CanvasSpriteFlip flip, D2D1_UNIT_MODE unitMode
 }
 
 
+static D2D1_RECT_U MakeSourceRect(CanvasSpriteFlip flip, D2D1_UNIT_MODE unitMode, ICanvasBitmap* bitmap, Rect sourceRect)
+{
+    return MakeSourceRect(flip, GetSourceRectDpi(unitMode, bitmap), sourceRect);
+}
+
+
+static void ValidateSpriteArraySize(wchar_t const* name, uint32_t spriteCount, uint32_t actualCount, void const* values)
+{
+    if (actualCount != 0 && actualCount != spriteCount)
+    {
+        WinStringBuilder message;
+        message.Format(Strings::WrongNamedArrayLength, name, spriteCount, actualCount);
+        ThrowHR(E_INVALIDARG, message.Get());
+    }
+
+    if (actualCount != 0 && !values)
+        ThrowHR(E_INVALIDARG);
+}
+
+
 static float3x2 MakeTransform(Vector2 const& origin, float rotation, Vector2 const& scale, Vector2 const& offset)
 {
     return
@@ -109,6 +135,74 @@ static float3x2 MakeTransform(Vector2 const& origin, float rotation, Vector2 con
 }
 
 
+D2D1_RECT_U CanvasSpriteBatch::MakeFlippedSourceRect(CanvasSpriteFlip flip, D2D1_SIZE_U const& bitmapSizeInPixels)
+{
+    return MakeSourceRect(flip, 0, 0, bitmapSizeInPixels.width, bitmapSizeInPixels.height);
+}
+
+
+D2D1_RECT_U CanvasSpriteBatch::MakeFlippedSourceRect(CanvasSpriteFlip flip, float dpi, Rect const& sourceRect)
+{
+    return MakeSourceRect(flip, dpi, sourceRect);
+}
+
+
+D2D1_RECT_U CanvasSpriteBatch::MakeFlippedSourceRect(CanvasSpriteFlip flip, D2D1_RECT_U const& sourceRectInPixels)
+{
+    // The input may itself be flipped, so normalize it first.
+    return MakeSourceRect(
+        flip,
+        std::min(sourceRectInPixels.left, sourceRectInPixels.right),
+        std::min(sourceRectInPixels.top, sourceRectInPixels.bottom),
+        std::max(sourceRectInPixels.left, sourceRectInPixels.right),
+        std::max(sourceRectInPixels.top, sourceRectInPixels.bottom));
+}
+
+
+void CanvasSpriteBatch::ValidateInterpolationAndOptions(CanvasImageInterpolation interpolation, CanvasSpriteOptions options)
+{
+    // Validate interpolation mode
+    switch (interpolation)
+    {
+    case CanvasImageInterpolation::NearestNeighbor:
+    case CanvasImageInterpolation::Linear:
+        break;
+
+    default:
+        // We have a special message for this case since there are
+        // various, valid looking, CanvasImageInterpolation modes that
+        // are not valid to use with this API.
+        ThrowHR(E_INVALIDARG, Strings::SpriteBatchInvalidInterpolation);
+    }
+
+    // Validate options
+    auto const validOptions = CanvasSpriteOptions::ClampToSourceRect;
+    if ((static_cast<uint32_t>(options) & ~static_cast<uint32_t>(validOptions)) != 0)
+    {
+        // no special message for this since this can't happen unless
+        // the app is doing casting.
+        ThrowHR(E_INVALIDARG);
+    }
+}
+
+
+void CanvasSpriteBatch::ValidateSortMode(CanvasSpriteSortMode sortMode)
+{
+    switch (sortMode)
+    {
+    case CanvasSpriteSortMode::None:
+    case CanvasSpriteSortMode::Bitmap:
+    case CanvasSpriteSortMode::BackToFront:
+    case CanvasSpriteSortMode::FrontToBack:
+    case CanvasSpriteSortMode::BitmapAndDepth:
+        break;
+
+    default:
+        ThrowHR(E_INVALIDARG);
+    }
+}
+
+
 CanvasSpriteBatch::CanvasSpriteBatch(
     ComPtr<ID2D1DeviceContext3> const& deviceContext,
     CanvasSpriteSortMode sortMode,
@@ -119,9 +213,13 @@ CanvasSpriteBatch::CanvasSpriteBatch(
     , m_interpolationMode(interpolation)
     , m_spriteOptions(options)
     , m_unitMode(deviceContext->GetUnitMode())
+    , m_depth(0.0f)
 {
     assert(m_sortMode == CanvasSpriteSortMode::None
-        || m_sortMode == CanvasSpriteSortMode::Bitmap);
+        || m_sortMode == CanvasSpriteSortMode::Bitmap
+        || m_sortMode == CanvasSpriteSortMode::BackToFront
+        || m_sortMode == CanvasSpriteSortMode::FrontToBack
+        || m_sortMode == CanvasSpriteSortMode::BitmapAndDepth);
     
     assert(m_interpolationMode == D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR
         || m_interpolationMode == D2D1_BITMAP_INTERPOLATION_MODE_LINEAR);
@@ -185,10 +283,11 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawAtOffsetWithTint(
         auto d2dSourceRect = MakeSourceRect(d2dBitmap, CanvasSpriteFlip::None);
         
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             d2dDestRect,
             d2dSourceRect,
-            tint);
+            tint,
+            m_depth);
     });
 }
 
@@ -217,10 +316,11 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawToRectWithTintAndFlip(
         auto d2dSourceRect = MakeSourceRect(d2dBitmap, flip);
         
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             ToD2DRect(destRect),
             d2dSourceRect,
-            tint);
+            tint,
+            m_depth);
     });
 }
 
@@ -241,11 +341,12 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawWithTransformAndTintAndFlip(
         auto d2dSourceRect = MakeSourceRect(d2dBitmap, flip);
 
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             d2dDestRect,
             d2dSourceRect,
             tint,
-            transform);
+            transform,
+            m_depth);
     });
 }
 
@@ -270,11 +371,12 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawAtOffsetWithTintAndTransform(
         auto transform = MakeTransform(origin, rotation, scale, offset);
 
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             d2dDestRect,
             d2dSourceRect,
             tint,
-            transform);
+            transform,
+            m_depth);
     });
 }
 
@@ -332,10 +434,11 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawFromSpriteSheetAtOffsetWithTint(
         auto d2dSourceRect = MakeSourceRect(CanvasSpriteFlip::None, m_unitMode, bitmap, sourceRect);
         
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             d2dDestRect,
             d2dSourceRect,
-            tint);
+            tint,
+            m_depth);
     });
 }
 
@@ -366,10 +469,11 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawFromSpriteSheetToRectWithTintAndFlip(
         auto d2dSourceRect = MakeSourceRect(flip, m_unitMode, bitmap, sourceRect);
         
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             ToD2DRect(destRect),
             d2dSourceRect,
-            tint);
+            tint,
+            m_depth);
     });
 }
 
@@ -391,11 +495,12 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawFromSpriteSheetWithTransformAndTintAndFlip
         auto d2dSourceRect = MakeSourceRect(flip, m_unitMode, bitmap, sourceRect);
         
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             d2dDestRect,
             d2dSourceRect,
             tint,
-            transform);
+            transform,
+            m_depth);
     });
 }
 
@@ -421,11 +526,182 @@ IFACEMETHODIMP CanvasSpriteBatch::DrawFromSpriteSheetAtOffsetWithTintAndTransfor
         auto transform = MakeTransform(origin, rotation, scale, offset);
 
         m_sprites.emplace_back(
-            std::move(d2dBitmap),
+            RetainBitmap(std::move(d2dBitmap)),
             d2dDestRect,
             d2dSourceRect,
             tint,
-            transform);
+            transform,
+            m_depth);
+    });
+}
+
+
+//
+// Shared implementation of the DrawSprites overloads.  Everything that only
+// depends on the bitmap (the QI for the D2D bitmap, its size and DPI) is
+// resolved once, and the sprites are appended directly to m_sprites.
+//
+// appendSprite is called once per sprite, with the destination rect that an
+// untransformed sprite would use (the size of its source rect, or of the whole
+// bitmap), and is responsible for appending the sprite to m_sprites.
+//
+template<typename APPEND_FN>
+void CanvasSpriteBatch::AddSprites(
+    ICanvasBitmap* bitmap,
+    uint32_t spriteCount,
+    uint32_t sourceRectCount,
+    Rect* sourceRects,
+    uint32_t tintCount,
+    Vector4* tints,
+    uint32_t flipCount,
+    CanvasSpriteFlip* flips,
+    APPEND_FN&& appendSprite)
+{
+    CheckInPointer(bitmap);
+    EnsureNotClosed();
+
+    ValidateSpriteArraySize(L"sourceRects", spriteCount, sourceRectCount, sourceRects);
+    ValidateSpriteArraySize(L"tints", spriteCount, tintCount, tints);
+    ValidateSpriteArraySize(L"flips", spriteCount, flipCount, flips);
+
+    if (spriteCount == 0)
+        return;
+
+    auto d2dBitmap = GetWrappedResource<ID2D1Bitmap>(bitmap);
+    auto bitmapDestRect = MakeDestRect(d2dBitmap);
+    auto bitmapSizeInPixels = d2dBitmap->GetPixelSize();
+    auto sourceRectDpi = (sourceRectCount != 0) ? GetSourceRectDpi(m_unitMode, bitmap) : DEFAULT_DPI;
+
+    auto rawBitmap = RetainBitmap(std::move(d2dBitmap));
+
+    auto originalSpriteCount = m_sprites.size();
+    auto rollbackWarden = MakeScopeWarden([&] { m_sprites.erase(m_sprites.begin() + originalSpriteCount, m_sprites.end()); });
+
+    m_sprites.reserve(originalSpriteCount + spriteCount);
+
+    for (uint32_t i = 0; i < spriteCount; ++i)
+    {
+        auto flip = (flipCount != 0) ? flips[i] : CanvasSpriteFlip::None;
+        auto const& tint = (tintCount != 0) ? tints[i] : DEFAULT_TINT;
+
+        if (sourceRectCount != 0)
+        {
+            appendSprite(
+                i,
+                rawBitmap,
+                MakeDestRect(sourceRects[i]),
+                MakeSourceRect(flip, sourceRectDpi, sourceRects[i]),
+                tint);
+        }
+        else
+        {
+            appendSprite(
+                i,
+                rawBitmap,
+                bitmapDestRect,
+                MakeSourceRect(flip, 0, 0, bitmapSizeInPixels.width, bitmapSizeInPixels.height),
+                tint);
+        }
+    }
+
+    rollbackWarden.Dismiss();
+}
+
+
+ID2D1Bitmap* CanvasSpriteBatch::RetainBitmap(ComPtr<ID2D1Bitmap>&& bitmap)
+{
+    auto rawBitmap = bitmap.Get();
+
+    // Sprites that alternate between a handful of bitmaps (eg. several
+    // particle textures) are common, so look back a few entries rather
+    // than only comparing against the most recent bitmap.
+    auto searchStart = m_bitmaps.size() - std::min(m_bitmaps.size(), RecentBitmapSearchCount);
+
+    for (auto i = m_bitmaps.size(); i > searchStart; --i)
+    {
+        if (m_bitmaps[i - 1].Get() == rawBitmap)
+            return rawBitmap;
+    }
+
+    m_bitmaps.push_back(std::move(bitmap));
+
+    return rawBitmap;
+}
+
+
+IFACEMETHODIMP CanvasSpriteBatch::DrawSpritesToRects(
+    ICanvasBitmap* bitmap,
+    uint32_t destRectCount,
+    Rect* destRects,
+    uint32_t sourceRectCount,
+    Rect* sourceRects,
+    uint32_t tintCount,
+    Vector4* tints,
+    uint32_t flipCount,
+    CanvasSpriteFlip* flips)
+{
+    return ExceptionBoundary([&]
+    {
+        if (destRectCount != 0)
+            CheckInPointer(destRects);
+
+        AddSprites(
+            bitmap,
+            destRectCount,
+            sourceRectCount,
+            sourceRects,
+            tintCount,
+            tints,
+            flipCount,
+            flips,
+            [&] (uint32_t i, ID2D1Bitmap* d2dBitmap, D2D1_RECT_F const&, D2D1_RECT_U const& d2dSourceRect, Vector4 const& tint)
+            {
+                m_sprites.emplace_back(
+                    d2dBitmap,
+                    ToD2DRect(destRects[i]),
+                    d2dSourceRect,
+                    tint,
+                    m_depth);
+            });
+    });
+}
+
+
+IFACEMETHODIMP CanvasSpriteBatch::DrawSpritesWithTransforms(
+    ICanvasBitmap* bitmap,
+    uint32_t transformCount,
+    Matrix3x2* transforms,
+    uint32_t sourceRectCount,
+    Rect* sourceRects,
+    uint32_t tintCount,
+    Vector4* tints,
+    uint32_t flipCount,
+    CanvasSpriteFlip* flips)
+{
+    return ExceptionBoundary([&]
+    {
+        if (transformCount != 0)
+            CheckInPointer(transforms);
+
+        AddSprites(
+            bitmap,
+            transformCount,
+            sourceRectCount,
+            sourceRects,
+            tintCount,
+            tints,
+            flipCount,
+            flips,
+            [&] (uint32_t i, ID2D1Bitmap* d2dBitmap, D2D1_RECT_F const& d2dDestRect, D2D1_RECT_U const& d2dSourceRect, Vector4 const& tint)
+            {
+                m_sprites.emplace_back(
+                    d2dBitmap,
+                    d2dDestRect,
+                    d2dSourceRect,
+                    tint,
+                    transforms[i],
+                    m_depth);
+            });
     });
 }
 
@@ -460,7 +736,7 @@ public:
             return;
         }
 
-        m_bitmap = m_sprites[m_endIndex].Bitmap.Get();
+        m_bitmap = m_sprites[m_endIndex].Bitmap;
 
         for (; InCurrentBatch(); ++m_endIndex)
         {
@@ -498,10 +774,170 @@ private:
         if (m_endIndex - m_startIndex >= m_maxSpritesPerBatch)
             return false;
         
-        return m_endIndex != m_sprites.size() && m_sprites[m_endIndex].Bitmap.Get() == m_bitmap;
+        return m_endIndex != m_sprites.size() && m_sprites[m_endIndex].Bitmap == m_bitmap;
     }
 };
 
+//
+// Sorting is done with an LSD radix sort over a 64-bit key per sprite.  The
+// key packs a primary and secondary sort value, so one (stable) sort orders
+// sprites by, say, depth and then groups sprites of equal depth by bitmap so
+// that they end up in the same DrawSpriteBatch call.
+//
+
+struct SpriteSortKey
+{
+    uint64_t Key;
+    uint32_t Index;
+};
+
+
+static void RadixSort(std::vector<SpriteSortKey>& keys)
+{
+    static const int RadixBits = 8;
+    static const int BucketCount = 1 << RadixBits;
+    static const int PassCount = 64 / RadixBits;
+
+    // Build the histograms for every pass in a single sweep over the keys.
+    uint32_t histograms[PassCount][BucketCount] = {};
+
+    for (auto const& key : keys)
+    {
+        for (int pass = 0; pass < PassCount; ++pass)
+            ++histograms[pass][(key.Key >> (pass * RadixBits)) & (BucketCount - 1)];
+    }
+
+    std::vector<SpriteSortKey> scratch(keys.size());
+    auto source = &keys;
+    auto dest = &scratch;
+
+    for (int pass = 0; pass < PassCount; ++pass)
+    {
+        auto& histogram = histograms[pass];
+        auto shift = pass * RadixBits;
+
+        // If every key has the same digit for this pass then it won't change
+        // the order, so we can skip it.  This is common: bitmap ranks only
+        // use the bottom few bits.
+        if (histogram[(source->front().Key >> shift) & (BucketCount - 1)] == keys.size())
+            continue;
+
+        uint32_t offset = 0;
+        for (auto& count : histogram)
+        {
+            auto bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+
+        for (auto const& key : *source)
+            (*dest)[histogram[(key.Key >> shift) & (BucketCount - 1)]++] = key;
+
+        std::swap(source, dest);
+    }
+
+    if (source != &keys)
+        keys.swap(scratch);
+}
+
+
+// Maps a float to an unsigned integer that sorts in the same order.
+static uint32_t MakeOrderedDepth(float depth)
+{
+    // Treat -0 and +0 as equal.
+    if (depth == 0.0f)
+        depth = 0.0f;
+
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+
+    // Negative floats sort in reverse order of their bit patterns, so flip
+    // all their bits; positive floats just need to sort after the negatives.
+    return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+
+void CanvasSpriteBatch::SortSprites()
+{
+    //
+    // Bitmaps are ranked by pointer value.  RetainBitmap only adds a bitmap
+    // to m_bitmaps when it wasn't used recently, so this is much smaller
+    // than the number of sprites.
+    //
+
+    std::vector<ID2D1Bitmap*> bitmaps;
+    bitmaps.reserve(m_bitmaps.size());
+    for (auto const& bitmap : m_bitmaps)
+        bitmaps.push_back(bitmap.Get());
+
+    std::sort(bitmaps.begin(), bitmaps.end());
+    bitmaps.erase(std::unique(bitmaps.begin(), bitmaps.end()), bitmaps.end());
+
+    //
+    // Build the keys
+    //
+
+    std::vector<SpriteSortKey> keys;
+    keys.reserve(m_sprites.size());
+
+    ID2D1Bitmap* previousBitmap = nullptr;
+    uint64_t bitmapRank = 0;
+
+    for (uint32_t i = 0; i < m_sprites.size(); ++i)
+    {
+        auto const& sprite = m_sprites[i];
+
+        if (sprite.Bitmap != previousBitmap)
+        {
+            previousBitmap = sprite.Bitmap;
+            bitmapRank = std::lower_bound(bitmaps.begin(), bitmaps.end(), sprite.Bitmap) - bitmaps.begin();
+        }
+
+        uint64_t depth = MakeOrderedDepth(sprite.Depth);
+        uint64_t key;
+
+        switch (m_sortMode)
+        {
+        case CanvasSpriteSortMode::Bitmap:
+            key = bitmapRank;
+            break;
+
+        case CanvasSpriteSortMode::BackToFront:
+            key = (static_cast<uint64_t>(~static_cast<uint32_t>(depth)) << 32) | bitmapRank;
+            break;
+
+        case CanvasSpriteSortMode::FrontToBack:
+            key = (depth << 32) | bitmapRank;
+            break;
+
+        case CanvasSpriteSortMode::BitmapAndDepth:
+            key = (bitmapRank << 32) | static_cast<uint32_t>(~static_cast<uint32_t>(depth));
+            break;
+
+        default:
+            assert(false);
+            ThrowHR(E_UNEXPECTED);
+        }
+
+        keys.push_back(SpriteSortKey{ key, i });
+    }
+
+    RadixSort(keys);
+
+    //
+    // Reorder the sprites to match
+    //
+
+    std::vector<Sprite> sortedSprites;
+    sortedSprites.reserve(m_sprites.size());
+
+    for (auto const& key : keys)
+        sortedSprites.push_back(m_sprites[key.Index]);
+
+    m_sprites.swap(sortedSprites);
+}
+
+
 IFACEMETHODIMP CanvasSpriteBatch::Close()
 {
     return ExceptionBoundary([&]
@@ -517,14 +953,8 @@ IFACEMETHODIMP CanvasSpriteBatch::Close()
         // Sort the sprites
         //
         
-        if (m_sortMode == CanvasSpriteSortMode::Bitmap)
-        {
-            std::stable_sort(m_sprites.begin(), m_sprites.end(),
-                [] (auto const& a, auto const& b)
-                {
-                    return a.Bitmap.Get() < b.Bitmap.Get();
-                });
-        }
+        if (m_sortMode != CanvasSpriteSortMode::None)
+            SortSprites();
 
         //
         // Build up a D2D sprite batch from our sprites
@@ -609,6 +1039,35 @@ IFACEMETHODIMP CanvasSpriteBatch::Close()
 
         m_sprites.clear();
         m_sprites.shrink_to_fit();
+        m_bitmaps.clear();
+        m_bitmaps.shrink_to_fit();
+    });
+}
+
+
+IFACEMETHODIMP CanvasSpriteBatch::get_Depth(float* value)
+{
+    return ExceptionBoundary([&]
+    {
+        CheckInPointer(value);
+        EnsureNotClosed();
+
+        *value = m_depth;
+    });
+}
+
+
+IFACEMETHODIMP CanvasSpriteBatch::put_Depth(float value)
+{
+    return ExceptionBoundary([&]
+    {
+        EnsureNotClosed();
+
+        // NaN has no place in a sort order.
+        if (isnan(value))
+            ThrowHR(E_INVALIDARG);
+
+        m_depth = value;
     });
 }
 
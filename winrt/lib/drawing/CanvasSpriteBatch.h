@@ -27,43 +27,64 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         D2D1_BITMAP_INTERPOLATION_MODE m_interpolationMode;
         D2D1_SPRITE_OPTIONS m_spriteOptions;
         D2D1_UNIT_MODE m_unitMode;
+        float m_depth;
         
         struct Sprite
         {
-            ComPtr<ID2D1Bitmap> Bitmap;
+            ID2D1Bitmap* Bitmap;
             D2D1_RECT_F DestinationRect;
             D2D1_RECT_U SourceRect;
             D2D1_COLOR_F Color;
             D2D1_MATRIX_3X2_F Transform;
+            float Depth;
 
             Sprite(
-                ComPtr<ID2D1Bitmap>&& bitmap,
+                ID2D1Bitmap* bitmap,
                 D2D1_RECT_F const& destinationRect,
                 D2D1_RECT_U const& sourceRect,
                 Vector4 const& tint,
-                Matrix3x2 const& transform)
-                : Bitmap(std::move(bitmap))
+                Matrix3x2 const& transform,
+                float depth)
+                : Bitmap(bitmap)
                 , DestinationRect(destinationRect)
                 , SourceRect(sourceRect)
                 , Color(*ReinterpretAs<D2D1_COLOR_F const*>(&tint))
                 , Transform(*ReinterpretAs<D2D1_MATRIX_3X2_F const*>(&transform))
+                , Depth(depth)
             {
             }
 
             Sprite(
-                ComPtr<ID2D1Bitmap>&& bitmap,
+                ID2D1Bitmap* bitmap,
                 D2D1_RECT_F const& destinationRect,
                 D2D1_RECT_U const& sourceRect,
-                Vector4 const& tint)
-                : Sprite(std::move(bitmap), destinationRect, sourceRect, tint, Identity3x2())
+                Vector4 const& tint,
+                float depth)
+                : Sprite(bitmap, destinationRect, sourceRect, tint, Identity3x2(), depth)
             {
             }
         };
 
         std::vector<Sprite> m_sprites;
 
+        // Sprites only hold raw bitmap pointers; the references that keep
+        // those bitmaps alive are held here.  A bitmap that is already among
+        // the last RecentBitmapSearchCount entries isn't added again, so
+        // neither bulk submission nor sprites interleaving a few bitmaps pay
+        // an AddRef per sprite.
+        static const size_t RecentBitmapSearchCount = 8;
+        std::vector<ComPtr<ID2D1Bitmap>> m_bitmaps;
+
     public:
         static Vector4 const DEFAULT_TINT;
+
+        // Helpers shared with CanvasRetainedSpriteBatch, which converts sprite
+        // parameters in the same way.
+        static D2D1_RECT_U MakeFlippedSourceRect(CanvasSpriteFlip flip, D2D1_SIZE_U const& bitmapSizeInPixels);
+        static D2D1_RECT_U MakeFlippedSourceRect(CanvasSpriteFlip flip, float dpi, Rect const& sourceRect);
+        static D2D1_RECT_U MakeFlippedSourceRect(CanvasSpriteFlip flip, D2D1_RECT_U const& sourceRectInPixels);
+        static void ValidateInterpolationAndOptions(CanvasImageInterpolation interpolation, CanvasSpriteOptions options);
+        static void ValidateSortMode(CanvasSpriteSortMode sortMode);
         
         CanvasSpriteBatch(
             ComPtr<ID2D1DeviceContext3> const& deviceContext,
@@ -182,6 +203,32 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             Vector2 scale,
             CanvasSpriteFlip flip) override;
 
+        IFACEMETHODIMP DrawSpritesToRects(
+            ICanvasBitmap* bitmap,
+            uint32_t destRectCount,
+            Rect* destRects,
+            uint32_t sourceRectCount,
+            Rect* sourceRects,
+            uint32_t tintCount,
+            Vector4* tints,
+            uint32_t flipCount,
+            CanvasSpriteFlip* flips) override;
+
+        IFACEMETHODIMP DrawSpritesWithTransforms(
+            ICanvasBitmap* bitmap,
+            uint32_t transformCount,
+            Matrix3x2* transforms,
+            uint32_t sourceRectCount,
+            Rect* sourceRects,
+            uint32_t tintCount,
+            Vector4* tints,
+            uint32_t flipCount,
+            CanvasSpriteFlip* flips) override;
+
+        IFACEMETHODIMP get_Depth(float* value) override;
+
+        IFACEMETHODIMP put_Depth(float value) override;
+
         //
         // IClosable
         //
@@ -214,6 +261,22 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
     private:
         void EnsureNotClosed();
+
+        ID2D1Bitmap* RetainBitmap(ComPtr<ID2D1Bitmap>&& bitmap);
+
+        void SortSprites();
+
+        template<typename APPEND_FN>
+        void AddSprites(
+            ICanvasBitmap* bitmap,
+            uint32_t spriteCount,
+            uint32_t sourceRectCount,
+            Rect* sourceRects,
+            uint32_t tintCount,
+            Vector4* tints,
+            uint32_t flipCount,
+            CanvasSpriteFlip* flips,
+            APPEND_FN&& appendSprite);
     };
 
 } } } }
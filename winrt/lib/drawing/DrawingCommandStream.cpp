@@ -0,0 +1,631 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "DrawingCommandStream.h"
+
+using ABI::Windows::UI::Color;
+using ABI::Microsoft::Graphics::Canvas::SolidColorBrushCache;
+namespace Strings = ABI::Microsoft::Graphics::Canvas::Strings;
+
+
+// Layout of the data returned by Save.
+struct SavedStreamHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t CommandCount;
+    uint32_t ByteCount;
+};
+
+static const uint32_t SavedStreamMagic = 0x52443257;     // "W2DR"
+static const uint32_t SavedStreamVersion = 2;
+
+// Polylines are drawn with D2D's default miter joins, which have a miter
+// limit of 10 stroke widths, so can poke out up to 5 widths from a vertex.
+static const float PolylineStrokeAllowance = 5.0f;
+
+
+static D2D1_RECT_F MakeBounds(D2D1_POINT_2F const& point0, D2D1_POINT_2F const& point1)
+{
+    return D2D1_RECT_F{
+        std::min(point0.x, point1.x),
+        std::min(point0.y, point1.y),
+        std::max(point0.x, point1.x),
+        std::max(point0.y, point1.y) };
+}
+
+
+static D2D1_RECT_F Inflate(D2D1_RECT_F const& rect, float amount)
+{
+    return D2D1_RECT_F{ rect.left - amount, rect.top - amount, rect.right + amount, rect.bottom + amount };
+}
+
+
+static D2D1_RECT_F Union(D2D1_RECT_F const& a, D2D1_RECT_F const& b)
+{
+    return D2D1_RECT_F{
+        std::min(a.left, b.left),
+        std::min(a.top, b.top),
+        std::max(a.right, b.right),
+        std::max(a.bottom, b.bottom) };
+}
+
+
+// Written so that NaN bounds count as intersecting, ie. get drawn rather than culled.
+static bool Intersects(D2D1_RECT_F const& a, D2D1_RECT_F const& b)
+{
+    return !(a.right < b.left || a.left > b.right || a.bottom < b.top || a.top > b.bottom);
+}
+
+
+static D2D1_RECT_F TransformBounds(D2D1_RECT_F const& rect, D2D1_MATRIX_3X2_F const& transform)
+{
+    auto matrix = D2D1::Matrix3x2F::ReinterpretBaseType(&transform);
+
+    auto p0 = matrix->TransformPoint(D2D1::Point2F(rect.left,  rect.top));
+    auto p1 = matrix->TransformPoint(D2D1::Point2F(rect.right, rect.top));
+    auto p2 = matrix->TransformPoint(D2D1::Point2F(rect.left,  rect.bottom));
+    auto p3 = matrix->TransformPoint(D2D1::Point2F(rect.right, rect.bottom));
+
+    return Union(MakeBounds(p0, p1), MakeBounds(p2, p3));
+}
+
+
+static bool IsSameColor(Color const& a, Color const& b)
+{
+    return a.A == b.A && a.R == b.R && a.G == b.G && a.B == b.B;
+}
+
+
+DrawingCommandStream::DrawingCommandStream()
+    : m_bounds{}
+    , m_transform(D2D1::Matrix3x2F::Identity())
+    , m_transformOffset(NoTransform)
+    , m_transformChanged(false)
+{
+}
+
+
+void DrawingCommandStream::SetTransform(D2D1_MATRIX_3X2_F const& transform)
+{
+    m_transform = transform;
+    m_transformChanged = true;
+}
+
+
+template<typename T>
+T* DrawingCommandStream::AddCommand(CommandType type, size_t size)
+{
+    assert(size >= sizeof(T) && size % sizeof(float) == 0);
+
+    if (m_transformChanged)
+    {
+        m_transformChanged = false;
+
+        auto isIdentity = D2D1::Matrix3x2F::ReinterpretBaseType(&m_transform)->IsIdentity();
+
+        // Identity is the starting state, so only needs writing out to undo an earlier transform.
+        if (!isIdentity || m_transformOffset != NoTransform)
+        {
+            auto transformOffset = m_bytes.size();
+
+            auto command = AddCommand<TransformCommand>(CommandType::SetTransform, sizeof(TransformCommand));
+            command->Transform = m_transform;
+
+            m_transformOffset = static_cast<uint32_t>(transformOffset);
+        }
+
+        if (isIdentity)
+            m_transformOffset = NoTransform;
+    }
+
+    auto offset = m_bytes.size();
+
+    if (size > UINT32_MAX - offset)
+        ThrowHR(E_OUTOFMEMORY);
+
+    m_bytes.resize(offset + size);
+
+    auto header = reinterpret_cast<CommandHeader*>(m_bytes.data() + offset);
+
+    header->Type = type;
+    header->Reserved = 0;
+    header->Size = static_cast<uint32_t>(size);
+
+    // Transforms aren't drawing commands, so aren't indexed.
+    if (type != CommandType::SetTransform)
+    {
+        m_index.push_back(IndexEntry{ static_cast<uint32_t>(offset), m_transformOffset });
+    }
+
+    return reinterpret_cast<T*>(header);
+}
+
+
+void DrawingCommandStream::IndexBounds()
+{
+    auto& entry = m_index.back();
+
+    auto bounds = GetLocalBounds(GetCommand<PaintCommand>(entry.Offset));
+
+    if (entry.TransformOffset != NoTransform)
+        bounds = TransformBounds(bounds, GetCommand<TransformCommand>(entry.TransformOffset).Transform);
+
+    entry.Bounds = bounds;
+
+    m_bounds = (m_index.size() == 1) ? bounds : Union(m_bounds, bounds);
+}
+
+
+static D2D1_RECT_F GetEllipseBounds(D2D1_ELLIPSE const& ellipse)
+{
+    auto radiusX = fabs(ellipse.radiusX);
+    auto radiusY = fabs(ellipse.radiusY);
+
+    return D2D1_RECT_F{
+        ellipse.point.x - radiusX,
+        ellipse.point.y - radiusY,
+        ellipse.point.x + radiusX,
+        ellipse.point.y + radiusY };
+}
+
+
+D2D1_RECT_F DrawingCommandStream::GetLocalBounds(PaintCommand const& command)
+{
+    auto strokeWidth = fabs(command.StrokeWidth);
+
+    switch (command.Header.Type)
+    {
+    case CommandType::FillRectangle:
+    case CommandType::DrawRectangle:
+        {
+            auto& rect = static_cast<RectangleCommand const&>(command).Rect;
+            return Inflate(MakeBounds(D2D1::Point2F(rect.left, rect.top), D2D1::Point2F(rect.right, rect.bottom)), strokeWidth);
+        }
+
+    case CommandType::FillRoundedRectangle:
+    case CommandType::DrawRoundedRectangle:
+        {
+            auto& rect = static_cast<RoundedRectangleCommand const&>(command).RoundedRect.rect;
+            return Inflate(MakeBounds(D2D1::Point2F(rect.left, rect.top), D2D1::Point2F(rect.right, rect.bottom)), strokeWidth);
+        }
+
+    case CommandType::FillEllipse:
+    case CommandType::DrawEllipse:
+        return Inflate(GetEllipseBounds(static_cast<EllipseCommand const&>(command).Ellipse), strokeWidth);
+
+    case CommandType::DrawLine:
+        {
+            auto& line = static_cast<LineCommand const&>(command);
+            return Inflate(MakeBounds(line.Point0, line.Point1), strokeWidth);
+        }
+
+    case CommandType::DrawPolyline:
+        {
+            auto& polyline = static_cast<PolylineCommand const&>(command);
+            auto points = reinterpret_cast<D2D1_POINT_2F const*>(&polyline + 1);
+
+            auto bounds = MakeBounds(points[0], points[0]);
+
+            for (uint32_t i = 1; i < polyline.PointCount; i++)
+            {
+                bounds = Union(bounds, MakeBounds(points[i], points[i]));
+            }
+
+            return Inflate(bounds, strokeWidth * PolylineStrokeAllowance);
+        }
+
+    default:
+        assert(false);
+        ThrowHR(E_UNEXPECTED);
+    }
+}
+
+
+void DrawingCommandStream::FillRectangle(D2D1_RECT_F const& rect, Color const& color)
+{
+    auto command = AddCommand<RectangleCommand>(CommandType::FillRectangle, sizeof(RectangleCommand));
+
+    command->Color = color;
+    command->StrokeWidth = 0;
+    command->Rect = rect;
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::DrawRectangle(D2D1_RECT_F const& rect, Color const& color, float strokeWidth)
+{
+    auto command = AddCommand<RectangleCommand>(CommandType::DrawRectangle, sizeof(RectangleCommand));
+
+    command->Color = color;
+    command->StrokeWidth = strokeWidth;
+    command->Rect = rect;
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::FillRoundedRectangle(D2D1_ROUNDED_RECT const& roundedRect, Color const& color)
+{
+    auto command = AddCommand<RoundedRectangleCommand>(CommandType::FillRoundedRectangle, sizeof(RoundedRectangleCommand));
+
+    command->Color = color;
+    command->StrokeWidth = 0;
+    command->RoundedRect = roundedRect;
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::DrawRoundedRectangle(D2D1_ROUNDED_RECT const& roundedRect, Color const& color, float strokeWidth)
+{
+    auto command = AddCommand<RoundedRectangleCommand>(CommandType::DrawRoundedRectangle, sizeof(RoundedRectangleCommand));
+
+    command->Color = color;
+    command->StrokeWidth = strokeWidth;
+    command->RoundedRect = roundedRect;
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::FillEllipse(D2D1_ELLIPSE const& ellipse, Color const& color)
+{
+    auto command = AddCommand<EllipseCommand>(CommandType::FillEllipse, sizeof(EllipseCommand));
+
+    command->Color = color;
+    command->StrokeWidth = 0;
+    command->Ellipse = ellipse;
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::DrawEllipse(D2D1_ELLIPSE const& ellipse, Color const& color, float strokeWidth)
+{
+    auto command = AddCommand<EllipseCommand>(CommandType::DrawEllipse, sizeof(EllipseCommand));
+
+    command->Color = color;
+    command->StrokeWidth = strokeWidth;
+    command->Ellipse = ellipse;
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::DrawLine(D2D1_POINT_2F const& point0, D2D1_POINT_2F const& point1, Color const& color, float strokeWidth)
+{
+    auto command = AddCommand<LineCommand>(CommandType::DrawLine, sizeof(LineCommand));
+
+    command->Color = color;
+    command->StrokeWidth = strokeWidth;
+    command->Point0 = point0;
+    command->Point1 = point1;
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::DrawPolyline(uint32_t pointCount, D2D1_POINT_2F const* points, Color const& color, float strokeWidth)
+{
+    if (pointCount == 0)
+        return;
+
+    if (pointCount > (UINT32_MAX - sizeof(PolylineCommand)) / sizeof(D2D1_POINT_2F))
+        ThrowHR(E_OUTOFMEMORY);
+
+    auto size = sizeof(PolylineCommand) + pointCount * sizeof(D2D1_POINT_2F);
+
+    auto command = AddCommand<PolylineCommand>(CommandType::DrawPolyline, size);
+
+    command->Color = color;
+    command->StrokeWidth = strokeWidth;
+    command->PointCount = pointCount;
+
+    std::copy(points, points + pointCount, reinterpret_cast<D2D1_POINT_2F*>(command + 1));
+
+    IndexBounds();
+}
+
+
+void DrawingCommandStream::Clear()
+{
+    m_bytes.clear();
+    m_index.clear();
+    m_bounds = D2D1_RECT_F{};
+
+    m_transform = D2D1::Matrix3x2F::Identity();
+    m_transformOffset = NoTransform;
+    m_transformChanged = false;
+}
+
+
+void DrawingCommandStream::ShrinkToFit()
+{
+    m_bytes.shrink_to_fit();
+    m_index.shrink_to_fit();
+}
+
+
+D2D1_RECT_F DrawingCommandStream::GetCommandBounds(uint32_t index) const
+{
+    assert(index < m_index.size());
+
+    return m_index[index].Bounds;
+}
+
+
+DrawingCommandStream::DrawStatistics DrawingCommandStream::Draw(
+    ID2D1DeviceContext* deviceContext,
+    SolidColorBrushCache& brushes,
+    D2D1_RECT_F const* cullRect,
+    uint32_t firstCommand,
+    uint32_t commandCount) const
+{
+    if (firstCommand > m_index.size() || commandCount > m_index.size() - firstCommand)
+        ThrowHR(E_INVALIDARG);
+
+    DrawStatistics statistics{};
+
+    if (commandCount == 0)
+        return statistics;
+
+    // Recorded transforms are relative to whatever transform the caller has set.
+    D2D1::Matrix3x2F baseTransform;
+    deviceContext->GetTransform(&baseTransform);
+
+    auto currentTransform = NoTransform;
+
+    auto restoreTransformWarden = MakeScopeWarden([&]
+    {
+        if (currentTransform != NoTransform)
+            deviceContext->SetTransform(&baseTransform);
+    });
+
+    // The brush for the current run of same-colored commands.  Nothing else
+    // uses the cache during the replay, so this brush keeps its color.
+    ID2D1SolidColorBrush* brush = nullptr;
+    Color brushColor{};
+
+    for (auto i = firstCommand; i < firstCommand + commandCount; i++)
+    {
+        auto& entry = m_index[i];
+        auto& command = GetCommand<PaintCommand>(entry.Offset);
+
+        if (cullRect && !Intersects(entry.Bounds, *cullRect))
+        {
+            statistics.Culled++;
+            continue;
+        }
+
+        // Culled commands never touch the transform, so a run of them costs nothing.
+        if (entry.TransformOffset != currentTransform)
+        {
+            if (entry.TransformOffset == NoTransform)
+            {
+                deviceContext->SetTransform(&baseTransform);
+            }
+            else
+            {
+                auto& recordedTransform = GetCommand<TransformCommand>(entry.TransformOffset).Transform;
+                auto transform = *D2D1::Matrix3x2F::ReinterpretBaseType(&recordedTransform) * baseTransform;
+                deviceContext->SetTransform(&transform);
+            }
+
+            currentTransform = entry.TransformOffset;
+        }
+
+        // Culled commands don't break a run, since they never reach D2D.
+        if (!brush || !IsSameColor(command.Color, brushColor))
+        {
+            brush = brushes.GetBrush(deviceContext, command.Color);
+            brushColor = command.Color;
+
+            statistics.BrushChanges++;
+        }
+
+        DrawCommand(deviceContext, brush, command);
+
+        statistics.Drawn++;
+    }
+
+    return statistics;
+}
+
+
+void DrawingCommandStream::DrawCommand(
+    ID2D1DeviceContext* deviceContext,
+    ID2D1Brush* brush,
+    PaintCommand const& command)
+{
+    switch (command.Header.Type)
+    {
+    case CommandType::FillRectangle:
+        deviceContext->FillRectangle(&static_cast<RectangleCommand const&>(command).Rect, brush);
+        break;
+
+    case CommandType::DrawRectangle:
+        deviceContext->DrawRectangle(&static_cast<RectangleCommand const&>(command).Rect, brush, command.StrokeWidth);
+        break;
+
+    case CommandType::FillRoundedRectangle:
+        deviceContext->FillRoundedRectangle(&static_cast<RoundedRectangleCommand const&>(command).RoundedRect, brush);
+        break;
+
+    case CommandType::DrawRoundedRectangle:
+        deviceContext->DrawRoundedRectangle(&static_cast<RoundedRectangleCommand const&>(command).RoundedRect, brush, command.StrokeWidth);
+        break;
+
+    case CommandType::FillEllipse:
+        deviceContext->FillEllipse(&static_cast<EllipseCommand const&>(command).Ellipse, brush);
+        break;
+
+    case CommandType::DrawEllipse:
+        deviceContext->DrawEllipse(&static_cast<EllipseCommand const&>(command).Ellipse, brush, command.StrokeWidth);
+        break;
+
+    case CommandType::DrawLine:
+        {
+            auto& line = static_cast<LineCommand const&>(command);
+            deviceContext->DrawLine(line.Point0, line.Point1, brush, command.StrokeWidth);
+        }
+        break;
+
+    case CommandType::DrawPolyline:
+        {
+            auto& polyline = static_cast<PolylineCommand const&>(command);
+
+            ComPtr<ID2D1Factory> d2dFactory;
+            deviceContext->GetFactory(&d2dFactory);
+
+            ComPtr<ID2D1PathGeometry1> pathGeometry;
+            ThrowIfFailed(As<ID2D1Factory1>(d2dFactory)->CreatePathGeometry(&pathGeometry));
+
+            ComPtr<ID2D1GeometrySink> geometrySink;
+            ThrowIfFailed(pathGeometry->Open(&geometrySink));
+
+            auto points = reinterpret_cast<D2D1_POINT_2F const*>(&polyline + 1);
+
+            geometrySink->BeginFigure(points[0], D2D1_FIGURE_BEGIN_FILLED);
+            geometrySink->AddLines(points + 1, polyline.PointCount - 1);
+            geometrySink->EndFigure(D2D1_FIGURE_END_OPEN);
+
+            ThrowIfFailed(geometrySink->Close());
+
+            deviceContext->DrawGeometry(pathGeometry.Get(), brush, command.StrokeWidth);
+        }
+        break;
+
+    default:
+        assert(false);
+        ThrowHR(E_UNEXPECTED);
+    }
+}
+
+
+std::vector<uint8_t> DrawingCommandStream::Save() const
+{
+    SavedStreamHeader header{ SavedStreamMagic, SavedStreamVersion, GetCommandCount(), static_cast<uint32_t>(m_bytes.size()) };
+
+    std::vector<uint8_t> result(sizeof(header) + m_bytes.size());
+
+    memcpy(result.data(), &header, sizeof(header));
+    std::copy(m_bytes.begin(), m_bytes.end(), result.begin() + sizeof(header));
+
+    return result;
+}
+
+
+void DrawingCommandStream::Load(uint8_t const* bytes, size_t byteCount)
+{
+    Clear();
+
+    auto clearOnFailureWarden = MakeScopeWarden([&] { Clear(); });
+
+    SavedStreamHeader header;
+
+    if (!bytes || byteCount < sizeof(header))
+        ThrowHR(E_INVALIDARG, Strings::DrawingRecordingInvalidData);
+
+    memcpy(&header, bytes, sizeof(header));
+
+    if (header.Magic != SavedStreamMagic ||
+        header.Version != SavedStreamVersion ||
+        header.ByteCount != byteCount - sizeof(header))
+    {
+        ThrowHR(E_INVALIDARG, Strings::DrawingRecordingInvalidData);
+    }
+
+    LoadCommands(bytes + sizeof(header), header.ByteCount, header.CommandCount);
+
+    clearOnFailureWarden.Dismiss();
+}
+
+
+// Copies and indexes the commands, checking as we go that every one is
+// well formed, since the replay code trusts what it finds in m_bytes.
+// Bounds are recomputed from each command's data and transform.
+void DrawingCommandStream::LoadCommands(uint8_t const* bytes, size_t byteCount, uint32_t expectedCommandCount)
+{
+    m_bytes.assign(bytes, bytes + byteCount);
+    m_index.reserve(expectedCommandCount);
+
+    size_t offset = 0;
+
+    while (offset < m_bytes.size())
+    {
+        if (m_bytes.size() - offset < sizeof(CommandHeader))
+            ThrowHR(E_INVALIDARG, Strings::DrawingRecordingInvalidData);
+
+        auto& header = GetCommand<CommandHeader>(static_cast<uint32_t>(offset));
+
+        auto fixedSize = GetFixedSize(header.Type);
+
+        if (!fixedSize ||
+            header.Size < fixedSize ||
+            header.Size % sizeof(float) != 0 ||
+            header.Size > m_bytes.size() - offset)
+        {
+            ThrowHR(E_INVALIDARG, Strings::DrawingRecordingInvalidData);
+        }
+
+        if (header.Type == CommandType::DrawPolyline)
+        {
+            auto& polyline = GetCommand<PolylineCommand>(static_cast<uint32_t>(offset));
+
+            if (polyline.PointCount == 0 ||
+                (header.Size - fixedSize) / sizeof(D2D1_POINT_2F) != polyline.PointCount ||
+                (header.Size - fixedSize) % sizeof(D2D1_POINT_2F) != 0)
+            {
+                ThrowHR(E_INVALIDARG, Strings::DrawingRecordingInvalidData);
+            }
+        }
+        else if (header.Size != fixedSize)
+        {
+            ThrowHR(E_INVALIDARG, Strings::DrawingRecordingInvalidData);
+        }
+
+        if (header.Type == CommandType::SetTransform)
+        {
+            m_transform = GetCommand<TransformCommand>(static_cast<uint32_t>(offset)).Transform;
+
+            if (D2D1::Matrix3x2F::ReinterpretBaseType(&m_transform)->IsIdentity())
+                m_transformOffset = NoTransform;
+            else
+                m_transformOffset = static_cast<uint32_t>(offset);
+        }
+        else
+        {
+            m_index.push_back(IndexEntry{ static_cast<uint32_t>(offset), m_transformOffset });
+
+            IndexBounds();
+        }
+
+        offset += header.Size;
+    }
+
+    if (m_index.size() != expectedCommandCount)
+        ThrowHR(E_INVALIDARG, Strings::DrawingRecordingInvalidData);
+}
+
+
+size_t DrawingCommandStream::GetFixedSize(CommandType type)
+{
+    switch (type)
+    {
+    case CommandType::SetTransform:         return sizeof(TransformCommand);
+    case CommandType::FillRectangle:        return sizeof(RectangleCommand);
+    case CommandType::DrawRectangle:        return sizeof(RectangleCommand);
+    case CommandType::FillRoundedRectangle: return sizeof(RoundedRectangleCommand);
+    case CommandType::DrawRoundedRectangle: return sizeof(RoundedRectangleCommand);
+    case CommandType::FillEllipse:          return sizeof(EllipseCommand);
+    case CommandType::DrawEllipse:          return sizeof(EllipseCommand);
+    case CommandType::DrawLine:             return sizeof(LineCommand);
+    case CommandType::DrawPolyline:         return sizeof(PolylineCommand);
+    default:                                return 0;
+    }
+}
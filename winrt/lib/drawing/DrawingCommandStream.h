@@ -0,0 +1,236 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include "SolidColorBrushCache.h"
+
+//
+// A recorded sequence of drawing commands, stored as a compact binary stream
+// that can be replayed onto any device context, in whole or in part.
+//
+// Unlike an ID2D1CommandList, every command has its own bounds, so a
+// replay can skip the commands that fall outside the area being drawn (eg.
+// off the edge of the target, or outside a dirty region) without handing
+// them to D2D.  The bounds are in the coordinate space of the recording
+// (ie. after the recorded transform has been applied), and include an
+// allowance for the stroke width.
+//
+// Commands are appended to a single buffer that only ever grows, so
+// recording does no per-command heap allocation, and Clear keeps the
+// buffer's capacity for the next frame.  Each command starts with a
+// CommandHeader giving its type and size; a side index of offsets gives
+// constant time access to command N for partial replay.  Transform changes
+// are stored in the stream as well, but are not counted as commands: each
+// index entry instead records which transform applies to it.
+//
+// Bounds live in the index rather than the stream, and are always computed
+// from a command's own data and transform, both when it is recorded and
+// when saved data is loaded.  Culling therefore never relies on bounds that
+// came from outside, which could otherwise hide commands that should be
+// drawn.
+//
+// Commands only refer to plain data (colors rather than brushes), so the
+// stream is independent of any device and can be saved to bytes and loaded
+// back again.  This is why only a handful of solid color primitives can be
+// recorded, rather than everything ICanvasDrawingSession offers: brushes,
+// images, effects, text and layers are device resources, or have bounds
+// that only D2D can work out, so could be neither culled nor saved.
+//
+// Replay coalesces runs of consecutive commands that share a color: the
+// brush is looked up once at the start of the run and handed to D2D for
+// every primitive in it.  D2D batches consecutive primitives that use the
+// same brush, so a scene recorded in same-colored runs reaches the GPU as
+// one batch per run rather than one per command.
+//
+class DrawingCommandStream
+{
+public:
+    struct DrawStatistics
+    {
+        uint32_t Drawn;
+        uint32_t Culled;
+
+        // How many times the brush changed, ie. the number of same-colored
+        // runs among the commands that were drawn.
+        uint32_t BrushChanges;
+    };
+
+private:
+    enum class CommandType : uint16_t
+    {
+        SetTransform,
+        FillRectangle,
+        DrawRectangle,
+        FillRoundedRectangle,
+        DrawRoundedRectangle,
+        FillEllipse,
+        DrawEllipse,
+        DrawLine,
+        DrawPolyline,
+    };
+
+    struct CommandHeader
+    {
+        CommandType Type;
+        uint16_t Reserved;
+        uint32_t Size;              // Including this header.
+    };
+
+    struct TransformCommand
+    {
+        CommandHeader Header;
+        D2D1_MATRIX_3X2_F Transform;
+    };
+
+    // Common to all the drawing commands.  Fills have a stroke width of zero.
+    struct PaintCommand
+    {
+        CommandHeader Header;
+        ABI::Windows::UI::Color Color;
+        float StrokeWidth;
+    };
+
+    struct RectangleCommand : PaintCommand
+    {
+        D2D1_RECT_F Rect;
+    };
+
+    struct RoundedRectangleCommand : PaintCommand
+    {
+        D2D1_ROUNDED_RECT RoundedRect;
+    };
+
+    struct EllipseCommand : PaintCommand
+    {
+        D2D1_ELLIPSE Ellipse;
+    };
+
+    struct LineCommand : PaintCommand
+    {
+        D2D1_POINT_2F Point0;
+        D2D1_POINT_2F Point1;
+    };
+
+    // Followed by PointCount D2D1_POINT_2Fs.
+    struct PolylineCommand : PaintCommand
+    {
+        uint32_t PointCount;
+    };
+
+    struct IndexEntry
+    {
+        uint32_t Offset;
+        uint32_t TransformOffset;   // NoTransform for identity.
+        D2D1_RECT_F Bounds;
+    };
+
+    static const uint32_t NoTransform = UINT32_MAX;
+
+    std::vector<uint8_t> m_bytes;
+    std::vector<IndexEntry> m_index;
+    D2D1_RECT_F m_bounds;
+
+    // The transform applied to commands recorded from now on, and the one
+    // most recently written to the stream (which may differ until the next
+    // command is recorded, so that repeated changes cost nothing).
+    D2D1_MATRIX_3X2_F m_transform;
+    uint32_t m_transformOffset;
+    bool m_transformChanged;
+
+public:
+    DrawingCommandStream();
+
+    DrawingCommandStream(DrawingCommandStream const&) = delete;
+    DrawingCommandStream& operator=(DrawingCommandStream const&) = delete;
+
+    //
+    // Recording
+    //
+
+    void SetTransform(D2D1_MATRIX_3X2_F const& transform);
+    D2D1_MATRIX_3X2_F const& GetTransform() const { return m_transform; }
+
+    void FillRectangle(D2D1_RECT_F const& rect, ABI::Windows::UI::Color const& color);
+    void DrawRectangle(D2D1_RECT_F const& rect, ABI::Windows::UI::Color const& color, float strokeWidth);
+
+    void FillRoundedRectangle(D2D1_ROUNDED_RECT const& roundedRect, ABI::Windows::UI::Color const& color);
+    void DrawRoundedRectangle(D2D1_ROUNDED_RECT const& roundedRect, ABI::Windows::UI::Color const& color, float strokeWidth);
+
+    void FillEllipse(D2D1_ELLIPSE const& ellipse, ABI::Windows::UI::Color const& color);
+    void DrawEllipse(D2D1_ELLIPSE const& ellipse, ABI::Windows::UI::Color const& color, float strokeWidth);
+
+    void DrawLine(D2D1_POINT_2F const& point0, D2D1_POINT_2F const& point1, ABI::Windows::UI::Color const& color, float strokeWidth);
+
+    void DrawPolyline(uint32_t pointCount, D2D1_POINT_2F const* points, ABI::Windows::UI::Color const& color, float strokeWidth);
+
+    // Removes every command, and resets the transform to identity.
+    void Clear();
+
+    // Frees the memory Clear keeps around for reuse.
+    void ShrinkToFit();
+
+    //
+    // Queries
+    //
+
+    uint32_t GetCommandCount() const { return static_cast<uint32_t>(m_index.size()); }
+
+    D2D1_RECT_F GetCommandBounds(uint32_t index) const;
+
+    // Union of the bounds of every command (empty if there are none).
+    D2D1_RECT_F GetBounds() const { return m_bounds; }
+
+    size_t GetByteCount() const { return m_bytes.size(); }
+
+    //
+    // Replay
+    //
+
+    // Draws commands [firstCommand, firstCommand + commandCount), on top of
+    // the device context's current transform, skipping any whose bounds don't
+    // intersect cullRect (if specified).  cullRect is in recording coordinates.
+    DrawStatistics Draw(
+        ID2D1DeviceContext* deviceContext,
+        ABI::Microsoft::Graphics::Canvas::SolidColorBrushCache& brushes,
+        D2D1_RECT_F const* cullRect,
+        uint32_t firstCommand,
+        uint32_t commandCount) const;
+
+    //
+    // Serialization
+    //
+
+    std::vector<uint8_t> Save() const;
+
+    // Replaces the contents of this stream.  Throws E_INVALIDARG if the data
+    // is not a valid saved stream, in which case this stream is left empty.
+    void Load(uint8_t const* bytes, size_t byteCount);
+
+private:
+    // Appends a command, and indexes it unless it is a transform.  The
+    // caller fills in the rest of the command, then calls IndexBounds.
+    template<typename T>
+    T* AddCommand(CommandType type, size_t size);
+
+    // Computes the bounds of the most recently indexed command.
+    void IndexBounds();
+
+    static D2D1_RECT_F GetLocalBounds(PaintCommand const& command);
+
+    template<typename T>
+    T const& GetCommand(uint32_t offset) const
+    {
+        return *reinterpret_cast<T const*>(m_bytes.data() + offset);
+    }
+
+    void LoadCommands(uint8_t const* bytes, size_t byteCount, uint32_t expectedCommandCount);
+
+    static size_t GetFixedSize(CommandType type);
+
+    static void DrawCommand(
+        ID2D1DeviceContext* deviceContext,
+        ID2D1Brush* brush,
+        PaintCommand const& command);
+};
@@ -0,0 +1,214 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "FrameArena.h"
+
+
+FrameArena::FrameArena(size_t blockSize)
+    : m_blockSize(std::max<size_t>(blockSize, 1))
+    , m_usedInLastBlock(0)
+    , m_arenaBytes(0)
+    , m_heapBytes(0)
+    , m_heapAllocationCount(0)
+{
+}
+
+
+void* FrameArena::Allocate(size_t byteCount, size_t alignment)
+{
+    // Blocks come from operator new, so are aligned for any fundamental type.
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    assert(alignment <= alignof(std::max_align_t));
+
+    if (byteCount == 0)
+        return nullptr;
+
+    if (!m_blocks.empty())
+    {
+        auto& block = m_blocks.back();
+        auto offset = (m_usedInLastBlock + alignment - 1) & ~(alignment - 1);
+
+        if (offset <= block.Size && byteCount <= block.Size - offset)
+        {
+            m_usedInLastBlock = offset + byteCount;
+            m_arenaBytes += byteCount;
+
+            return block.Memory.get() + offset;
+        }
+    }
+
+    auto blockSize = std::max(byteCount, m_blockSize);
+
+    Block newBlock{ std::unique_ptr<uint8_t[]>(new uint8_t[blockSize]), blockSize };
+    auto memory = newBlock.Memory.get();
+
+    m_heapBytes += byteCount;
+    m_heapAllocationCount++;
+
+    if (byteCount > m_blockSize && !m_blocks.empty())
+    {
+        // Oversized allocations get a block to themselves, slotted in before
+        // the current block so that the space left in that can still be used.
+        m_blocks.insert(m_blocks.end() - 1, std::move(newBlock));
+    }
+    else
+    {
+        m_blocks.push_back(std::move(newBlock));
+        m_usedInLastBlock = byteCount;
+    }
+
+    return memory;
+}
+
+
+void FrameArena::Rewind()
+{
+    if (m_blocks.size() > 1)
+    {
+        auto largest = std::max_element(m_blocks.begin(), m_blocks.end(),
+            [](Block const& a, Block const& b) { return a.Size < b.Size; });
+
+        std::swap(*largest, m_blocks.front());
+
+        m_blocks.erase(m_blocks.begin() + 1, m_blocks.end());
+    }
+
+    m_usedInLastBlock = 0;
+}
+
+
+void FrameArena::Clear()
+{
+    m_blocks.clear();
+    m_blocks.shrink_to_fit();
+
+    m_usedInLastBlock = 0;
+}
+
+
+FrameArena::Statistics FrameArena::GetStatistics() const
+{
+    size_t reservedBytes = 0;
+
+    for (auto& block : m_blocks)
+    {
+        reservedBytes += block.Size;
+    }
+
+    return Statistics{ m_arenaBytes, m_heapBytes, m_heapAllocationCount, reservedBytes };
+}
+
+
+void FrameArena::ResetStatistics()
+{
+    m_arenaBytes = 0;
+    m_heapBytes = 0;
+    m_heapAllocationCount = 0;
+}
+
+
+//
+// FrameArenaPool implementation
+//
+
+
+FrameArenaPool::FrameArenaPool(bool reportStatistics)
+    : m_closed(false)
+    , m_reportStatistics(reportStatistics)
+{
+}
+
+
+FrameArenaLease FrameArenaPool::TakeLease()
+{
+    std::unique_ptr<FrameArena> arena;
+
+    {
+        Lock lock(m_mutex);
+
+        if (m_closed)
+            ThrowHR(RO_E_CLOSED);
+
+        if (!m_idleArenas.empty())
+        {
+            arena = std::move(m_idleArenas.back());
+            m_idleArenas.pop_back();
+        }
+    }
+
+    if (arena)
+        arena->ResetStatistics();
+    else
+        arena = std::make_unique<FrameArena>();
+
+    return FrameArenaLease(this, std::move(arena));
+}
+
+
+// Called as leases are returned, which can be from a destructor, so this
+// formats into a fixed buffer rather than anything that might throw.
+static void ReportStatistics(FrameArena::Statistics const& stats)
+{
+    wchar_t message[256];
+
+    swprintf_s(message, L"Win2D: drawing session scratch memory: %llu bytes reused, %llu bytes in %u new heap blocks, %Iu bytes kept for the next session\n",
+        stats.ArenaBytes,
+        stats.HeapBytes,
+        stats.HeapAllocationCount,
+        stats.ReservedBytes);
+
+    OutputDebugString(message);
+}
+
+
+void FrameArenaPool::ReturnLease(std::unique_ptr<FrameArena>&& arena)
+{
+    if (!arena)
+        return;
+
+    arena->Rewind();
+
+    if (m_reportStatistics)
+        ReportStatistics(arena->GetStatistics());
+
+    Lock lock(m_mutex);
+
+    //
+    // If the pool has been closed we just discard the arena
+    //
+    if (m_closed)
+        return;
+
+    static auto maxPoolSize = std::max(std::thread::hardware_concurrency(), 1U);
+
+    if (m_idleArenas.size() < maxPoolSize)
+        m_idleArenas.emplace_back(std::move(arena));
+}
+
+
+void FrameArenaPool::Trim()
+{
+    Lock lock(m_mutex);
+
+    m_idleArenas.clear();
+}
+
+
+size_t FrameArenaPool::GetIdleArenaCount()
+{
+    Lock lock(m_mutex);
+
+    return m_idleArenas.size();
+}
+
+
+void FrameArenaPool::Close()
+{
+    Lock lock(m_mutex);
+
+    m_idleArenas.clear();
+    m_closed = true;
+}
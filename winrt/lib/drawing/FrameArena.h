@@ -0,0 +1,214 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+//
+// Bump allocator for the short-lived scratch memory used by a drawing
+// session.
+//
+// Allocating is just a pointer increment within the current block, and
+// nothing is ever freed individually: Rewind makes the memory available
+// again, and Clear gives everything back to the heap.  This keeps per-call
+// temporaries in the drawing session off the process heap, which is shared
+// (and locked) with every other thread in the app.  Once the largest block
+// is big enough for a call's temporaries, later calls don't touch the heap
+// at all.  Arenas are leased from a FrameArenaPool owned by the device, so
+// that the blocks outlive the drawing session that grew them.
+//
+// Only trivially destructible types can be allocated, since destructors are
+// never run.  Memory is aligned for any fundamental type.
+//
+class FrameArena
+{
+public:
+    static const size_t DefaultBlockSize = 64 * 1024;
+
+    struct Statistics
+    {
+        // Bytes handed out from blocks the arena already owned.
+        uint64_t ArenaBytes;
+
+        // Bytes handed out from blocks that had to be allocated for them.
+        uint64_t HeapBytes;
+
+        uint32_t HeapAllocationCount;
+        size_t ReservedBytes;
+    };
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> Memory;
+        size_t Size;
+    };
+
+    size_t m_blockSize;
+
+    // Allocations are made from the last block.
+    std::vector<Block> m_blocks;
+    size_t m_usedInLastBlock;
+
+    uint64_t m_arenaBytes;
+    uint64_t m_heapBytes;
+    uint32_t m_heapAllocationCount;
+
+public:
+    explicit FrameArena(size_t blockSize = DefaultBlockSize);
+
+    FrameArena(FrameArena const&) = delete;
+    FrameArena& operator=(FrameArena const&) = delete;
+
+    // Returns null if byteCount is zero.
+    void* Allocate(size_t byteCount, size_t alignment);
+
+    template<typename T>
+    T* Allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+
+        if (count > SIZE_MAX / sizeof(T))
+            ThrowHR(E_OUTOFMEMORY);
+
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Invalidates everything allocated so far, keeping the largest block for
+    // reuse.
+    void Rewind();
+
+    // Releases all memory.  Statistics are kept.
+    void Clear();
+
+    Statistics GetStatistics() const;
+
+    // Zeroes the byte and allocation counts.  ReservedBytes is unaffected,
+    // since it reflects the blocks currently held.
+    void ResetStatistics();
+};
+
+
+class FrameArenaLease;
+
+//
+// Keeps the arenas of finished drawing sessions, so that the next session on
+// the same device starts with blocks that are already big enough for its
+// temporaries instead of reallocating them every frame.
+//
+// Returned arenas are rewound, so each keeps only its largest block.  As with
+// DeviceContextPool, at most one idle arena per CPU is kept.
+//
+class FrameArenaPool
+{
+    std::mutex m_mutex;
+    bool m_closed;
+    bool m_reportStatistics;
+    std::vector<std::unique_ptr<FrameArena>> m_idleArenas;
+
+public:
+    // When reportStatistics is set, the counts for each lease are written to
+    // the debugger output as it is returned.
+    explicit FrameArenaPool(bool reportStatistics = false);
+
+    FrameArenaPool(FrameArenaPool const&) = delete;
+    FrameArenaPool& operator=(FrameArenaPool const&) = delete;
+
+    // The leased arena's statistics start from zero.
+    FrameArenaLease TakeLease();
+
+    // Releases all idle arenas.  Arenas that are currently leased out are
+    // still returned to the pool as normal.
+    void Trim();
+
+    size_t GetIdleArenaCount();
+
+    void Close();
+
+private:
+    void ReturnLease(std::unique_ptr<FrameArena>&& arena);
+
+    friend class FrameArenaLease;
+};
+
+
+class FrameArenaLease
+{
+    FrameArenaPool* m_owner;
+    std::unique_ptr<FrameArena> m_arena;
+
+public:
+    FrameArenaLease()
+        : m_owner(nullptr)
+    {
+    }
+
+    // An unpooled lease, whose arena is simply destroyed when it is returned.
+    explicit FrameArenaLease(std::unique_ptr<FrameArena>&& arena)
+        : m_owner(nullptr)
+        , m_arena(std::move(arena))
+    {
+    }
+
+    FrameArenaLease(FrameArenaLease&& other)
+        : m_owner(other.m_owner)
+        , m_arena(std::move(other.m_arena))
+    {
+        other.m_owner = nullptr;
+    }
+
+    FrameArenaLease& operator=(FrameArenaLease&& other)
+    {
+        ReturnLease();
+        m_owner = other.m_owner;
+        m_arena = std::move(other.m_arena);
+        other.m_owner = nullptr;
+        return *this;
+    }
+
+    FrameArenaLease(FrameArenaLease const&) = delete;
+    FrameArenaLease& operator=(FrameArenaLease const&) = delete;
+
+    ~FrameArenaLease()
+    {
+        ReturnLease();
+    }
+
+    FrameArena* Get()
+    {
+        return m_arena.get();
+    }
+
+    FrameArena* operator->()
+    {
+        return m_arena.get();
+    }
+
+    explicit operator bool() const
+    {
+        return static_cast<bool>(m_arena);
+    }
+
+private:
+    FrameArenaLease(FrameArenaPool* owner, std::unique_ptr<FrameArena>&& arena)
+        : m_owner(owner)
+        , m_arena(std::move(arena))
+    {
+        assert(m_owner);
+    }
+
+    void ReturnLease()
+    {
+        if (m_owner)
+        {
+            m_owner->ReturnLease(std::move(m_arena));
+            m_owner = nullptr;
+        }
+        else
+        {
+            m_arena.reset();
+        }
+    }
+
+    friend class FrameArenaPool;
+};
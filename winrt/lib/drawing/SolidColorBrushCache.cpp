@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "SolidColorBrushCache.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    using ABI::Windows::UI::Color;
+
+    SolidColorBrushCache::SolidColorBrushCache(size_t capacity)
+        : m_capacity(std::max<size_t>(capacity, 1))
+        , m_hits(0)
+        , m_misses(0)
+        , m_recolors(0)
+    {
+        m_entries.reserve(m_capacity);
+    }
+
+
+    ID2D1SolidColorBrush* SolidColorBrushCache::GetBrush(ID2D1DeviceContext* deviceContext, Color const& color)
+    {
+        auto key = GetKey(color);
+
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            if (m_entries[i].Key == key)
+            {
+                m_hits++;
+
+                // Move to the front, preserving the order of everything more recent.
+                if (i > 0)
+                    std::rotate(m_entries.begin(), m_entries.begin() + i, m_entries.begin() + i + 1);
+
+                return m_entries.front().Brush.Get();
+            }
+        }
+
+        m_misses++;
+
+        if (m_entries.size() < m_capacity)
+        {
+            Entry entry{ key };
+            ThrowIfFailed(deviceContext->CreateSolidColorBrush(ToD2DColor(color), &entry.Brush));
+
+            m_entries.insert(m_entries.begin(), std::move(entry));
+        }
+        else
+        {
+            // Full, so recycle the least recently used brush.
+            auto& oldest = m_entries.back();
+
+            oldest.Key = key;
+            oldest.Brush->SetColor(ToD2DColor(color));
+
+            m_recolors++;
+
+            std::rotate(m_entries.begin(), m_entries.end() - 1, m_entries.end());
+        }
+
+        return m_entries.front().Brush.Get();
+    }
+
+
+    void SolidColorBrushCache::Clear()
+    {
+        m_entries.clear();
+    }
+
+
+    SolidColorBrushCache::Statistics SolidColorBrushCache::GetStatistics() const
+    {
+        return Statistics{ m_hits, m_misses, m_recolors, m_entries.size() };
+    }
+}}}}
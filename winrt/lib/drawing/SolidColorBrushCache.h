@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // Hands out solid color brushes for the drawing session's Color overloads.
+    //
+    // A single brush that is recolored for every primitive means D2D sees a
+    // brush change whenever colors are interleaved, which stops it batching
+    // consecutive primitives.  Instead we keep one brush per recently used
+    // color, so repeated colors reuse exactly the same brush and never call
+    // SetColor.  Once the cache is full, the least recently used brush is
+    // recolored rather than creating another.
+    //
+    // The cache is small, so entries are kept in a vector in most recently used
+    // order and searched linearly, which is cheaper than hashing for a handful
+    // of colors and keeps the common case (same color as last time) to a
+    // single comparison.
+    //
+    class SolidColorBrushCache
+    {
+    public:
+        static const size_t DefaultCapacity = 16;
+
+        struct Statistics
+        {
+            uint64_t Hits;
+            uint64_t Misses;
+            uint64_t Recolors;
+            size_t BrushCount;
+        };
+
+    private:
+        struct Entry
+        {
+            uint32_t Key;
+            ComPtr<ID2D1SolidColorBrush> Brush;
+        };
+
+        size_t m_capacity;
+
+        // Most recently used at the front.
+        std::vector<Entry> m_entries;
+
+        uint64_t m_hits;
+        uint64_t m_misses;
+        uint64_t m_recolors;
+
+    public:
+        explicit SolidColorBrushCache(size_t capacity = DefaultCapacity);
+
+        SolidColorBrushCache(SolidColorBrushCache const&) = delete;
+        SolidColorBrushCache& operator=(SolidColorBrushCache const&) = delete;
+
+        // The returned brush stays valid, and keeps its color, until another
+        // capacity's worth of different colors have been requested.
+        ID2D1SolidColorBrush* GetBrush(ID2D1DeviceContext* deviceContext, ABI::Windows::UI::Color const& color);
+
+        void Clear();
+
+        Statistics GetStatistics() const;
+
+    private:
+        static uint32_t GetKey(ABI::Windows::UI::Color const& color)
+        {
+            return (static_cast<uint32_t>(color.A) << 24) |
+                   (static_cast<uint32_t>(color.R) << 16) |
+                   (static_cast<uint32_t>(color.G) << 8) |
+                   (static_cast<uint32_t>(color.B));
+        }
+    };
+}}}}
@@ -0,0 +1,183 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "StagingBitmapPool.h"
+
+
+//
+// StagingBitmapPool implementation
+//
+
+
+StagingBitmapPool::StagingBitmapPool(DeviceContextPool* deviceContextPool, size_t budgetInBytes)
+    : m_deviceContextPool(deviceContextPool)
+    , m_budgetInBytes(budgetInBytes)
+    , m_closed(false)
+    , m_idleBytes(0)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+
+//
+// Small sizes are rounded up to a power of two, so that eg. a stream of
+// differently sized hit-test readbacks can all share a handful of bitmaps.
+// Beyond that, rounding to powers of two would waste too much memory, so
+// larger sizes are rounded up to a multiple of the largest small size.
+//
+uint32_t StagingBitmapPool::GetBucketSize(uint32_t size)
+{
+    const uint32_t smallSizeLimit = 256;
+
+    if (size > smallSizeLimit)
+        return (size + smallSizeLimit - 1) / smallSizeLimit * smallSizeLimit;
+
+    uint32_t bucketSize = 4;
+
+    while (bucketSize < size)
+        bucketSize *= 2;
+
+    return bucketSize;
+}
+
+
+static size_t GetSizeInBytes(D2D1_SIZE_U const& size, D2D1_PIXEL_FORMAT const& format)
+{
+    auto blockSize = GetBlockSize(format.format);
+
+    return static_cast<size_t>(size.width / blockSize) * (size.height / blockSize) * GetBytesPerBlock(format.format);
+}
+
+
+StagingBitmapLease StagingBitmapPool::TakeLease(D2D1_SIZE_U const& size, D2D1_PIXEL_FORMAT const& format)
+{
+    auto deviceContext = m_deviceContextPool->TakeLease();
+
+    auto maximumSize = deviceContext->GetMaximumBitmapSize();
+
+    //
+    // If rounding up would take us past the maximum bitmap size, fall back to
+    // the exact size.  Such bitmaps still go through the pool, but will only
+    // get reused by requests for exactly the same size.
+    //
+    Key key{ { GetBucketSize(size.width), GetBucketSize(size.height) }, format };
+
+    if (key.Size.width > maximumSize || key.Size.height > maximumSize)
+        key.Size = size;
+
+    {
+        Lock lock(m_mutex);
+
+        if (m_closed)
+            ThrowHR(RO_E_CLOSED);
+
+        auto it = std::find_if(m_idleBitmaps.rbegin(), m_idleBitmaps.rend(),
+            [&](Entry const& entry) { return entry.Bucket == key; });
+
+        if (it != m_idleBitmaps.rend())
+        {
+            auto entry = std::move(*it);
+            m_idleBitmaps.erase(std::next(it).base());
+            m_idleBytes -= entry.SizeInBytes;
+            m_hits++;
+
+            return StagingBitmapLease(this, std::move(entry));
+        }
+
+        m_misses++;
+    }
+
+    auto bitmapProperties = D2D1::BitmapProperties1(
+        D2D1_BITMAP_OPTIONS_CPU_READ | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+        format);
+
+    Entry entry{ key, GetSizeInBytes(key.Size, format) };
+
+    ThrowIfFailed(deviceContext->CreateBitmap(
+        key.Size,
+        nullptr,
+        0,
+        &bitmapProperties,
+        &entry.Bitmap));
+
+    return StagingBitmapLease(this, std::move(entry));
+}
+
+
+void StagingBitmapPool::ReturnLease(Entry&& entry)
+{
+    if (!entry.Bitmap)
+        return;
+
+    Lock lock(m_mutex);
+
+    //
+    // If the pool has been closed we just discard the bitmap
+    //
+    if (m_closed)
+        return;
+
+    m_idleBytes += entry.SizeInBytes;
+    m_idleBitmaps.emplace_back(std::move(entry));
+
+    TrimToBudget();
+}
+
+
+void StagingBitmapPool::TrimToBudget()
+{
+    // The most recently returned bitmap is kept even when it is larger than
+    // the whole budget, so that repeated large readbacks (eg. 4K RGBA16F
+    // frames) are pooled too.  A budget of zero disables pooling entirely.
+    size_t keepCount = (m_budgetInBytes > 0 && !m_idleBitmaps.empty()) ? 1 : 0;
+    size_t trimCount = 0;
+
+    while (m_idleBytes > m_budgetInBytes && trimCount < m_idleBitmaps.size() - keepCount)
+    {
+        m_idleBytes -= m_idleBitmaps[trimCount].SizeInBytes;
+        trimCount++;
+    }
+
+    m_idleBitmaps.erase(m_idleBitmaps.begin(), m_idleBitmaps.begin() + trimCount);
+}
+
+
+void StagingBitmapPool::Trim()
+{
+    Lock lock(m_mutex);
+
+    m_idleBitmaps.clear();
+    m_idleBytes = 0;
+}
+
+
+void StagingBitmapPool::SetBudget(size_t budgetInBytes)
+{
+    Lock lock(m_mutex);
+
+    m_budgetInBytes = budgetInBytes;
+
+    TrimToBudget();
+}
+
+
+StagingBitmapPool::Statistics StagingBitmapPool::GetStatistics()
+{
+    Lock lock(m_mutex);
+
+    return Statistics{ m_hits, m_misses, m_idleBitmaps.size(), m_idleBytes };
+}
+
+
+void StagingBitmapPool::Close()
+{
+    Lock lock(m_mutex);
+
+    m_idleBitmaps.clear();
+    m_idleBytes = 0;
+    m_closed = true;
+}
@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include "DeviceContextPool.h"
+
+class StagingBitmapLease;
+
+//
+// Recycles the CPU readable bitmaps used to copy pixels back from the GPU
+// (see ScopedBitmapMappedPixelAccess), so that repeated readbacks don't
+// allocate a new staging resource every time.
+//
+// Bitmaps are bucketed by pixel format and by rounded-up size, so a request
+// can be satisfied by any idle bitmap of at least the required size.  Idle
+// bitmaps are kept in least-recently-used order, and the oldest are released
+// once their total size exceeds the budget.  The most recently returned
+// bitmap is always kept (unless the budget is zero), however large it is.
+//
+class StagingBitmapPool
+{
+public:
+    static const size_t DefaultBudgetInBytes = 16 * 1024 * 1024;
+
+    struct Statistics
+    {
+        uint64_t Hits;
+        uint64_t Misses;
+        size_t IdleBitmapCount;
+        size_t IdleBytes;
+    };
+
+private:
+    struct Key
+    {
+        D2D1_SIZE_U Size;
+        D2D1_PIXEL_FORMAT Format;
+
+        bool operator==(Key const& other) const
+        {
+            return Size.width == other.Size.width &&
+                   Size.height == other.Size.height &&
+                   Format.format == other.Format.format &&
+                   Format.alphaMode == other.Format.alphaMode;
+        }
+    };
+
+    struct Entry
+    {
+        Key Bucket;
+        size_t SizeInBytes;
+        ComPtr<ID2D1Bitmap1> Bitmap;
+    };
+
+    DeviceContextPool* m_deviceContextPool;
+    size_t m_budgetInBytes;
+
+    std::mutex m_mutex;
+    bool m_closed;
+
+    // Least recently used at the front, most recently returned at the back.
+    std::vector<Entry> m_idleBitmaps;
+    size_t m_idleBytes;
+
+    uint64_t m_hits;
+    uint64_t m_misses;
+
+public:
+    StagingBitmapPool(DeviceContextPool* deviceContextPool, size_t budgetInBytes = DefaultBudgetInBytes);
+
+    StagingBitmapPool(StagingBitmapPool const&) = delete;
+    StagingBitmapPool& operator=(StagingBitmapPool const&) = delete;
+
+    // The leased bitmap may be larger than requested; only the top left
+    // corner of it is meaningful.
+    StagingBitmapLease TakeLease(D2D1_SIZE_U const& size, D2D1_PIXEL_FORMAT const& format);
+
+    // Releases all idle bitmaps.  Bitmaps that are currently leased out are
+    // still returned to the pool as normal.
+    void Trim();
+
+    void SetBudget(size_t budgetInBytes);
+
+    Statistics GetStatistics();
+
+    void Close();
+
+    static uint32_t GetBucketSize(uint32_t size);
+
+private:
+    void ReturnLease(Entry&& entry);
+    void TrimToBudget();
+
+    friend class StagingBitmapLease;
+};
+
+
+class StagingBitmapLease
+{
+    StagingBitmapPool* m_owner;
+    StagingBitmapPool::Entry m_entry;
+
+public:
+    StagingBitmapLease()
+        : m_owner(nullptr)
+        , m_entry{}
+    {
+    }
+
+    explicit StagingBitmapLease(ComPtr<ID2D1Bitmap1>&& bitmap)
+        : m_owner(nullptr)
+        , m_entry{}
+    {
+        m_entry.Bitmap = std::move(bitmap);
+    }
+
+    StagingBitmapLease(StagingBitmapLease&& other)
+        : m_owner(other.m_owner)
+        , m_entry(std::move(other.m_entry))
+    {
+        other.m_owner = nullptr;
+    }
+
+    StagingBitmapLease& operator=(StagingBitmapLease&& other)
+    {
+        ReturnLease();
+        m_owner = other.m_owner;
+        m_entry = std::move(other.m_entry);
+        other.m_owner = nullptr;
+        return *this;
+    }
+
+    StagingBitmapLease(StagingBitmapLease const&) = delete;
+    StagingBitmapLease& operator=(StagingBitmapLease const&) = delete;
+
+    ~StagingBitmapLease()
+    {
+        ReturnLease();
+    }
+
+    ID2D1Bitmap1* Get()
+    {
+        return m_entry.Bitmap.Get();
+    }
+
+    ID2D1Bitmap1* operator->()
+    {
+        return m_entry.Bitmap.Get();
+    }
+
+private:
+    StagingBitmapLease(StagingBitmapPool* owner, StagingBitmapPool::Entry&& entry)
+        : m_owner(owner)
+        , m_entry(std::move(entry))
+    {
+        assert(m_owner);
+    }
+
+    void ReturnLease()
+    {
+        if (m_owner)
+        {
+            m_owner->ReturnLease(std::move(m_entry));
+            m_owner = nullptr;
+        }
+        else
+        {
+            m_entry.Bitmap.Reset();
+        }
+    }
+
+    friend class StagingBitmapPool;
+};
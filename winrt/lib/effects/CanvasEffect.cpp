@@ -5,6 +5,7 @@
 #include "pch.h"
 #include "effects/shader/PixelShaderEffect.h"
 #include "effects/shader/PixelShaderEffectImpl.h"
+#include "ColorMatrixFolding.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects 
 {
@@ -17,6 +18,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         , m_sources(sourcesSize)
         , m_cacheOutput(false)
         , m_bufferPrecision(D2D1_BUFFER_PRECISION_UNKNOWN)
+        , m_realizationCounters{}
     {
         // If this effect has a variable number of inputs, expose them as an IVector<>.
         if (!isSourcesSizeFixed)
@@ -82,20 +84,10 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         // Look up which strongly typed Win2D wrapper class matches the effect CLSID.
         IID effectId = d2dEffect->GetValue<IID>(D2D1_PROPERTY_CLSID);
 
-        for (auto effectMaker = m_effectMakers; effectMaker->second; effectMaker++)
+        if (auto effectMaker = TryGetEffectMaker(effectId))
         {
-            if (IsEqualGUID(effectMaker->first, effectId))
-            {
-                // Found it! Create the Win2D wrapper class.
-                effectMaker->second(device, d2dEffect.Get(), result);
-                return true;
-            }
-        }
-
-        // If this isn't one of the codegenned effect wrappers, could it be our custom pixel shader effect?
-        if (IsEqualGUID(effectId, CLSID_PixelShaderEffect))
-        {
-            MakeEffect<PixelShaderEffect>(device, d2dEffect.Get(), result);
+            // Found it! Create the Win2D wrapper class.
+            effectMaker(device, d2dEffect.Get(), result);
             return true;
         }
 
@@ -133,17 +125,50 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
     bool CanvasEffect::IsWin2DEffectId(REFIID effectId)
     {
-        // Check the generated effect wrappers first
-        for (auto effectMaker = m_effectMakers; effectMaker->second; effectMaker++)
+        return TryGetEffectMaker(effectId) != nullptr;
+    }
+
+    static bool IsLessThan(IID const& a, IID const& b)
+    {
+        return memcmp(&a, &b, sizeof(IID)) < 0;
+    }
+
+    CanvasEffect::MakeEffectFunction CanvasEffect::TryGetEffectMaker(REFIID effectId)
+    {
+        typedef std::pair<IID, MakeEffectFunction> EffectMaker;
+
+        // Built on first use (C++ guarantees this is thread safe).
+        static std::vector<EffectMaker> const sortedEffectMakers = []
         {
-            if (IsEqualGUID(effectMaker->first, effectId))
+            std::vector<EffectMaker> effectMakers;
+
+            for (auto effectMaker = m_effectMakers; effectMaker->second; effectMaker++)
             {
-                return true;
+                effectMakers.push_back(*effectMaker);
             }
-        }
 
-        // Check PixelShaderEffect specifically next
-        return IsEqualGUID(effectId, CLSID_PixelShaderEffect);
+            // PixelShaderEffect is hand written rather than codegenned, so isn't in the generated table.
+            effectMakers.push_back(EffectMaker(CLSID_PixelShaderEffect, MakeEffect<PixelShaderEffect>));
+
+            std::sort(effectMakers.begin(), effectMakers.end(),
+                [](EffectMaker const& a, EffectMaker const& b)
+                {
+                    return IsLessThan(a.first, b.first);
+                });
+
+            return effectMakers;
+        }();
+
+        auto it = std::lower_bound(sortedEffectMakers.begin(), sortedEffectMakers.end(), effectId,
+            [](EffectMaker const& effectMaker, IID const& id)
+            {
+                return IsLessThan(effectMaker.first, id);
+            });
+
+        if (it == sortedEffectMakers.end() || !IsEqualGUID(it->first, effectId))
+            return nullptr;
+
+        return it->second;
     }
 
 
@@ -245,9 +270,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
         if (!IsSameInstance(d2dDevice.Get(), m_realizationDevice.GetResource()))
         {
-            Unrealize();
+            SuspendRealization();
 
             m_realizationDevice.Set(d2dDevice.Get(), device);
+
+            PurgeStaleCachedRealizations();
         }
 
         if (!HasResource())
@@ -271,6 +298,83 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
+    bool CanvasEffect::TryGetColorTransform(D2D1_MATRIX_5X4_F* matrix, bool* clampOutput, ComPtr<IGraphicsEffectSource>* source)
+    {
+        // An effect that is part way through GetD2DImage already holds its lock,
+        // and if that is on this thread, folding it would form a cycle.  m_mutex
+        // is not recursive, so rather than block, an effect that is busy is just
+        // left to be realized normally.
+        Lock lock(m_mutex, std::try_to_lock);
+
+        if (!lock.owns_lock())
+            return false;
+
+        if (m_closed || m_insideGetImage || !IsColorTransformEffect(m_effectId))
+            return false;
+
+        // Caching and buffer precision don't mean anything once the effect is folded away.
+        if (m_sourcesVector || m_sources.size() != 1 || m_cacheOutput || m_bufferPrecision != D2D1_BUFFER_PRECISION_UNKNOWN)
+            return false;
+
+        if (MaybeGetResource())
+        {
+            std::vector<EffectPropertyValue> properties;
+            std::vector<ComPtr<IGraphicsEffectSource>> sources;
+
+            GetCurrentState(&properties, &sources);
+
+            if (!TryGetEffectColorMatrix(m_effectId, properties, matrix, clampOutput))
+                return false;
+
+            *source = sources[0];
+        }
+        else
+        {
+            if (!TryGetEffectColorMatrix(m_effectId, m_properties, matrix, clampOutput))
+                return false;
+
+            *source = m_sources[0].GetWrapper();
+        }
+
+        return true;
+    }
+
+
+    void CanvasEffect::GetCurrentState(std::vector<EffectPropertyValue>* properties, std::vector<ComPtr<IGraphicsEffectSource>>* sources)
+    {
+        auto& d2dEffect = MaybeGetResource();
+
+        if (d2dEffect)
+        {
+            // If we are realized (eg. because this effect is also drawn elsewhere), the D2D effect holds the current state.
+            properties->resize(m_properties.size());
+
+            for (unsigned int i = 0; i < properties->size(); i++)
+            {
+                GetD2DProperty(d2dEffect.Get(), i, &(*properties)[i]);
+            }
+
+            sources->resize(d2dEffect->GetInputCount());
+
+            for (unsigned int i = 0; i < sources->size(); i++)
+            {
+                (*sources)[i] = GetD2DInput(d2dEffect.Get(), i);
+            }
+        }
+        else
+        {
+            *properties = m_properties;
+
+            sources->clear();
+
+            for (auto& source : m_sources)
+            {
+                sources->push_back(source.GetWrapper());
+            }
+        }
+    }
+
+
     //
     // ICanvasResourceWrapperNative
     //
@@ -311,6 +415,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         ReleaseResource();
 
         m_realizationDevice.Reset();
+        m_cachedRealizations.clear();
         m_workaround6146411.Reset();
         m_sources.assign(m_sources.size(), SourceReference());
 
@@ -406,7 +511,10 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
                 if (index >= m_properties.size())
                     ThrowHR(E_BOUNDS);
 
-                ThrowIfFailed(GetProperty(index).CopyTo(value));
+                EffectPropertyValue storedValue;
+                GetProperty(index, &storedValue);
+
+                ThrowIfFailed(storedValue.Box(m_propertyValueFactory.Get()).CopyTo(value));
             });
     }
 
@@ -1197,6 +1305,126 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
     
+    //
+    // Implements WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS. If the source feeding an input is the
+    // head of a chain of color transform effects, only the image at the bottom of the chain is realized,
+    // and all the transforms are applied at once by a single D2D1ColorMatrix (or by nothing at all, if
+    // they cancel out). The effects in the chain are left unrealized.
+    //
+    // Returns false if the input should be realized normally.
+    //
+    bool CanvasEffect::TryFoldColorTransforms(unsigned int index, IGraphicsEffectSource* source, WIN2D_GET_D2D_IMAGE_FLAGS flags, float targetDpi, ID2D1DeviceContext* deviceContext, ComPtr<ID2D1Image>* realizedSource, float* realizedDpi)
+    {
+        // Bounds the chain length, in case of cycles between unrealized effects.
+        const unsigned int maxFoldedEffects = 64;
+
+        if ((flags & WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS) == WIN2D_GET_D2D_IMAGE_FLAGS_NONE)
+            return false;
+
+        // Walk down the chain. The first transform found is the last one to be applied.
+        auto matrix = MakeIdentityColorMatrix();
+        bool clampOutput = false;
+        unsigned int foldedEffectCount = 0;
+        ComPtr<IGraphicsEffectSource> chainSource = source;
+
+        while (chainSource && foldedEffectCount < maxFoldedEffects)
+        {
+            auto internalSource = MaybeAs<ICanvasImageInternal>(chainSource);
+
+            D2D1_MATRIX_5X4_F sourceMatrix;
+            bool sourceClampOutput;
+            ComPtr<IGraphicsEffectSource> nextSource;
+
+            if (!internalSource || !internalSource->TryGetColorTransform(&sourceMatrix, &sourceClampOutput, &nextSource))
+                break;
+
+            // Clamping can only be done after all the transforms, so can't come from further down.
+            if (sourceClampOutput && foldedEffectCount > 0)
+                break;
+
+            matrix = CombineColorMatrices(sourceMatrix, matrix);
+            clampOutput = clampOutput || sourceClampOutput;
+            chainSource = nextSource;
+            foldedEffectCount++;
+        }
+
+        bool isIdentity = IsIdentityColorMatrix(matrix) && !clampOutput;
+
+        // Swapping one effect for an equivalent D2D1ColorMatrix gains nothing, unless it turns out to do nothing.
+        if (foldedEffectCount == 0 || (foldedEffectCount == 1 && !isIdentity))
+            return false;
+
+        // Leave anything unusual at the bottom of the chain (null, interop images, images
+        // bound to a different device) to the normal path, which knows how to report errors.
+        if (!chainSource)
+            return false;
+
+        auto bottomSource = MaybeAs<ICanvasImageInternal>(chainSource);
+
+        if (!bottomSource)
+            return false;
+
+        if (auto sourceWithDevice = MaybeAs<ICanvasResourceWrapperWithDevice>(chainSource))
+        {
+            ComPtr<ICanvasDevice> sourceDevice;
+            ThrowIfFailed(sourceWithDevice->get_Device(&sourceDevice));
+
+            if (!IsSameInstance(RealizationDevice(), sourceDevice.Get()))
+                return false;
+        }
+
+        auto bottomImage = bottomSource->GetD2DImage(RealizationDevice(), deviceContext, flags, targetDpi, realizedDpi);
+
+        if (!bottomImage)
+            return false;
+
+        if (m_sources.size() <= index)
+            m_sources.resize(index + 1);
+
+        auto& sourceInfo = m_sources[index];
+
+        if (isIdentity)
+        {
+            sourceInfo.ColorTransform.Reset();
+            *realizedSource = bottomImage;
+            return true;
+        }
+
+        bool isNew = !sourceInfo.ColorTransform;
+
+        if (isNew)
+        {
+            sourceInfo.ColorTransform = CreateD2DEffect(deviceContext, CLSID_D2D1ColorMatrix);
+
+            ThrowIfFailed(sourceInfo.ColorTransform->SetValue(D2D1_COLORMATRIX_PROP_ALPHA_MODE, D2D1_COLORMATRIX_ALPHA_MODE_PREMULTIPLIED));
+        }
+
+        // Only pass changes through to D2D, so redrawing an unchanged graph doesn't invalidate anything.
+        if (isNew || memcmp(&matrix, &sourceInfo.ColorTransformMatrix, sizeof(matrix)) != 0)
+        {
+            ThrowIfFailed(sourceInfo.ColorTransform->SetValue(D2D1_COLORMATRIX_PROP_COLOR_MATRIX, matrix));
+            sourceInfo.ColorTransformMatrix = matrix;
+        }
+
+        if (isNew || clampOutput != sourceInfo.ColorTransformClampOutput)
+        {
+            ThrowIfFailed(sourceInfo.ColorTransform->SetValue(D2D1_COLORMATRIX_PROP_CLAMP_OUTPUT, static_cast<BOOL>(clampOutput)));
+            sourceInfo.ColorTransformClampOutput = clampOutput;
+        }
+
+        ComPtr<ID2D1Image> currentInput;
+
+        if (!isNew)
+            sourceInfo.ColorTransform->GetInput(0, &currentInput);
+
+        if (!IsSameInstance(currentInput.Get(), bottomImage.Get()))
+            SetEffectInput(sourceInfo.ColorTransform.Get(), 0, bottomImage.Get());
+
+        *realizedSource = As<ID2D1Image>(sourceInfo.ColorTransform);
+        return true;
+    }
+
+
     void CanvasEffect::RefreshInputs(WIN2D_GET_D2D_IMAGE_FLAGS flags, float targetDpi, ID2D1DeviceContext* deviceContext)
     {
         auto& d2dEffect = GetResource();
@@ -1218,8 +1446,15 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             else
             {
                 // Get the underlying D2D interface. This call recurses through the effect graph.
-                float realizedDpi;
-                auto realizedSource = ICanvasImageInternal::GetD2DImageFromInternalOrInteropSource(source.Get(), RealizationDevice(), deviceContext, flags, targetDpi, &realizedDpi);
+                float realizedDpi = 0;
+                ComPtr<ID2D1Image> realizedSource;
+
+                if (!TryFoldColorTransforms(i, source.Get(), flags, targetDpi, deviceContext, &realizedSource, &realizedDpi))
+                {
+                    sourceInfo.ColorTransform.Reset();
+
+                    realizedSource = ICanvasImageInternal::GetD2DImageFromInternalOrInteropSource(source.Get(), RealizationDevice(), deviceContext, flags, targetDpi, &realizedDpi);
+                }
 
                 bool resourceChanged = sourceInfo.UpdateResource(realizedSource.Get());
 
@@ -1239,6 +1474,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     {
         ComPtr<ID2D1Image> realizedSource;
         float realizedDpi = 0;
+        bool isFolded = false;
 
         if (source)
         {
@@ -1332,7 +1568,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             }
 
             // Get the underlying D2D interface. This call recurses through the effect graph.
-            if (internalSource)
+            if (TryFoldColorTransforms(index, source, flags, targetDpi, deviceContext, &realizedSource, &realizedDpi))
+            {
+                isFolded = true;
+            }
+            else if (internalSource)
             {
                 realizedSource = internalSource->GetD2DImage(RealizationDevice(), deviceContext, flags, targetDpi, &realizedDpi);
             }
@@ -1364,6 +1604,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
         m_sources[index].Set(realizedSource.Get(), source);
 
+        if (!isFolded)
+            m_sources[index].ColorTransform.Reset();
+
         // Update the underlying D2D effect state.
         ApplyDpiCompensation(index, realizedSource, realizedDpi, flags, targetDpi, deviceContext);
 
@@ -1401,7 +1644,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
-    void CanvasEffect::SetProperty(unsigned int index, IPropertyValue* propertyValue)
+    void CanvasEffect::SetProperty(unsigned int index, EffectPropertyValue const& value)
     {
         auto lock = Lock(m_mutex);
 
@@ -1412,67 +1655,63 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         if (d2dEffect)
         {
             // If we are realized, set the property value through to the underlying D2D resource.
-            SetD2DProperty(d2dEffect.Get(), index, propertyValue);
+            SetD2DProperty(d2dEffect.Get(), index, value);
         }
         else
         {
             // If we are not realized, directly store the property value.
-            m_properties[index] = propertyValue;
+            m_properties[index] = value;
         }
     }
 
 
-    void CanvasEffect::SetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index, IPropertyValue* propertyValue)
+    void CanvasEffect::SetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index, EffectPropertyValue const& value)
     {
-        PropertyType propertyType;
-        ThrowIfFailed(propertyValue->get_Type(&propertyType));
-
-        switch (propertyType)
+        switch (value.GetType())
         {
-        case PropertyType_Boolean:
+        case EffectPropertyValue::Type::Boolean:
             {
-                boolean value;
-                ThrowIfFailed(propertyValue->GetBoolean(&value));
-                ThrowIfFailed(d2dEffect->SetValue(index, static_cast<BOOL>(value)));
+                boolean storedValue;
+                value.Get(&storedValue);
+                ThrowIfFailed(d2dEffect->SetValue(index, static_cast<BOOL>(storedValue)));
             }
             break;
 
-        case PropertyType_Int32:
+        case EffectPropertyValue::Type::Int32:
             {
-                INT32 value;
-                ThrowIfFailed(propertyValue->GetInt32(&value));
-                ThrowIfFailed(d2dEffect->SetValue(index, value));
+                INT32 storedValue;
+                value.Get(&storedValue);
+                ThrowIfFailed(d2dEffect->SetValue(index, storedValue));
             }
             break;
 
-        case PropertyType_UInt32:
+        case EffectPropertyValue::Type::UInt32:
             {
-                UINT32 value;
-                ThrowIfFailed(propertyValue->GetUInt32(&value));
-                ThrowIfFailed(d2dEffect->SetValue(index, value));
+                UINT32 storedValue;
+                value.Get(&storedValue);
+                ThrowIfFailed(d2dEffect->SetValue(index, storedValue));
             }
             break;
 
-        case PropertyType_Single:
+        case EffectPropertyValue::Type::Single:
             {
-                float value;
-                ThrowIfFailed(propertyValue->GetSingle(&value));
-                ThrowIfFailed(d2dEffect->SetValue(index, value));
+                float storedValue;
+                value.Get(&storedValue);
+                ThrowIfFailed(d2dEffect->SetValue(index, storedValue));
             }
             break;
 
-        case PropertyType_SingleArray:
+        case EffectPropertyValue::Type::SingleArray:
             {
-                ComArray<float> value;
-                ThrowIfFailed(propertyValue->GetSingleArray(value.GetAddressOfSize(), value.GetAddressOfData()));
-                ThrowIfFailed(d2dEffect->SetValue(index, reinterpret_cast<BYTE*>(value.GetData()), value.GetSize() * sizeof(float)));
+                uint32_t valueCount;
+                auto storedValue = value.GetSingleArray(&valueCount);
+                ThrowIfFailed(d2dEffect->SetValue(index, reinterpret_cast<BYTE const*>(storedValue), valueCount * sizeof(float)));
             }
             break;
 
-        case PropertyType_InspectableArray:
+        case EffectPropertyValue::Type::Inspectable:
             {
-                ComPtr<IInspectable> wrapper;
-                GetValueOfProperty(propertyValue, wrapper.GetAddressOf());
+                auto wrapper = value.GetInspectable();
 
                 auto d2dResource = wrapper ? GetWrappedResource<IUnknown>(wrapper, m_realizationDevice.GetWrapper()) : nullptr;
 
@@ -1493,7 +1732,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
-    ComPtr<IPropertyValue> CanvasEffect::GetProperty(unsigned int index)
+    void CanvasEffect::GetProperty(unsigned int index, EffectPropertyValue* value)
     {
         auto lock = Lock(m_mutex);
 
@@ -1504,46 +1743,46 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         if (d2dEffect)
         {
             // If we are realized, read the property value from the underlying D2D resource.
-            return GetD2DProperty(d2dEffect.Get(), index);
+            GetD2DProperty(d2dEffect.Get(), index, value);
         }
         else
         {
             // If we are not realized, directly return the property value.
-            return m_properties[index];
+            *value = m_properties[index];
         }
     }
 
 
-    ComPtr<IPropertyValue> CanvasEffect::GetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index)
+    void CanvasEffect::GetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index, EffectPropertyValue* value)
     {
         switch (d2dEffect->GetType(index))
         {
         case D2D1_PROPERTY_TYPE_BOOL:
             {
-                BOOL value = d2dEffect->GetValue<BOOL>(index);
-                return CreateProperty(m_propertyValueFactory.Get(), static_cast<boolean>(value));
+                BOOL d2dValue = d2dEffect->GetValue<BOOL>(index);
+                value->Set(static_cast<boolean>(d2dValue));
             }
             break;
 
         case D2D1_PROPERTY_TYPE_INT32:
         case D2D1_PROPERTY_TYPE_UINT32:     // Not a mistake: unsigned DImage properties are exposed in WinRT as signed.
             {
-                INT32 value = d2dEffect->GetValue<INT32>(index);
-                return CreateProperty(m_propertyValueFactory.Get(), value);
+                INT32 d2dValue = d2dEffect->GetValue<INT32>(index);
+                value->Set(static_cast<int32_t>(d2dValue));
             }
             break;
 
         case D2D1_PROPERTY_TYPE_ENUM:
             {
-                UINT32 value = d2dEffect->GetValue<UINT32>(index);
-                return CreateProperty(m_propertyValueFactory.Get(), value);
+                UINT32 d2dValue = d2dEffect->GetValue<UINT32>(index);
+                value->Set(static_cast<uint32_t>(d2dValue));
             }
             break;
 
         case D2D1_PROPERTY_TYPE_FLOAT:
             {
-                float value = d2dEffect->GetValue<float>(index);
-                return CreateProperty(m_propertyValueFactory.Get(), value);
+                float d2dValue = d2dEffect->GetValue<float>(index);
+                value->Set(d2dValue);
             }
             break;
 
@@ -1558,10 +1797,10 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
                 unsigned sizeInBytes = d2dEffect->GetValueSize(index);
                 unsigned sizeInFloats = sizeInBytes / sizeof(float);
 
-                std::vector<BYTE> value(sizeInBytes);
-                ThrowIfFailed(d2dEffect->GetValue(index, value.data(), sizeInBytes));
-
-                return CreateProperty(m_propertyValueFactory.Get(), sizeInFloats, reinterpret_cast<float*>(value.data()));
+                // Read into storage rounded up to whole floats, then drop any partial float at the end.
+                auto storage = value->ResizeSingleArray((sizeInBytes + sizeof(float) - 1) / sizeof(float));
+                ThrowIfFailed(d2dEffect->GetValue(index, reinterpret_cast<BYTE*>(storage), sizeInBytes));
+                value->ResizeSingleArray(sizeInFloats);
             }
             break;
 
@@ -1584,7 +1823,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
                 auto wrapper = d2dResource ? ResourceManager::GetOrCreate(m_realizationDevice.GetWrapper(), d2dResource.Get(), 0) : nullptr;
 
-                return CreateProperty(m_propertyValueFactory.Get(), wrapper.Get());
+                value->Set(wrapper.Get());
             }
             break;
 
@@ -1604,20 +1843,40 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             ThrowHR(E_INVALIDARG, Strings::EffectNoSources);
         }
 
-        // Create a new D2D effect instance.
-        auto d2dEffect = CreateD2DEffect(deviceContext, m_effectId);
+        // Reuse the D2D effect from an earlier realization on this device if we have one, otherwise create a new one.
+        CachedRealization cachedRealization;
+        ComPtr<ID2D1Effect> d2dEffect;
+        bool isReused = TakeCachedRealization(&cachedRealization);
+
+        if (isReused)
+        {
+            d2dEffect = cachedRealization.Effect;
+
+            // Reinstate the DPI compensation effects that went with it, so they don't need recreating either.
+            auto count = std::min(m_sources.size(), cachedRealization.DpiCompensators.size());
+
+            for (size_t i = 0; i < count; i++)
+            {
+                m_sources[i].DpiCompensator = cachedRealization.DpiCompensators[i];
+            }
+        }
+        else
+        {
+            d2dEffect = CreateD2DEffect(deviceContext, m_effectId);
+        }
 
         // Transfer property values from our resource independent m_properties store to the D2D effect.
         for (unsigned i = 0; i < m_properties.size(); ++i)
         {
-            SetD2DProperty(d2dEffect.Get(), i, m_properties[i].Get());
+            SetD2DProperty(d2dEffect.Get(), i, m_properties[i]);
         }
 
         // Also transfer the special properties that are common to all effects (CacheOutput and BufferPrecision).
-        if (m_cacheOutput)
-            ThrowIfFailed(d2dEffect->SetValue(D2D1_PROPERTY_CACHED, static_cast<BOOL>(true)));
+        // A reused effect may hold non-default values from before, so those are always set.
+        if (m_cacheOutput || isReused)
+            ThrowIfFailed(d2dEffect->SetValue(D2D1_PROPERTY_CACHED, static_cast<BOOL>(m_cacheOutput)));
 
-        if (m_bufferPrecision != D2D1_BUFFER_PRECISION_UNKNOWN)
+        if (m_bufferPrecision != D2D1_BUFFER_PRECISION_UNKNOWN || isReused)
             ThrowIfFailed(d2dEffect->SetValue(D2D1_PROPERTY_PRECISION, m_bufferPrecision));
 
         // Transfer input images across to the D2D effect.
@@ -1630,11 +1889,19 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         }
 
         // Wipe m_properties, as the D2D effect is now the One True Source Of Authoritativeness.
-        m_properties.assign(m_properties.size(), nullptr);
+        for (auto& property : m_properties)
+        {
+            property.Clear();
+        }
 
         // Store the new effect.
         SetResource(d2dEffect.Get());
 
+        if (isReused)
+            m_realizationCounters.EffectsReused++;
+        else
+            m_realizationCounters.EffectsCreated++;
+
         return true;
     }
 
@@ -1648,7 +1915,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             // Transfer property values from the D2D effect to our resource independent m_properties store.
             for (unsigned i = 0; i < m_properties.size(); ++i)
             {
-                m_properties[i] = GetD2DProperty(d2dEffect.Get(), i);
+                GetD2DProperty(d2dEffect.Get(), i, &m_properties[i]);
             }
 
             // Also transfer the special properties that are common to all effects (CacheOutput and BufferPrecision).
@@ -1677,7 +1944,109 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             ReleaseResource();
 
             m_workaround6146411.Reset();
+
+            m_realizationCounters.Unrealizations++;
+        }
+    }
+
+
+    //
+    // Called when switching to a different device. Rather than discarding the D2D
+    // effect, this keeps it (along with any DPI compensation effects feeding it) so
+    // that a later realization back onto the same device can pick up where it left
+    // off. The effect state is still read back, because that is authoritative while
+    // we are realized on the other device.
+    //
+    void CanvasEffect::SuspendRealization()
+    {
+        auto d2dEffect = MaybeGetResource();
+
+        if (!d2dEffect)
+            return;
+
+        auto device = m_realizationDevice.GetWrapper();
+
+        if (!device)
+        {
+            // Nothing to key a cache entry on.
+            Unrealize();
+            return;
         }
+
+        CachedRealization cachedRealization;
+        cachedRealization.Device = AsWeak(device);
+        cachedRealization.Effect = d2dEffect;
+
+        // Unrealize forgets the DPI compensators, so grab them first.
+        for (auto& source : m_sources)
+        {
+            cachedRealization.DpiCompensators.push_back(source.DpiCompensator);
+        }
+
+        Unrealize();
+
+        m_cachedRealizations.insert(m_cachedRealizations.begin(), std::move(cachedRealization));
+
+        if (m_cachedRealizations.size() > MaxCachedRealizations)
+        {
+            m_cachedRealizations.pop_back();
+            m_realizationCounters.CacheEvictions++;
+        }
+    }
+
+
+    void CanvasEffect::PurgeStaleCachedRealizations()
+    {
+        auto isStale = [](CachedRealization& cachedRealization)
+        {
+            auto device = LockWeakRef<ICanvasDevice>(cachedRealization.Device);
+
+            if (!device)
+                return true;
+
+            // IsDeviceLost fails if the device has been closed.
+            boolean isLost;
+            return FAILED(device->IsDeviceLost2(&isLost)) || isLost;
+        };
+
+        auto end = std::remove_if(m_cachedRealizations.begin(), m_cachedRealizations.end(), isStale);
+
+        m_realizationCounters.StalePurges += static_cast<uint32_t>(m_cachedRealizations.end() - end);
+
+        m_cachedRealizations.erase(end, m_cachedRealizations.end());
+    }
+
+
+    bool CanvasEffect::TakeCachedRealization(CachedRealization* result)
+    {
+        auto device = m_realizationDevice.GetWrapper();
+
+        auto it = std::find_if(m_cachedRealizations.begin(), m_cachedRealizations.end(),
+            [&](CachedRealization& cachedRealization)
+            {
+                return IsSameInstance(LockWeakRef<ICanvasDevice>(cachedRealization.Device).Get(), device);
+            });
+
+        if (it == m_cachedRealizations.end())
+            return false;
+
+        *result = std::move(*it);
+        m_cachedRealizations.erase(it);
+
+        // If the app kept hold of this D2D effect via interop and has since wrapped it
+        // with a different Win2D object, it no longer belongs to us.
+        if (ResourceManager::IsWrapperRegistered(result->Effect.Get()))
+            return false;
+
+        return true;
+    }
+
+
+    EffectRealizationCounters CanvasEffect::GetRealizationCounters()
+    {
+        auto lock = Lock(m_mutex);
+
+        return m_realizationCounters;
     }
 
 
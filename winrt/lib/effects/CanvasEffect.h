@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "EffectPropertyValue.h"
+
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
 {
     using namespace ::Microsoft::WRL;
@@ -29,6 +31,17 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     };
 
 
+    // Counts of realization events, for diagnosing effect graphs that keep being rebuilt.
+    struct EffectRealizationCounters
+    {
+        uint32_t EffectsCreated;    // Realizations that created a new D2D effect.
+        uint32_t EffectsReused;     // Realizations that reused a D2D effect from an earlier realization on the same device.
+        uint32_t Unrealizations;    // Times the effect state was read back from a D2D effect.
+        uint32_t CacheEvictions;    // Cached D2D effects released to limit how many devices are held on to.
+        uint32_t StalePurges;       // Cached D2D effects released because their device was released, closed or lost.
+    };
+
+
     class CanvasEffect
         : public Implements<
             RuntimeClassFlags<WinRtClassicComMix>,
@@ -56,12 +69,33 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         // What device are we currently realized on?
         CachedResourceReference<ID2D1Device, ICanvasDevice> m_realizationDevice;
 
+        // D2D effects left over from realizations on other devices, most recently used first.
+        // When the same effect graph is drawn alternately on more than one device (eg. a print
+        // device alongside the main one), these are reused rather than rebuilding the graph
+        // every time the device changes.
+        //
+        // Entries only hold a weak reference to their CanvasDevice. Whenever the effect moves
+        // to a different device, entries whose device has since been released, closed or lost
+        // are dropped, so a dead device's effect graph doesn't linger in the cache.
+        struct CachedRealization
+        {
+            WeakRef Device;
+            ComPtr<ID2D1Effect> Effect;
+            std::vector<ComPtr<ID2D1Effect>> DpiCompensators;
+        };
+
+        static const size_t MaxCachedRealizations = 2;
+
+        std::vector<CachedRealization> m_cachedRealizations;
+
         // Effect property values (only used when the effect is not realized).
-        std::vector<ComPtr<IPropertyValue>> m_properties;
+        std::vector<EffectPropertyValue> m_properties;
 
         boolean m_cacheOutput;
         D2D1_BUFFER_PRECISION m_bufferPrecision;
 
+        EffectRealizationCounters m_realizationCounters;
+
         // Workaround Windows bug 6146411 (crash when reading back DESTINATION_COLOR_CONTEXT from a CLSID_D2D1ColorManagement effect).
         ComPtr<IUnknown> m_workaround6146411;
 
@@ -76,14 +110,24 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         struct SourceReference : public CachedResourceReference<ID2D1Image, IGraphicsEffectSource>
         {
             SourceReference()
+                : ColorTransformMatrix{}
+                , ColorTransformClampOutput(false)
             { }
 
             SourceReference(IGraphicsEffectSource* source)
+                : ColorTransformMatrix{}
+                , ColorTransformClampOutput(false)
             {
                 Set(nullptr, source);
             }
 
             ComPtr<ID2D1Effect> DpiCompensator;
+
+            // Set when WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS has replaced the chain
+            // of color effects feeding this input with a single D2D1ColorMatrix.
+            ComPtr<ID2D1Effect> ColorTransform;
+            D2D1_MATRIX_5X4_F ColorTransformMatrix;
+            bool ColorTransformClampOutput;
         };
 
         std::vector<SourceReference> m_sources;
@@ -124,6 +168,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
         static std::pair<IID, MakeEffectFunction> m_effectMakers[];
 
+        // Finds the factory function for an effect CLSID (including PixelShaderEffect), or returns
+        // null if there is no Win2D wrapper class for it. Interop can look up every node of a large
+        // effect graph, so this binary searches a copy of m_effectMakers that is sorted on first use.
+        static MakeEffectFunction TryGetEffectMaker(REFIID effectId);
+
 
     protected:
         // Constructor.
@@ -141,6 +190,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         std::mutex m_mutex;
 
     public:
+        EffectRealizationCounters GetRealizationCounters();
+
         // Used by ResourceManager (in GetOrCreate and to register effect factories).
         static bool TryCreateEffect(ICanvasDevice* device, IUnknown* resource, float dpi, ComPtr<IInspectable>* result);
         static bool IsWin2DEffectId(REFIID effectId);
@@ -163,6 +214,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         //
 
         virtual ComPtr<ID2D1Image> GetD2DImage(ICanvasDevice* device, ID2D1DeviceContext* deviceContext, WIN2D_GET_D2D_IMAGE_FLAGS flags, float targetDpi, float* realizedDpi = nullptr) override;
+        virtual bool TryGetColorTransform(D2D1_MATRIX_5X4_F* matrix, bool* clampOutput, ComPtr<IGraphicsEffectSource>* source) override;
 
         //
         // ICanvasResourceWrapperNative
@@ -215,13 +267,17 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         // enums are stored as unsigned integers, vectors and matrices as float arrays, and
         // colors as float[3] or float[4] depending on whether they include alpha.
         //
+        // Despite the names, values are held in an unboxed EffectPropertyValue. They are only
+        // boxed into an IPropertyValue when requested through IGraphicsEffectD2D1Interop.
+        //
 
         template<typename TBoxed, typename TPublic>
         void SetBoxedProperty(unsigned int index, TPublic const& value)
         {
-            auto boxedValue = PropertyTypeConverter<TBoxed, TPublic>::Box(m_propertyValueFactory.Get(), value);
+            EffectPropertyValue storedValue;
+            PropertyTypeConverter<TBoxed, TPublic>::Store(value, &storedValue);
 
-            SetProperty(index, boxedValue.Get());
+            SetProperty(index, storedValue);
         }
 
         template<typename TBoxed, typename TPublic>
@@ -229,17 +285,21 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         {
             CheckInPointer(value);
 
-            auto boxedValue = GetProperty(index);
+            EffectPropertyValue storedValue;
+            GetProperty(index, &storedValue);
 
-            PropertyTypeConverter<TBoxed, TPublic>::Unbox(boxedValue.Get(), value);
+            PropertyTypeConverter<TBoxed, TPublic>::Load(storedValue, value);
         }
 
         template<typename T>
         void SetArrayProperty(unsigned int index, uint32_t valueCount, T const* value)
         {
-            auto boxedValue = CreateProperty(m_propertyValueFactory.Get(), valueCount, value);
+            static_assert(std::is_same<T, float>::value, "Only float arrays are supported");
+
+            EffectPropertyValue storedValue;
+            storedValue.Set(valueCount, value);
 
-            SetProperty(index, boxedValue.Get());
+            SetProperty(index, storedValue);
         }
 
         template<typename T>
@@ -251,12 +311,19 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         template<typename T>
         void GetArrayProperty(unsigned int index, uint32_t* valueCount, T** value)
         {
+            static_assert(std::is_same<T, float>::value, "Only float arrays are supported");
+
             CheckInPointer(valueCount);
             CheckAndClearOutPointer(value);
 
-            auto boxedValue = GetProperty(index);
+            EffectPropertyValue storedValue;
+            GetProperty(index, &storedValue);
+
+            uint32_t storedCount;
+            auto storedArray = storedValue.GetSingleArray(&storedCount);
 
-            GetValueOfProperty(boxedValue.Get(), valueCount, value);
+            ComArray<T> result(storedArray, storedArray + storedCount);
+            result.Detach(valueCount, value);
         }
 
 
@@ -282,17 +349,24 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
     private:
         ComPtr<ID2D1Effect> CreateD2DEffect(ID2D1DeviceContext* deviceContext, IID const& effectId);
+        void SuspendRealization();
+        void PurgeStaleCachedRealizations();
+        bool TakeCachedRealization(CachedRealization* result);
         bool ApplyDpiCompensation(unsigned int index, ComPtr<ID2D1Image>& inputImage, float inputDpi, WIN2D_GET_D2D_IMAGE_FLAGS flags, float targetDpi, ID2D1DeviceContext* deviceContext);
         void RefreshInputs(WIN2D_GET_D2D_IMAGE_FLAGS flags, float targetDpi, ID2D1DeviceContext* deviceContext);
+        bool TryFoldColorTransforms(unsigned int index, IGraphicsEffectSource* source, WIN2D_GET_D2D_IMAGE_FLAGS flags, float targetDpi, ID2D1DeviceContext* deviceContext, ComPtr<ID2D1Image>* realizedSource, float* realizedDpi);
         
         bool SetD2DInput(ID2D1Effect* d2dEffect, unsigned int index, IGraphicsEffectSource* source, WIN2D_GET_D2D_IMAGE_FLAGS flags, float targetDpi = 0, ID2D1DeviceContext* deviceContext = nullptr);
         ComPtr<IGraphicsEffectSource> GetD2DInput(ID2D1Effect* d2dEffect, unsigned int index);
 
-        void SetProperty(unsigned int index, IPropertyValue* propertyValue);
-        void SetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index, IPropertyValue* propertyValue);
+        void SetProperty(unsigned int index, EffectPropertyValue const& value);
+        void SetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index, EffectPropertyValue const& value);
+
+        void GetProperty(unsigned int index, EffectPropertyValue* value);
+        void GetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index, EffectPropertyValue* value);
 
-        ComPtr<IPropertyValue> GetProperty(unsigned int index);
-        ComPtr<IPropertyValue> GetD2DProperty(ID2D1Effect* d2dEffect, unsigned int index);
+        // Reads all property values and sources, from the D2D effect if realized. The caller must hold m_mutex.
+        void GetCurrentState(std::vector<EffectPropertyValue>* properties, std::vector<ComPtr<IGraphicsEffectSource>>* sources);
 
         void ThrowIfClosed();
 
@@ -317,14 +391,14 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         {
             static_assert(std::is_same<TBoxed, TPublic>::value, "Default PropertyTypeConverter should only be used when TBoxed = TPublic");
 
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, TPublic const& value)
+            static void Store(TPublic const& value, EffectPropertyValue* result)
             {
-                return CreateProperty(factory, value);
+                result->Set(value);
             }
 
-            static void Unbox(IPropertyValue* propertyValue, TPublic* result)
+            static void Load(EffectPropertyValue const& value, TPublic* result)
             {
-                GetValueOfProperty(propertyValue, result);
+                value.Get(result);
             }
         };
 
@@ -334,16 +408,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         struct PropertyTypeConverter<uint32_t, TPublic,
                                      typename std::enable_if<std::is_enum<TPublic>::value>::type>
         {
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, TPublic value)
+            static void Store(TPublic value, EffectPropertyValue* result)
             {
-                return CreateProperty(factory, static_cast<uint32_t>(value));
+                result->Set(static_cast<uint32_t>(value));
             }
 
-            static void Unbox(IPropertyValue* propertyValue, TPublic* result)
+            static void Load(EffectPropertyValue const& value, TPublic* result)
             {
-                uint32_t value;
-                GetValueOfProperty(propertyValue, &value);
-                *result = static_cast<TPublic>(value);
+                uint32_t storedValue;
+                value.Get(&storedValue);
+                *result = static_cast<TPublic>(storedValue);
             }
         };
 
@@ -362,23 +436,22 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
             static_assert(sizeof(TPublic) == sizeof(float[N]), "Wrong array size");
 
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, TPublic const& value)
+            static_assert(N <= EffectPropertyValue::InlineArrayCapacity, "Fixed size arrays should be stored inline");
+
+            static void Store(TPublic const& value, EffectPropertyValue* result)
             {
-                ComPtr<IPropertyValue> propertyValue;
-                ThrowIfFailed(factory->CreateSingleArray(N, (float*)&value, &propertyValue));
-                return propertyValue;
+                result->Set(N, reinterpret_cast<float const*>(&value));
             }
 
-            static void Unbox(IPropertyValue* propertyValue, TPublic* result)
+            static void Load(EffectPropertyValue const& value, TPublic* result)
             {
-                ComArray<float> value;
-
-                ThrowIfFailed(propertyValue->GetSingleArray(value.GetAddressOfSize(), value.GetAddressOfData()));
+                uint32_t valueCount;
+                auto storedValue = value.GetSingleArray(&valueCount);
 
-                if (value.GetSize() != N)
+                if (valueCount != N)
                     ThrowHR(E_BOUNDS);
 
-                *result = *reinterpret_cast<TPublic*>(value.GetData());
+                *result = *reinterpret_cast<TPublic const*>(storedValue);
             }
         };
 
@@ -389,16 +462,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         {
             typedef PropertyTypeConverter<float[4], Numerics::Vector4> VectorConverter;
 
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, Color const& value)
+            static void Store(Color const& value, EffectPropertyValue* result)
             {
-                return VectorConverter::Box(factory, ToVector4(value));
+                VectorConverter::Store(ToVector4(value), result);
             }
 
-            static void Unbox(IPropertyValue* propertyValue, Color* result)
+            static void Load(EffectPropertyValue const& value, Color* result)
             {
-                Numerics::Vector4 value;
-                VectorConverter::Unbox(propertyValue, &value);
-                *result = ToWindowsColor(value);
+                Numerics::Vector4 storedValue;
+                VectorConverter::Load(value, &storedValue);
+                *result = ToWindowsColor(storedValue);
             }
         };
 
@@ -409,16 +482,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         {
             typedef PropertyTypeConverter<float[3], Numerics::Vector3> VectorConverter;
 
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, Color const& value)
+            static void Store(Color const& value, EffectPropertyValue* result)
             {
-                return VectorConverter::Box(factory, ToVector3(value));
+                VectorConverter::Store(ToVector3(value), result);
             }
 
-            static void Unbox(IPropertyValue* propertyValue, Color* result)
+            static void Load(EffectPropertyValue const& value, Color* result)
             {
-                Numerics::Vector3 value;
-                VectorConverter::Unbox(propertyValue, &value);
-                *result = ToWindowsColor(value);
+                Numerics::Vector3 storedValue;
+                VectorConverter::Load(value, &storedValue);
+                *result = ToWindowsColor(storedValue);
             }
         };
 
@@ -429,16 +502,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         {
             typedef PropertyTypeConverter<float[3], Numerics::Vector3> VectorConverter;
 
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, Numerics::Vector4 const& value)
+            static void Store(Numerics::Vector4 const& value, EffectPropertyValue* result)
             {
-                return VectorConverter::Box(factory, Numerics::Vector3{ value.X, value.Y, value.Z });
+                VectorConverter::Store(Numerics::Vector3{ value.X, value.Y, value.Z }, result);
             }
 
-            static void  Unbox(IPropertyValue* propertyValue, Numerics::Vector4* result)
+            static void Load(EffectPropertyValue const& value, Numerics::Vector4* result)
             {
-                Numerics::Vector3 value;
-                VectorConverter::Unbox(propertyValue, &value);
-                *result = Numerics::Vector4{ value.X, value.Y, value.Z, 1.0f };
+                Numerics::Vector3 storedValue;
+                VectorConverter::Load(value, &storedValue);
+                *result = Numerics::Vector4{ storedValue.X, storedValue.Y, storedValue.Z, 1.0f };
             }
         };
 
@@ -449,17 +522,17 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         {
             typedef PropertyTypeConverter<float[4], Numerics::Vector4> VectorConverter;
 
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, Rect const& value)
+            static void Store(Rect const& value, EffectPropertyValue* result)
             {
                 auto d2dRect = ToD2DRect(value);
-                return VectorConverter::Box(factory, *ReinterpretAs<Numerics::Vector4*>(&d2dRect));
+                VectorConverter::Store(*ReinterpretAs<Numerics::Vector4*>(&d2dRect), result);
             }
 
-            static void Unbox(IPropertyValue* propertyValue, Rect* result)
+            static void Load(EffectPropertyValue const& value, Rect* result)
             {
-                Numerics::Vector4 value;
-                VectorConverter::Unbox(propertyValue, &value);
-                *result = FromD2DRect(*ReinterpretAs<D2D1_RECT_F*>(&value));
+                Numerics::Vector4 storedValue;
+                VectorConverter::Load(value, &storedValue);
+                *result = FromD2DRect(*ReinterpretAs<D2D1_RECT_F*>(&storedValue));
             }
         };
 
@@ -468,15 +541,15 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         template<>
         struct PropertyTypeConverter<ConvertRadiansToDegrees, float>
         {
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, float value)
+            static void Store(float value, EffectPropertyValue* result)
             {
-                return CreateProperty(factory, ::DirectX::XMConvertToDegrees(value));
+                result->Set(::DirectX::XMConvertToDegrees(value));
             }
 
-            static void Unbox(IPropertyValue* propertyValue, float* result)
+            static void Load(EffectPropertyValue const& value, float* result)
             {
                 float degrees;
-                GetValueOfProperty(propertyValue, &degrees);
+                value.Get(&degrees);
                 *result = ::DirectX::XMConvertToRadians(degrees);
             }
         };
@@ -489,92 +562,23 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             static_assert(D2D1_COLORMATRIX_ALPHA_MODE_PREMULTIPLIED == D2D1_ALPHA_MODE_PREMULTIPLIED, "Enum values should match");
             static_assert(D2D1_COLORMATRIX_ALPHA_MODE_STRAIGHT == D2D1_ALPHA_MODE_STRAIGHT, "Enum values should match");
 
-            static ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory, CanvasAlphaMode value)
+            static void Store(CanvasAlphaMode value, EffectPropertyValue* result)
             {
                 if (value == CanvasAlphaMode::Ignore)
                     ThrowHR(E_INVALIDARG);
 
-                return CreateProperty(factory, static_cast<uint32_t>(ToD2DAlphaMode(value)));
+                result->Set(static_cast<uint32_t>(ToD2DAlphaMode(value)));
             }
 
-            static void Unbox(IPropertyValue* propertyValue, CanvasAlphaMode* result)
+            static void Load(EffectPropertyValue const& value, CanvasAlphaMode* result)
             {
-                uint32_t value;
-                GetValueOfProperty(propertyValue, &value);
-                *result = FromD2DAlphaMode(static_cast<D2D1_ALPHA_MODE>(value));
+                uint32_t storedValue;
+                value.Get(&storedValue);
+                *result = FromD2DAlphaMode(static_cast<D2D1_ALPHA_MODE>(storedValue));
             }
         };
 
 
-        //
-        // Wrap the IPropertyValue accessors (which use different method names for each type) with
-        // overloaded C++ versions that can be used by generic PropertyTypeConverter implementations.
-        //
-
-#define PROPERTY_TYPE_ACCESSOR(TYPE, WINRT_NAME)                                                        \
-        static ComPtr<IPropertyValue> CreateProperty(IPropertyValueStatics* factory, TYPE const& value) \
-        {                                                                                               \
-            ComPtr<IPropertyValue> propertyValue;                                                       \
-            ThrowIfFailed(factory->Create##WINRT_NAME(value, &propertyValue));                          \
-            return propertyValue;                                                                       \
-        }                                                                                               \
-                                                                                                        \
-        static void GetValueOfProperty(IPropertyValue* propertyValue, TYPE* result)                     \
-        {                                                                                               \
-            ThrowIfFailed(propertyValue->Get##WINRT_NAME(result));                                      \
-        }
-
-#define ARRAY_PROPERTY_TYPE_ACCESSOR(TYPE, WINRT_NAME)                                                                          \
-        static ComPtr<IPropertyValue> CreateProperty(IPropertyValueStatics* factory, uint32_t valueCount, TYPE const* value)    \
-        {                                                                                                                       \
-            ComPtr<IPropertyValue> propertyValue;                                                                               \
-            ThrowIfFailed(factory->Create##WINRT_NAME##Array(valueCount, const_cast<TYPE*>(value), &propertyValue));            \
-            return propertyValue;                                                                                               \
-        }                                                                                                                       \
-                                                                                                                                \
-        static void GetValueOfProperty(IPropertyValue* propertyValue, uint32_t* valueCount, TYPE** value)                       \
-        {                                                                                                                       \
-            ThrowIfFailed(propertyValue->Get##WINRT_NAME##Array(valueCount, value));                                            \
-        }
-
-        PROPERTY_TYPE_ACCESSOR(float,    Single)
-        PROPERTY_TYPE_ACCESSOR(int32_t,  Int32)
-        PROPERTY_TYPE_ACCESSOR(uint32_t, UInt32)
-        PROPERTY_TYPE_ACCESSOR(boolean,  Boolean)
-        
-        ARRAY_PROPERTY_TYPE_ACCESSOR(float, Single)
-
-#undef PROPERTY_TYPE_ACCESSOR
-#undef ARRAY_PROPERTY_TYPE_ACCESSOR
-
-
-        // Interface types are stored as a PropertyType_InspectableArray containing a single IInspectable.
-        // This is because IPropertyValue provides CreateInspectableArray, but not CreateInspectable.
-        static ComPtr<IPropertyValue> CreateProperty(IPropertyValueStatics* factory, IInspectable* value)
-        {
-            ComPtr<IPropertyValue> propertyValue;
-            ThrowIfFailed(factory->CreateInspectableArray(1, &value, &propertyValue));
-            return propertyValue;
-        }
-
-        template<typename T>
-        static void GetValueOfProperty(IPropertyValue* propertyValue, T** result)
-        {
-            static_assert(std::is_base_of<IInspectable, T>::value, "Interface types must be IInspectable");
-            
-            ComArray<ComPtr<IInspectable>> value;
-            ThrowIfFailed(propertyValue->GetInspectableArray(value.GetAddressOfSize(), value.GetAddressOfData()));
-
-            if (value.GetSize() != 1)
-                ThrowHR(E_NOTIMPL);
-
-            if (value[0])
-                ThrowIfFailed(value[0].CopyTo(result));
-            else
-                *result = nullptr;
-        }
-
-
         //
         // Macros used by the generated strongly typed effect subclasses
         // 
@@ -0,0 +1,245 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "ColorMatrixFolding.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    // Luminance weights used by the D2D saturation and hue rotation effects
+    // (the same as the SVG feColorMatrix filter).
+    static const float LuminanceR = 0.213f;
+    static const float LuminanceG = 0.715f;
+    static const float LuminanceB = 0.072f;
+
+
+    D2D1_MATRIX_5X4_F MakeIdentityColorMatrix()
+    {
+        return MakeScaleColorMatrix(1, 1, 1, 1);
+    }
+
+
+    D2D1_MATRIX_5X4_F MakeScaleColorMatrix(float r, float g, float b, float a)
+    {
+        D2D1_MATRIX_5X4_F matrix{};
+
+        matrix.m[0][0] = r;
+        matrix.m[1][1] = g;
+        matrix.m[2][2] = b;
+        matrix.m[3][3] = a;
+
+        return matrix;
+    }
+
+
+    D2D1_MATRIX_5X4_F MakeSaturationColorMatrix(float saturation)
+    {
+        float s = saturation;
+
+        D2D1_MATRIX_5X4_F matrix{};
+
+        matrix.m[0][0] = LuminanceR + (1 - LuminanceR) * s;
+        matrix.m[0][1] = LuminanceR - LuminanceR * s;
+        matrix.m[0][2] = LuminanceR - LuminanceR * s;
+
+        matrix.m[1][0] = LuminanceG - LuminanceG * s;
+        matrix.m[1][1] = LuminanceG + (1 - LuminanceG) * s;
+        matrix.m[1][2] = LuminanceG - LuminanceG * s;
+
+        matrix.m[2][0] = LuminanceB - LuminanceB * s;
+        matrix.m[2][1] = LuminanceB - LuminanceB * s;
+        matrix.m[2][2] = LuminanceB + (1 - LuminanceB) * s;
+
+        matrix.m[3][3] = 1;
+
+        return matrix;
+    }
+
+
+    D2D1_MATRIX_5X4_F MakeHueRotationColorMatrix(float degrees)
+    {
+        float radians = ::DirectX::XMConvertToRadians(degrees);
+        float c = cosf(radians);
+        float s = sinf(radians);
+
+        D2D1_MATRIX_5X4_F matrix{};
+
+        matrix.m[0][0] = LuminanceR + c * 0.787f - s * 0.213f;
+        matrix.m[0][1] = LuminanceR - c * 0.213f + s * 0.143f;
+        matrix.m[0][2] = LuminanceR - c * 0.213f - s * 0.787f;
+
+        matrix.m[1][0] = LuminanceG - c * 0.715f - s * 0.715f;
+        matrix.m[1][1] = LuminanceG + c * 0.285f + s * 0.140f;
+        matrix.m[1][2] = LuminanceG - c * 0.715f + s * 0.715f;
+
+        matrix.m[2][0] = LuminanceB - c * 0.072f + s * 0.928f;
+        matrix.m[2][1] = LuminanceB - c * 0.072f - s * 0.283f;
+        matrix.m[2][2] = LuminanceB + c * 0.928f + s * 0.072f;
+
+        matrix.m[3][3] = 1;
+
+        return matrix;
+    }
+
+
+    D2D1_MATRIX_5X4_F CombineColorMatrices(D2D1_MATRIX_5X4_F const& first, D2D1_MATRIX_5X4_F const& second)
+    {
+        D2D1_MATRIX_5X4_F result;
+
+        for (int row = 0; row < 5; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                // The offset row is treated as if it were the color [0 0 0 0 1].
+                float value = (row == 4) ? second.m[4][column] : 0;
+
+                for (int k = 0; k < 4; k++)
+                {
+                    value += first.m[row][k] * second.m[k][column];
+                }
+
+                result.m[row][column] = value;
+            }
+        }
+
+        return result;
+    }
+
+
+    bool IsIdentityColorMatrix(D2D1_MATRIX_5X4_F const& matrix)
+    {
+        // The luminance weights don't add up to exactly 1 in floating point, so
+        // eg. a zero degree hue rotation needs a little tolerance.
+        const float epsilon = 1e-6f;
+
+        auto identity = MakeIdentityColorMatrix();
+
+        for (int row = 0; row < 5; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                if (fabs(matrix.m[row][column] - identity.m[row][column]) > epsilon)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    static bool TryGetMatrixProperty(EffectPropertyValue const& value, D2D1_MATRIX_5X4_F* matrix)
+    {
+        if (value.GetType() != EffectPropertyValue::Type::SingleArray)
+            return false;
+
+        uint32_t valueCount;
+        auto values = value.GetSingleArray(&valueCount);
+
+        if (valueCount != 20)
+            return false;
+
+        memcpy(matrix, values, sizeof(*matrix));
+        return true;
+    }
+
+
+    static bool GetBooleanProperty(EffectPropertyValue const& value)
+    {
+        boolean result;
+        value.Get(&result);
+        return !!result;
+    }
+
+
+    static float GetFloatProperty(EffectPropertyValue const& value)
+    {
+        float result;
+        value.Get(&result);
+        return result;
+    }
+
+
+    bool IsColorTransformEffect(IID const& effectId)
+    {
+        return IsEqualGUID(effectId, CLSID_D2D1ColorMatrix) ||
+               IsEqualGUID(effectId, CLSID_D2D1Saturation) ||
+               IsEqualGUID(effectId, CLSID_D2D1HueRotation) ||
+               IsEqualGUID(effectId, CLSID_D2D1Opacity) ||
+               IsEqualGUID(effectId, CLSID_D2D1Tint);
+    }
+
+
+    bool TryGetEffectColorMatrix(IID const& effectId, std::vector<EffectPropertyValue> const& properties, D2D1_MATRIX_5X4_F* matrix, bool* clampOutput)
+    {
+        *clampOutput = false;
+
+        if (IsEqualGUID(effectId, CLSID_D2D1ColorMatrix))
+        {
+            if (properties.size() <= D2D1_COLORMATRIX_PROP_CLAMP_OUTPUT)
+                return false;
+
+            // In straight alpha mode the matrix applies to premultiplied colors,
+            // so can't be combined with the others.
+            uint32_t alphaMode;
+            properties[D2D1_COLORMATRIX_PROP_ALPHA_MODE].Get(&alphaMode);
+
+            if (alphaMode != D2D1_COLORMATRIX_ALPHA_MODE_PREMULTIPLIED)
+                return false;
+
+            *clampOutput = GetBooleanProperty(properties[D2D1_COLORMATRIX_PROP_CLAMP_OUTPUT]);
+
+            return TryGetMatrixProperty(properties[D2D1_COLORMATRIX_PROP_COLOR_MATRIX], matrix);
+        }
+        else if (IsEqualGUID(effectId, CLSID_D2D1Saturation))
+        {
+            if (properties.size() <= D2D1_SATURATION_PROP_SATURATION)
+                return false;
+
+            *matrix = MakeSaturationColorMatrix(GetFloatProperty(properties[D2D1_SATURATION_PROP_SATURATION]));
+            return true;
+        }
+        else if (IsEqualGUID(effectId, CLSID_D2D1HueRotation))
+        {
+            if (properties.size() <= D2D1_HUEROTATION_PROP_ANGLE)
+                return false;
+
+            *matrix = MakeHueRotationColorMatrix(GetFloatProperty(properties[D2D1_HUEROTATION_PROP_ANGLE]));
+            return true;
+        }
+        else if (IsEqualGUID(effectId, CLSID_D2D1Opacity))
+        {
+            if (properties.size() <= D2D1_OPACITY_PROP_OPACITY)
+                return false;
+
+            *matrix = MakeScaleColorMatrix(1, 1, 1, GetFloatProperty(properties[D2D1_OPACITY_PROP_OPACITY]));
+            return true;
+        }
+        else if (IsEqualGUID(effectId, CLSID_D2D1Tint))
+        {
+            if (properties.size() <= D2D1_TINT_PROP_CLAMP_OUTPUT)
+                return false;
+
+            auto& colorProperty = properties[D2D1_TINT_PROP_COLOR];
+
+            if (colorProperty.GetType() != EffectPropertyValue::Type::SingleArray)
+                return false;
+
+            uint32_t valueCount;
+            auto color = colorProperty.GetSingleArray(&valueCount);
+
+            // Only opaque tints are folded.  With an opaque color, scaling the
+            // channels is the same whether Tint works on straight or
+            // premultiplied colors, which isn't true once alpha is involved.
+            if (valueCount != 4 || color[3] != 1.0f)
+                return false;
+
+            *clampOutput = GetBooleanProperty(properties[D2D1_TINT_PROP_CLAMP_OUTPUT]);
+            *matrix = MakeScaleColorMatrix(color[0], color[1], color[2], 1);
+            return true;
+        }
+
+        return false;
+    }
+}}}}}
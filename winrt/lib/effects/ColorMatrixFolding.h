@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include "EffectPropertyValue.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    //
+    // Math used to fold chains of per-pixel color effects into a single
+    // D2D1ColorMatrix (see WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS).
+    //
+    // Matrices use the D2D1ColorMatrix convention: the straight alpha color
+    // row vector [r g b a 1] is multiplied by the 5x4 matrix, so row 4 holds
+    // the offsets.  This is what D2D1ColorMatrix does in its default
+    // (premultiplied) alpha mode, which unpremultiplies its input first.
+    //
+
+    D2D1_MATRIX_5X4_F MakeIdentityColorMatrix();
+    D2D1_MATRIX_5X4_F MakeSaturationColorMatrix(float saturation);
+    D2D1_MATRIX_5X4_F MakeHueRotationColorMatrix(float degrees);
+    D2D1_MATRIX_5X4_F MakeScaleColorMatrix(float r, float g, float b, float a);
+
+    // Returns the matrix that applies first, then second.
+    D2D1_MATRIX_5X4_F CombineColorMatrices(D2D1_MATRIX_5X4_F const& first, D2D1_MATRIX_5X4_F const& second);
+
+    bool IsIdentityColorMatrix(D2D1_MATRIX_5X4_F const& matrix);
+
+    // Whether TryGetEffectColorMatrix knows about this type of effect.
+    bool IsColorTransformEffect(IID const& effectId);
+
+    // Works out the color matrix that is equivalent to a D2D effect with the
+    // specified property values (indexed the same as the D2D properties).
+    // Returns false if the effect is not a color transform, or is configured
+    // in a way that can't be expressed as one.
+    bool TryGetEffectColorMatrix(IID const& effectId, std::vector<EffectPropertyValue> const& properties, D2D1_MATRIX_5X4_F* matrix, bool* clampOutput);
+}}}}}
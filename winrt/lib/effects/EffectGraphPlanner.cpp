@@ -0,0 +1,335 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "EffectGraphPlanner.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    // Limits recursion when walking pathologically deep graphs.
+    static const unsigned int MaxGraphDepth = 256;
+
+    // D2D reports the bounds of effects that generate an infinite output (eg. flood)
+    // either as +/- FLT_MAX, or clamped to this logically infinite size.
+    static const float MaxBoundedExtent = 4194304.0f;
+
+
+    void EffectGraphPlanner::Analyze(ICanvasEffect* root, ICanvasResourceCreatorWithDpi* resourceCreator)
+    {
+        CheckInPointer(root);
+        CheckInPointer(resourceCreator);
+
+        m_nodes.clear();
+
+        std::map<IUnknown*, size_t> nodeIndices;
+
+        AddNode(root, nodeIndices, 0);
+
+        for (size_t i = 0; i < m_nodes.size(); i++)
+        {
+            m_nodes[i].SubgraphSize = CountSubgraph(i);
+        }
+
+        float dpi;
+        ThrowIfFailed(resourceCreator->get_Dpi(&dpi));
+
+        auto baseResourceCreator = As<ICanvasResourceCreator>(resourceCreator);
+
+        for (auto& node : m_nodes)
+        {
+            MeasureNode(node, baseResourceCreator.Get(), dpi);
+        }
+    }
+
+
+    size_t EffectGraphPlanner::AddNode(ICanvasEffect* effect, std::map<IUnknown*, size_t>& nodeIndices, unsigned int depth)
+    {
+        if (depth >= MaxGraphDepth)
+            ThrowHR(D2DERR_CYCLIC_GRAPH);
+
+        auto identity = As<IUnknown>(effect);
+
+        auto it = nodeIndices.find(identity.Get());
+
+        if (it != nodeIndices.end())
+            return it->second;
+
+        auto index = m_nodes.size();
+
+        nodeIndices.insert(std::make_pair(identity.Get(), index));
+
+        EffectGraphNode node{};
+        node.Effect = effect;
+        m_nodes.push_back(node);
+
+        // Walk the sources through the public interop interface, so the planner sees
+        // the same graph as any other app code (eg. folded color effects still appear).
+        auto effectInterop = As<IGraphicsEffectD2D1Interop>(effect);
+
+        UINT sourceCount;
+        ThrowIfFailed(effectInterop->GetSourceCount(&sourceCount));
+
+        for (UINT i = 0; i < sourceCount; i++)
+        {
+            ComPtr<IGraphicsEffectSource> source;
+            ThrowIfFailed(effectInterop->GetSource(i, &source));
+
+            auto sourceEffect = MaybeAs<ICanvasEffect>(source);
+
+            if (!sourceEffect)
+                continue;
+
+            // m_nodes may be reallocated by the recursion, so don't hold references into it.
+            auto sourceIndex = AddNode(sourceEffect.Get(), nodeIndices, depth + 1);
+
+            m_nodes[index].Sources.push_back(sourceIndex);
+            m_nodes[sourceIndex].Consumers.push_back(index);
+        }
+
+        return index;
+    }
+
+
+    unsigned int EffectGraphPlanner::CountSubgraph(size_t index) const
+    {
+        std::vector<bool> visited(m_nodes.size());
+        std::vector<size_t> pending{ index };
+
+        unsigned int count = 0;
+
+        while (!pending.empty())
+        {
+            auto i = pending.back();
+            pending.pop_back();
+
+            if (visited[i])
+                continue;
+
+            visited[i] = true;
+            count++;
+
+            pending.insert(pending.end(), m_nodes[i].Sources.begin(), m_nodes[i].Sources.end());
+        }
+
+        return count;
+    }
+
+
+    void EffectGraphPlanner::MeasureNode(EffectGraphNode& node, ICanvasResourceCreator* resourceCreator, float dpi)
+    {
+        ThrowIfFailed(As<ICanvasImage>(node.Effect)->GetBounds(resourceCreator, &node.Bounds));
+
+        auto width = node.Bounds.Width * dpi / DEFAULT_DPI;
+        auto height = node.Bounds.Height * dpi / DEFAULT_DPI;
+
+        node.IsBounded = std::isfinite(width) && std::isfinite(height) &&
+                         width < MaxBoundedExtent && height < MaxBoundedExtent;
+
+        node.PixelCount = node.IsBounded ? static_cast<uint64_t>(ceil(width)) * static_cast<uint64_t>(ceil(height)) : 0;
+
+        ComPtr<IReference<CanvasBufferPrecision>> precision;
+        ThrowIfFailed(node.Effect->get_BufferPrecision(&precision));
+
+        if (precision)
+        {
+            CanvasBufferPrecision value;
+            ThrowIfFailed(precision->get_Value(&value));
+            node.Precision = ToD2DBufferPrecision(value);
+        }
+        else
+        {
+            node.Precision = D2D1_BUFFER_PRECISION_UNKNOWN;
+        }
+
+        boolean cacheOutput;
+        ThrowIfFailed(node.Effect->get_CacheOutput(&cacheOutput));
+        node.CacheOutput = !!cacheOutput;
+    }
+
+
+    uint32_t EffectGraphPlanner::GetBytesPerPixel(D2D1_BUFFER_PRECISION precision)
+    {
+        switch (precision)
+        {
+        case D2D1_BUFFER_PRECISION_8BPC_UNORM:
+        case D2D1_BUFFER_PRECISION_8BPC_UNORM_SRGB:
+            return 4;
+
+        case D2D1_BUFFER_PRECISION_16BPC_UNORM:
+        case D2D1_BUFFER_PRECISION_16BPC_FLOAT:
+            return 8;
+
+        case D2D1_BUFFER_PRECISION_32BPC_FLOAT:
+            return 16;
+
+        default:
+            ThrowHR(E_INVALIDARG);
+        }
+    }
+
+
+    EffectGraphPlan EffectGraphPlanner::Plan(EffectGraphPlanOptions const& options) const
+    {
+        auto defaultBytesPerPixel = GetBytesPerPixel(options.DefaultPrecision);
+
+        auto getBytesPerPixel = [&](D2D1_BUFFER_PRECISION precision)
+        {
+            return (precision == D2D1_BUFFER_PRECISION_UNKNOWN) ? defaultBytesPerPixel : GetBytesPerPixel(precision);
+        };
+
+        EffectGraphPlan plan{};
+
+        plan.Entries.resize(m_nodes.size());
+
+        std::vector<size_t> candidates;
+
+        for (size_t i = 0; i < m_nodes.size(); i++)
+        {
+            auto& node = m_nodes[i];
+            auto& entry = plan.Entries[i];
+
+            entry.CacheOutput = false;
+            entry.Precision = node.Precision;
+            entry.Bytes = node.PixelCount * getBytesPerPixel(node.Precision);
+
+            plan.IntermediateBytes += entry.Bytes;
+
+            if (node.IsBounded && node.PixelCount > 0)
+                candidates.push_back(i);
+        }
+
+        // Effects that feed more consumers, or sit on top of more work, save the most
+        // rendering when cached. Rank them by how much of that we get for each byte.
+        auto getBenefit = [&](size_t i)
+        {
+            auto& node = m_nodes[i];
+            return static_cast<double>(node.SubgraphSize) * std::max<size_t>(node.Consumers.size(), 1) / plan.Entries[i].Bytes;
+        };
+
+        std::stable_sort(candidates.begin(), candidates.end(),
+            [&](size_t a, size_t b)
+            {
+                return getBenefit(a) > getBenefit(b);
+            });
+
+        std::vector<int> memo;
+
+        auto isRedundant = [&](size_t i)
+        {
+            memo.assign(m_nodes.size(), -1);
+            return IsRedundant(i, plan.Entries, memo);
+        };
+
+        for (auto i : candidates)
+        {
+            auto& entry = plan.Entries[i];
+
+            if (isRedundant(i))
+                continue;
+
+            auto bytes = entry.Bytes;
+            auto precision = entry.Precision;
+
+            if (plan.CachedBytes + bytes > options.ByteBudget)
+            {
+                auto reducedBytes = m_nodes[i].PixelCount * GetBytesPerPixel(D2D1_BUFFER_PRECISION_8BPC_UNORM);
+
+                if (!options.AllowPrecisionReduction ||
+                    reducedBytes >= bytes ||
+                    plan.CachedBytes + reducedBytes > options.ByteBudget)
+                {
+                    continue;
+                }
+
+                bytes = reducedBytes;
+                precision = D2D1_BUFFER_PRECISION_8BPC_UNORM;
+            }
+
+            entry.CacheOutput = true;
+            entry.Precision = precision;
+            entry.Bytes = bytes;
+
+            plan.CachedBytes += bytes;
+
+            // Anything already chosen that is only read via this effect is no longer needed.
+            for (size_t j = 0; j < plan.Entries.size(); j++)
+            {
+                auto& other = plan.Entries[j];
+
+                if (j == i || !other.CacheOutput || !isRedundant(j))
+                    continue;
+
+                plan.CachedBytes -= other.Bytes;
+
+                other.CacheOutput = false;
+                other.Precision = m_nodes[j].Precision;
+                other.Bytes = m_nodes[j].PixelCount * getBytesPerPixel(other.Precision);
+            }
+        }
+
+        return plan;
+    }
+
+
+    // An effect's output is never read when everything consuming it is either cached or
+    // itself redundant. The root has no consumers, but is always read by whoever draws it.
+    bool EffectGraphPlanner::IsRedundant(size_t index, std::vector<EffectGraphPlanEntry> const& entries, std::vector<int>& memo) const
+    {
+        if (memo[index] >= 0)
+            return !!memo[index];
+
+        // Guards against cycles: a node is assumed to be needed until proven otherwise.
+        memo[index] = 0;
+
+        auto& consumers = m_nodes[index].Consumers;
+
+        bool isRedundant = !consumers.empty() &&
+            std::all_of(consumers.begin(), consumers.end(),
+                [&](size_t consumer)
+                {
+                    return entries[consumer].CacheOutput || IsRedundant(consumer, entries, memo);
+                });
+
+        memo[index] = isRedundant;
+
+        return isRedundant;
+    }
+
+
+    void EffectGraphPlanner::Apply(EffectGraphPlan const& plan)
+    {
+        if (plan.Entries.size() != m_nodes.size())
+            ThrowHR(E_INVALIDARG);
+
+        for (size_t i = 0; i < m_nodes.size(); i++)
+        {
+            auto& node = m_nodes[i];
+            auto& entry = plan.Entries[i];
+
+            // Precision first, so a newly cached output is stored at the planned size.
+            if (entry.Precision != node.Precision)
+            {
+                ComPtr<IReference<CanvasBufferPrecision>> precision;
+
+                if (entry.Precision != D2D1_BUFFER_PRECISION_UNKNOWN)
+                {
+                    precision = Make<Nullable<CanvasBufferPrecision>>(FromD2DBufferPrecision(entry.Precision));
+                    CheckMakeResult(precision);
+                }
+
+                ThrowIfFailed(node.Effect->put_BufferPrecision(precision.Get()));
+
+                node.Precision = entry.Precision;
+            }
+
+            if (entry.CacheOutput != node.CacheOutput)
+            {
+                ThrowIfFailed(node.Effect->put_CacheOutput(entry.CacheOutput));
+
+                node.CacheOutput = entry.CacheOutput;
+            }
+        }
+    }
+}}}}}
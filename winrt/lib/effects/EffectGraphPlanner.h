@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    using namespace ::Microsoft::WRL;
+    using namespace ABI::Windows::Foundation;
+
+    // What the planner knows about one effect in the graph.
+    struct EffectGraphNode
+    {
+        ComPtr<ICanvasEffect> Effect;
+
+        // Indices of the effect nodes read by this one (other sources, such as
+        // bitmaps, are leaves and not tracked), and of the nodes reading it.
+        // A node that reads the same source twice lists it twice.
+        std::vector<size_t> Sources;
+        std::vector<size_t> Consumers;
+
+        // Number of distinct effects D2D evaluates to produce this output, including itself.
+        unsigned int SubgraphSize;
+
+        // Output bounds in DIPs, as returned by ICanvasImage::GetBounds, and their size
+        // in pixels at the DPI of the resource creator the graph was analyzed with.
+        Rect Bounds;
+        bool IsBounded;
+        uint64_t PixelCount;
+
+        // UNKNOWN if the effect inherits its precision from the device context.
+        D2D1_BUFFER_PRECISION Precision;
+        bool CacheOutput;
+    };
+
+
+    struct EffectGraphPlanOptions
+    {
+        // Upper limit on memory used by cached effect outputs.
+        uint64_t ByteBudget;
+
+        // Precision assumed for effects that don't specify one.
+        D2D1_BUFFER_PRECISION DefaultPrecision;
+
+        // Allows high precision effects to be cached at 8 bits per channel,
+        // when they would not otherwise fit in the budget.
+        bool AllowPrecisionReduction;
+
+        EffectGraphPlanOptions()
+            : ByteBudget(0)
+            , DefaultPrecision(D2D1_BUFFER_PRECISION_8BPC_UNORM)
+            , AllowPrecisionReduction(false)
+        { }
+    };
+
+
+    struct EffectGraphPlanEntry
+    {
+        bool CacheOutput;
+        D2D1_BUFFER_PRECISION Precision;
+
+        // Estimated size of the intermediate holding this effect's output.
+        uint64_t Bytes;
+    };
+
+
+    struct EffectGraphPlan
+    {
+        // Parallel to EffectGraphPlanner::Nodes().
+        std::vector<EffectGraphPlanEntry> Entries;
+
+        // Total of Bytes for the entries with CacheOutput set.
+        uint64_t CachedBytes;
+
+        // Total of Bytes for every bounded entry, ie. roughly the intermediate
+        // memory needed if D2D had to keep every effect output around at once.
+        uint64_t IntermediateBytes;
+    };
+
+
+    //
+    // Estimates how much intermediate texture memory each effect in a graph
+    // needs, and chooses which effects should have CacheOutput set so that
+    // the graph can be redrawn without re-evaluating them, without letting
+    // the cached outputs exceed a caller supplied byte budget.
+    //
+    // Analyze realizes the graph on the device of the given resource creator,
+    // so its output bounds can be measured using the same GetBounds path as
+    // ICanvasImage.  Plan is a pure function of the analysis, and Apply
+    // writes the chosen CacheOutput and BufferPrecision values back to the
+    // effects.
+    //
+    // Caching is worth most for effects that are expensive to recompute (ie.
+    // have a large subgraph) or are read by more than one consumer, and costs
+    // least for effects with small outputs.  The planner greedily picks effects in order
+    // of benefit per byte, and skips effects whose output would never be read
+    // because everything consuming them is already cached.  Effects with
+    // unbounded output (eg. floods or borders) can't be cached.
+    //
+    class EffectGraphPlanner
+    {
+        std::vector<EffectGraphNode> m_nodes;
+
+    public:
+        // Replaces any previous analysis.  The root is always Nodes()[0].
+        void Analyze(ICanvasEffect* root, ICanvasResourceCreatorWithDpi* resourceCreator);
+
+        std::vector<EffectGraphNode> const& Nodes() const { return m_nodes; }
+
+        EffectGraphPlan Plan(EffectGraphPlanOptions const& options) const;
+
+        void Apply(EffectGraphPlan const& plan);
+
+        static uint32_t GetBytesPerPixel(D2D1_BUFFER_PRECISION precision);
+
+    private:
+        size_t AddNode(ICanvasEffect* effect, std::map<IUnknown*, size_t>& nodeIndices, unsigned int depth);
+
+        void MeasureNode(EffectGraphNode& node, ICanvasResourceCreator* resourceCreator, float dpi);
+
+        unsigned int CountSubgraph(size_t index) const;
+
+        bool IsRedundant(size_t index, std::vector<EffectGraphPlanEntry> const& entries, std::vector<int>& memo) const;
+    };
+}}}}}
@@ -0,0 +1,254 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "EffectPropertyValue.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    EffectPropertyValue::EffectPropertyValue()
+        : m_type(Type::Empty)
+        , m_scalar{}
+        , m_arrayCount(0)
+    {
+    }
+
+
+    void EffectPropertyValue::Clear()
+    {
+        m_type = Type::Empty;
+        m_arrayCount = 0;
+        m_heapArray = std::vector<float>();
+        m_inspectable.Reset();
+    }
+
+
+    void EffectPropertyValue::Set(boolean value)
+    {
+        Clear();
+        m_type = Type::Boolean;
+        m_scalar.Boolean = value;
+    }
+
+
+    void EffectPropertyValue::Set(int32_t value)
+    {
+        Clear();
+        m_type = Type::Int32;
+        m_scalar.Int32 = value;
+    }
+
+
+    void EffectPropertyValue::Set(uint32_t value)
+    {
+        Clear();
+        m_type = Type::UInt32;
+        m_scalar.UInt32 = value;
+    }
+
+
+    void EffectPropertyValue::Set(float value)
+    {
+        Clear();
+        m_type = Type::Single;
+        m_scalar.Single = value;
+    }
+
+
+    void EffectPropertyValue::Set(uint32_t valueCount, float const* value)
+    {
+        if (valueCount > 0)
+            CheckInPointer(value);
+
+        // Keep any heap array, so that repeatedly setting a long array can
+        // reuse its storage.
+        m_inspectable.Reset();
+        m_type = Type::SingleArray;
+        m_arrayCount = 0;
+        m_heapArray.clear();
+
+        std::copy_n(value, valueCount, ResizeSingleArray(valueCount));
+    }
+
+
+    void EffectPropertyValue::Set(IInspectable* value)
+    {
+        Clear();
+        m_type = Type::Inspectable;
+        m_inspectable = value;
+    }
+
+
+    void EffectPropertyValue::Get(boolean* result) const
+    {
+        if (m_type != Type::Boolean)
+            ThrowHR(TYPE_E_TYPEMISMATCH);
+
+        *result = m_scalar.Boolean;
+    }
+
+
+    void EffectPropertyValue::Get(int32_t* result) const
+    {
+        switch (m_type)
+        {
+        case Type::Int32:
+            *result = m_scalar.Int32;
+            break;
+
+        case Type::UInt32:
+            if (m_scalar.UInt32 > static_cast<uint32_t>(INT32_MAX))
+                ThrowHR(E_BOUNDS);
+
+            *result = static_cast<int32_t>(m_scalar.UInt32);
+            break;
+
+        default:
+            ThrowHR(TYPE_E_TYPEMISMATCH);
+        }
+    }
+
+
+    void EffectPropertyValue::Get(uint32_t* result) const
+    {
+        switch (m_type)
+        {
+        case Type::UInt32:
+            *result = m_scalar.UInt32;
+            break;
+
+        case Type::Int32:
+            if (m_scalar.Int32 < 0)
+                ThrowHR(E_BOUNDS);
+
+            *result = static_cast<uint32_t>(m_scalar.Int32);
+            break;
+
+        default:
+            ThrowHR(TYPE_E_TYPEMISMATCH);
+        }
+    }
+
+
+    void EffectPropertyValue::Get(float* result) const
+    {
+        switch (m_type)
+        {
+        case Type::Single:
+            *result = m_scalar.Single;
+            break;
+
+        case Type::Int32:
+            *result = static_cast<float>(m_scalar.Int32);
+            break;
+
+        case Type::UInt32:
+            *result = static_cast<float>(m_scalar.UInt32);
+            break;
+
+        default:
+            ThrowHR(TYPE_E_TYPEMISMATCH);
+        }
+    }
+
+
+    float const* EffectPropertyValue::GetSingleArray(uint32_t* valueCount) const
+    {
+        if (m_type != Type::SingleArray)
+            ThrowHR(TYPE_E_TYPEMISMATCH);
+
+        *valueCount = m_arrayCount;
+
+        return m_heapArray.empty() ? m_inlineArray : m_heapArray.data();
+    }
+
+
+    float* EffectPropertyValue::ResizeSingleArray(uint32_t valueCount)
+    {
+        if (m_type != Type::SingleArray)
+        {
+            Clear();
+            m_type = Type::SingleArray;
+        }
+
+        if (valueCount <= InlineArrayCapacity)
+        {
+            if (!m_heapArray.empty())
+            {
+                std::copy_n(m_heapArray.data(), std::min(valueCount, m_arrayCount), m_inlineArray);
+                m_heapArray = std::vector<float>();
+            }
+
+            m_arrayCount = valueCount;
+
+            return m_inlineArray;
+        }
+        else
+        {
+            if (m_heapArray.empty())
+                m_heapArray.assign(m_inlineArray, m_inlineArray + m_arrayCount);
+
+            m_heapArray.resize(valueCount);
+            m_arrayCount = valueCount;
+
+            return m_heapArray.data();
+        }
+    }
+
+
+    IInspectable* EffectPropertyValue::GetInspectable() const
+    {
+        if (m_type != Type::Inspectable)
+            ThrowHR(TYPE_E_TYPEMISMATCH);
+
+        return m_inspectable.Get();
+    }
+
+
+    ComPtr<IPropertyValue> EffectPropertyValue::Box(IPropertyValueStatics* factory) const
+    {
+        ComPtr<IPropertyValue> propertyValue;
+
+        switch (m_type)
+        {
+        case Type::Empty:
+            break;
+
+        case Type::Boolean:
+            ThrowIfFailed(factory->CreateBoolean(m_scalar.Boolean, &propertyValue));
+            break;
+
+        case Type::Int32:
+            ThrowIfFailed(factory->CreateInt32(m_scalar.Int32, &propertyValue));
+            break;
+
+        case Type::UInt32:
+            ThrowIfFailed(factory->CreateUInt32(m_scalar.UInt32, &propertyValue));
+            break;
+
+        case Type::Single:
+            ThrowIfFailed(factory->CreateSingle(m_scalar.Single, &propertyValue));
+            break;
+
+        case Type::SingleArray:
+            {
+                uint32_t valueCount;
+                auto value = GetSingleArray(&valueCount);
+                ThrowIfFailed(factory->CreateSingleArray(valueCount, const_cast<float*>(value), &propertyValue));
+            }
+            break;
+
+        case Type::Inspectable:
+            {
+                // IPropertyValue provides CreateInspectableArray, but not CreateInspectable.
+                auto value = m_inspectable.Get();
+                ThrowIfFailed(factory->CreateInspectableArray(1, &value, &propertyValue));
+            }
+            break;
+        }
+
+        return propertyValue;
+    }
+}}}}}
@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    using namespace ::Microsoft::WRL;
+    using namespace ABI::Windows::Foundation;
+
+    //
+    // Typed storage for a single effect property value, used by CanvasEffect
+    // while the effect is not realized.
+    //
+    // Scalars, vectors and matrices (up to and including Matrix5x4) are stored
+    // inline, so setting them, and transferring them to and from a D2D effect,
+    // does not allocate.  Only longer float arrays (such as transfer tables or
+    // convolution kernels) use the heap.  An IPropertyValue is only created
+    // when a value is requested through IGraphicsEffectD2D1Interop.
+    //
+    class EffectPropertyValue
+    {
+    public:
+        enum class Type
+        {
+            Empty,
+            Boolean,
+            Int32,
+            UInt32,
+            Single,
+            SingleArray,
+            Inspectable,
+        };
+
+        // Enough for a Matrix5x4.
+        static const uint32_t InlineArrayCapacity = 20;
+
+    private:
+        Type m_type;
+
+        union
+        {
+            boolean Boolean;
+            int32_t Int32;
+            uint32_t UInt32;
+            float Single;
+        } m_scalar;
+
+        uint32_t m_arrayCount;
+        float m_inlineArray[InlineArrayCapacity];
+        std::vector<float> m_heapArray;
+
+        ComPtr<IInspectable> m_inspectable;
+
+    public:
+        EffectPropertyValue();
+
+        Type GetType() const { return m_type; }
+
+        // Releases any interface reference or heap array held by the value.
+        void Clear();
+
+        void Set(boolean value);
+        void Set(int32_t value);
+        void Set(uint32_t value);
+        void Set(float value);
+        void Set(uint32_t valueCount, float const* value);
+        void Set(IInspectable* value);
+
+        // Numeric getters convert between Int32 and UInt32, matching the
+        // coercion done by IPropertyValue.  This matters because D2D reports
+        // its UINT32 properties as Int32 when they are read back.
+        void Get(boolean* result) const;
+        void Get(int32_t* result) const;
+        void Get(uint32_t* result) const;
+        void Get(float* result) const;
+
+        float const* GetSingleArray(uint32_t* valueCount) const;
+
+        // Returns storage for valueCount floats, for filling in place.  When
+        // shrinking, the existing contents are preserved.
+        float* ResizeSingleArray(uint32_t valueCount);
+
+        template<typename T>
+        void Get(T** result) const
+        {
+            static_assert(std::is_base_of<IInspectable, T>::value, "Interface types must be IInspectable");
+
+            if (m_type != Type::Inspectable)
+                ThrowHR(TYPE_E_TYPEMISMATCH);
+
+            if (m_inspectable)
+                ThrowIfFailed(m_inspectable.CopyTo(result));
+            else
+                *result = nullptr;
+        }
+
+        IInspectable* GetInspectable() const;
+
+        // Creates the equivalent IPropertyValue, or null for an empty value.
+        ComPtr<IPropertyValue> Box(IPropertyValueStatics* factory) const;
+    };
+}}}}}
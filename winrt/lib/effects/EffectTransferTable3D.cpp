@@ -4,6 +4,12 @@
 
 #include "pch.h"
 #include "EffectTransferTable3D.h"
+#include "LookupTableFileParser.h"
+
+#include <DirectXPackedVector.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
 
 
 static D2D1_BUFFER_PRECISION ConvertTableFormatToBufferPrecision(DirectXPixelFormat format)
@@ -107,6 +113,169 @@ ComPtr<EffectTransferTable3D> EffectTransferTable3D::CreateNew(
 }
 
 
+// Expands packed RGB entries to RGBA, reordering them so blue changes fastest.
+// The output is written sequentially, so the input is read with a stride when
+// its red axis changes fastest.
+template<typename TIn, typename TOut, typename TConvert>
+static std::vector<TOut> ExpandPackedRgb(
+    BYTE* bytes,
+    int32_t sizeB,
+    int32_t sizeG,
+    int32_t sizeR,
+    EffectTransferTable3DAxisOrder axisOrder,
+    TConvert&& convert)
+{
+    auto input = reinterpret_cast<TIn const*>(bytes);
+
+    std::vector<TOut> output(static_cast<size_t>(sizeB) * sizeG * sizeR);
+
+    auto redFastest = (axisOrder == EffectTransferTable3DAxisOrder::RedFastest);
+    size_t bStride = redFastest ? static_cast<size_t>(sizeR) * sizeG : 1;
+
+    auto out = output.data();
+
+    for (int32_t r = 0; r < sizeR; r++)
+    {
+        for (int32_t g = 0; g < sizeG; g++)
+        {
+            size_t i = redFastest ? static_cast<size_t>(g) * sizeR + r
+                                  : (static_cast<size_t>(r) * sizeG + g) * sizeB;
+
+            for (int32_t b = 0; b < sizeB; b++, i += bStride)
+            {
+                *out++ = convert(input + i * 3);
+            }
+        }
+    }
+
+    return output;
+}
+
+
+ComPtr<EffectTransferTable3D> EffectTransferTable3D::CreateNew(
+    ICanvasResourceCreator* resourceCreator,
+    uint32_t byteCount,
+    BYTE* bytes,
+    int32_t sizeB,
+    int32_t sizeG,
+    int32_t sizeR,
+    DirectXPixelFormat channelFormat,
+    EffectTransferTable3DAxisOrder axisOrder)
+{
+    CheckInPointer(resourceCreator);
+    CheckInPointer(bytes);
+
+    if (sizeB < 2 || sizeB > 256 ||
+        sizeG < 2 || sizeG > 256 ||
+        sizeR < 2 || sizeR > 256)
+    {
+        ThrowHR(E_INVALIDARG);
+    }
+
+    if (axisOrder != EffectTransferTable3DAxisOrder::BlueFastest &&
+        axisOrder != EffectTransferTable3DAxisOrder::RedFastest)
+    {
+        ThrowHR(E_INVALIDARG);
+    }
+
+    uint32_t bytesPerChannel;
+
+    switch (channelFormat)
+    {
+        case PIXEL_FORMAT(R16Float): bytesPerChannel = 2; break;
+        case PIXEL_FORMAT(R32Float): bytesPerChannel = 4; break;
+
+        default:
+            ThrowHR(WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT);
+    }
+
+    auto bytesNeeded = bytesPerChannel * 3 * sizeB * sizeG * sizeR;
+
+    if (byteCount < bytesNeeded)
+    {
+        ThrowHR(E_INVALIDARG);
+    }
+
+    if (bytesPerChannel == 2)
+    {
+        auto one = XMConvertFloatToHalf(1);
+
+        auto rgba = ExpandPackedRgb<HALF, XMHALF4>(bytes, sizeB, sizeG, sizeR, axisOrder,
+            [=](HALF const* rgb)
+            {
+                return XMHALF4(rgb[0], rgb[1], rgb[2], one);
+            });
+
+        return CreateNew(
+            resourceCreator,
+            static_cast<uint32_t>(rgba.size() * sizeof(XMHALF4)),
+            reinterpret_cast<BYTE*>(rgba.data()),
+            sizeB,
+            sizeG,
+            sizeR,
+            PIXEL_FORMAT(R16G16B16A16Float));
+    }
+    else
+    {
+        auto rgba = ExpandPackedRgb<float, XMFLOAT4>(bytes, sizeB, sizeG, sizeR, axisOrder,
+            [](float const* rgb)
+            {
+                XMFLOAT4 result;
+                XMStoreFloat4(&result, XMVectorSetW(XMLoadFloat3(reinterpret_cast<XMFLOAT3 const*>(rgb)), 1));
+                return result;
+            });
+
+        return CreateNew(
+            resourceCreator,
+            static_cast<uint32_t>(rgba.size() * sizeof(XMFLOAT4)),
+            reinterpret_cast<BYTE*>(rgba.data()),
+            sizeB,
+            sizeG,
+            sizeR,
+            PIXEL_FORMAT(R32G32B32A32Float));
+    }
+}
+
+
+ComPtr<EffectTransferTable3D> EffectTransferTable3D::CreateNew(
+    ICanvasResourceCreator* resourceCreator,
+    IStream* stream)
+{
+    CheckInPointer(resourceCreator);
+    CheckInPointer(stream);
+
+    // Large tables are parsed a chunk at a time rather than reading the whole file up front.
+    LookupTableFileParser parser;
+
+    std::vector<char> buffer(64 * 1024);
+
+    for (;;)
+    {
+        ULONG bytesRead;
+        ThrowIfFailed(stream->Read(buffer.data(), static_cast<ULONG>(buffer.size()), &bytesRead));
+
+        if (bytesRead == 0)
+            break;
+
+        parser.Parse(buffer.data(), bytesRead);
+    }
+
+    parser.Finish();
+
+    auto& table = parser.Table();
+    auto size = parser.Size();
+
+    return CreateNew(
+        resourceCreator,
+        static_cast<uint32_t>(table.size() * sizeof(XMFLOAT4)),
+        reinterpret_cast<BYTE*>(const_cast<XMFLOAT4*>(table.data())),
+        size,
+        size,
+        size,
+        PIXEL_FORMAT(R32G32B32A32Float));
+}
+
+
 EffectTransferTable3D::EffectTransferTable3D(ICanvasDevice* device, ID2D1LookupTable3D* lookupTable)
     : ResourceWrapper(lookupTable)
     , m_device(device)
@@ -174,4 +343,60 @@ IFACEMETHODIMP EffectTransferTable3DFactory::CreateFromBytes(
 }
 
 
+IFACEMETHODIMP EffectTransferTable3DFactory::CreateFromPackedRgb(
+    ICanvasResourceCreator* resourceCreator,
+    uint32_t byteCount,
+    BYTE* bytes,
+    int32_t sizeB,
+    int32_t sizeG,
+    int32_t sizeR,
+    DirectXPixelFormat channelFormat,
+    EffectTransferTable3DAxisOrder axisOrder,
+    IEffectTransferTable3D** result)
+{
+    return ExceptionBoundary([&]
+    {
+        CheckAndClearOutPointer(result);
+
+        auto transferTable = EffectTransferTable3D::CreateNew(resourceCreator, byteCount, bytes, sizeB, sizeG, sizeR, channelFormat, axisOrder);
+
+        ThrowIfFailed(transferTable.CopyTo(result));
+    });
+}
+
+
+IFACEMETHODIMP EffectTransferTable3DFactory::LoadAsync(
+    ICanvasResourceCreator* resourceCreator,
+    ABI::Windows::Storage::Streams::IRandomAccessStream* rawStream,
+    ABI::Windows::Foundation::IAsyncOperation<EffectTransferTable3D*>** result)
+{
+    return ExceptionBoundary([&]
+    {
+        CheckInPointer(resourceCreator);
+        CheckInPointer(rawStream);
+        CheckAndClearOutPointer(result);
+
+        // Hold the device rather than the resource creator, which might be a drawing session.
+        ComPtr<ICanvasDevice> device;
+        ThrowIfFailed(resourceCreator->get_Device(&device));
+
+        auto deviceResourceCreator = As<ICanvasResourceCreator>(device);
+
+        ComPtr<ABI::Windows::Storage::Streams::IRandomAccessStream> stream = rawStream;
+
+        auto asyncOperation = Make<AsyncOperation<EffectTransferTable3D>>(
+            [=]
+            {
+                ComPtr<IStream> nativeStream;
+                ThrowIfFailed(CreateStreamOverRandomAccessStream(stream.Get(), IID_PPV_ARGS(&nativeStream)));
+
+                return EffectTransferTable3D::CreateNew(deviceResourceCreator.Get(), nativeStream.Get());
+            });
+
+        CheckMakeResult(asyncOperation);
+        ThrowIfFailed(asyncOperation.CopyTo(result));
+    });
+}
+
+
 ActivatableStaticOnlyFactory(EffectTransferTable3DFactory);
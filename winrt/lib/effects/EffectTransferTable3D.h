@@ -34,6 +34,21 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             int32_t sizeR,
             DirectXPixelFormat format);
 
+        static ComPtr<EffectTransferTable3D> CreateNew(
+            ICanvasResourceCreator* resourceCreator,
+            uint32_t byteCount,
+            BYTE* bytes,
+            int32_t sizeB,
+            int32_t sizeG,
+            int32_t sizeR,
+            DirectXPixelFormat channelFormat,
+            EffectTransferTable3DAxisOrder axisOrder);
+
+        // Reads a .cube or .3dl file.
+        static ComPtr<EffectTransferTable3D> CreateNew(
+            ICanvasResourceCreator* resourceCreator,
+            IStream* stream);
+
         EffectTransferTable3D(ICanvasDevice* device, ID2D1LookupTable3D* lookupTable);
 
         IFACEMETHOD(Close)() override;
@@ -67,6 +82,22 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             int32_t sizeR,
             DirectXPixelFormat format,
             IEffectTransferTable3D** result) override;
+
+        IFACEMETHOD(CreateFromPackedRgb)(
+            ICanvasResourceCreator* resourceCreator,
+            uint32_t byteCount,
+            BYTE* bytes,
+            int32_t sizeB,
+            int32_t sizeG,
+            int32_t sizeR,
+            DirectXPixelFormat channelFormat,
+            EffectTransferTable3DAxisOrder axisOrder,
+            IEffectTransferTable3D** result) override;
+
+        IFACEMETHOD(LoadAsync)(
+            ICanvasResourceCreator* resourceCreator,
+            ABI::Windows::Storage::Streams::IRandomAccessStream* stream,
+            ABI::Windows::Foundation::IAsyncOperation<EffectTransferTable3D*>** result) override;
     };
 
 }}}}}
@@ -0,0 +1,366 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <charconv>
+
+#include "LookupTableFileParser.h"
+
+using namespace DirectX;
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    // Text files have short lines, so anything longer is probably not text at all.
+    static const size_t MaxLineLength = 64 * 1024;
+
+
+    static bool IsWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+
+    static char const* SkipWhitespace(char const* begin, char const* end)
+    {
+        while (begin != end && IsWhitespace(*begin))
+            begin++;
+
+        return begin;
+    }
+
+
+    static char const* FindWhitespace(char const* begin, char const* end)
+    {
+        while (begin != end && !IsWhitespace(*begin))
+            begin++;
+
+        return begin;
+    }
+
+
+    static bool IsKeyword(char const* begin, char const* end, char const* keyword)
+    {
+        auto length = strlen(keyword);
+
+        return static_cast<size_t>(end - begin) == length && memcmp(begin, keyword, length) == 0;
+    }
+
+
+    LookupTableFileParser::LookupTableFileParser()
+        : m_format(Format::Unknown)
+        , m_lineNumber(0)
+        , m_size(0)
+        , m_entryCount(0)
+        , m_outputBitDepth(0)
+        , m_expectMeshLine(false)
+        , m_maxValue(0)
+    {
+    }
+
+
+    void LookupTableFileParser::Parse(char const* text, size_t length)
+    {
+        auto end = text + length;
+
+        while (text != end)
+        {
+            auto newline = std::find(text, end, '\n');
+
+            if (newline == end)
+            {
+                // Keep the end of the chunk until we see the rest of the line.
+                if (m_partialLine.size() + (end - text) > MaxLineLength)
+                    ThrowInvalidFile();
+
+                m_partialLine.append(text, end);
+                break;
+            }
+
+            if (m_partialLine.empty())
+            {
+                ParseLine(text, newline);
+            }
+            else
+            {
+                m_partialLine.append(text, newline);
+                ParseLine(m_partialLine.data(), m_partialLine.data() + m_partialLine.size());
+                m_partialLine.clear();
+            }
+
+            text = newline + 1;
+        }
+    }
+
+
+    void LookupTableFileParser::Finish()
+    {
+        // The last line need not end with a newline.
+        if (!m_partialLine.empty())
+        {
+            auto line = std::move(m_partialLine);
+            m_partialLine.clear();
+
+            ParseLine(line.data(), line.data() + line.size());
+        }
+
+        if (m_size == 0 || m_entryCount != m_table.size())
+            ThrowInvalidFile();
+
+        if (m_format == Format::ThreeDL)
+        {
+            // .3dl files store integers, with the bit depth either given by a Mesh
+            // keyword or implied by the largest value (matching OpenColorIO).
+            auto bitDepth = m_outputBitDepth;
+
+            if (!bitDepth)
+            {
+                for (bitDepth = 8; bitDepth < 16 && m_maxValue > (1 << bitDepth) - 1; bitDepth += 2)
+                    ;
+            }
+
+            auto scale = 1.0f / ((1 << bitDepth) - 1);
+
+            auto scaleVector = XMVectorSet(scale, scale, scale, 1);
+
+            for (auto& entry : m_table)
+            {
+                XMStoreFloat4(&entry, XMVectorMultiply(XMLoadFloat4(&entry), scaleVector));
+            }
+        }
+    }
+
+
+    void LookupTableFileParser::ParseLine(char const* begin, char const* end)
+    {
+        m_lineNumber++;
+
+        // Skip a UTF-8 byte order mark.
+        if (m_lineNumber == 1 && end - begin >= 3 && memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+            begin += 3;
+
+        // Strip comments and whitespace.
+        end = std::find(begin, end, '#');
+
+        begin = SkipWhitespace(begin, end);
+
+        while (end != begin && IsWhitespace(end[-1]))
+            end--;
+
+        if (begin == end)
+            return;
+
+        if (isalpha(static_cast<unsigned char>(*begin)))
+            ParseKeyword(begin, end);
+        else
+            ParseValues(begin, end);
+    }
+
+
+    void LookupTableFileParser::ParseKeyword(char const* begin, char const* end)
+    {
+        auto keywordEnd = FindWhitespace(begin, end);
+
+        auto parseArguments = [&](size_t expectedCount)
+        {
+            ParseNumbers(keywordEnd, end);
+
+            if (m_values.size() != expectedCount)
+                ThrowInvalidFile();
+        };
+
+        if (IsKeyword(begin, keywordEnd, "LUT_3D_SIZE"))
+        {
+            parseArguments(1);
+
+            if (m_format == Format::ThreeDL || m_size != 0)
+                ThrowInvalidFile();
+
+            m_format = Format::Cube;
+
+            SetSize(m_values[0]);
+        }
+        else if (IsKeyword(begin, keywordEnd, "DOMAIN_MIN"))
+        {
+            parseArguments(3);
+
+            if (m_values[0] != 0 || m_values[1] != 0 || m_values[2] != 0)
+                ThrowUnsupportedFile();
+        }
+        else if (IsKeyword(begin, keywordEnd, "DOMAIN_MAX"))
+        {
+            parseArguments(3);
+
+            if (m_values[0] != 1 || m_values[1] != 1 || m_values[2] != 1)
+                ThrowUnsupportedFile();
+        }
+        else if (IsKeyword(begin, keywordEnd, "LUT_3D_INPUT_RANGE"))
+        {
+            parseArguments(2);
+
+            if (m_values[0] != 0 || m_values[1] != 1)
+                ThrowUnsupportedFile();
+        }
+        else if (IsKeyword(begin, keywordEnd, "LUT_1D_SIZE"))
+        {
+            ThrowUnsupportedFile();
+        }
+        else if (IsKeyword(begin, keywordEnd, "3DMESH"))
+        {
+            if (m_format == Format::Cube)
+                ThrowInvalidFile();
+
+            m_format = Format::ThreeDL;
+        }
+        else if (IsKeyword(begin, keywordEnd, "Mesh"))
+        {
+            // "Mesh <input bits> <output bits>", followed by the usual line of input values.
+            parseArguments(2);
+
+            if (m_format == Format::Cube || m_size != 0)
+                ThrowInvalidFile();
+
+            auto inputBitDepth = m_values[0];
+            auto outputBitDepth = m_values[1];
+
+            if (inputBitDepth < 1 || inputBitDepth > 8 || inputBitDepth != floor(inputBitDepth) ||
+                outputBitDepth < 1 || outputBitDepth > 16 || outputBitDepth != floor(outputBitDepth))
+            {
+                ThrowUnsupportedFile();
+            }
+
+            m_format = Format::ThreeDL;
+            m_outputBitDepth = static_cast<int>(outputBitDepth);
+            m_expectMeshLine = true;
+
+            SetSize((1 << static_cast<int>(inputBitDepth)) + 1.0f);
+        }
+
+        // Anything else (eg. TITLE) doesn't affect the table, so is ignored.
+    }
+
+
+    void LookupTableFileParser::ParseValues(char const* begin, char const* end)
+    {
+        ParseNumbers(begin, end);
+
+        if (m_size == 0)
+        {
+            // Before the size is known, a line of numbers can only be the list of
+            // input values that starts a .3dl file (one per table entry along each axis).
+            if (m_format == Format::Cube)
+                ThrowInvalidFile();
+
+            m_format = Format::ThreeDL;
+
+            SetSize(static_cast<float>(m_values.size()));
+            return;
+        }
+
+        if (m_expectMeshLine)
+        {
+            m_expectMeshLine = false;
+
+            if (m_values.size() == static_cast<size_t>(m_size))
+                return;
+        }
+
+        if (m_values.size() != 3)
+            ThrowInvalidFile();
+
+        AddEntry();
+    }
+
+
+    void LookupTableFileParser::ParseNumbers(char const* begin, char const* end)
+    {
+        m_values.clear();
+
+        auto p = SkipWhitespace(begin, end);
+
+        while (p != end)
+        {
+            // from_chars is locale independent, but doesn't accept a leading plus sign.
+            if (*p == '+')
+                p++;
+
+            float value;
+            auto result = std::from_chars(p, end, value);
+
+            if (result.ec != std::errc() || !std::isfinite(value))
+                ThrowInvalidFile();
+
+            p = result.ptr;
+
+            if (p != end && !IsWhitespace(*p))
+                ThrowInvalidFile();
+
+            m_values.push_back(value);
+
+            p = SkipWhitespace(p, end);
+        }
+    }
+
+
+    void LookupTableFileParser::AddEntry()
+    {
+        if (m_entryCount >= m_table.size())
+            ThrowInvalidFile();
+
+        uint32_t index;
+
+        if (m_format == Format::Cube)
+        {
+            // .cube files list entries with red changing fastest, but the table wants blue fastest.
+            auto size = static_cast<uint32_t>(m_size);
+
+            auto r = m_entryCount % size;
+            auto g = (m_entryCount / size) % size;
+            auto b = m_entryCount / (size * size);
+
+            index = (r * size + g) * size + b;
+        }
+        else
+        {
+            if (m_values[0] < 0 || m_values[1] < 0 || m_values[2] < 0)
+                ThrowInvalidFile();
+
+            m_maxValue = std::max(m_maxValue, std::max(m_values[0], std::max(m_values[1], m_values[2])));
+
+            index = m_entryCount;
+        }
+
+        m_table[index] = XMFLOAT4(m_values[0], m_values[1], m_values[2], 1);
+
+        m_entryCount++;
+    }
+
+
+    void LookupTableFileParser::SetSize(float size)
+    {
+        // Same limits as EffectTransferTable3D.
+        if (size < 2 || size > 256 || size != floor(size))
+            ThrowUnsupportedFile();
+
+        m_size = static_cast<int>(size);
+
+        m_table.resize(static_cast<size_t>(m_size) * m_size * m_size);
+    }
+
+
+    void LookupTableFileParser::ThrowInvalidFile()
+    {
+        WinStringBuilder message;
+        message.Format(Strings::LookupTableFileInvalid, m_lineNumber);
+        ThrowHR(E_INVALIDARG, message.Get());
+    }
+
+
+    void LookupTableFileParser::ThrowUnsupportedFile()
+    {
+        WinStringBuilder message;
+        message.Format(Strings::LookupTableFileUnsupported, m_lineNumber);
+        ThrowHR(E_INVALIDARG, message.Get());
+    }
+}}}}}
@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    //
+    // Streaming parser for 3D color lookup table files, in either the .cube
+    // format (as written by Resolve, Adobe tools and OpenColorIO) or the
+    // Autodesk .3dl format.  The format is detected from the file contents.
+    //
+    // Text can be passed to Parse in arbitrary sized chunks, so large tables
+    // (eg. 65x65x65) are read straight from a stream without ever holding the
+    // whole file in memory.  Each entry is written directly to its final place
+    // in the table as it is parsed, converting from the red-fastest axis order
+    // of .cube files to the blue-fastest order used by EffectTransferTable3D.
+    //
+    // Invalid or unsupported files (eg. 1D tables, or tables with an input
+    // domain other than 0 to 1) throw E_INVALIDARG with a message giving the
+    // line number.
+    //
+    class LookupTableFileParser
+    {
+        enum class Format
+        {
+            Unknown,
+            Cube,
+            ThreeDL,
+        };
+
+        Format m_format;
+
+        // Holds the start of a line split across calls to Parse.
+        std::string m_partialLine;
+        unsigned int m_lineNumber;
+
+        int m_size;
+        uint32_t m_entryCount;
+
+        // For .3dl files, which store integers of an unspecified bit depth.
+        int m_outputBitDepth;
+        bool m_expectMeshLine;
+        float m_maxValue;
+
+        std::vector<float> m_values;
+        std::vector<DirectX::XMFLOAT4> m_table;
+
+    public:
+        LookupTableFileParser();
+
+        void Parse(char const* text, size_t length);
+
+        // Call after the last chunk of text.
+        void Finish();
+
+        // Number of entries along each axis (only valid after Finish).
+        int Size() const { return m_size; }
+
+        // RGBA values with blue changing fastest, and alpha set to one.
+        std::vector<DirectX::XMFLOAT4> const& Table() const { return m_table; }
+
+    private:
+        void ParseLine(char const* begin, char const* end);
+        void ParseKeyword(char const* begin, char const* end);
+        void ParseValues(char const* begin, char const* end);
+        void ParseNumbers(char const* begin, char const* end);
+        void AddEntry();
+        void SetSize(float size);
+
+        __declspec(noreturn) void ThrowInvalidFile();
+        __declspec(noreturn) void ThrowUnsupportedFile();
+    };
+}}}}}
@@ -32,6 +32,26 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
+    IFACEMETHODIMP PixelShaderEffectFactory::get_ShaderCacheFolder(HSTRING* value)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(value);
+
+            WinString(SharedShaderState::GetDescriptionCacheFolder()).CopyTo(value);
+        });
+    }
+
+
+    IFACEMETHODIMP PixelShaderEffectFactory::put_ShaderCacheFolder(HSTRING value)
+    {
+        return ExceptionBoundary([&]
+        {
+            SharedShaderState::SetDescriptionCacheFolder(WindowsGetStringRawBuffer(value, nullptr));
+        });
+    }
+
+
     // Describe how to implement WinRT IMap<> methods in terms of our shader constant buffer.
     template<typename TKey, typename TValue>
     struct PixelShaderEffectPropertyMapTraits
@@ -204,6 +224,90 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
+    IFACEMETHODIMP PixelShaderEffect::GetPropertyHandle(HSTRING name, int32_t* handle)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(handle);
+
+            *handle = m_sharedState->GetPropertyHandle(name);
+        });
+    }
+
+
+    IFACEMETHODIMP PixelShaderEffect::SetPropertyFloats(int32_t handle, uint32_t valueCount, float* valueElements)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(valueElements);
+
+            auto lock = Lock(m_mutex);
+
+            // Store the new values into our shared state object.
+            m_sharedState->SetPropertyValues(handle, valueElements, valueCount);
+
+            // If we are realized, pass the updated constant buffer on to Direct2D.
+            SetD2DConstants();
+        });
+    }
+
+
+    IFACEMETHODIMP PixelShaderEffect::SetPropertyIntegers(int32_t handle, uint32_t valueCount, int32_t* valueElements)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(valueElements);
+
+            auto lock = Lock(m_mutex);
+
+            // Store the new values into our shared state object.
+            m_sharedState->SetPropertyValues(handle, valueElements, valueCount);
+
+            // If we are realized, pass the updated constant buffer on to Direct2D.
+            SetD2DConstants();
+        });
+    }
+
+
+    IFACEMETHODIMP PixelShaderEffect::GetPropertyOffset(int32_t handle, uint32_t* offset)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(offset);
+
+            *offset = m_sharedState->GetPropertyOffset(handle);
+        });
+    }
+
+
+    IFACEMETHODIMP PixelShaderEffect::get_ConstantBufferSize(uint32_t* value)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(value);
+
+            *value = static_cast<uint32_t>(m_sharedState->Constants().size());
+        });
+    }
+
+
+    IFACEMETHODIMP PixelShaderEffect::SetConstantBuffer(uint32_t valueCount, BYTE* valueElements)
+    {
+        return ExceptionBoundary([&]
+        {
+            CheckInPointer(valueElements);
+
+            auto lock = Lock(m_mutex);
+
+            // Store the new constants into our shared state object.
+            m_sharedState->SetConstants(valueElements, valueCount);
+
+            // If we are realized, pass the updated constant buffer on to Direct2D.
+            SetD2DConstants();
+        });
+    }
+
+
     bool PixelShaderEffect::IsSupported(ICanvasDevice* device)
     {
         ComPtr<ID3D11Device> d3dDevice;
@@ -12,13 +12,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
 
     // WinRT activation factory.
-    class PixelShaderEffectFactory : public AgileActivationFactory<IPixelShaderEffectFactory>
+    class PixelShaderEffectFactory : public AgileActivationFactory<IPixelShaderEffectFactory, IPixelShaderEffectStatics>
                                    , private LifespanTracker<PixelShaderEffectFactory>
     {
         InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_Effects_PixelShaderEffect, BaseTrust);
 
     public:
         IFACEMETHOD(Create)(uint32_t shaderCodeCount, BYTE* shaderCode, IPixelShaderEffect** effect) override;
+
+        IFACEMETHOD(get_ShaderCacheFolder)(HSTRING* value) override;
+        IFACEMETHOD(put_ShaderCacheFolder)(HSTRING value) override;
     };
 
 
@@ -85,6 +88,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
         IFACEMETHOD(IsSupported)(ICanvasDevice* device, boolean* result) override;
 
+        IFACEMETHOD(GetPropertyHandle)(HSTRING name, int32_t* handle) override;
+        IFACEMETHOD(SetPropertyFloats)(int32_t handle, uint32_t valueCount, float* valueElements) override;
+        IFACEMETHOD(SetPropertyIntegers)(int32_t handle, uint32_t valueCount, int32_t* valueElements) override;
+        IFACEMETHOD(GetPropertyOffset)(int32_t handle, uint32_t* offset) override;
+        IFACEMETHOD(get_ConstantBufferSize)(uint32_t* value) override;
+        IFACEMETHOD(SetConstantBuffer)(uint32_t valueCount, BYTE* valueElements) override;
+
     protected:
         bool IsSupported(ICanvasDevice* device);
 
@@ -18,6 +18,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             , Elements(type.Elements)
             , Size(desc.Size)
             , Offset(desc.StartOffset)
+            , IsContiguous(ComputeIsContiguous(type))
         { }
 
 
@@ -33,6 +34,10 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         unsigned Size;
         unsigned Offset;
 
+        // Whether the components are laid out in the constant buffer in the same order as
+        // the flattened property value, without padding, so can be copied in one go.
+        bool IsContiguous;
+
 
         unsigned ComponentCount() const
         {
@@ -54,6 +59,22 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
                    Rows == rows &&
                    Columns == columns;
         }
+
+
+    private:
+        // Constant buffer registers hold four components, and each array element or
+        // matrix row (column, for column major matrices) starts a new register.
+        static bool ComputeIsContiguous(D3D11_SHADER_TYPE_DESC const& type)
+        {
+            if (type.Class == D3D_SVC_MATRIX_COLUMNS)
+            {
+                return type.Columns == 1 && (type.Rows == 4 || type.Elements == 0);
+            }
+            else
+            {
+                return type.Columns == 4 || (type.Rows == 1 && type.Elements == 0);
+            }
+        }
     };
 
 
@@ -76,6 +97,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             , InputCount(0)
             , InstructionCount(0)
             , MinFeatureLevel(static_cast<D3D_FEATURE_LEVEL>(0))
+            , SimpleInputs(0)
         { }
 
 
@@ -90,6 +112,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
         // Sorted by name.
         std::vector<ShaderVariable> Variables;
+
+        // Constant buffer contents before any properties are set (ie. variable default values).
+        std::vector<BYTE> DefaultConstants;
+
+        // Bitmask of inputs that the shader linking function says are sampled one-to-one.
+        uint32_t SimpleInputs;
     };
 
 }}}}}
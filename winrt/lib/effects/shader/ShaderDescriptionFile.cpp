@@ -0,0 +1,331 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+#include "ShaderDescriptionFile.h"
+#include "SharedShaderState.h"
+#include "utils/HashUtilities.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    // File layout: FileHeader, FileVariable[VariableCount], default constants
+    // (padded to a multiple of four bytes), then a table of null terminated names.
+    static const uint32_t FileMagic = 0x44533257;   // "W2SD"
+
+    static const size_t ChecksumSize = 20;          // SHA-1
+
+    struct FileHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        BYTE Checksum[ChecksumSize];    // Covers everything after this field.
+
+        IID Hash;
+        uint32_t CodeSize;
+        uint32_t InputCount;
+        uint32_t InstructionCount;
+        uint32_t MinFeatureLevel;
+        uint32_t SimpleInputs;
+        uint32_t VariableCount;
+        uint32_t DefaultConstantsSize;
+        uint32_t NamesSize;
+    };
+
+    struct FileVariable
+    {
+        uint32_t NameOffset;
+        uint32_t Class;
+        uint32_t Type;
+        uint32_t Rows;
+        uint32_t Columns;
+        uint32_t Elements;
+        uint32_t Size;
+        uint32_t Offset;
+    };
+
+    static const size_t ChecksumEnd = offsetof(FileHeader, Checksum) + ChecksumSize;
+
+
+    static uint64_t PadToDword(uint64_t size)
+    {
+        return (size + 3) & ~3ull;
+    }
+
+
+    static uint64_t GetDescriptionFileSize(FileHeader const& header)
+    {
+        // 64 bit math, so corrupt counts can't overflow.
+        return sizeof(FileHeader) +
+               static_cast<uint64_t>(header.VariableCount) * sizeof(FileVariable) +
+               PadToDword(header.DefaultConstantsSize) +
+               header.NamesSize;
+    }
+
+
+    std::vector<BYTE> SerializeShaderDescription(ShaderDescription const& shader)
+    {
+        // Build the name table. ShaderVariable widened the names from the ASCII strings
+        // returned by shader reflection, so narrowing them again is lossless.
+        std::vector<char> names;
+        std::vector<FileVariable> variables;
+
+        variables.reserve(shader.Variables.size());
+
+        for (auto& variable : shader.Variables)
+        {
+            FileVariable fileVariable;
+
+            fileVariable.NameOffset = static_cast<uint32_t>(names.size());
+            fileVariable.Class = variable.Class;
+            fileVariable.Type = variable.Type;
+            fileVariable.Rows = variable.Rows;
+            fileVariable.Columns = variable.Columns;
+            fileVariable.Elements = variable.Elements;
+            fileVariable.Size = variable.Size;
+            fileVariable.Offset = variable.Offset;
+
+            variables.push_back(fileVariable);
+
+            for (auto c = static_cast<wchar_t const*>(variable.Name); *c; c++)
+            {
+                names.push_back(static_cast<char>(*c));
+            }
+
+            names.push_back(0);
+        }
+
+        FileHeader header{};
+
+        header.Magic = FileMagic;
+        header.Version = ShaderDescriptionFileVersion;
+        header.Hash = shader.Hash;
+        header.CodeSize = static_cast<uint32_t>(shader.Code.size());
+        header.InputCount = shader.InputCount;
+        header.InstructionCount = shader.InstructionCount;
+        header.MinFeatureLevel = shader.MinFeatureLevel;
+        header.SimpleInputs = shader.SimpleInputs;
+        header.VariableCount = static_cast<uint32_t>(variables.size());
+        header.DefaultConstantsSize = static_cast<uint32_t>(shader.DefaultConstants.size());
+        header.NamesSize = static_cast<uint32_t>(names.size());
+
+        // Lay out the file.
+        std::vector<BYTE> data(static_cast<size_t>(GetDescriptionFileSize(header)));
+
+        auto variablesStart = data.data() + sizeof(FileHeader);
+        auto constantsStart = variablesStart + variables.size() * sizeof(FileVariable);
+        auto namesStart = constantsStart + PadToDword(shader.DefaultConstants.size());
+
+        std::copy(variables.begin(), variables.end(), reinterpret_cast<FileVariable*>(variablesStart));
+        std::copy(shader.DefaultConstants.begin(), shader.DefaultConstants.end(), constantsStart);
+        std::copy(names.begin(), names.end(), namesStart);
+
+        memcpy(data.data(), &header, sizeof(header));
+
+        // Checksum everything after the checksum field.
+        auto checksum = GetSha1Hash(data.data() + ChecksumEnd, data.size() - ChecksumEnd);
+
+        assert(checksum.GetSize() == ChecksumSize);
+
+        memcpy(data.data() + offsetof(FileHeader, Checksum), checksum.GetData(), ChecksumSize);
+
+        return data;
+    }
+
+
+    bool TryDeserializeShaderDescription(BYTE const* data, size_t dataSize, IID const& hash, BYTE const* shaderCode, uint32_t shaderCodeSize, ShaderDescription* result)
+    {
+        // Validate the header.
+        if (dataSize < sizeof(FileHeader))
+            return false;
+
+        FileHeader header;
+        memcpy(&header, data, sizeof(header));
+
+        if (header.Magic != FileMagic ||
+            header.Version != ShaderDescriptionFileVersion ||
+            !IsEqualGUID(header.Hash, hash) ||
+            header.CodeSize != shaderCodeSize ||
+            GetDescriptionFileSize(header) != dataSize ||
+            header.InputCount > MaxShaderInputs)
+        {
+            return false;
+        }
+
+        // Reject files that have been truncated, partially written, or otherwise corrupted.
+        auto checksum = GetSha1Hash(data + ChecksumEnd, dataSize - ChecksumEnd);
+
+        if (checksum.GetSize() != ChecksumSize ||
+            memcmp(checksum.GetData(), header.Checksum, ChecksumSize) != 0)
+        {
+            return false;
+        }
+
+        auto variablesStart = data + sizeof(FileHeader);
+        auto constantsStart = variablesStart + header.VariableCount * sizeof(FileVariable);
+        auto namesStart = reinterpret_cast<char const*>(constantsStart + PadToDword(header.DefaultConstantsSize));
+
+        if (header.NamesSize > 0 && namesStart[header.NamesSize - 1] != 0)
+            return false;
+
+        ShaderDescription shader;
+
+        shader.Hash = hash;
+        shader.InputCount = header.InputCount;
+        shader.InstructionCount = header.InstructionCount;
+        shader.MinFeatureLevel = static_cast<D3D_FEATURE_LEVEL>(header.MinFeatureLevel);
+        shader.SimpleInputs = header.SimpleInputs;
+        shader.DefaultConstants.assign(constantsStart, constantsStart + header.DefaultConstantsSize);
+
+        shader.Variables.reserve(header.VariableCount);
+
+        for (uint32_t i = 0; i < header.VariableCount; i++)
+        {
+            FileVariable fileVariable;
+            memcpy(&fileVariable, variablesStart + i * sizeof(FileVariable), sizeof(fileVariable));
+
+            // Sanity check the variable, as SharedShaderState relies on it lying inside the constant buffer.
+            auto endOffset = static_cast<uint64_t>(fileVariable.Offset) + fileVariable.Size;
+
+            if (fileVariable.NameOffset >= header.NamesSize ||
+                endOffset > header.DefaultConstantsSize)
+            {
+                return false;
+            }
+
+            // Rebuild the reflection structs that ShaderVariable is constructed from.
+            D3D11_SHADER_VARIABLE_DESC desc{};
+
+            desc.Name = namesStart + fileVariable.NameOffset;
+            desc.StartOffset = fileVariable.Offset;
+            desc.Size = fileVariable.Size;
+
+            D3D11_SHADER_TYPE_DESC type{};
+
+            type.Class = static_cast<D3D_SHADER_VARIABLE_CLASS>(fileVariable.Class);
+            type.Type = static_cast<D3D_SHADER_VARIABLE_TYPE>(fileVariable.Type);
+            type.Rows = fileVariable.Rows;
+            type.Columns = fileVariable.Columns;
+            type.Elements = fileVariable.Elements;
+
+            shader.Variables.emplace_back(desc, type);
+        }
+
+        // Property lookups binary search the variables, so make sure they're still in order.
+        if (!std::is_sorted(shader.Variables.begin(), shader.Variables.end(), VariableNameComparison()))
+            return false;
+
+        shader.Code.assign(shaderCode, shaderCode + shaderCodeSize);
+
+        *result = std::move(shader);
+
+        return true;
+    }
+
+
+    static std::wstring GetShaderDescriptionFileName(std::wstring const& folder, IID const& hash)
+    {
+        wchar_t hashString[39];
+
+        if (!StringFromGUID2(hash, hashString, _countof(hashString)))
+            ThrowHR(E_UNEXPECTED);
+
+        std::wstring fileName = folder;
+
+        if (!fileName.empty() && fileName.back() != L'\\' && fileName.back() != L'/')
+            fileName += L'\\';
+
+        return fileName + hashString + L".win2dshader";
+    }
+
+
+    struct MappedViewDeleter
+    {
+        void operator()(void const* view) const
+        {
+            UnmapViewOfFile(view);
+        }
+    };
+
+
+    bool TryLoadShaderDescriptionFile(std::wstring const& folder, IID const& hash, BYTE const* shaderCode, uint32_t shaderCodeSize, ShaderDescription* result)
+    try
+    {
+        auto fileName = GetShaderDescriptionFileName(folder, hash);
+
+        Wrappers::FileHandle file(CreateFile2(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr));
+
+        if (!file.IsValid())
+            return false;
+
+        LARGE_INTEGER fileSize;
+
+        if (!GetFileSizeEx(file.Get(), &fileSize) ||
+            fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader)) ||
+            fileSize.QuadPart > UINT32_MAX)
+        {
+            return false;
+        }
+
+        // Map the file and read the description straight out of the view.
+        Wrappers::HandleT<Wrappers::HandleTraits::HANDLENullTraits> mapping(CreateFileMappingW(file.Get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+
+        if (!mapping.IsValid())
+            return false;
+
+        std::unique_ptr<void const, MappedViewDeleter> view(MapViewOfFile(mapping.Get(), FILE_MAP_READ, 0, 0, 0));
+
+        if (!view)
+            return false;
+
+        return TryDeserializeShaderDescription(static_cast<BYTE const*>(view.get()), static_cast<size_t>(fileSize.QuadPart), hash, shaderCode, shaderCodeSize, result);
+    }
+    catch (HResultException const&)
+    {
+        return false;
+    }
+
+
+    bool TrySaveShaderDescriptionFile(std::wstring const& folder, ShaderDescription const& shader)
+    try
+    {
+        auto data = SerializeShaderDescription(shader);
+
+        auto fileName = GetShaderDescriptionFileName(folder, shader.Hash);
+
+        // Write to a temporary file then rename it, so other processes (or threads) never see a
+        // partially written file. Include the thread ID in the temporary name in case several
+        // are writing the same shader at once.
+        auto tempFileName = fileName + L"." + std::to_wstring(GetCurrentThreadId()) + L".tmp";
+
+        {
+            Wrappers::FileHandle file(CreateFile2(tempFileName.c_str(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr));
+
+            if (!file.IsValid())
+                return false;
+
+            DWORD bytesWritten;
+
+            if (!WriteFile(file.Get(), data.data(), static_cast<DWORD>(data.size()), &bytesWritten, nullptr) ||
+                bytesWritten != data.size())
+            {
+                file.Close();
+                DeleteFileW(tempFileName.c_str());
+                return false;
+            }
+        }
+
+        if (!MoveFileExW(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            DeleteFileW(tempFileName.c_str());
+            return false;
+        }
+
+        return true;
+    }
+    catch (HResultException const&)
+    {
+        return false;
+    }
+
+}}}}}
@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include "ShaderDescription.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
+{
+    //
+    // Binary format used to persist shader reflection results between runs of
+    // an app (see PixelShaderEffect.ShaderCacheFolder), so later launches can
+    // skip D3DReflect entirely.
+    //
+    // Files are designed to be read in place from a memory mapped view: a
+    // fixed size header is followed by flat arrays of 32 bit fields, using
+    // offsets rather than pointers. The shader code itself is not stored, as
+    // whoever is loading the description already has it. Files are keyed by
+    // the code hash, and validated against the hash, the code size, a format
+    // version and a checksum of their contents. Anything that doesn't match
+    // is ignored, so a missing, stale or corrupt file just falls back to
+    // reflecting over the shader as normal.
+    //
+
+    // Bump this whenever the file layout, or what reflection stores in ShaderDescription, changes.
+    const uint32_t ShaderDescriptionFileVersion = 1;
+
+    std::vector<BYTE> SerializeShaderDescription(ShaderDescription const& shader);
+
+    // On success, the result holds a copy of shaderCode along with the deserialized metadata.
+    bool TryDeserializeShaderDescription(BYTE const* data, size_t dataSize, IID const& hash, BYTE const* shaderCode, uint32_t shaderCodeSize, ShaderDescription* result);
+
+    // Helpers for reading and writing <folder>\<hash>.win2dshader files. Failures
+    // are reported by returning false, since the cache is purely an optimization.
+    bool TryLoadShaderDescriptionFile(std::wstring const& folder, IID const& hash, BYTE const* shaderCode, uint32_t shaderCodeSize, ShaderDescription* result);
+    bool TrySaveShaderDescriptionFile(std::wstring const& folder, ShaderDescription const& shader);
+
+}}}}}
@@ -4,7 +4,9 @@
 
 #include "pch.h"
 #include "SharedShaderState.h"
+#include "ShaderDescriptionFile.h"
 #include "utils/HashUtilities.h"
+#include "utils/LockUtilities.h"
 #include "Windows.Perception.Spatial.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Effects
@@ -30,6 +32,14 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
 
     SharedShaderState::SharedShaderState(ShaderDescription const& shader, std::vector<BYTE> const& constants, CoordinateMappingState const& coordinateMapping, SourceInterpolationState const& sourceInterpolation)
+        : m_shader(std::make_shared<ShaderDescription>(shader))
+        , m_constants(constants)
+        , m_coordinateMapping(coordinateMapping)
+        , m_sourceInterpolation(sourceInterpolation)
+    { }
+
+
+    SharedShaderState::SharedShaderState(std::shared_ptr<ShaderDescription const> const& shader, std::vector<BYTE> const& constants, CoordinateMappingState const& coordinateMapping, SourceInterpolationState const& sourceInterpolation)
         : m_shader(shader)
         , m_constants(constants)
         , m_coordinateMapping(coordinateMapping)
@@ -38,17 +48,148 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
 
     SharedShaderState::SharedShaderState(BYTE* shaderCode, uint32_t shaderCodeSize)
+        : m_shader(GetShaderDescription(shaderCode, shaderCodeSize))
+        , m_constants(m_shader->DefaultConstants)
     {
-        // Store the shader program code.
-        m_shader.Code.assign(shaderCode, shaderCode + shaderCodeSize);
+        // Inputs that the shader linking function says are simple default to passthrough coordinate mapping.
+        for (int i = 0; i < MaxShaderInputs; i++)
+        {
+            if (m_shader->SimpleInputs & (1u << i))
+            {
+                m_coordinateMapping.Mapping[i] = SamplerCoordinateMapping::OneToOne;
+            }
+        }
+    }
+
+
+    // Reflecting over a shader costs far more than the rest of creating a PixelShaderEffect,
+    // and apps tend to create many effects from the same few shaders, so descriptions are
+    // cached process-wide. The cache is ordered from least to most recently used.
+    static const size_t MaxCachedShaderDescriptions = 64;
 
-        // Hash it to generate a unique ID.
+    static std::mutex shaderDescriptionCacheMutex;
+    static std::vector<std::shared_ptr<ShaderDescription const>> shaderDescriptionCache;
+    static ShaderDescriptionCacheCounters shaderDescriptionCacheCounters;
+    static std::wstring shaderDescriptionCacheFolder;
+
+
+    // Must be called with the cache mutex held.
+    static std::shared_ptr<ShaderDescription const> FindCachedShaderDescription(IID const& hash, BYTE* shaderCode, uint32_t shaderCodeSize)
+    {
+        auto it = std::find_if(shaderDescriptionCache.rbegin(), shaderDescriptionCache.rend(),
+            [&](std::shared_ptr<ShaderDescription const> const& description)
+            {
+                // Compare the code as well as the hash, so a collision can never pick up the wrong metadata.
+                return IsEqualGUID(description->Hash, hash) &&
+                       description->Code.size() == shaderCodeSize &&
+                       memcmp(description->Code.data(), shaderCode, shaderCodeSize) == 0;
+            });
+
+        if (it == shaderDescriptionCache.rend())
+            return nullptr;
+
+        // Move the entry to the most recently used end of the cache.
+        std::rotate(std::prev(it.base()), it.base(), shaderDescriptionCache.end());
+
+        return shaderDescriptionCache.back();
+    }
+
+
+    std::shared_ptr<ShaderDescription const> SharedShaderState::GetShaderDescription(BYTE* shaderCode, uint32_t shaderCodeSize)
+    {
+        // Hash the code to generate a unique ID.
         static const IID salt{ 0x489257f6, 0x6544, 0x4277, 0x89, 0x82, 0xea, 0xd1, 0x69, 0x39, 0x1f, 0x3d };
 
-        m_shader.Hash = GetVersion5Uuid(salt, shaderCode, shaderCodeSize);
+        auto hash = GetVersion5Uuid(salt, shaderCode, shaderCodeSize);
+
+        std::wstring cacheFolder;
+
+        {
+            auto lock = Lock(shaderDescriptionCacheMutex);
+
+            if (auto cached = FindCachedShaderDescription(hash, shaderCode, shaderCodeSize))
+            {
+                shaderDescriptionCacheCounters.Hits++;
+                return cached;
+            }
+
+            cacheFolder = shaderDescriptionCacheFolder;
+        }
+
+        // Cache miss, so look up the shader metadata. This is done without holding
+        // the lock, so other shaders can be created in the meantime.
+        auto description = std::make_shared<ShaderDescription>();
+
+        bool loadedFromDisk = !cacheFolder.empty() &&
+                              TryLoadShaderDescriptionFile(cacheFolder, hash, shaderCode, shaderCodeSize, description.get());
+
+        if (!loadedFromDisk)
+        {
+            // Store the shader program code, and reflect over it.
+            description->Code.assign(shaderCode, shaderCode + shaderCodeSize);
+            description->Hash = hash;
+
+            ReflectOverShader(*description);
+
+            // Failing to write the file doesn't matter: we'll just reflect again next time.
+            if (!cacheFolder.empty())
+            {
+                TrySaveShaderDescriptionFile(cacheFolder, *description);
+            }
+        }
+
+        auto lock = Lock(shaderDescriptionCacheMutex);
+
+        shaderDescriptionCacheCounters.Misses++;
+
+        if (loadedFromDisk)
+            shaderDescriptionCacheCounters.DiskHits++;
+
+        // Another thread may have added the same shader while we weren't holding the lock.
+        if (auto cached = FindCachedShaderDescription(hash, shaderCode, shaderCodeSize))
+            return cached;
+
+        shaderDescriptionCache.push_back(description);
+
+        if (shaderDescriptionCache.size() > MaxCachedShaderDescriptions)
+        {
+            shaderDescriptionCache.erase(shaderDescriptionCache.begin());
+            shaderDescriptionCacheCounters.Evictions++;
+        }
+
+        return description;
+    }
+
+
+    ShaderDescriptionCacheCounters SharedShaderState::GetDescriptionCacheCounters()
+    {
+        auto lock = Lock(shaderDescriptionCacheMutex);
+
+        return shaderDescriptionCacheCounters;
+    }
+
+
+    void SharedShaderState::ClearDescriptionCache()
+    {
+        auto lock = Lock(shaderDescriptionCacheMutex);
+
+        shaderDescriptionCache.clear();
+    }
+
+
+    std::wstring SharedShaderState::GetDescriptionCacheFolder()
+    {
+        auto lock = Lock(shaderDescriptionCacheMutex);
+
+        return shaderDescriptionCacheFolder;
+    }
+
+
+    void SharedShaderState::SetDescriptionCacheFolder(std::wstring const& folder)
+    {
+        auto lock = Lock(shaderDescriptionCacheMutex);
 
-        // Look up shader metadata.
-        ReflectOverShader();
+        shaderDescriptionCacheFolder = folder;
     }
 
 
@@ -63,13 +204,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
     unsigned SharedShaderState::GetPropertyCount()
     {
-        return static_cast<unsigned>(m_shader.Variables.size());
+        return static_cast<unsigned>(m_shader->Variables.size());
     }
 
 
     bool SharedShaderState::HasProperty(HSTRING name)
     {
-        return std::binary_search(m_shader.Variables.begin(), m_shader.Variables.end(), name, VariableNameComparison());
+        return std::binary_search(m_shader->Variables.begin(), m_shader->Variables.end(), name, VariableNameComparison());
     }
 
 
@@ -211,9 +352,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     {
         std::vector<StringObjectPair> properties;
 
-        properties.reserve(m_shader.Variables.size());
+        properties.reserve(m_shader->Variables.size());
 
-        for (auto& variable : m_shader.Variables)
+        for (auto& variable : m_shader->Variables)
         {
             properties.emplace_back(variable.Name, GetProperty(variable));
         }
@@ -226,9 +367,9 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     {
         VariableNameComparison comparison;
 
-        auto it = std::lower_bound(m_shader.Variables.begin(), m_shader.Variables.end(), name, comparison);
+        auto it = std::lower_bound(m_shader->Variables.begin(), m_shader->Variables.end(), name, comparison);
 
-        if (it == m_shader.Variables.end() || comparison(name, *it))
+        if (it == m_shader->Variables.end() || comparison(name, *it))
         {
             WinStringBuilder message;
             message.Format(Strings::CustomEffectUnknownProperty, WindowsGetStringRawBuffer(name, nullptr));
@@ -461,12 +602,117 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
-    void SharedShaderState::ReflectOverShader()
+    int SharedShaderState::GetPropertyHandle(HSTRING name)
+    {
+        auto& variable = FindVariable(name);
+
+        // Handles are indices into the (immutable) variable list.
+        return static_cast<int>(&variable - m_shader->Variables.data());
+    }
+
+
+    ShaderVariable const& SharedShaderState::GetVariable(int handle)
+    {
+        if (handle < 0 || static_cast<size_t>(handle) >= m_shader->Variables.size())
+            ThrowHR(E_INVALIDARG, Strings::CustomEffectInvalidPropertyHandle);
+
+        return m_shader->Variables[handle];
+    }
+
+
+    unsigned SharedShaderState::GetPropertyOffset(int handle)
+    {
+        return GetVariable(handle).Offset;
+    }
+
+
+    template<typename TComponent>
+    void SharedShaderState::CopyPropertyValues(ShaderVariable const& variable, TComponent const* values, uint32_t valueCount)
+    {
+        if (valueCount != variable.ComponentCount())
+        {
+            WinStringBuilder message;
+            message.Format(Strings::CustomEffectWrongPropertyComponentCount, static_cast<wchar_t const*>(variable.Name), variable.ComponentCount());
+            ThrowHR(E_INVALIDARG, message.Get());
+        }
+
+        if (variable.IsContiguous && sizeof(TComponent) == sizeof(uint32_t))
+        {
+            // Sanity check (can only fail if the shader blob is corrupted).
+            if (valueCount * sizeof(TComponent) > variable.Size)
+                ThrowHR(E_UNEXPECTED);
+
+            memcpy(m_constants.data() + variable.Offset, values, valueCount * sizeof(TComponent));
+        }
+        else
+        {
+            // CopyConstantData only reads from values when writing to the constant buffer.
+            CopyConstantData<CopyDirection::Write>(variable, const_cast<TComponent*>(values));
+        }
+    }
+
+
+    void SharedShaderState::SetPropertyValues(int handle, float const* values, uint32_t valueCount)
+    {
+        auto& variable = GetVariable(handle);
+
+        if (variable.Type != D3D_SVT_FLOAT)
+        {
+            WinStringBuilder message;
+            message.Format(Strings::CustomEffectWrongPropertyType, static_cast<wchar_t const*>(variable.Name), (variable.Type == D3D_SVT_BOOL) ? PropertyTypeName<bool>() : PropertyTypeName<int>());
+            ThrowHR(E_INVALIDARG, message.Get());
+        }
+
+        CopyPropertyValues(variable, values, valueCount);
+    }
+
+
+    void SharedShaderState::SetPropertyValues(int handle, int const* values, uint32_t valueCount)
+    {
+        auto& variable = GetVariable(handle);
+
+        if (variable.Type == D3D_SVT_FLOAT)
+        {
+            WinStringBuilder message;
+            message.Format(Strings::CustomEffectWrongPropertyType, static_cast<wchar_t const*>(variable.Name), PropertyTypeName<float>());
+            ThrowHR(E_INVALIDARG, message.Get());
+        }
+
+        if (variable.Type == D3D_SVT_BOOL)
+        {
+            // Booleans must be normalized to 0 or 1, so can't be copied directly.
+            std::vector<boolean> booleans(std::min(valueCount, variable.ComponentCount()));
+
+            std::transform(values, values + booleans.size(), booleans.begin(), [](int value) -> boolean { return value != 0; });
+
+            CopyPropertyValues(variable, booleans.data(), valueCount);
+        }
+        else
+        {
+            CopyPropertyValues(variable, values, valueCount);
+        }
+    }
+
+
+    void SharedShaderState::SetConstants(BYTE const* constants, uint32_t size)
+    {
+        if (size != m_constants.size())
+        {
+            WinStringBuilder message;
+            message.Format(Strings::CustomEffectWrongConstantBufferSize, static_cast<unsigned>(m_constants.size()));
+            ThrowHR(E_INVALIDARG, message.Get());
+        }
+
+        std::copy(constants, constants + size, m_constants.begin());
+    }
+
+
+    void SharedShaderState::ReflectOverShader(ShaderDescription& shader)
     {
         // Create the shader reflection interface.
         ComPtr<ID3D11ShaderReflection> reflector;
 
-        HRESULT hr = D3DReflect(m_shader.Code.data(), m_shader.Code.size(), IID_PPV_ARGS(&reflector));
+        HRESULT hr = D3DReflect(shader.Code.data(), shader.Code.size(), IID_PPV_ARGS(&reflector));
 
         if (FAILED(hr))
             ThrowHR(E_INVALIDARG, Strings::CustomEffectBadShader);
@@ -485,25 +731,25 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         }
 
         // Examine the input bindings.
-        ReflectOverBindings(reflector.Get(), desc);
+        ReflectOverBindings(shader, reflector.Get(), desc);
 
         // Store the mapping from named constants to buffer locations.
         if (desc.ConstantBuffers)
         {
-            ReflectOverConstantBuffer(reflector->GetConstantBufferByIndex(0));
+            ReflectOverConstantBuffer(shader, reflector->GetConstantBufferByIndex(0));
         }
 
         // Grab some other metadata.
-        m_shader.InstructionCount = desc.InstructionCount;
+        shader.InstructionCount = desc.InstructionCount;
 
-        ThrowIfFailed(reflector->GetMinFeatureLevel(&m_shader.MinFeatureLevel));
+        ThrowIfFailed(reflector->GetMinFeatureLevel(&shader.MinFeatureLevel));
 
         // If this shader was compiled to support shader linking, we can also determine which inputs are simple vs. complex.
-        ReflectOverShaderLinkingFunction();
+        ReflectOverShaderLinkingFunction(shader);
     }
 
 
-    void SharedShaderState::ReflectOverBindings(ID3D11ShaderReflection* reflector, D3D11_SHADER_DESC const& desc)
+    void SharedShaderState::ReflectOverBindings(ShaderDescription& shader, ID3D11ShaderReflection* reflector, D3D11_SHADER_DESC const& desc)
     {
         for (unsigned i = 0; i < desc.BoundResources; i++)
         {
@@ -517,7 +763,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
                     ThrowHR(E_INVALIDARG, Strings::CustomEffectTooManyTextures);
 
                 // Record how many input textures this shader uses.
-                m_shader.InputCount = std::max(m_shader.InputCount, inputDesc.BindPoint + 1);
+                shader.InputCount = std::max(shader.InputCount, inputDesc.BindPoint + 1);
                 break;
 
             case D3D_SIT_CBUFFER:
@@ -530,24 +776,24 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
-    void SharedShaderState::ReflectOverConstantBuffer(ID3D11ShaderReflectionConstantBuffer* constantBuffer)
+    void SharedShaderState::ReflectOverConstantBuffer(ShaderDescription& shader, ID3D11ShaderReflectionConstantBuffer* constantBuffer)
     {
         D3D11_SHADER_BUFFER_DESC desc;
         ThrowIfFailed(constantBuffer->GetDesc(&desc));
 
-        // Resize our constant buffer to match the shader.
-        m_constants.resize(desc.Size);
+        // Size the default constant buffer to match the shader.
+        shader.DefaultConstants.resize(desc.Size);
 
         // Look up variable metadata.
-        m_shader.Variables.reserve(desc.Variables);
+        shader.Variables.reserve(desc.Variables);
 
         for (unsigned i = 0; i < desc.Variables; i++)
         {
-            ReflectOverVariable(constantBuffer->GetVariableByIndex(i));
+            ReflectOverVariable(shader, constantBuffer->GetVariableByIndex(i));
         }
 
         // Sort the variables by name.
-        std::sort(m_shader.Variables.begin(), m_shader.Variables.end(), VariableNameComparison());
+        std::sort(shader.Variables.begin(), shader.Variables.end(), VariableNameComparison());
     }
 
 
@@ -630,7 +876,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
     }
 
 
-    void SharedShaderState::ReflectOverVariable(ID3D11ShaderReflectionVariable* variable)
+    void SharedShaderState::ReflectOverVariable(ShaderDescription& shader, ID3D11ShaderReflectionVariable* variable)
     {
         D3D11_SHADER_VARIABLE_DESC desc;
         ThrowIfFailed(variable->GetDesc(&desc));
@@ -653,23 +899,23 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         // This can only fail if the shader blob is corrupted.
         auto endOffset = desc.StartOffset + desc.Size;
 
-        if (endOffset > m_constants.size() || endOffset < desc.StartOffset)
+        if (endOffset > shader.DefaultConstants.size() || endOffset < desc.StartOffset)
         {
             ThrowHR(E_UNEXPECTED);
         }
 
-        // Initialize our constant buffer with the default value of the variable.
+        // Initialize the default constant buffer with the default value of the variable.
         if (desc.DefaultValue)
         {
-            CopyDefaultValue(m_constants.data() + desc.StartOffset, desc, type);
+            CopyDefaultValue(shader.DefaultConstants.data() + desc.StartOffset, desc, type);
         }
 
         // Store metadata about this variable.
-        m_shader.Variables.emplace_back(desc, type);
+        shader.Variables.emplace_back(desc, type);
     }
 
 
-    void SharedShaderState::ReflectOverShaderLinkingFunction()
+    void SharedShaderState::ReflectOverShaderLinkingFunction(ShaderDescription& shader)
     {
         // If this shader was compiled to support shader linking, we can get extra information
         // (telling us which inputs are simple vs. complex) from the shader linking function.
@@ -677,7 +923,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         // It's valid to use shaders that don't support linking, so we return on failure rather than throwing.
         ComPtr<ID3DBlob> privateData;
 
-        if (FAILED(D3DGetBlobPart(m_shader.Code.data(), m_shader.Code.size(), D3D_BLOB_PRIVATE_DATA, 0, &privateData)))
+        if (FAILED(D3DGetBlobPart(shader.Code.data(), shader.Code.size(), D3D_BLOB_PRIVATE_DATA, 0, &privateData)))
             return;
 
         ComPtr<ID3D11LibraryReflection> reflector;
@@ -712,7 +958,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             else if (strstr(parameterDesc.SemanticName, "INPUT"))
             {
                 // INPUT semantic means a simple input, so select passthrough coordinate mapping mode.
-                m_coordinateMapping.Mapping[inputCount++] = SamplerCoordinateMapping::OneToOne;
+                if (inputCount < MaxShaderInputs)
+                {
+                    shader.SimpleInputs |= 1u << inputCount;
+                }
+
+                inputCount++;
             }
         }
     }
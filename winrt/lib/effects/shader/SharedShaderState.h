@@ -62,24 +62,44 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         virtual ComPtr<IInspectable> GetProperty(HSTRING name) = 0;
         virtual void SetProperty(HSTRING name, IInspectable* boxedValue) = 0;
         virtual std::vector<StringObjectPair> EnumerateProperties() = 0;
+
+        // Handle based accessors resolve names and validate the variable up front, so
+        // updating values doesn't involve any string comparison or boxing.
+        virtual int GetPropertyHandle(HSTRING name) = 0;
+        virtual unsigned GetPropertyOffset(int handle) = 0;
+        virtual void SetPropertyValues(int handle, float const* values, uint32_t valueCount) = 0;
+        virtual void SetPropertyValues(int handle, int const* values, uint32_t valueCount) = 0;
+        virtual void SetConstants(BYTE const* constants, uint32_t size) = 0;
     };
     
 
+    struct ShaderDescriptionCacheCounters
+    {
+        uint32_t Hits;          // Shaders that were already reflected over, so reused a cached description.
+        uint32_t Misses;        // Shaders that were not already in the cache.
+        uint32_t DiskHits;      // Misses that were loaded from the on-disk cache rather than reflected over.
+        uint32_t Evictions;     // Cached descriptions dropped to limit how many shaders are held on to.
+    };
+
+
     class SharedShaderState : public RuntimeClass<RuntimeClassFlags<ClassicCom>, ISharedShaderState>
                             , private LifespanTracker<SharedShaderState>
     {
-        ShaderDescription m_shader;
+        // Immutable, so can be shared between all the states created from the same shader code.
+        std::shared_ptr<ShaderDescription const> m_shader;
+
         std::vector<BYTE> m_constants;
         CoordinateMappingState m_coordinateMapping;
         SourceInterpolationState m_sourceInterpolation;
 
     public:
         SharedShaderState(ShaderDescription const& shader, std::vector<BYTE> const& constants, CoordinateMappingState const& coordinateMapping, SourceInterpolationState const& sourceInterpolation);
+        SharedShaderState(std::shared_ptr<ShaderDescription const> const& shader, std::vector<BYTE> const& constants, CoordinateMappingState const& coordinateMapping, SourceInterpolationState const& sourceInterpolation);
         SharedShaderState(BYTE* shaderCode, uint32_t shaderCodeSize);
 
         virtual ComPtr<ISharedShaderState> Clone() override;
 
-        virtual ShaderDescription const& Shader() override { return m_shader; }
+        virtual ShaderDescription const& Shader() override { return *m_shader; }
         virtual std::vector<BYTE> const& Constants() override { return m_constants; }
         virtual CoordinateMappingState& CoordinateMapping() override { return m_coordinateMapping; }
         virtual SourceInterpolationState& SourceInterpolation() { return m_sourceInterpolation; }
@@ -91,9 +111,28 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         virtual void SetProperty(HSTRING name, IInspectable* boxedValue) override;
         virtual std::vector<StringObjectPair> EnumerateProperties() override;
 
+        // Handle based accessors.
+        virtual int GetPropertyHandle(HSTRING name) override;
+        virtual unsigned GetPropertyOffset(int handle) override;
+        virtual void SetPropertyValues(int handle, float const* values, uint32_t valueCount) override;
+        virtual void SetPropertyValues(int handle, int const* values, uint32_t valueCount) override;
+        virtual void SetConstants(BYTE const* constants, uint32_t size) override;
+
+        // Shader reflection results are cached process-wide, keyed by the code hash.
+        static ShaderDescriptionCacheCounters GetDescriptionCacheCounters();
+        static void ClearDescriptionCache();
+
+        // Opt-in persistent cache, so reflection results survive between runs. Empty means disabled.
+        static std::wstring GetDescriptionCacheFolder();
+        static void SetDescriptionCacheFolder(std::wstring const& folder);
+
     private:
         ComPtr<IInspectable> GetProperty(ShaderVariable const& variable);
         ShaderVariable const& FindVariable(HSTRING name);
+        ShaderVariable const& GetVariable(int handle);
+
+        template<typename TComponent>
+        void CopyPropertyValues(ShaderVariable const& variable, TComponent const* values, uint32_t valueCount);
 
 
         // Transfer property values between constant buffer and boxed IInspectable formats.
@@ -107,12 +146,15 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         void CopyConstantData(ShaderVariable const& variable, TComponent* values);
 
 
-        // Shader reflection (done at init time).
-        void ReflectOverShader();
-        void ReflectOverBindings(ID3D11ShaderReflection* reflector, D3D11_SHADER_DESC const& desc);
-        void ReflectOverConstantBuffer(ID3D11ShaderReflectionConstantBuffer* constantBuffer);
-        void ReflectOverVariable(ID3D11ShaderReflectionVariable* variable);
-        void ReflectOverShaderLinkingFunction();
+        // Looks up the description of a shader in the cache, reflecting over it on a miss.
+        static std::shared_ptr<ShaderDescription const> GetShaderDescription(BYTE* shaderCode, uint32_t shaderCodeSize);
+
+        // Shader reflection (done the first time each shader is used).
+        static void ReflectOverShader(ShaderDescription& shader);
+        static void ReflectOverBindings(ShaderDescription& shader, ID3D11ShaderReflection* reflector, D3D11_SHADER_DESC const& desc);
+        static void ReflectOverConstantBuffer(ShaderDescription& shader, ID3D11ShaderReflectionConstantBuffer* constantBuffer);
+        static void ReflectOverVariable(ShaderDescription& shader, ID3D11ShaderReflectionVariable* variable);
+        static void ReflectOverShaderLinkingFunction(ShaderDescription& shader);
     };
 
 }}}}}
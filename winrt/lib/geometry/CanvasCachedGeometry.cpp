@@ -107,12 +107,30 @@ CanvasCachedGeometry::CanvasCachedGeometry(
     ID2D1GeometryRealization* d2dGeometryRealization)
     : ResourceWrapper(d2dGeometryRealization)
     , m_canvasDevice(device)
+    , m_source{}
+{
+
+}
+
+CanvasCachedGeometry::CanvasCachedGeometry(
+    ICanvasDevice* device,
+    ID2D1GeometryRealization* d2dGeometryRealization,
+    CachedGeometrySource const& source)
+    : ResourceWrapper(d2dGeometryRealization)
+    , m_canvasDevice(device)
+    , m_source(source)
 {
 
 }
 
 IFACEMETHODIMP CanvasCachedGeometry::Close()
 {
+    {
+        auto lock = Lock(m_mutex);
+        m_source = CachedGeometrySource{};
+        m_spatialIndex.reset();
+    }
+
     m_canvasDevice.Close();
     return ResourceWrapper::Close();
 }
@@ -128,6 +146,78 @@ IFACEMETHODIMP CanvasCachedGeometry::get_Device(ICanvasDevice** device)
         });
 }
 
+IFACEMETHODIMP CanvasCachedGeometry::ContainsPoint(
+    Vector2 point,
+    boolean* containsPoint)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(containsPoint);
+
+            auto spatialIndex = GetSpatialIndex();
+
+            *containsPoint = spatialIndex->ContainsPoint(ToD2DPoint(point));
+        });
+}
+
+IFACEMETHODIMP CanvasCachedGeometry::IntersectsRectangle(
+    Rect rectangle,
+    boolean* intersects)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(intersects);
+
+            auto spatialIndex = GetSpatialIndex();
+
+            *intersects = spatialIndex->IntersectsRect(ToD2DRect(rectangle));
+        });
+}
+
+std::shared_ptr<GeometrySpatialIndex const> CanvasCachedGeometry::GetSpatialIndex()
+{
+    GetResource();
+
+    auto lock = Lock(m_mutex);
+
+    if (!m_spatialIndex)
+    {
+        if (!m_source.Geometry)
+            ThrowHR(E_NOTIMPL, Strings::CachedGeometryHasNoSourceGeometry);
+
+        auto sink = Make<FlattenedGeometrySink>(m_source.FlatteningTolerance);
+        CheckMakeResult(sink);
+
+        if (m_source.IsStroke)
+        {
+            // The outline of a stroke overlaps itself, so it is filled
+            // using the winding rule.
+            ThrowIfFailed(m_source.Geometry->Widen(
+                m_source.StrokeWidth,
+                m_source.StrokeStyle.Get(),
+                nullptr,
+                m_source.FlatteningTolerance,
+                sink.Get()));
+
+            sink->GetGeometry().SetFillMode(D2D1_FILL_MODE_WINDING);
+        }
+        else
+        {
+            ThrowIfFailed(m_source.Geometry->Simplify(
+                D2D1_GEOMETRY_SIMPLIFICATION_OPTION_LINES,
+                nullptr,
+                m_source.FlatteningTolerance,
+                sink.Get()));
+        }
+
+        m_spatialIndex = std::make_shared<GeometrySpatialIndex>(sink->GetGeometry());
+    }
+
+    return m_spatialIndex;
+}
+
 // Cached fills
 ComPtr<CanvasCachedGeometry> CanvasCachedGeometry::CreateNew(
     ICanvasDevice* device,
@@ -145,7 +235,11 @@ ComPtr<CanvasCachedGeometry> CanvasCachedGeometry::CreateNew(
         d2dGeometry.Get(),
         flatteningTolerance);
 
-    auto canvasCachedGeometry = Make<CanvasCachedGeometry>(device, d2dGeometryRealization.Get());
+    CachedGeometrySource source{};
+    source.Geometry = d2dGeometry;
+    source.FlatteningTolerance = flatteningTolerance;
+
+    auto canvasCachedGeometry = Make<CanvasCachedGeometry>(device, d2dGeometryRealization.Get(), source);
     CheckMakeResult(canvasCachedGeometry);
 
     return canvasCachedGeometry;
@@ -166,13 +260,22 @@ ComPtr<CanvasCachedGeometry> CanvasCachedGeometry::CreateNew(
 
     auto d2dGeometry = GetWrappedResource<ID2D1Geometry>(geometry);
 
+    auto d2dStrokeStyle = MaybeGetStrokeStyleResource(d2dGeometry.Get(), strokeStyle);
+
     auto d2dGeometryRealization = deviceInternal->CreateStrokedGeometryRealization(
         d2dGeometry.Get(),
         strokeWidth,
-        MaybeGetStrokeStyleResource(d2dGeometry.Get(), strokeStyle).Get(),
+        d2dStrokeStyle.Get(),
         flatteningTolerance);
 
-    auto canvasCachedGeometry = Make<CanvasCachedGeometry>(device, d2dGeometryRealization.Get());
+    CachedGeometrySource source{};
+    source.Geometry = d2dGeometry;
+    source.IsStroke = true;
+    source.StrokeWidth = strokeWidth;
+    source.StrokeStyle = d2dStrokeStyle;
+    source.FlatteningTolerance = flatteningTolerance;
+
+    auto canvasCachedGeometry = Make<CanvasCachedGeometry>(device, d2dGeometryRealization.Get(), source);
     CheckMakeResult(canvasCachedGeometry);
 
     return canvasCachedGeometry;
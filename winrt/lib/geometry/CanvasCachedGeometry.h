@@ -4,10 +4,24 @@
 
 #pragma once
 
+#include "GeometrySpatialIndex.h"
+#include "utils/LockUtilities.h"
+
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
 {
     using namespace ::Microsoft::WRL;
 
+    // What a cached geometry was realized from, kept so that hit tests can
+    // be answered against the same area that gets drawn.
+    struct CachedGeometrySource
+    {
+        ComPtr<ID2D1Geometry> Geometry;
+        bool IsStroke;
+        float StrokeWidth;
+        ComPtr<ID2D1StrokeStyle> StrokeStyle;
+        float FlatteningTolerance;
+    };
+
     class CanvasCachedGeometry : RESOURCE_WRAPPER_RUNTIME_CLASS(
         ID2D1GeometryRealization,
         CanvasCachedGeometry,
@@ -18,6 +32,12 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
         ClosablePtr<ICanvasDevice> m_canvasDevice;
 
+        // The spatial index is only built the first time it is needed, since
+        // many cached geometries are drawn but never hit tested.
+        std::mutex m_mutex;
+        CachedGeometrySource m_source;
+        std::shared_ptr<GeometrySpatialIndex const> m_spatialIndex;
+
     public:
         // Cached fills
         static ComPtr<CanvasCachedGeometry> CreateNew(
@@ -37,9 +57,25 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             ICanvasDevice* device,
             ID2D1GeometryRealization* d2dGeometryRealization);
 
+        CanvasCachedGeometry(
+            ICanvasDevice* device,
+            ID2D1GeometryRealization* d2dGeometryRealization,
+            CachedGeometrySource const& source);
+
         IFACEMETHOD(Close)();
 
         IFACEMETHOD(get_Device)(ICanvasDevice** device);
+
+        IFACEMETHOD(ContainsPoint)(
+            Numerics::Vector2 point,
+            boolean* containsPoint) override;
+
+        IFACEMETHOD(IntersectsRectangle)(
+            Rect rectangle,
+            boolean* intersects) override;
+
+    private:
+        std::shared_ptr<GeometrySpatialIndex const> GetSpatialIndex();
     };
 
 
@@ -8,6 +8,8 @@
 #include "CanvasPathBuilder.h"
 #include "GeometrySink.h"
 #include "TessellationSink.h"
+#include "FlattenedGeometry.h"
+#include "Polyline.h"
 #include "../images/CanvasCommandList.h"
 #include "../text/DrawGlyphRunHelper.h"
 #include "InkToGeometryCommandSink.h"
@@ -279,6 +281,35 @@ IFACEMETHODIMP CanvasGeometryFactory::CreatePolygon(
         });
 }
 
+IFACEMETHODIMP CanvasGeometryFactory::CreatePolyline(
+    ICanvasResourceCreator* resourceCreator,
+    uint32_t pointCount,
+    Numerics::Vector2* points,
+    boolean closed,
+    ICanvasGeometry** geometry)
+{
+    return CreatePolylineWithDecimationTolerance(resourceCreator, pointCount, points, closed, 0, geometry);
+}
+
+IFACEMETHODIMP CanvasGeometryFactory::CreatePolylineWithDecimationTolerance(
+    ICanvasResourceCreator* resourceCreator,
+    uint32_t pointCount,
+    Numerics::Vector2* points,
+    boolean closed,
+    float decimationTolerance,
+    ICanvasGeometry** geometry)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckAndClearOutPointer(geometry);
+
+            auto newCanvasGeometry = CanvasGeometry::CreateNew(resourceCreator, pointCount, points, !!closed, decimationTolerance);
+
+            ThrowIfFailed(newCanvasGeometry.CopyTo(geometry));
+        });
+}
+
 IFACEMETHODIMP CanvasGeometryFactory::CreateGroup(
     ICanvasResourceCreator* resourceCreator,
     uint32_t geometryCount,
@@ -466,17 +497,27 @@ IFACEMETHODIMP CanvasGeometryFactory::get_DefaultFlatteningTolerance(float* theV
 CanvasGeometry::CanvasGeometry(GeometryDevicePtr const& device, ID2D1Geometry* d2dGeometry)
     : ResourceWrapper(d2dGeometry)
     , m_device(device)
+    , m_flattenedFill{}
+    , m_flattenedStroke{}
 {
 }
 
 CanvasGeometry::CanvasGeometry(ICanvasDevice* device, ID2D1Geometry* d2dGeometry)
     : ResourceWrapper(d2dGeometry)
     , m_device(device)
+    , m_flattenedFill{}
+    , m_flattenedStroke{}
 {
 }
 
 IFACEMETHODIMP CanvasGeometry::Close()
 {
+    {
+        Lock lock(m_flattenedGeometryMutex);
+        m_flattenedFill = CachedFlattenedGeometry{};
+        m_flattenedStroke = CachedFlattenedGeometry{};
+    }
+
     m_device.Close();
     return ResourceWrapper::Close();
 }
@@ -883,6 +924,162 @@ void CanvasGeometry::ComputePointOnPathImpl(
     }
 }
 
+//
+// The batched queries flatten the geometry once, via Simplify (or Widen for
+// strokes), and then answer every query against the flattened copy.  This
+// avoids D2D walking the whole geometry again for each point.
+//
+bool CanvasGeometry::FlattenedGeometryKey::operator==(FlattenedGeometryKey const& other) const
+{
+    return memcmp(&Transform, &other.Transform, sizeof(Transform)) == 0 &&
+           FlatteningTolerance == other.FlatteningTolerance &&
+           StrokeWidth == other.StrokeWidth &&
+           IsSameInstance(StrokeStyle.Get(), other.StrokeStyle.Get());
+}
+
+std::shared_ptr<FlattenedGeometry const> CanvasGeometry::GetCachedFlattening(
+    CachedFlattenedGeometry& cache,
+    FlattenedGeometryKey const& key,
+    std::function<FlattenedGeometry(void)> const& flatten)
+{
+    {
+        Lock lock(m_flattenedGeometryMutex);
+
+        if (cache.Geometry && cache.Key == key)
+            return cache.Geometry;
+    }
+
+    // Flattening happens outside the lock, so that a slow one doesn't hold
+    // up queries on other threads that can use the cached copy.
+    auto flattened = std::make_shared<FlattenedGeometry const>(flatten());
+
+    Lock lock(m_flattenedGeometryMutex);
+
+    cache.Key = key;
+    cache.Geometry = flattened;
+
+    return flattened;
+}
+
+std::shared_ptr<FlattenedGeometry const> CanvasGeometry::GetFlattenedGeometry(
+    ID2D1Geometry* d2dGeometry,
+    Matrix3x2* transform,
+    float flatteningTolerance)
+{
+    auto& d2dTransform = *ReinterpretAs<D2D1_MATRIX_3X2_F*>(transform);
+
+    FlattenedGeometryKey key{ d2dTransform, flatteningTolerance };
+
+    return GetCachedFlattening(m_flattenedFill, key,
+        [&]
+        {
+            auto sink = Make<FlattenedGeometrySink>(flatteningTolerance);
+            CheckMakeResult(sink);
+
+            ThrowIfFailed(d2dGeometry->Simplify(
+                D2D1_GEOMETRY_SIMPLIFICATION_OPTION_LINES,
+                &d2dTransform,
+                flatteningTolerance,
+                sink.Get()));
+
+            return std::move(sink->GetGeometry());
+        });
+}
+
+std::shared_ptr<FlattenedGeometry const> CanvasGeometry::GetFlattenedStroke(
+    ID2D1Geometry* d2dGeometry,
+    float strokeWidth,
+    ICanvasStrokeStyle* strokeStyle,
+    Matrix3x2* transform,
+    float flatteningTolerance)
+{
+    auto d2dTransform = ReinterpretAs<D2D1_MATRIX_3X2_F*>(transform);
+    auto d2dStrokeStyle = MaybeGetStrokeStyleResource(d2dGeometry, strokeStyle);
+
+    // No transform and the identity flatten the same way, so share an entry.
+    FlattenedGeometryKey key{ d2dTransform ? *d2dTransform : D2D1::Matrix3x2F::Identity(), flatteningTolerance, strokeWidth, d2dStrokeStyle };
+
+    return GetCachedFlattening(m_flattenedStroke, key,
+        [&]
+        {
+            // Widen produces the outline of the stroke, including caps, joins
+            // and dashes, so hit testing the stroke becomes hit testing the fill
+            // of its outline.  The outline can overlap itself, so it must be
+            // filled with the winding rule.
+            auto sink = Make<FlattenedGeometrySink>(flatteningTolerance);
+            CheckMakeResult(sink);
+
+            ThrowIfFailed(d2dGeometry->Widen(
+                strokeWidth,
+                d2dStrokeStyle.Get(),
+                d2dTransform,
+                flatteningTolerance,
+                sink.Get()));
+
+            auto& flattened = sink->GetGeometry();
+            flattened.SetFillMode(D2D1_FILL_MODE_WINDING);
+
+            return std::move(flattened);
+        });
+}
+
+IFACEMETHODIMP CanvasGeometry::ComputePointsOnPath(
+    UINT32 distancesCount,
+    float* distances,
+    UINT32* pointsCount,
+    Vector2** points)
+{
+    return ComputePointsOnPathWithTransformAndFlatteningTolerance(
+        distancesCount,
+        distances,
+        Identity3x2(),
+        D2D1_DEFAULT_FLATTENING_TOLERANCE,
+        pointsCount,
+        points);
+}
+
+IFACEMETHODIMP CanvasGeometry::ComputePointsOnPathWithTransformAndFlatteningTolerance(
+    UINT32 distancesCount,
+    float* distances,
+    Matrix3x2 transform,
+    float flatteningTolerance,
+    UINT32* pointsCount,
+    Vector2** points)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            if (distancesCount > 0)
+            {
+                CheckInPointer(distances);
+            }
+
+            CheckInPointer(pointsCount);
+            CheckAndClearOutPointer(points);
+
+            auto& resource = GetResource();
+
+            ComArray<Vector2> result(distancesCount);
+
+            if (distancesCount > 0)
+            {
+                auto flattened = GetFlattenedGeometry(resource.Get(), &transform, flatteningTolerance);
+
+                for (uint32_t i = 0; i < distancesCount; i++)
+                {
+                    D2D1_POINT_2F d2dPoint;
+                    D2D1_POINT_2F d2dUnitTangentVector;
+
+                    flattened->ComputePointAtLength(distances[i], &d2dPoint, &d2dUnitTangentVector);
+
+                    result[i] = FromD2DPoint(d2dPoint);
+                }
+            }
+
+            result.Detach(pointsCount, points);
+        });
+}
+
 IFACEMETHODIMP CanvasGeometry::FillContainsPoint(
     Vector2 point,
     boolean* containsPoint)
@@ -919,6 +1116,58 @@ IFACEMETHODIMP CanvasGeometry::FillContainsPointWithTransformAndFlatteningTolera
         });
 }
 
+IFACEMETHODIMP CanvasGeometry::FillContainsPoints(
+    UINT32 pointsCount,
+    Vector2* points,
+    UINT32* resultsCount,
+    boolean** results)
+{
+    return FillContainsPointsWithTransformAndFlatteningTolerance(
+        pointsCount,
+        points,
+        Identity3x2(),
+        D2D1_DEFAULT_FLATTENING_TOLERANCE,
+        resultsCount,
+        results);
+}
+
+IFACEMETHODIMP CanvasGeometry::FillContainsPointsWithTransformAndFlatteningTolerance(
+    UINT32 pointsCount,
+    Vector2* points,
+    Matrix3x2 transform,
+    float flatteningTolerance,
+    UINT32* resultsCount,
+    boolean** results)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            if (pointsCount > 0)
+            {
+                CheckInPointer(points);
+            }
+
+            CheckInPointer(resultsCount);
+            CheckAndClearOutPointer(results);
+
+            auto& resource = GetResource();
+
+            ComArray<boolean> result(pointsCount);
+
+            if (pointsCount > 0)
+            {
+                auto flattened = GetFlattenedGeometry(resource.Get(), &transform, flatteningTolerance);
+
+                for (uint32_t i = 0; i < pointsCount; i++)
+                {
+                    result[i] = flattened->FillContainsPoint(ToD2DPoint(points[i]), flatteningTolerance);
+                }
+            }
+
+            result.Detach(resultsCount, results);
+        });
+}
+
 IFACEMETHODIMP CanvasGeometry::ComputeBounds(
     Rect* bounds)
 {
@@ -1075,6 +1324,89 @@ void CanvasGeometry::StrokeContainsPointImpl(
     *containsPoint = !!d2dContainsPoint;
 }
 
+IFACEMETHODIMP CanvasGeometry::StrokeContainsPoints(
+    UINT32 pointsCount,
+    Vector2* points,
+    float strokeWidth,
+    UINT32* resultsCount,
+    boolean** results)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            StrokeContainsPointsImpl(pointsCount, points, strokeWidth, nullptr, nullptr, D2D1_DEFAULT_FLATTENING_TOLERANCE, resultsCount, results);
+        });
+}
+
+IFACEMETHODIMP CanvasGeometry::StrokeContainsPointsWithStrokeStyle(
+    UINT32 pointsCount,
+    Vector2* points,
+    float strokeWidth,
+    ICanvasStrokeStyle* strokeStyle,
+    UINT32* resultsCount,
+    boolean** results)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(strokeStyle);
+            StrokeContainsPointsImpl(pointsCount, points, strokeWidth, strokeStyle, nullptr, D2D1_DEFAULT_FLATTENING_TOLERANCE, resultsCount, results);
+        });
+}
+
+IFACEMETHODIMP CanvasGeometry::StrokeContainsPointsWithAllOptions(
+    UINT32 pointsCount,
+    Vector2* points,
+    float strokeWidth,
+    ICanvasStrokeStyle* strokeStyle,
+    Matrix3x2 transform,
+    float flatteningTolerance,
+    UINT32* resultsCount,
+    boolean** results)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(strokeStyle);
+            StrokeContainsPointsImpl(pointsCount, points, strokeWidth, strokeStyle, &transform, flatteningTolerance, resultsCount, results);
+        });
+}
+
+void CanvasGeometry::StrokeContainsPointsImpl(
+    UINT32 pointsCount,
+    Vector2* points,
+    float strokeWidth,
+    ICanvasStrokeStyle* strokeStyle,
+    Matrix3x2* transform,
+    float flatteningTolerance,
+    UINT32* resultsCount,
+    boolean** results)
+{
+    if (pointsCount > 0)
+    {
+        CheckInPointer(points);
+    }
+
+    CheckInPointer(resultsCount);
+    CheckAndClearOutPointer(results);
+
+    auto& resource = GetResource();
+
+    ComArray<boolean> result(pointsCount);
+
+    if (pointsCount > 0)
+    {
+        auto flattened = GetFlattenedStroke(resource.Get(), strokeWidth, strokeStyle, transform, flatteningTolerance);
+
+        for (uint32_t i = 0; i < pointsCount; i++)
+        {
+            result[i] = flattened->FillContainsPoint(ToD2DPoint(points[i]), flatteningTolerance);
+        }
+    }
+
+    result.Detach(resultsCount, results);
+}
+
 IFACEMETHODIMP CanvasGeometry::Tessellate(
     UINT32* trianglesCount,
     CanvasTriangleVertices** triangles)
@@ -1112,6 +1444,61 @@ IFACEMETHODIMP CanvasGeometry::TessellateWithTransformAndFlatteningTolerance(
     });
 }
 
+IFACEMETHODIMP CanvasGeometry::TessellateWithBuffer(
+    ABI::Windows::Storage::Streams::IBuffer* buffer,
+    UINT32* trianglesCount)
+{
+    return TessellateWithBufferAndTransformAndFlatteningTolerance(
+        buffer,
+        Identity3x2(),
+        D2D1_DEFAULT_FLATTENING_TOLERANCE,
+        trianglesCount);
+}
+
+IFACEMETHODIMP CanvasGeometry::TessellateWithBufferAndTransformAndFlatteningTolerance(
+    ABI::Windows::Storage::Streams::IBuffer* buffer,
+    Matrix3x2 transform,
+    float flatteningTolerance,
+    UINT32* trianglesCount)
+{
+    using ::Windows::Storage::Streams::IBufferByteAccess;
+
+    return ExceptionBoundary([&]
+    {
+        CheckInPointer(buffer);
+        CheckInPointer(trianglesCount);
+
+        auto& resource = GetResource();
+
+        uint32_t capacity;
+        ThrowIfFailed(buffer->get_Capacity(&capacity));
+
+        uint8_t* destination;
+        ThrowIfFailed(As<IBufferByteAccess>(buffer)->Buffer(&destination));
+
+        uint32_t capacityInTriangles = capacity / sizeof(CanvasTriangleVertices);
+
+        // D2D hands its triangles straight to the sink, which writes them
+        // directly into the buffer's memory.
+        auto tessellationSink = Make<TessellationSink>(destination, capacityInTriangles);
+        CheckMakeResult(tessellationSink);
+
+        ThrowIfFailed(resource->Tessellate(
+            ReinterpretAs<D2D1_MATRIX_3X2_F*>(&transform),
+            flatteningTolerance,
+            tessellationSink.Get()));
+
+        auto count = tessellationSink->GetTriangleCount();
+
+        // If the buffer was too small, its contents are incomplete, so we
+        // report it as empty and let the caller retry with a bigger one.
+        bool fits = count <= capacityInTriangles;
+        ThrowIfFailed(buffer->put_Length(fits ? count * sizeof(CanvasTriangleVertices) : 0));
+
+        *trianglesCount = count;
+    });
+}
+
 IFACEMETHODIMP CanvasGeometry::SendPathTo(
     ICanvasPathReceiver* streamReader)
 {
@@ -1284,6 +1671,37 @@ ComPtr<CanvasGeometry> CanvasGeometry::CreateNew(
     return canvasGeometry;
 }
 
+ComPtr<CanvasGeometry> CanvasGeometry::CreateNew(
+    ICanvasResourceCreator* resourceCreator,
+    uint32_t pointCount,
+    Vector2 const* points,
+    bool closed,
+    float decimationTolerance)
+{
+    if (pointCount > 0)
+    {
+        CheckInPointer(points);
+    }
+
+    CheckPolylineColumnWidth(decimationTolerance);
+
+    GeometryDevicePtr device(resourceCreator);
+
+    auto pathGeometry = GeometryAdapter::GetInstance()->CreatePathGeometry(device);
+
+    ComPtr<ID2D1GeometrySink> geometrySink;
+    ThrowIfFailed(pathGeometry->Open(&geometrySink));
+
+    AddPolylineToSink(geometrySink.Get(), pointCount, points, closed, decimationTolerance, 0);
+
+    ThrowIfFailed(geometrySink->Close());
+
+    auto canvasGeometry = Make<CanvasGeometry>(device, pathGeometry.Get());
+    CheckMakeResult(canvasGeometry);
+
+    return canvasGeometry;
+}
+
 ComPtr<CanvasGeometry> CanvasGeometry::CreateNew(
     ICanvasResourceCreator* resourceCreator,
     uint32_t geometryCount,
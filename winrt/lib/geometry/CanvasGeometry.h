@@ -13,6 +13,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
     class GeometryAdapter;
     class DefaultGeometryAdapter;
+    class FlattenedGeometry;
 
 
     // When geometry is used without an associated CanvasDevice, this singleton provides
@@ -88,6 +89,31 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
         GeometryDevicePtr m_device;
 
+        // The batched queries keep the most recent flattening of the fill, and
+        // of the widened stroke, and reuse each for as long as they are passed
+        // the same arguments.  D2D geometry is immutable, so neither goes
+        // stale.  Changing a CanvasStrokeStyle releases its D2D stroke style,
+        // so keying on that instance picks up style changes.
+        struct FlattenedGeometryKey
+        {
+            D2D1_MATRIX_3X2_F Transform;
+            float FlatteningTolerance;
+            float StrokeWidth;
+            ComPtr<ID2D1StrokeStyle> StrokeStyle;
+
+            bool operator==(FlattenedGeometryKey const& other) const;
+        };
+
+        struct CachedFlattenedGeometry
+        {
+            FlattenedGeometryKey Key;
+            std::shared_ptr<FlattenedGeometry const> Geometry;
+        };
+
+        std::mutex m_flattenedGeometryMutex;
+        CachedFlattenedGeometry m_flattenedFill;
+        CachedFlattenedGeometry m_flattenedStroke;
+
     public:
         static ComPtr<CanvasGeometry> CreateNew(
             ICanvasResourceCreator* device,
@@ -113,6 +139,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             uint32_t pointCount,
             Vector2* points);
 
+        static ComPtr<CanvasGeometry> CreateNew(
+            ICanvasResourceCreator* resourceCreator,
+            uint32_t pointCount,
+            Vector2 const* points,
+            bool closed,
+            float decimationTolerance);
+
         static ComPtr<CanvasGeometry> CreateNew(
             ICanvasResourceCreator* resourceCreator,
             uint32_t geometryCount,
@@ -242,6 +275,20 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             Vector2* tangent,
             Vector2* point) override;
 
+        IFACEMETHOD(ComputePointsOnPath)(
+            UINT32 distancesCount,
+            float* distances,
+            UINT32* pointsCount,
+            Vector2** points) override;
+
+        IFACEMETHOD(ComputePointsOnPathWithTransformAndFlatteningTolerance)(
+            UINT32 distancesCount,
+            float* distances,
+            Matrix3x2 transform,
+            float flatteningTolerance,
+            UINT32* pointsCount,
+            Vector2** points) override;
+
         IFACEMETHOD(FillContainsPoint)(
             Vector2 point,
             boolean* containsPoint) override;
@@ -252,6 +299,20 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             float flatteningTolerance,
             boolean* containsPoint) override;
 
+        IFACEMETHOD(FillContainsPoints)(
+            UINT32 pointsCount,
+            Vector2* points,
+            UINT32* resultsCount,
+            boolean** results) override;
+
+        IFACEMETHOD(FillContainsPointsWithTransformAndFlatteningTolerance)(
+            UINT32 pointsCount,
+            Vector2* points,
+            Matrix3x2 transform,
+            float flatteningTolerance,
+            UINT32* resultsCount,
+            boolean** results) override;
+
         IFACEMETHOD(ComputeBounds)(
             Rect* bounds) override;
 
@@ -294,6 +355,31 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             float flatteningTolerance,
             boolean* containsPoint) override;
 
+        IFACEMETHOD(StrokeContainsPoints)(
+            UINT32 pointsCount,
+            Vector2* points,
+            float strokeWidth,
+            UINT32* resultsCount,
+            boolean** results) override;
+
+        IFACEMETHOD(StrokeContainsPointsWithStrokeStyle)(
+            UINT32 pointsCount,
+            Vector2* points,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle,
+            UINT32* resultsCount,
+            boolean** results) override;
+
+        IFACEMETHOD(StrokeContainsPointsWithAllOptions)(
+            UINT32 pointsCount,
+            Vector2* points,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle,
+            Matrix3x2 transform,
+            float flatteningTolerance,
+            UINT32* resultsCount,
+            boolean** results) override;
+
         IFACEMETHOD(Tessellate)(
             UINT32* trianglesCount,
             CanvasTriangleVertices** triangles) override;
@@ -304,6 +390,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             UINT32* trianglesCount,
             CanvasTriangleVertices** triangles) override;
 
+        IFACEMETHOD(TessellateWithBuffer)(
+            ABI::Windows::Storage::Streams::IBuffer* buffer,
+            UINT32* trianglesCount) override;
+
+        IFACEMETHOD(TessellateWithBufferAndTransformAndFlatteningTolerance)(
+            ABI::Windows::Storage::Streams::IBuffer* buffer,
+            Matrix3x2 transform,
+            float flatteningTolerance,
+            UINT32* trianglesCount) override;
+
         IFACEMETHOD(SendPathTo)(
             ICanvasPathReceiver* streamReader) override;
 
@@ -316,6 +412,23 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             ID2D1Geometry** geometry) override;
 
     private:
+        std::shared_ptr<FlattenedGeometry const> GetFlattenedGeometry(
+            ID2D1Geometry* d2dGeometry,
+            Matrix3x2* transform,
+            float flatteningTolerance);
+
+        std::shared_ptr<FlattenedGeometry const> GetFlattenedStroke(
+            ID2D1Geometry* d2dGeometry,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle,
+            Matrix3x2* transform,
+            float flatteningTolerance);
+
+        std::shared_ptr<FlattenedGeometry const> GetCachedFlattening(
+            CachedFlattenedGeometry& cache,
+            FlattenedGeometryKey const& key,
+            std::function<FlattenedGeometry(void)> const& flatten);
+
         void StrokeImpl(
             float strokeWidth,
             ICanvasStrokeStyle* strokeStyle,
@@ -338,6 +451,16 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             float flatteningTolerance,
             boolean* containsPoint);
 
+        void StrokeContainsPointsImpl(
+            UINT32 pointsCount,
+            Vector2* points,
+            float strokeWidth,
+            ICanvasStrokeStyle* strokeStyle,
+            Matrix3x2* transform,
+            float flatteningTolerance,
+            UINT32* resultsCount,
+            boolean** results);
+
         void ComputeStrokeBoundsImpl(
             float strokeWidth,
             ICanvasStrokeStyle* strokeStyle,
@@ -429,6 +552,21 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             Numerics::Vector2* points,
             ICanvasGeometry** geometry) override;
 
+        IFACEMETHOD(CreatePolyline)(
+            ICanvasResourceCreator* resourceCreator,
+            uint32_t pointCount,
+            Numerics::Vector2* points,
+            boolean closed,
+            ICanvasGeometry** geometry) override;
+
+        IFACEMETHOD(CreatePolylineWithDecimationTolerance)(
+            ICanvasResourceCreator* resourceCreator,
+            uint32_t pointCount,
+            Numerics::Vector2* points,
+            boolean closed,
+            float decimationTolerance,
+            ICanvasGeometry** geometry) override;
+
         IFACEMETHOD(CreateGroup)(
             ICanvasResourceCreator* resourceCreator,
             uint32_t geometryCount,
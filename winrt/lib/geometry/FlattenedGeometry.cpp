@@ -0,0 +1,456 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "FlattenedGeometry.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
+{
+    static const uint32_t MaxBezierSegments = 1000;
+    static const uint32_t MaxBandCount = 1024;
+
+    static float Distance(D2D1_POINT_2F const& a, D2D1_POINT_2F const& b)
+    {
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        return sqrtf(dx * dx + dy * dy);
+    }
+
+    static float DistanceSquaredToSegment(D2D1_POINT_2F const& point, D2D1_POINT_2F const& a, D2D1_POINT_2F const& b)
+    {
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        float lengthSquared = dx * dx + dy * dy;
+
+        // Project the point onto the segment, clamping to its ends.
+        float t = (lengthSquared > 0) ? ((point.x - a.x) * dx + (point.y - a.y) * dy) / lengthSquared : 0;
+        t = std::max(0.0f, std::min(t, 1.0f));
+
+        float x = a.x + t * dx - point.x;
+        float y = a.y + t * dy - point.y;
+
+        return x * x + y * y;
+    }
+
+    FlattenedGeometry::FlattenedGeometry()
+        : m_fillMode(D2D1_FILL_MODE_ALTERNATE)
+        , m_bandTop(0)
+        , m_bandBottom(0)
+        , m_bandHeight(0)
+        , m_totalLength(0)
+        , m_firstPoint{}
+        , m_hasFirstPoint(false)
+        , m_figureIsFilled(false)
+        , m_isInFigure(false)
+        , m_isSealed(false)
+    {
+    }
+
+
+    void FlattenedGeometry::SetFillMode(D2D1_FILL_MODE fillMode)
+    {
+        m_fillMode = fillMode;
+    }
+
+
+    void FlattenedGeometry::BeginFigure(D2D1_POINT_2F const& startPoint, bool isFilled)
+    {
+        assert(!m_isSealed);
+
+        if (m_isInFigure)
+            EndFigure(false);
+
+        m_figure.clear();
+        m_figure.push_back(startPoint);
+        m_figureIsFilled = isFilled;
+        m_isInFigure = true;
+
+        if (isFilled)
+            m_filledFigureStarts.push_back(static_cast<uint32_t>(m_edges.size()));
+
+        if (!m_hasFirstPoint)
+        {
+            m_firstPoint = startPoint;
+            m_hasFirstPoint = true;
+        }
+    }
+
+
+    void FlattenedGeometry::AddLine(D2D1_POINT_2F const& point)
+    {
+        assert(m_isInFigure);
+
+        AddPathSegment(m_figure.back(), point);
+
+        if (m_figureIsFilled)
+            AddEdge(m_figure.back(), point);
+
+        m_figure.push_back(point);
+    }
+
+
+    //
+    // Cubic beziers are flattened by evaluating them at evenly spaced
+    // parameter values.  The number of segments comes from Wang's formula,
+    // which bounds how far the polyline can stray from the curve.
+    //
+    void FlattenedGeometry::AddBezier(D2D1_BEZIER_SEGMENT const& bezier, float flatteningTolerance)
+    {
+        assert(m_isInFigure);
+
+        auto p0 = m_figure.back();
+        auto& p1 = bezier.point1;
+        auto& p2 = bezier.point2;
+        auto& p3 = bezier.point3;
+
+        if (!(flatteningTolerance > 0))
+            flatteningTolerance = D2D1_DEFAULT_FLATTENING_TOLERANCE;
+
+        float ddx0 = p0.x - 2 * p1.x + p2.x;
+        float ddy0 = p0.y - 2 * p1.y + p2.y;
+        float ddx1 = p1.x - 2 * p2.x + p3.x;
+        float ddy1 = p1.y - 2 * p2.y + p3.y;
+
+        float maxSecondDifference = sqrtf(std::max(ddx0 * ddx0 + ddy0 * ddy0, ddx1 * ddx1 + ddy1 * ddy1));
+
+        float idealSegmentCount = ceilf(sqrtf(0.75f * maxSecondDifference / flatteningTolerance));
+
+        uint32_t segmentCount = 1;
+        if (idealSegmentCount > 1)
+            segmentCount = idealSegmentCount < MaxBezierSegments ? static_cast<uint32_t>(idealSegmentCount) : MaxBezierSegments;
+
+        for (uint32_t i = 1; i < segmentCount; i++)
+        {
+            float t = static_cast<float>(i) / segmentCount;
+            float u = 1 - t;
+
+            float a = u * u * u;
+            float b = 3 * u * u * t;
+            float c = 3 * u * t * t;
+            float d = t * t * t;
+
+            AddLine(D2D1::Point2F(
+                a * p0.x + b * p1.x + c * p2.x + d * p3.x,
+                a * p0.y + b * p1.y + c * p2.y + d * p3.y));
+        }
+
+        // Finish exactly on the end point.
+        AddLine(p3);
+    }
+
+
+    void FlattenedGeometry::EndFigure(bool isClosed)
+    {
+        assert(m_isInFigure);
+
+        auto& start = m_figure.front();
+        auto& end = m_figure.back();
+
+        if (isClosed)
+            AddPathSegment(end, start);
+
+        // Fills always treat figures as closed.
+        if (m_figureIsFilled)
+            AddEdge(end, start);
+
+        m_figure.clear();
+        m_isInFigure = false;
+    }
+
+
+    void FlattenedGeometry::AddEdge(D2D1_POINT_2F const& start, D2D1_POINT_2F const& end)
+    {
+        if (start.x != end.x || start.y != end.y)
+            m_edges.push_back(Edge{ start, end });
+    }
+
+
+    void FlattenedGeometry::AddPathSegment(D2D1_POINT_2F const& start, D2D1_POINT_2F const& end)
+    {
+        float length = Distance(start, end);
+
+        if (length > 0)
+        {
+            m_pathSegments.push_back(PathSegment{ start, end, m_totalLength, length });
+            m_totalLength += length;
+        }
+    }
+
+
+    void FlattenedGeometry::Seal()
+    {
+        if (m_isSealed)
+            return;
+
+        if (m_isInFigure)
+            EndFigure(false);
+
+        m_isSealed = true;
+
+        if (m_edges.empty())
+            return;
+
+        float top = FLT_MAX;
+        float bottom = -FLT_MAX;
+
+        for (auto& edge : m_edges)
+        {
+            top = std::min(top, std::min(edge.Start.y, edge.End.y));
+            bottom = std::max(bottom, std::max(edge.Start.y, edge.End.y));
+        }
+
+        // Roughly sqrt(n) bands keeps both the number of bands and the
+        // number of edges per band small.
+        auto bandCount = static_cast<uint32_t>(sqrtf(static_cast<float>(m_edges.size())));
+        bandCount = std::max(1u, std::min(bandCount, MaxBandCount));
+
+        m_bandTop = top;
+        m_bandBottom = bottom;
+        m_bandHeight = (bottom - top) / bandCount;
+        m_bands.resize(bandCount);
+
+        if (!(m_bandHeight > 0 && m_bandHeight < FLT_MAX))
+        {
+            m_bandHeight = 0;
+            m_bands.resize(1);
+        }
+
+        //
+        // Horizontal edges never cross the horizontal rays used for the
+        // winding test, so they add nothing to it, but they are still needed
+        // in the bands for the tolerance test.
+        //
+        for (uint32_t i = 0; i < m_edges.size(); i++)
+        {
+            auto& edge = m_edges[i];
+
+            auto firstBand = GetBandIndex(std::min(edge.Start.y, edge.End.y));
+            auto endBand = GetBandIndex(std::max(edge.Start.y, edge.End.y));
+
+            for (auto band = firstBand; band <= endBand; band++)
+            {
+                m_bands[band].push_back(i);
+            }
+        }
+    }
+
+
+    uint32_t FlattenedGeometry::GetBandIndex(float y) const
+    {
+        if (m_bandHeight == 0)
+            return 0;
+
+        float band = (y - m_bandTop) / m_bandHeight;
+        auto lastBand = static_cast<uint32_t>(m_bands.size() - 1);
+
+        return band <= 0 ? 0u : (band < lastBand ? static_cast<uint32_t>(band) : lastBand);
+    }
+
+
+    //
+    // Computes the winding number of the geometry around the point by
+    // counting signed crossings of a ray from the point towards +x.  Edges
+    // are treated as half open in y so that a ray passing exactly through a
+    // vertex is only counted once.
+    //
+    bool FlattenedGeometry::FillContainsPoint(D2D1_POINT_2F const& point, float tolerance) const
+    {
+        assert(m_isSealed);
+
+        if (!(tolerance > 0))
+            tolerance = 0;
+
+        if (m_bands.empty() || !(point.y >= m_bandTop - tolerance))
+            return false;
+
+        int windingNumber = 0;
+
+        for (auto edgeIndex : m_bands[GetBandIndex(point.y)])
+        {
+            auto& edge = m_edges[edgeIndex];
+            auto& a = edge.Start;
+            auto& b = edge.End;
+
+            // Which side of the edge is the point on?
+            float side = (b.x - a.x) * (point.y - a.y) - (point.x - a.x) * (b.y - a.y);
+
+            if (a.y <= point.y)
+            {
+                if (b.y > point.y && side > 0)
+                    windingNumber++;
+            }
+            else
+            {
+                if (b.y <= point.y && side < 0)
+                    windingNumber--;
+            }
+        }
+
+        bool isInside;
+
+        if (m_fillMode == D2D1_FILL_MODE_WINDING)
+            isInside = windingNumber != 0;
+        else
+            isInside = (windingNumber & 1) != 0;
+
+        return isInside || IsWithinToleranceOfEdge(point, tolerance);
+    }
+
+
+    bool FlattenedGeometry::IsWithinToleranceOfEdge(D2D1_POINT_2F const& point, float tolerance) const
+    {
+        if (!(point.y <= m_bandBottom + tolerance))
+            return false;
+
+        auto firstBand = GetBandIndex(point.y - tolerance);
+        auto endBand = GetBandIndex(point.y + tolerance);
+
+        float toleranceSquared = tolerance * tolerance;
+
+        for (auto band = firstBand; band <= endBand; band++)
+        {
+            for (auto edgeIndex : m_bands[band])
+            {
+                auto& edge = m_edges[edgeIndex];
+
+                if (DistanceSquaredToSegment(point, edge.Start, edge.End) <= toleranceSquared)
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+
+    float FlattenedGeometry::GetLength() const
+    {
+        assert(m_isSealed);
+
+        return m_totalLength;
+    }
+
+
+    void FlattenedGeometry::ComputePointAtLength(float length, D2D1_POINT_2F* point, D2D1_POINT_2F* unitTangent) const
+    {
+        assert(m_isSealed);
+
+        if (m_pathSegments.empty())
+        {
+            *point = m_firstPoint;
+            *unitTangent = D2D1_POINT_2F{ 0, 0 };
+            return;
+        }
+
+        // Find the last segment that starts at or before this length.
+        auto it = std::upper_bound(
+            m_pathSegments.begin(),
+            m_pathSegments.end(),
+            length,
+            [](float value, PathSegment const& segment) { return value < segment.StartLength; });
+
+        auto& segment = (it == m_pathSegments.begin()) ? m_pathSegments.front() : *(it - 1);
+
+        float t = (length - segment.StartLength) / segment.Length;
+        t = std::max(0.0f, std::min(t, 1.0f));
+
+        float dx = segment.End.x - segment.Start.x;
+        float dy = segment.End.y - segment.Start.y;
+
+        *point = D2D1::Point2F(segment.Start.x + dx * t, segment.Start.y + dy * t);
+        *unitTangent = D2D1::Point2F(dx / segment.Length, dy / segment.Length);
+    }
+
+
+    //
+    // FlattenedGeometrySink
+    //
+
+    FlattenedGeometrySink::FlattenedGeometrySink(float flatteningTolerance)
+        : m_flatteningTolerance(flatteningTolerance)
+        , m_result(S_OK)
+    {
+    }
+
+
+    IFACEMETHODIMP_(void) FlattenedGeometrySink::SetFillMode(D2D1_FILL_MODE fillMode)
+    {
+        m_geometry.SetFillMode(fillMode);
+    }
+
+
+    IFACEMETHODIMP_(void) FlattenedGeometrySink::SetSegmentFlags(D2D1_PATH_SEGMENT)
+    {
+    }
+
+
+    IFACEMETHODIMP_(void) FlattenedGeometrySink::BeginFigure(D2D1_POINT_2F startPoint, D2D1_FIGURE_BEGIN figureBegin)
+    {
+        if (FAILED(m_result))
+            return;
+
+        m_result = ExceptionBoundary([&]
+        {
+            m_geometry.BeginFigure(startPoint, figureBegin == D2D1_FIGURE_BEGIN_FILLED);
+        });
+    }
+
+
+    IFACEMETHODIMP_(void) FlattenedGeometrySink::AddLines(D2D1_POINT_2F const* points, UINT32 pointsCount)
+    {
+        if (FAILED(m_result))
+            return;
+
+        m_result = ExceptionBoundary([&]
+        {
+            for (uint32_t i = 0; i < pointsCount; i++)
+            {
+                m_geometry.AddLine(points[i]);
+            }
+        });
+    }
+
+
+    IFACEMETHODIMP_(void) FlattenedGeometrySink::AddBeziers(D2D1_BEZIER_SEGMENT const* beziers, UINT32 beziersCount)
+    {
+        if (FAILED(m_result))
+            return;
+
+        m_result = ExceptionBoundary([&]
+        {
+            for (uint32_t i = 0; i < beziersCount; i++)
+            {
+                m_geometry.AddBezier(beziers[i], m_flatteningTolerance);
+            }
+        });
+    }
+
+
+    IFACEMETHODIMP_(void) FlattenedGeometrySink::EndFigure(D2D1_FIGURE_END figureEnd)
+    {
+        if (FAILED(m_result))
+            return;
+
+        m_result = ExceptionBoundary([&]
+        {
+            m_geometry.EndFigure(figureEnd == D2D1_FIGURE_END_CLOSED);
+        });
+    }
+
+
+    IFACEMETHODIMP FlattenedGeometrySink::Close()
+    {
+        return m_result;
+    }
+
+
+    FlattenedGeometry& FlattenedGeometrySink::GetGeometry()
+    {
+        ThrowIfFailed(m_result);
+
+        m_geometry.Seal();
+
+        return m_geometry;
+    }
+}}}}}
@@ -0,0 +1,140 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
+{
+    //
+    // A geometry that has been flattened into polylines, for answering many
+    // hit-test and path queries without going back to D2D for each one.
+    //
+    // This is plain C++ that only uses the D2D value types, so it can be
+    // tested without a device.  Once built, all the queries are const and
+    // independent of each other, so they are safe to run concurrently.
+    //
+    class FlattenedGeometry
+    {
+    public:
+        struct Edge
+        {
+            D2D1_POINT_2F Start;
+            D2D1_POINT_2F End;
+        };
+
+    private:
+        struct PathSegment
+        {
+            D2D1_POINT_2F Start;
+            D2D1_POINT_2F End;
+            float StartLength;
+            float Length;
+        };
+
+        D2D1_FILL_MODE m_fillMode;
+
+        // Every edge that bounds the filled area.  Open figures are
+        // implicitly closed for filling; hollow figures aren't filled at all.
+        std::vector<Edge> m_edges;
+
+        // Index into m_edges of the first edge of each filled figure.  Each
+        // filled figure's edges form a closed loop.
+        std::vector<uint32_t> m_filledFigureStarts;
+
+        // Edges are bucketed into horizontal bands, so a point only needs to
+        // be tested against the edges that overlap its row.
+        float m_bandTop;
+        float m_bandBottom;
+        float m_bandHeight;
+        std::vector<std::vector<uint32_t>> m_bands;
+
+        // The segments that make up the path, in order, with the distance
+        // along the path at which each one starts.  Zero length segments are
+        // left out since they have no direction.
+        std::vector<PathSegment> m_pathSegments;
+        float m_totalLength;
+        D2D1_POINT_2F m_firstPoint;
+        bool m_hasFirstPoint;
+
+        // Figure currently being built.
+        std::vector<D2D1_POINT_2F> m_figure;
+        bool m_figureIsFilled;
+        bool m_isInFigure;
+        bool m_isSealed;
+
+    public:
+        FlattenedGeometry();
+
+        //
+        // Building
+        //
+
+        void SetFillMode(D2D1_FILL_MODE fillMode);
+
+        void BeginFigure(D2D1_POINT_2F const& startPoint, bool isFilled);
+        void AddLine(D2D1_POINT_2F const& point);
+        void AddBezier(D2D1_BEZIER_SEGMENT const& bezier, float flatteningTolerance);
+        void EndFigure(bool isClosed);
+
+        // Finishes building and sets up the acceleration structures.  Must
+        // be called before any queries.
+        void Seal();
+
+        //
+        // Queries
+        //
+
+        D2D1_FILL_MODE GetFillMode() const { return m_fillMode; }
+
+        // As with ID2D1Geometry::FillContainsPoint, points that miss the
+        // fill by no more than the tolerance are still considered inside.
+        bool FillContainsPoint(D2D1_POINT_2F const& point, float tolerance = 0) const;
+
+        // The edges that bound the filled area, grouped by figure.
+        std::vector<Edge> const& GetEdges() const { return m_edges; }
+        std::vector<uint32_t> const& GetFilledFigureStarts() const { return m_filledFigureStarts; }
+
+        float GetLength() const;
+
+        // Returns the point the specified distance along the path, and the
+        // unit tangent there.  Distances are clamped to the length of the
+        // path.  An empty path returns the origin (or the start point of its
+        // first figure) with a zero tangent.
+        void ComputePointAtLength(float length, D2D1_POINT_2F* point, D2D1_POINT_2F* unitTangent) const;
+
+    private:
+        uint32_t GetBandIndex(float y) const;
+        bool IsWithinToleranceOfEdge(D2D1_POINT_2F const& point, float tolerance) const;
+
+        void AddEdge(D2D1_POINT_2F const& start, D2D1_POINT_2F const& end);
+        void AddPathSegment(D2D1_POINT_2F const& start, D2D1_POINT_2F const& end);
+    };
+
+
+    //
+    // Receives the output of ID2D1Geometry::Simplify or Widen and flattens it
+    // into a FlattenedGeometry.
+    //
+    class FlattenedGeometrySink : public RuntimeClass<RuntimeClassFlags<ClassicCom>, ID2D1SimplifiedGeometrySink>,
+                                  private LifespanTracker<FlattenedGeometrySink>
+    {
+        FlattenedGeometry m_geometry;
+        float m_flatteningTolerance;
+        HRESULT m_result;
+
+    public:
+        FlattenedGeometrySink(float flatteningTolerance);
+
+        IFACEMETHODIMP_(void) SetFillMode(D2D1_FILL_MODE fillMode) override;
+        IFACEMETHODIMP_(void) SetSegmentFlags(D2D1_PATH_SEGMENT vertexFlags) override;
+        IFACEMETHODIMP_(void) BeginFigure(D2D1_POINT_2F startPoint, D2D1_FIGURE_BEGIN figureBegin) override;
+        IFACEMETHODIMP_(void) AddLines(D2D1_POINT_2F const* points, UINT32 pointsCount) override;
+        IFACEMETHODIMP_(void) AddBeziers(D2D1_BEZIER_SEGMENT const* beziers, UINT32 beziersCount) override;
+        IFACEMETHODIMP_(void) EndFigure(D2D1_FIGURE_END figureEnd) override;
+        IFACEMETHODIMP Close() override;
+
+        // Returns the sealed geometry; fails if D2D reported an error.
+        FlattenedGeometry& GetGeometry();
+    };
+}}}}}
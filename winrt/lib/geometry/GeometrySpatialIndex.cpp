@@ -0,0 +1,339 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "GeometrySpatialIndex.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
+{
+    typedef FlattenedGeometry::Edge Edge;
+
+    static const uint32_t MaxEdgesPerLeaf = 4;
+
+    // Median splits keep both levels of the tree balanced, so the traversal
+    // stack never holds more than about log2(figures) + log2(edges) + 2
+    // entries, which this comfortably covers.
+    static const uint32_t MaxTraversalDepth = 128;
+
+    static D2D1_RECT_F GetEdgeBounds(Edge const& edge)
+    {
+        return D2D1::RectF(
+            std::min(edge.Start.x, edge.End.x),
+            std::min(edge.Start.y, edge.End.y),
+            std::max(edge.Start.x, edge.End.x),
+            std::max(edge.Start.y, edge.End.y));
+    }
+
+    static void Union(D2D1_RECT_F* bounds, D2D1_RECT_F const& other)
+    {
+        bounds->left = std::min(bounds->left, other.left);
+        bounds->top = std::min(bounds->top, other.top);
+        bounds->right = std::max(bounds->right, other.right);
+        bounds->bottom = std::max(bounds->bottom, other.bottom);
+    }
+
+    static bool Overlaps(D2D1_RECT_F const& a, D2D1_RECT_F const& b)
+    {
+        return a.left <= b.right && b.left <= a.right &&
+               a.top <= b.bottom && b.top <= a.bottom;
+    }
+
+    static bool IsSplitOnX(D2D1_RECT_F const& bounds)
+    {
+        return (bounds.right - bounds.left) >= (bounds.bottom - bounds.top);
+    }
+
+    //
+    // Liang-Barsky clipping: the segment is parameterized as start + t *
+    // delta, and each side of the rectangle narrows the range of t that is
+    // inside.  The segment intersects the rectangle if any range remains.
+    //
+    static bool SegmentIntersectsRect(Edge const& edge, D2D1_RECT_F const& rect)
+    {
+        float dx = edge.End.x - edge.Start.x;
+        float dy = edge.End.y - edge.Start.y;
+
+        float p[] = { -dx, dx, -dy, dy };
+        float q[] =
+        {
+            edge.Start.x - rect.left,
+            rect.right - edge.Start.x,
+            edge.Start.y - rect.top,
+            rect.bottom - edge.Start.y
+        };
+
+        float tMin = 0;
+        float tMax = 1;
+
+        for (int i = 0; i < 4; i++)
+        {
+            if (p[i] == 0)
+            {
+                // Parallel to this side; either entirely inside it or not.
+                if (q[i] < 0)
+                    return false;
+            }
+            else
+            {
+                float t = q[i] / p[i];
+
+                if (p[i] < 0)
+                    tMin = std::max(tMin, t);
+                else
+                    tMax = std::min(tMax, t);
+
+                if (tMin > tMax)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    GeometrySpatialIndex::GeometrySpatialIndex(FlattenedGeometry const& geometry)
+        : m_fillMode(geometry.GetFillMode())
+        , m_edges(geometry.GetEdges())
+    {
+        auto& figureStarts = geometry.GetFilledFigureStarts();
+
+        std::vector<Figure> figures;
+        figures.reserve(figureStarts.size());
+
+        for (size_t i = 0; i < figureStarts.size(); i++)
+        {
+            uint32_t firstEdge = figureStarts[i];
+            uint32_t endEdge = (i + 1 < figureStarts.size()) ? figureStarts[i + 1] : static_cast<uint32_t>(m_edges.size());
+
+            if (firstEdge == endEdge)
+                continue;
+
+            auto bounds = GetEdgeBounds(m_edges[firstEdge]);
+            for (uint32_t j = firstEdge + 1; j < endEdge; j++)
+            {
+                Union(&bounds, GetEdgeBounds(m_edges[j]));
+            }
+
+            figures.push_back(Figure{ bounds, firstEdge, endEdge - firstEdge });
+        }
+
+        if (figures.empty())
+            return;
+
+        // Both levels are binary trees with non-empty leaves, so this is
+        // always enough.
+        m_nodes.reserve(2 * (m_edges.size() + figures.size()));
+
+        BuildFigureNode(figures.begin(), figures.end());
+    }
+
+
+    uint32_t GeometrySpatialIndex::BuildFigureNode(std::vector<Figure>::iterator begin, std::vector<Figure>::iterator end)
+    {
+        auto figureCount = end - begin;
+
+        if (figureCount == 1)
+            return BuildEdgeNode(begin->FirstEdge, begin->EdgeCount, true);
+
+        auto nodeIndex = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back(Node{});
+
+        auto bounds = begin->Bounds;
+        for (auto it = begin + 1; it != end; ++it)
+        {
+            Union(&bounds, it->Bounds);
+        }
+
+        m_nodes[nodeIndex].Bounds = bounds;
+
+        bool splitOnX = IsSplitOnX(bounds);
+
+        auto middle = begin + figureCount / 2;
+
+        std::nth_element(begin, middle, end,
+            [=](Figure const& a, Figure const& b)
+            {
+                if (splitOnX)
+                    return a.Bounds.left + a.Bounds.right < b.Bounds.left + b.Bounds.right;
+                else
+                    return a.Bounds.top + a.Bounds.bottom < b.Bounds.top + b.Bounds.bottom;
+            });
+
+        BuildFigureNode(begin, middle);
+        m_nodes[nodeIndex].SecondChild = BuildFigureNode(middle, end);
+
+        return nodeIndex;
+    }
+
+
+    uint32_t GeometrySpatialIndex::BuildEdgeNode(uint32_t firstEdge, uint32_t edgeCount, bool isFigureRoot)
+    {
+        auto nodeIndex = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back(Node{});
+
+        auto begin = m_edges.begin() + firstEdge;
+        auto end = begin + edgeCount;
+
+        auto bounds = GetEdgeBounds(*begin);
+        for (auto it = begin + 1; it != end; ++it)
+        {
+            Union(&bounds, GetEdgeBounds(*it));
+        }
+
+        m_nodes[nodeIndex].Bounds = bounds;
+        m_nodes[nodeIndex].IsFigureRoot = isFigureRoot;
+
+        if (edgeCount <= MaxEdgesPerLeaf)
+        {
+            m_nodes[nodeIndex].FirstEdge = firstEdge;
+            m_nodes[nodeIndex].EdgeCount = edgeCount;
+            return nodeIndex;
+        }
+
+        bool splitOnX = IsSplitOnX(bounds);
+
+        auto middle = begin + edgeCount / 2;
+
+        std::nth_element(begin, middle, end,
+            [=](Edge const& a, Edge const& b)
+            {
+                if (splitOnX)
+                    return a.Start.x + a.End.x < b.Start.x + b.End.x;
+                else
+                    return a.Start.y + a.End.y < b.Start.y + b.End.y;
+            });
+
+        BuildEdgeNode(firstEdge, edgeCount / 2, false);
+        m_nodes[nodeIndex].SecondChild = BuildEdgeNode(firstEdge + edgeCount / 2, edgeCount - edgeCount / 2, false);
+
+        return nodeIndex;
+    }
+
+
+    //
+    // Same half-open ray crossing rule as FlattenedGeometry::FillContainsPoint.
+    // Above the figure roots, only figures whose bounds contain the point are
+    // visited.  Within a figure, only the parts of its tree that the ray from
+    // the point towards +x passes through are visited.
+    //
+    bool GeometrySpatialIndex::ContainsPoint(D2D1_POINT_2F const& point) const
+    {
+        if (m_nodes.empty())
+            return false;
+
+        int windingNumber = 0;
+
+        struct StackEntry
+        {
+            uint32_t NodeIndex;
+            bool IsInFigure;
+        };
+
+        StackEntry stack[MaxTraversalDepth];
+        uint32_t stackSize = 0;
+
+        stack[stackSize++] = StackEntry{ 0, false };
+
+        while (stackSize > 0)
+        {
+            auto entry = stack[--stackSize];
+            auto& node = m_nodes[entry.NodeIndex];
+
+            bool isInFigure = entry.IsInFigure || node.IsFigureRoot;
+
+            // Written so that a NaN point doesn't visit anything.
+            bool rayHitsNode = point.y >= node.Bounds.top &&
+                               point.y < node.Bounds.bottom &&
+                               point.x <= node.Bounds.right;
+
+            if (!isInFigure || node.IsFigureRoot)
+                rayHitsNode = rayHitsNode && point.x >= node.Bounds.left;
+
+            if (!rayHitsNode)
+                continue;
+
+            if (node.EdgeCount == 0)
+            {
+                assert(stackSize + 2 <= MaxTraversalDepth);
+                stack[stackSize++] = StackEntry{ node.SecondChild, isInFigure };
+                stack[stackSize++] = StackEntry{ entry.NodeIndex + 1, isInFigure };
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.EdgeCount; i++)
+            {
+                auto& edge = m_edges[node.FirstEdge + i];
+                auto& a = edge.Start;
+                auto& b = edge.End;
+
+                float side = (b.x - a.x) * (point.y - a.y) - (point.x - a.x) * (b.y - a.y);
+
+                if (a.y <= point.y)
+                {
+                    if (b.y > point.y && side > 0)
+                        windingNumber++;
+                }
+                else
+                {
+                    if (b.y <= point.y && side < 0)
+                        windingNumber--;
+                }
+            }
+        }
+
+        if (m_fillMode == D2D1_FILL_MODE_WINDING)
+            return windingNumber != 0;
+        else
+            return (windingNumber & 1) != 0;
+    }
+
+
+    //
+    // The area intersects the rectangle if its boundary crosses the
+    // rectangle, or if the rectangle lies entirely inside the area.  (If the
+    // area lies entirely inside the rectangle then so does its boundary.)
+    //
+    bool GeometrySpatialIndex::IntersectsRect(D2D1_RECT_F const& rect) const
+    {
+        if (m_nodes.empty())
+            return false;
+
+        auto normalized = D2D1::RectF(
+            std::min(rect.left, rect.right),
+            std::min(rect.top, rect.bottom),
+            std::max(rect.left, rect.right),
+            std::max(rect.top, rect.bottom));
+
+        uint32_t stack[MaxTraversalDepth];
+        uint32_t stackSize = 0;
+
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            auto nodeIndex = stack[--stackSize];
+            auto& node = m_nodes[nodeIndex];
+
+            if (!Overlaps(node.Bounds, normalized))
+                continue;
+
+            if (node.EdgeCount == 0)
+            {
+                assert(stackSize + 2 <= MaxTraversalDepth);
+                stack[stackSize++] = node.SecondChild;
+                stack[stackSize++] = nodeIndex + 1;
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.EdgeCount; i++)
+            {
+                if (SegmentIntersectsRect(m_edges[node.FirstEdge + i], normalized))
+                    return true;
+            }
+        }
+
+        return ContainsPoint(D2D1::Point2F(normalized.left, normalized.top));
+    }
+}}}}}
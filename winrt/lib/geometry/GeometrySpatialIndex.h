@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include "FlattenedGeometry.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
+{
+    //
+    // A bounding volume hierarchy over a flattened area, for answering
+    // repeated hit tests without visiting every edge.
+    //
+    // The tree has two levels.  The upper level groups whole figures, and
+    // below each figure is a tree over that figure's edges.  Because every
+    // figure is a closed loop, a figure whose bounds don't contain a point
+    // can't change the winding number there, so point queries only descend
+    // into the figures around the point.
+    //
+    // Nodes are stored depth first, so a node's first child immediately
+    // follows it and only the index of the second child needs storing.
+    // Leaves refer to a run of edges, which are reordered during the build
+    // so that each leaf's edges are contiguous.
+    //
+    class GeometrySpatialIndex
+    {
+        struct Node
+        {
+            D2D1_RECT_F Bounds;
+            uint32_t FirstEdge;         // leaves only
+            uint32_t EdgeCount;         // zero for interior nodes
+            uint32_t SecondChild;       // interior nodes only
+            bool IsFigureRoot;
+        };
+
+        struct Figure
+        {
+            D2D1_RECT_F Bounds;
+            uint32_t FirstEdge;
+            uint32_t EdgeCount;
+        };
+
+        D2D1_FILL_MODE m_fillMode;
+        std::vector<FlattenedGeometry::Edge> m_edges;
+        std::vector<Node> m_nodes;
+
+    public:
+        explicit GeometrySpatialIndex(FlattenedGeometry const& geometry);
+
+        bool ContainsPoint(D2D1_POINT_2F const& point) const;
+
+        // Whether any part of the area lies within the rectangle, including
+        // its edges.  The rectangle does not need to be normalized.
+        bool IntersectsRect(D2D1_RECT_F const& rect) const;
+
+        uint32_t GetEdgeCount() const { return static_cast<uint32_t>(m_edges.size()); }
+        uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+    private:
+        uint32_t BuildFigureNode(std::vector<Figure>::iterator begin, std::vector<Figure>::iterator end);
+        uint32_t BuildEdgeNode(uint32_t firstEdge, uint32_t edgeCount, bool isFigureRoot);
+    };
+}}}}}
@@ -0,0 +1,131 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "Polyline.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
+{
+    std::vector<D2D1_POINT_2F> DecimatePolyline(
+        uint32_t pointCount,
+        Vector2 const* points,
+        float columnWidth,
+        float columnOrigin)
+    {
+        std::vector<D2D1_POINT_2F> result(pointCount);
+
+        result.resize(DecimatePolyline(pointCount, points, columnWidth, columnOrigin, result.data()));
+
+        return result;
+    }
+
+
+    uint32_t DecimatePolyline(
+        uint32_t pointCount,
+        Vector2 const* points,
+        float columnWidth,
+        float columnOrigin,
+        D2D1_POINT_2F* result)
+    {
+        if (columnWidth <= 0)
+        {
+            for (uint32_t i = 0; i < pointCount; i++)
+            {
+                result[i] = ToD2DPoint(points[i]);
+            }
+
+            return pointCount;
+        }
+
+        uint32_t resultCount = 0;
+
+        // Double precision keeps columns consistent for large X values (eg. timestamps).
+        auto getColumn = [&](uint32_t i)
+        {
+            return floor((static_cast<double>(points[i].X) + columnOrigin) / columnWidth);
+        };
+
+        uint32_t runStart = 0;
+
+        while (runStart < pointCount)
+        {
+            auto column = getColumn(runStart);
+
+            uint32_t lowest = runStart;
+            uint32_t highest = runStart;
+            uint32_t runEnd = runStart + 1;
+
+            // NaN never compares equal, so a NaN point always forms a run of its own.
+            while (runEnd < pointCount && getColumn(runEnd) == column)
+            {
+                if (points[runEnd].Y < points[lowest].Y)
+                    lowest = runEnd;
+
+                if (points[runEnd].Y > points[highest].Y)
+                    highest = runEnd;
+
+                runEnd++;
+            }
+
+            uint32_t kept[] = { runStart, std::min(lowest, highest), std::max(lowest, highest), runEnd - 1 };
+
+            for (size_t i = 0; i < _countof(kept); i++)
+            {
+                if (i == 0 || kept[i] != kept[i - 1])
+                    result[resultCount++] = ToD2DPoint(points[kept[i]]);
+            }
+
+            runStart = runEnd;
+        }
+
+        return resultCount;
+    }
+
+
+    void AddPolylineToSink(
+        ID2D1GeometrySink* sink,
+        uint32_t pointCount,
+        Vector2 const* points,
+        bool closed,
+        float columnWidth,
+        float columnOrigin,
+        D2D1_POINT_2F* scratch)
+    {
+        if (pointCount == 0)
+            return;
+
+        std::vector<D2D1_POINT_2F> decimatedPoints;
+
+        auto d2dPoints = ReinterpretAs<D2D1_POINT_2F const*>(points);
+
+        if (columnWidth > 0)
+        {
+            if (!scratch)
+            {
+                decimatedPoints.resize(pointCount);
+                scratch = decimatedPoints.data();
+            }
+
+            pointCount = DecimatePolyline(pointCount, points, columnWidth, columnOrigin, scratch);
+            d2dPoints = scratch;
+        }
+
+        sink->BeginFigure(d2dPoints[0], D2D1_FIGURE_BEGIN_FILLED);
+
+        if (pointCount > 1)
+        {
+            sink->AddLines(d2dPoints + 1, pointCount - 1);
+        }
+
+        sink->EndFigure(closed ? D2D1_FIGURE_END_CLOSED : D2D1_FIGURE_END_OPEN);
+    }
+
+
+    void CheckPolylineColumnWidth(float columnWidth)
+    {
+        if (!(columnWidth >= 0) || !std::isfinite(columnWidth))
+            ThrowHR(E_INVALIDARG);
+    }
+}}}}}
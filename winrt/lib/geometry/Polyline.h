@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
+{
+    using namespace Numerics;
+
+    //
+    // Builds polylines straight from arrays of points, for line charts and
+    // other large data sets where going through CanvasPathBuilder would
+    // cost an ABI call and a sink write per point.
+    //
+    // Decimation divides the X axis into columns of the given width, and
+    // replaces each run of consecutive points that fall in the same column
+    // with the first, lowest, highest and last of them (in their original
+    // order).  With columns no wider than a pixel this draws the same pixels
+    // as the full data set for time series, while keeping at most four
+    // points per column however dense the data is.  A column width of zero
+    // disables decimation.
+    //
+    // Columns start at X = -columnOrigin, so that they can be lined up with
+    // pixel columns when the points will be drawn with a translation.
+    //
+    std::vector<D2D1_POINT_2F> DecimatePolyline(
+        uint32_t pointCount,
+        Vector2 const* points,
+        float columnWidth,
+        float columnOrigin = 0);
+
+    // Decimation never adds points, so result needs room for pointCount
+    // points.  Returns how many were written.
+    uint32_t DecimatePolyline(
+        uint32_t pointCount,
+        Vector2 const* points,
+        float columnWidth,
+        float columnOrigin,
+        D2D1_POINT_2F* result);
+
+    // Writes a single figure to the sink.  Does nothing if there are no points.
+    // If scratch is not null it must have room for pointCount points, and is
+    // used for the decimated points instead of allocating a buffer.
+    void AddPolylineToSink(
+        ID2D1GeometrySink* sink,
+        uint32_t pointCount,
+        Vector2 const* points,
+        bool closed,
+        float columnWidth,
+        float columnOrigin,
+        D2D1_POINT_2F* scratch = nullptr);
+
+    void CheckPolylineColumnWidth(float columnWidth);
+}}}}}
@@ -6,15 +6,40 @@
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Geometry
 {
+    //
+    // Collects triangles from ID2D1Geometry::Tessellate.
+    //
+    // By default the triangles are written straight into a ComArray, grown
+    // geometrically, which GetTriangles then hands out without copying.
+    // Alternatively the sink can write into caller-provided memory; in that
+    // case triangles that don't fit are counted but not stored, so that
+    // GetTriangleCount reports how much space would have been needed.
+    //
     class TessellationSink : public RuntimeClass<RuntimeClassFlags<ClassicCom>, ID2D1TessellationSink>,
                              private LifespanTracker<TessellationSink>
     {
-        std::vector<CanvasTriangleVertices> m_triangles;
+        static const uint32_t MinimumCapacity = 256;
+
+        ComArray<CanvasTriangleVertices> m_triangles;
+        uint8_t* m_destination;
+        uint32_t m_destinationCapacity;
+        uint32_t m_count;
         HRESULT m_result;
 
     public:
         TessellationSink()
-            : m_result(S_OK)
+            : m_destination(nullptr)
+            , m_destinationCapacity(0)
+            , m_count(0)
+            , m_result(S_OK)
+        { }
+
+        // The destination does not need to be aligned.
+        TessellationSink(uint8_t* destination, uint32_t capacityInTriangles)
+            : m_destination(destination)
+            , m_destinationCapacity(capacityInTriangles)
+            , m_count(0)
+            , m_result(S_OK)
         { }
 
         IFACEMETHODIMP_(void) AddTriangles(D2D1_TRIANGLE const* triangles, UINT32 trianglesCount)
@@ -24,9 +49,34 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
 
             m_result = ExceptionBoundary([&]
             {
-                auto canvasTriangles = ReinterpretAs<CanvasTriangleVertices const*>(triangles);
+                static_assert(sizeof(D2D1_TRIANGLE) == sizeof(CanvasTriangleVertices), "CanvasTriangleVertices must match D2D1_TRIANGLE");
+
+                uint32_t newCount = m_count + trianglesCount;
+                if (newCount < m_count)
+                    ThrowHR(E_OUTOFMEMORY);
+
+                if (m_destination)
+                {
+                    if (newCount <= m_destinationCapacity)
+                        memcpy(m_destination + m_count * sizeof(D2D1_TRIANGLE), triangles, trianglesCount * sizeof(D2D1_TRIANGLE));
+                }
+                else
+                {
+                    if (newCount > m_triangles.GetSize())
+                    {
+                        uint64_t capacity = std::max<uint64_t>(m_triangles.GetSize() * 2ull, MinimumCapacity);
+                        capacity = std::max<uint64_t>(capacity, newCount);
+                        capacity = std::min<uint64_t>(capacity, UINT_MAX);
+
+                        m_triangles.Resize(static_cast<size_t>(capacity));
+                    }
+
+                    auto canvasTriangles = ReinterpretAs<CanvasTriangleVertices const*>(triangles);
+
+                    std::copy(canvasTriangles, canvasTriangles + trianglesCount, begin(m_triangles) + m_count);
+                }
 
-                m_triangles.insert(m_triangles.end(), canvasTriangles, canvasTriangles + trianglesCount);
+                m_count = newCount;
             });
         }
 
@@ -36,10 +86,22 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
         }
 
         ComArray<CanvasTriangleVertices> GetTriangles()
+        {
+            assert(!m_destination);
+
+            ThrowIfFailed(m_result);
+
+            // Trim off the unused capacity; this normally happens in place.
+            m_triangles.Resize(m_count);
+
+            return std::move(m_triangles);
+        }
+
+        uint32_t GetTriangleCount()
         {
             ThrowIfFailed(m_result);
 
-            return ComArray<CanvasTriangleVertices>(m_triangles.begin(), m_triangles.end());
+            return m_count;
         }
     };
 }}}}}
@@ -5,6 +5,8 @@
 #include "pch.h"
 #include <propkey.h>
 
+#include "utils/PixelConversion.h"
+
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
     using namespace ABI::Windows::Storage::Streams;
@@ -1188,6 +1190,23 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             stdext::make_checked_array_iterator(destination, capacity));
     }
 
+    static void CopyBgraToColors(
+        ScopedBitmapMappedPixelAccess& bitmapPixelAccess,
+        uint32_t width,
+        uint32_t height,
+        Color* destination)
+    {
+        auto& kernels = GetPixelConversionKernels();
+
+        uint8_t* sourceRowStart = bitmapPixelAccess.GetLockedData();
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            kernels.ReverseChannelOrder(sourceRowStart, reinterpret_cast<uint8_t*>(destination + y * width), width);
+            sourceRowStart += bitmapPixelAccess.GetStride();
+        }
+    }
+
     void GetPixelColorsImpl(
         ComPtr<ICanvasDevice> const& device,
         ComPtr<ID2D1Bitmap1> const& d2dBitmap,
@@ -1212,23 +1231,121 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         const unsigned int destSizeInPixels = subRectangleWidth * subRectangleHeight;
         ComArray<Color> array(destSizeInPixels);
 
-        byte* sourceRowStart = bitmapPixelAccess.GetLockedData();
+        CopyBgraToColors(bitmapPixelAccess, subRectangleWidth, subRectangleHeight, array.GetData());
 
-        for (unsigned int y = 0; y < subRectangleHeight; y++)
-        {
-            for (unsigned int x = 0; x < subRectangleWidth; x++)
+        array.Detach(valueCount, valueElements);
+    }
+
+    static ComPtr<IBuffer> CreateBuffer(uint32_t capacity)
+    {
+        ComPtr<IBufferFactory> bufferFactory;
+        ThrowIfFailed(GetActivationFactory(
+            HStringReference(RuntimeClass_Windows_Storage_Streams_Buffer).Get(),
+            &bufferFactory));
+
+        ComPtr<IBuffer> buffer;
+        ThrowIfFailed(bufferFactory->Create(capacity, &buffer));
+        ThrowIfFailed(buffer->put_Length(capacity));
+
+        return buffer;
+    }
+
+    void GetPixelBytesAsyncImpl(
+        ComPtr<ICanvasDevice> const& device,
+        ComPtr<ID2D1Bitmap1> const& d2dBitmap,
+        D2D1_RECT_U const& subRectangle,
+        IAsyncOperation<IBuffer*>** operation)
+    {
+        using ::Windows::Storage::Streams::IBufferByteAccess;
+
+        CheckAndClearOutPointer(operation);
+
+        BitmapSubRectangle r(d2dBitmap, subRectangle);
+
+        // The copy is issued now, on the calling thread, so the pixels
+        // returned are the ones the bitmap contains at the time of this call.
+        // Mapping the result runs on the threadpool once the GPU has finished
+        // the copy.
+        auto readback = std::make_shared<PendingBitmapReadback>(device.Get(), d2dBitmap.Get(), subRectangle);
+
+        auto asyncOperation = Make<AsyncOperation<IBuffer>>(
+            PendingBitmapReadback::WhenCompleteAsync(readback),
+            [=]
             {
-                uint32_t sourcePixel = *(reinterpret_cast<uint32_t*>(&sourceRowStart[x * 4]));
-                Color& destColor = array[y * subRectangleWidth + x];
-                destColor.B = (sourcePixel >> 0) & 0xFF;
-                destColor.G = (sourcePixel >> 8) & 0xFF;
-                destColor.R = (sourcePixel >> 16) & 0xFF;
-                destColor.A = (sourcePixel >> 24) & 0xFF;
-            }
-            sourceRowStart += bitmapPixelAccess.GetStride();
+                ScopedBitmapMappedPixelAccess bitmapPixelAccess(*readback);
+
+                auto buffer = CreateBuffer(r.GetTotalBytes());
+
+                uint8_t* destination;
+                ThrowIfFailed(As<IBufferByteAccess>(buffer)->Buffer(&destination));
+
+                CopyPixelBytes(
+                    r,
+                    bitmapPixelAccess.GetStride(),
+                    r.GetBytesPerRow(),
+                    begin(bitmapPixelAccess),
+                    stdext::make_checked_array_iterator(destination, r.GetTotalBytes()));
+
+                return buffer;
+            });
+
+        CheckMakeResult(asyncOperation);
+        ThrowIfFailed(asyncOperation.CopyTo(operation));
+    }
+
+    template<typename T>
+    struct ColorVectorTraits : public collections::DefaultVectorTraits<T>
+    {
+        static bool Equals(Color const& value1, Color const& value2)
+        {
+            return value1.A == value2.A &&
+                   value1.R == value2.R &&
+                   value1.G == value2.G &&
+                   value1.B == value2.B;
         }
+    };
 
-        array.Detach(valueCount, valueElements);
+    void GetPixelColorsAsyncImpl(
+        ComPtr<ICanvasDevice> const& device,
+        ComPtr<ID2D1Bitmap1> const& d2dBitmap,
+        D2D1_RECT_U const& subRectangle,
+        IAsyncOperation<Collections::IVectorView<Color>*>** operation)
+    {
+        CheckAndClearOutPointer(operation);
+
+        VerifyWellFormedSubrectangle(subRectangle, d2dBitmap->GetPixelSize());
+
+        if (d2dBitmap->GetPixelFormat().format != DXGI_FORMAT_B8G8R8A8_UNORM)
+        {
+            ThrowHR(E_INVALIDARG, Strings::PixelColorsFormatRestriction);
+        }
+
+        auto readback = std::make_shared<PendingBitmapReadback>(device.Get(), d2dBitmap.Get(), subRectangle);
+
+        auto asyncOperation = Make<AsyncOperation<Collections::IVectorView<Color>>>(
+            PendingBitmapReadback::WhenCompleteAsync(readback),
+            [=]
+            {
+                ScopedBitmapMappedPixelAccess bitmapPixelAccess(*readback);
+
+                const unsigned int subRectangleWidth = subRectangle.right - subRectangle.left;
+                const unsigned int subRectangleHeight = subRectangle.bottom - subRectangle.top;
+
+                auto colors = Make<collections::Vector<Color, ColorVectorTraits>>(true, subRectangleWidth * subRectangleHeight);
+                CheckMakeResult(colors);
+
+                auto& destination = colors->InternalVector();
+
+                CopyBgraToColors(bitmapPixelAccess, subRectangleWidth, subRectangleHeight, destination.data());
+
+                ComPtr<Collections::IVectorView<Color>> view;
+                ThrowIfFailed(colors->GetView(&view));
+
+                return view;
+            });
+
+        CheckMakeResult(asyncOperation);
+        ThrowIfFailed(asyncOperation.CopyTo(operation));
     }
 
     static void SaveBitmap(
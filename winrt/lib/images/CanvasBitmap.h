@@ -273,6 +273,18 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         uint32_t* valueCount,
         Color **valueElements);
 
+    void GetPixelBytesAsyncImpl(
+        ComPtr<ICanvasDevice> const& device,
+        ComPtr<ID2D1Bitmap1> const& d2dBitmap,
+        D2D1_RECT_U const& subRectangle,
+        IAsyncOperation<IBuffer*>** operation);
+
+    void GetPixelColorsAsyncImpl(
+        ComPtr<ICanvasDevice> const& device,
+        ComPtr<ID2D1Bitmap1> const& d2dBitmap,
+        D2D1_RECT_U const& subRectangle,
+        IAsyncOperation<Collections::IVectorView<Color>*>** operation);
+
     void SaveBitmapToFileImpl(
         ComPtr<ID2D1Device> const& d2dDevice,
         ComPtr<ID2D1Bitmap1> const& d2dBitmap,
@@ -732,6 +744,78 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
                 });
         }
 
+        IFACEMETHODIMP GetPixelBytesAsync(
+            IAsyncOperation<IBuffer*>** operation) override
+        {
+            return ExceptionBoundary(
+                [&]
+                {
+                    auto& d2dBitmap = GetResource();
+
+                    GetPixelBytesAsyncImpl(
+                        m_device,
+                        d2dBitmap,
+                        GetResourceBitmapExtents(d2dBitmap),
+                        operation);
+                });
+        }
+
+        IFACEMETHODIMP GetPixelBytesWithSubrectangleAsync(
+            int32_t left,
+            int32_t top,
+            int32_t width,
+            int32_t height,
+            IAsyncOperation<IBuffer*>** operation) override
+        {
+            return ExceptionBoundary(
+                [&]
+                {
+                    auto& d2dBitmap = GetResource();
+
+                    GetPixelBytesAsyncImpl(
+                        m_device,
+                        d2dBitmap,
+                        ToD2DRectU(left, top, width, height),
+                        operation);
+                });
+        }
+
+        IFACEMETHODIMP GetPixelColorsAsync(
+            IAsyncOperation<Collections::IVectorView<ABI::Windows::UI::Color>*>** operation) override
+        {
+            return ExceptionBoundary(
+                [&]
+                {
+                    auto& d2dBitmap = GetResource();
+
+                    GetPixelColorsAsyncImpl(
+                        m_device,
+                        d2dBitmap,
+                        GetResourceBitmapExtents(d2dBitmap),
+                        operation);
+                });
+        }
+
+        IFACEMETHODIMP GetPixelColorsWithSubrectangleAsync(
+            int32_t left,
+            int32_t top,
+            int32_t width,
+            int32_t height,
+            IAsyncOperation<Collections::IVectorView<ABI::Windows::UI::Color>*>** operation) override
+        {
+            return ExceptionBoundary(
+                [&]
+                {
+                    auto& d2dBitmap = GetResource();
+
+                    GetPixelColorsAsyncImpl(
+                        m_device,
+                        d2dBitmap,
+                        ToD2DRectU(left, top, width, height),
+                        operation);
+                });
+        }
+
         IFACEMETHODIMP SetPixelBytes(
             uint32_t valueCount,
             uint8_t* valueElements) override
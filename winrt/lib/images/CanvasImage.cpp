@@ -4,6 +4,8 @@
 
 #include "pch.h"
 
+#include "effects/EffectGraphPlanner.h"
+
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
     using namespace ABI::Windows::Foundation;
@@ -457,6 +459,59 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 
         return m_wicAdapter->GetFactory();
     }
-       
-        
+
+    IFACEMETHODIMP CanvasImageFactory::OptimizeEffectCaching(
+        Effects::ICanvasEffect* effect,
+        ICanvasResourceCreatorWithDpi* resourceCreator,
+        uint64_t maximumCacheSizeInBytes,
+        uint64_t* cachedBytes)
+    {
+        return OptimizeEffectCachingWithPrecisionReduction(effect, resourceCreator, maximumCacheSizeInBytes, false, cachedBytes);
+    }
+
+    IFACEMETHODIMP CanvasImageFactory::OptimizeEffectCachingWithPrecisionReduction(
+        Effects::ICanvasEffect* effect,
+        ICanvasResourceCreatorWithDpi* resourceCreator,
+        uint64_t maximumCacheSizeInBytes,
+        boolean allowPrecisionReduction,
+        uint64_t* cachedBytes)
+    {
+        return ExceptionBoundary(
+            [&]
+            {
+                CheckInPointer(effect);
+                CheckInPointer(resourceCreator);
+                CheckInPointer(cachedBytes);
+
+                Effects::EffectGraphPlanOptions options;
+
+                options.ByteBudget = maximumCacheSizeInBytes;
+                options.AllowPrecisionReduction = !!allowPrecisionReduction;
+
+                // Effects that don't specify a precision get whatever the drawing session defaults to.
+                if (auto drawingSession = MaybeAs<ICanvasDrawingSession>(resourceCreator))
+                {
+                    ComPtr<IReference<CanvasBufferPrecision>> sessionPrecision;
+                    ThrowIfFailed(drawingSession->get_EffectBufferPrecision(&sessionPrecision));
+
+                    if (sessionPrecision)
+                    {
+                        CanvasBufferPrecision precision;
+                        ThrowIfFailed(sessionPrecision->get_Value(&precision));
+
+                        options.DefaultPrecision = ToD2DBufferPrecision(precision);
+                    }
+                }
+
+                Effects::EffectGraphPlanner planner;
+
+                planner.Analyze(effect, resourceCreator);
+
+                auto plan = planner.Plan(options);
+
+                planner.Apply(plan);
+
+                *cachedBytes = plan.CachedBytes;
+            });
+    }
 }}}}
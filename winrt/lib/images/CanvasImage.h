@@ -62,6 +62,13 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             float targetDpi = 0,
             float* realizedDpi = nullptr) = 0;
 
+        // Used when realizing with WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS. Images that are a per-pixel
+        // color transform of a single source (see ColorMatrixFolding.h) report that transform, and the source.
+        virtual bool TryGetColorTransform(D2D1_MATRIX_5X4_F* /*matrix*/, bool* /*clampOutput*/, ComPtr<IGraphicsEffectSource>* /*source*/)
+        {
+            return false;
+        }
+
         // Static helper for internal callers to invoke GetD2DImage on multiple input types. That is, this method
         // handles not just ICanvasImageInternal sources, but ICanvasImageInterop source as well. This way, callers
         // don't have to worry about the second interop interface, and can just get an image from a single code path.
@@ -212,5 +219,18 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         IFACEMETHODIMP IsHistogramSupported(
             ICanvasDevice* device,
             boolean* result) override;
+
+        IFACEMETHODIMP OptimizeEffectCaching(
+            Effects::ICanvasEffect* effect,
+            ICanvasResourceCreatorWithDpi* resourceCreator,
+            uint64_t maximumCacheSizeInBytes,
+            uint64_t* cachedBytes) override;
+
+        IFACEMETHODIMP OptimizeEffectCachingWithPrecisionReduction(
+            Effects::ICanvasEffect* effect,
+            ICanvasResourceCreatorWithDpi* resourceCreator,
+            uint64_t maximumCacheSizeInBytes,
+            boolean allowPrecisionReduction,
+            uint64_t* cachedBytes) override;
     };
 }}}}
@@ -0,0 +1,272 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "CanvasTextureAtlas.h"
+#include "CanvasBitmap.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas;
+
+
+//
+// CanvasTextureAtlasRegion
+//
+
+CanvasTextureAtlasRegion::CanvasTextureAtlasRegion(ICanvasBitmap* page, int32_t pageIndex, Rect const& sourceRect)
+    : m_page(page)
+    , m_pageIndex(pageIndex)
+    , m_sourceRect(sourceRect)
+{
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlasRegion::get_Bitmap(ICanvasBitmap** value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckAndClearOutPointer(value);
+            ThrowIfFailed(m_page.CopyTo(value));
+        });
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlasRegion::get_SourceRect(Rect* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+            *value = m_sourceRect;
+        });
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlasRegion::get_PageIndex(int32_t* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+            *value = m_pageIndex;
+        });
+}
+
+
+//
+// CanvasTextureAtlasFactory
+//
+
+IFACEMETHODIMP CanvasTextureAtlasFactory::Create(
+    ICanvasResourceCreator* resourceCreator,
+    int32_t pageWidthInPixels,
+    int32_t pageHeightInPixels,
+    float dpi,
+    ICanvasTextureAtlas** textureAtlas)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(resourceCreator);
+            CheckAndClearOutPointer(textureAtlas);
+
+            if (pageWidthInPixels <= 0 || pageHeightInPixels <= 0 || !(dpi > 0))
+                ThrowHR(E_INVALIDARG, Strings::ExpectedPositiveNonzero);
+
+            ComPtr<ICanvasDevice> device;
+            ThrowIfFailed(resourceCreator->get_Device(&device));
+
+            auto newTextureAtlas = Make<CanvasTextureAtlas>(
+                device.Get(),
+                static_cast<uint32_t>(pageWidthInPixels),
+                static_cast<uint32_t>(pageHeightInPixels),
+                dpi);
+            CheckMakeResult(newTextureAtlas);
+
+            ThrowIfFailed(newTextureAtlas.CopyTo(textureAtlas));
+        });
+}
+
+
+//
+// CanvasTextureAtlas
+//
+
+CanvasTextureAtlas::CanvasTextureAtlas(ICanvasDevice* device, uint32_t pageWidth, uint32_t pageHeight, float dpi)
+    : m_device(device)
+    , m_pageWidth(pageWidth)
+    , m_pageHeight(pageHeight)
+    , m_dpi(dpi)
+{
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlas::Add(ICanvasBitmap* bitmap, ICanvasTextureAtlasRegion** region)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(bitmap);
+            CheckAndClearOutPointer(region);
+
+            auto& device = m_device.EnsureNotClosed();
+
+            auto d2dBitmap = GetWrappedResource<ID2D1Bitmap>(bitmap, device.Get());
+
+            // Pages are premultiplied BGRA, and CopyFromBitmap can't convert
+            // between formats, so that's the only thing we can accept.
+            auto pixelFormat = d2dBitmap->GetPixelFormat();
+
+            if (pixelFormat.format != DXGI_FORMAT_B8G8R8A8_UNORM || pixelFormat.alphaMode != D2D1_ALPHA_MODE_PREMULTIPLIED)
+                ThrowHR(E_INVALIDARG, Strings::TextureAtlasUnsupportedFormat);
+
+            auto size = d2dBitmap->GetPixelSize();
+            auto paddedWidth = size.width + Padding;
+            auto paddedHeight = size.height + Padding;
+
+            // Padding is only needed between regions, so a bitmap that
+            // exactly fills a page is still allowed.
+            if (size.width > m_pageWidth || size.height > m_pageHeight)
+                ThrowHR(E_INVALIDARG, Strings::TextureAtlasBitmapTooLarge);
+
+            paddedWidth = std::min(paddedWidth, m_pageWidth);
+            paddedHeight = std::min(paddedHeight, m_pageHeight);
+
+            SkylinePacker::Position position{};
+            size_t pageIndex = 0;
+
+            while (pageIndex < m_pages.size() && !m_pages[pageIndex].Packer.TryInsert(paddedWidth, paddedHeight, &position))
+            {
+                pageIndex++;
+            }
+
+            if (pageIndex == m_pages.size())
+            {
+                if (!AddPage().Packer.TryInsert(paddedWidth, paddedHeight, &position))
+                    ThrowHR(E_UNEXPECTED);
+            }
+
+            auto& page = m_pages[pageIndex];
+
+            D2D1_POINT_2U destPoint{ position.X, position.Y };
+            ThrowIfFailed(page.D2DBitmap->CopyFromBitmap(&destPoint, d2dBitmap.Get(), nullptr));
+
+            Rect sourceRect
+            {
+                PixelsToDips(static_cast<int>(position.X), m_dpi),
+                PixelsToDips(static_cast<int>(position.Y), m_dpi),
+                PixelsToDips(static_cast<int>(size.width), m_dpi),
+                PixelsToDips(static_cast<int>(size.height), m_dpi)
+            };
+
+            auto newRegion = Make<CanvasTextureAtlasRegion>(page.Bitmap.Get(), static_cast<int32_t>(pageIndex), sourceRect);
+            CheckMakeResult(newRegion);
+
+            ThrowIfFailed(newRegion.CopyTo(region));
+        });
+}
+
+
+CanvasTextureAtlas::Page& CanvasTextureAtlas::AddPage()
+{
+    auto& device = m_device.EnsureNotClosed();
+
+    // Start each page out fully transparent, so the padding between regions
+    // doesn't bleed into anything drawn from them.
+    uint32_t pitch = m_pageWidth * 4;
+    std::vector<uint8_t> zeroes(static_cast<size_t>(pitch) * m_pageHeight);
+
+    auto d2dBitmap = As<ICanvasDeviceInternal>(device)->CreateBitmapFromBytes(
+        zeroes.data(),
+        pitch,
+        static_cast<int32_t>(m_pageWidth),
+        static_cast<int32_t>(m_pageHeight),
+        m_dpi,
+        PIXEL_FORMAT(B8G8R8A8UIntNormalized),
+        CanvasAlphaMode::Premultiplied);
+
+    auto bitmap = Make<CanvasBitmap>(device.Get(), d2dBitmap.Get());
+    CheckMakeResult(bitmap);
+
+    m_pages.push_back(Page{ bitmap, d2dBitmap, SkylinePacker(m_pageWidth, m_pageHeight) });
+
+    return m_pages.back();
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlas::get_PageCount(int32_t* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+            m_device.EnsureNotClosed();
+
+            *value = static_cast<int32_t>(m_pages.size());
+        });
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlas::GetPage(int32_t index, ICanvasBitmap** page)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckAndClearOutPointer(page);
+            m_device.EnsureNotClosed();
+
+            if (index < 0 || static_cast<size_t>(index) >= m_pages.size())
+                ThrowHR(E_BOUNDS);
+
+            ThrowIfFailed(m_pages[index].Bitmap.CopyTo(page));
+        });
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlas::get_PageSize(BitmapSize* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+            
+            *value = BitmapSize{ m_pageWidth, m_pageHeight };
+        });
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlas::get_Dpi(float* value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckInPointer(value);
+
+            *value = m_dpi;
+        });
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlas::get_Device(ICanvasDevice** value)
+{
+    return ExceptionBoundary(
+        [&]
+        {
+            CheckAndClearOutPointer(value);
+
+            ThrowIfFailed(m_device.EnsureNotClosed().CopyTo(value));
+        });
+}
+
+
+IFACEMETHODIMP CanvasTextureAtlas::Close()
+{
+    m_pages.clear();
+    m_device.Close();
+    return S_OK;
+}
+
+
+ActivatableClassWithFactory(CanvasTextureAtlas, CanvasTextureAtlasFactory);
@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include "utils/SkylinePacker.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    class CanvasTextureAtlasRegion : public RuntimeClass<ICanvasTextureAtlasRegion>,
+                                     private LifespanTracker<CanvasTextureAtlasRegion>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextureAtlasRegion, BaseTrust);
+
+        ComPtr<ICanvasBitmap> m_page;
+        int32_t m_pageIndex;
+        Rect m_sourceRect;
+
+    public:
+        CanvasTextureAtlasRegion(ICanvasBitmap* page, int32_t pageIndex, Rect const& sourceRect);
+
+        IFACEMETHOD(get_Bitmap)(ICanvasBitmap** value) override;
+
+        IFACEMETHOD(get_SourceRect)(Rect* value) override;
+
+        IFACEMETHOD(get_PageIndex)(int32_t* value) override;
+    };
+
+
+    class CanvasTextureAtlasFactory
+        : public AgileActivationFactory<ICanvasTextureAtlasFactory>
+        , private LifespanTracker<CanvasTextureAtlasFactory>
+    {
+        InspectableClassStatic(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextureAtlas, BaseTrust);
+
+    public:
+        IFACEMETHOD(Create)(
+            ICanvasResourceCreator* resourceCreator,
+            int32_t pageWidthInPixels,
+            int32_t pageHeightInPixels,
+            float dpi,
+            ICanvasTextureAtlas** textureAtlas) override;
+    };
+
+
+    //
+    // Copies many small bitmaps into a few large 'page' bitmaps, so that
+    // sprites drawn from them can share a DrawSpriteBatch call.  Bitmaps are
+    // placed by a SkylinePacker as they are added; nothing is ever moved, so
+    // regions that have been handed out stay valid.
+    //
+    class CanvasTextureAtlas : public RuntimeClass<ICanvasTextureAtlas, IClosable>,
+                               private LifespanTracker<CanvasTextureAtlas>
+    {
+        InspectableClass(RuntimeClass_Microsoft_Graphics_Canvas_CanvasTextureAtlas, BaseTrust);
+
+        // Each bitmap is followed by this many transparent pixels to the right
+        // and below, so that linear filtering at the edge of a region doesn't
+        // pick up its neighbours.
+        static const uint32_t Padding = 1;
+
+        struct Page
+        {
+            ComPtr<ICanvasBitmap> Bitmap;
+            ComPtr<ID2D1Bitmap1> D2DBitmap;
+            SkylinePacker Packer;
+        };
+
+        ClosablePtr<ICanvasDevice> m_device;
+        uint32_t m_pageWidth;
+        uint32_t m_pageHeight;
+        float m_dpi;
+        std::vector<Page> m_pages;
+
+    public:
+        CanvasTextureAtlas(ICanvasDevice* device, uint32_t pageWidth, uint32_t pageHeight, float dpi);
+
+        IFACEMETHOD(Add)(ICanvasBitmap* bitmap, ICanvasTextureAtlasRegion** region) override;
+
+        IFACEMETHOD(get_PageCount)(int32_t* value) override;
+
+        IFACEMETHOD(GetPage)(int32_t index, ICanvasBitmap** page) override;
+
+        IFACEMETHOD(get_PageSize)(BitmapSize* value) override;
+
+        IFACEMETHOD(get_Dpi)(float* value) override;
+
+        IFACEMETHOD(get_Device)(ICanvasDevice** value) override;
+
+        IFACEMETHOD(Close)() override;
+
+    private:
+        Page& AddPage();
+    };
+}}}}
@@ -7,14 +7,12 @@
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
+    using namespace ABI::Windows::Foundation;
+    using namespace ::Microsoft::WRL::Wrappers;
+
     ScopedBitmapMappedPixelAccess::ScopedBitmapMappedPixelAccess(ICanvasDevice* device, ID2D1Bitmap1* d2dBitmap, D2D1_RECT_U const* optionalSubRectangle)
     {
         auto bitmapSize = d2dBitmap->GetPixelSize();
-        
-        auto bitmapOptions = D2D1_BITMAP_OPTIONS_CPU_READ | 
-                             D2D1_BITMAP_OPTIONS_CANNOT_DRAW;
-        
-        D2D1_BITMAP_PROPERTIES1 bitmapProperties = D2D1::BitmapProperties1(bitmapOptions, d2dBitmap->GetPixelFormat());
 
         if (optionalSubRectangle)
         {
@@ -25,14 +23,11 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             bitmapSize.height = optionalSubRectangle->bottom - optionalSubRectangle->top;
         }
 
-        auto deviceContext = As<ICanvasDeviceInternal>(device)->GetResourceCreationDeviceContext();
-
-        ThrowIfFailed(deviceContext->CreateBitmap(
-            bitmapSize, 
-            nullptr,
-            0,
-            &bitmapProperties,
-            &m_stagingResource));
+        //
+        // Staging bitmaps are recycled by the device, so the one we get may
+        // be larger than bitmapSize.
+        //
+        m_stagingResource = As<ICanvasDeviceInternal>(device)->LeaseStagingBitmap(bitmapSize, d2dBitmap->GetPixelFormat());
 
         // 
         // This class copies only the requested subrectangle, not the
@@ -44,11 +39,26 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
             d2dBitmap,
             optionalSubRectangle));
 
+        Map(bitmapSize.height);
+    }
+
+
+    ScopedBitmapMappedPixelAccess::ScopedBitmapMappedPixelAccess(PendingBitmapReadback& readback)
+        : m_stagingResource(std::move(readback.m_stagingResource))
+    {
+        assert(m_stagingResource.Get());
+
+        Map(readback.m_size.height);
+    }
+
+
+    void ScopedBitmapMappedPixelAccess::Map(uint32_t heightInPixels)
+    {
         ThrowIfFailed(m_stagingResource->Map(
             D2D1_MAP_OPTIONS_READ,
             &m_mappedSubresource));
 
-        m_lockedBufferSize = m_mappedSubresource.pitch * bitmapSize.height;
+        m_lockedBufferSize = m_mappedSubresource.pitch * heightInPixels;
     }
 
 
@@ -57,4 +67,221 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         ThrowIfFailed(m_stagingResource->Unmap());
     }
 
+
+    PendingBitmapReadback::PendingBitmapReadback(ICanvasDevice* device, ID2D1Bitmap1* d2dBitmap, D2D1_RECT_U const& subRectangle)
+        : m_device(device)
+        , m_size{ subRectangle.right - subRectangle.left, subRectangle.bottom - subRectangle.top }
+    {
+        m_stagingResource = As<ICanvasDeviceInternal>(device)->LeaseStagingBitmap(m_size, d2dBitmap->GetPixelFormat());
+
+        auto d3dDevice = GetDXGIInterface<ID3D11Device>(device);
+
+        d3dDevice->GetImmediateContext(&m_d3dContext);
+
+        auto d3dDevice5 = MaybeAs<ID3D11Device5>(d3dDevice);
+        auto d3dContext4 = MaybeAs<ID3D11DeviceContext4>(m_d3dContext);
+
+        if (!d3dDevice5 || !d3dContext4 ||
+            FAILED(d3dDevice5->CreateFence(0, D3D11_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_copyCompletedFence))))
+        {
+            m_copyCompletedFence.Reset();
+
+            D3D11_QUERY_DESC queryDesc{ D3D11_QUERY_EVENT, 0 };
+            ThrowIfFailed(d3dDevice->CreateQuery(&queryDesc, &m_copyCompletedQuery));
+        }
+
+        //
+        // The copy is queued on the immediate context, followed by a fence (or
+        // query) that the GPU signals once it gets that far.  Flushing makes
+        // sure the GPU actually starts on it, rather than waiting for whoever
+        // next happens to submit work.
+        //
+        D2DResourceLock lock(d2dBitmap);
+
+        ThrowIfFailed(m_stagingResource->CopyFromBitmap(
+            nullptr,
+            d2dBitmap,
+            &subRectangle));
+
+        if (m_copyCompletedFence)
+            ThrowIfFailed(d3dContext4->Signal(m_copyCompletedFence.Get(), CopyCompletedFenceValue));
+        else
+            m_d3dContext->End(m_copyCompletedQuery.Get());
+
+        m_d3dContext->Flush();
+    }
+
+
+    bool PendingBitmapReadback::IsComplete()
+    {
+        if (m_copyCompletedFence)
+            return m_copyCompletedFence->GetCompletedValue() >= CopyCompletedFenceValue;
+
+        D2DResourceLock lock(m_stagingResource.Get());
+
+        HRESULT hr = m_d3dContext->GetData(m_copyCompletedQuery.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH);
+        ThrowIfFailed(hr);
+
+        return hr == S_OK;
+    }
+
+
+    bool PendingBitmapReadback::TrySetEventOnCompletion(HANDLE event)
+    {
+        if (!m_copyCompletedFence)
+            return false;
+
+        ThrowIfFailed(m_copyCompletedFence->SetEventOnCompletion(CopyCompletedFenceValue, event));
+        return true;
+    }
+
+
+    //
+    // Completes once a PendingBitmapReadback has finished.  Where the device
+    // supports fences, a threadpool wait is registered on the fence's event.
+    // Otherwise the query is checked from a threadpool timer, which is
+    // rescheduled until the GPU has got past it.  Either way, no thread sits
+    // waiting for the GPU.
+    //
+    class PendingBitmapReadbackAction : public AsyncCommon<IAsyncAction>,
+                                        private LifespanTracker<PendingBitmapReadbackAction>
+    {
+        InspectableClass(InterfaceName_Windows_Foundation_IAsyncAction, BaseTrust);
+
+        // Relative due times are negative, in 100ns units.
+        static const int64_t PollInterval = -10 * 1000;
+
+        std::shared_ptr<PendingBitmapReadback> m_readback;
+
+        Event m_copyCompletedEvent;
+        PTP_WAIT m_wait;
+        PTP_TIMER m_timer;
+
+        // Keeps this alive while a wait or timer callback is pending.
+        ComPtr<PendingBitmapReadbackAction> m_keepAlive;
+
+    public:
+        PendingBitmapReadbackAction(std::shared_ptr<PendingBitmapReadback> const& readback)
+            : m_readback(readback)
+            , m_wait(nullptr)
+            , m_timer(nullptr)
+        {
+        }
+
+        ~PendingBitmapReadbackAction()
+        {
+            // These may be closed from within their own callback, in which
+            // case the threadpool frees them once the callback returns.
+            if (m_wait)
+                CloseThreadpoolWait(m_wait);
+
+            if (m_timer)
+                CloseThreadpoolTimer(m_timer);
+        }
+
+        void BeginWait()
+        {
+            m_keepAlive = this;
+
+            auto releaseOnFailure = MakeScopeWarden([&] { m_keepAlive.Reset(); });
+
+            m_copyCompletedEvent.Attach(CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS));
+
+            if (!m_copyCompletedEvent.IsValid())
+                ThrowHR(HRESULT_FROM_WIN32(GetLastError()));
+
+            if (m_readback->TrySetEventOnCompletion(m_copyCompletedEvent.Get()))
+            {
+                m_wait = CreateThreadpoolWait(OnCopyCompleted, this, nullptr);
+
+                if (!m_wait)
+                    ThrowHR(HRESULT_FROM_WIN32(GetLastError()));
+
+                releaseOnFailure.Dismiss();
+
+                SetThreadpoolWait(m_wait, m_copyCompletedEvent.Get(), nullptr);
+            }
+            else
+            {
+                m_timer = CreateThreadpoolTimer(OnPollTimer, this, nullptr);
+
+                if (!m_timer)
+                    ThrowHR(HRESULT_FROM_WIN32(GetLastError()));
+
+                releaseOnFailure.Dismiss();
+
+                SchedulePoll();
+            }
+        }
+
+        IFACEMETHODIMP GetResults() override
+        {
+            return CheckValidStateForResultsCall();
+        }
+
+    protected:
+        virtual void OnClose() override
+        {
+        }
+
+    private:
+        void SchedulePoll()
+        {
+            ULARGE_INTEGER dueTime;
+            dueTime.QuadPart = static_cast<ULONGLONG>(PollInterval);
+
+            FILETIME dueFileTime{ dueTime.LowPart, dueTime.HighPart };
+
+            // One-shot, so that a slow callback can't overlap the next one.
+            SetThreadpoolTimer(m_timer, &dueFileTime, 0, 0);
+        }
+
+        static void CALLBACK OnCopyCompleted(PTP_CALLBACK_INSTANCE, void* context, PTP_WAIT, TP_WAIT_RESULT)
+        {
+            static_cast<PendingBitmapReadbackAction*>(context)->Complete(S_OK);
+        }
+
+        static void CALLBACK OnPollTimer(PTP_CALLBACK_INSTANCE, void* context, PTP_TIMER)
+        {
+            auto self = static_cast<PendingBitmapReadbackAction*>(context);
+
+            bool isComplete = false;
+
+            HRESULT hr = ExceptionBoundary(
+                [&]
+                {
+                    isComplete = self->m_readback->IsComplete();
+                });
+
+            if (SUCCEEDED(hr) && !isComplete)
+                self->SchedulePoll();
+            else
+                self->Complete(hr);
+        }
+
+        void Complete(HRESULT hr)
+        {
+            if (SUCCEEDED(hr))
+                (void)TryTransitionToCompleted();
+            else
+                (void)TryTransitionToError(hr);
+
+            FireCompletion();
+
+            // This may be the last reference.
+            m_keepAlive.Reset();
+        }
+    };
+
+
+    ComPtr<IAsyncAction> PendingBitmapReadback::WhenCompleteAsync(std::shared_ptr<PendingBitmapReadback> const& readback)
+    {
+        auto action = Make<PendingBitmapReadbackAction>(readback);
+        CheckMakeResult(action);
+
+        action->BeginWait();
+
+        return action;
+    }
+
 }}}}
@@ -4,23 +4,73 @@
 
 #pragma once
 
+#include "drawing/StagingBitmapPool.h"
 #include "utils/D2DResourceLock.h"
 
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
 {
+    //
+    // Starts copying part of a bitmap into a staging bitmap, without waiting
+    // for the GPU to get around to it.  Once IsComplete returns true, the
+    // staging bitmap can be mapped (using ScopedBitmapMappedPixelAccess)
+    // without stalling.
+    //
+    class PendingBitmapReadback : LifespanTracker<PendingBitmapReadback>
+    {
+        // Keeps the device, and so the staging bitmap pool, alive.
+        ComPtr<ICanvasDevice> m_device;
+        StagingBitmapLease m_stagingResource;
+        D2D1_SIZE_U m_size;
+
+        ComPtr<ID3D11DeviceContext> m_d3dContext;
+
+        // Devices that support fences signal m_copyCompletedFence once the
+        // copy is done; others fall back to an event query.
+        ComPtr<ID3D11Fence> m_copyCompletedFence;
+        ComPtr<ID3D11Query> m_copyCompletedQuery;
+
+        static const uint64_t CopyCompletedFenceValue = 1;
+
+    public:
+        PendingBitmapReadback(ICanvasDevice* device, ID2D1Bitmap1* d2dBitmap, D2D1_RECT_U const& subRectangle);
+
+        bool IsComplete();
+
+        // Returns an action that completes once IsComplete returns true.  No
+        // thread is blocked while the GPU works through the copy.
+        static ComPtr<ABI::Windows::Foundation::IAsyncAction> WhenCompleteAsync(std::shared_ptr<PendingBitmapReadback> const& readback);
+
+    private:
+        // Returns false if the device does not support fences, in which case
+        // the caller has to check IsComplete instead.
+        bool TrySetEventOnCompletion(HANDLE event);
+
+        friend class ScopedBitmapMappedPixelAccess;
+        friend class PendingBitmapReadbackAction;
+    };
+
+
     class ScopedBitmapMappedPixelAccess : LifespanTracker<ScopedBitmapMappedPixelAccess>
     {
         D2D1_MAPPED_RECT m_mappedSubresource;
         unsigned int m_lockedBufferSize;
-        ComPtr<ID2D1Bitmap1> m_stagingResource;
+        StagingBitmapLease m_stagingResource;
 
     public:
         ScopedBitmapMappedPixelAccess(ICanvasDevice* device, ID2D1Bitmap1* d2dBitmap, D2D1_RECT_U const* optionalSubRectangle = nullptr);
+
+        // Maps the result of a completed readback.  The readback gives up its
+        // staging bitmap, so it can only be mapped once.
+        explicit ScopedBitmapMappedPixelAccess(PendingBitmapReadback& readback);
+
         ~ScopedBitmapMappedPixelAccess();
 
         uint8_t* GetLockedData()           const { return m_mappedSubresource.bits; }
         unsigned int GetLockedBufferSize() const { return m_lockedBufferSize; }
         unsigned int GetStride()           const { return m_mappedSubresource.pitch; }
+
+    private:
+        void Map(uint32_t heightInPixels);
     };
 
 
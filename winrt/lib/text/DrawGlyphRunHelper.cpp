@@ -8,6 +8,17 @@
 
 #include "DrawGlyphRunHelper.h"
 #include "CanvasFontFace.h"
+#include "drawing/FrameArena.h"
+
+template<typename T>
+static T* AllocateArray(FrameArena* frameArena, std::vector<T>& fallback, size_t count)
+{
+    if (frameArena)
+        return frameArena->Allocate<T>(count);
+
+    fallback.resize(count);
+    return fallback.data();
+}
 
 DrawGlyphRunHelper::DrawGlyphRunHelper(
     ICanvasFontFace* fontFace,
@@ -49,7 +60,8 @@ DrawGlyphRunHelper::DrawGlyphRunHelper(
     uint32_t clusterMapIndicesCount,
     int* clusterMapIndices,
     uint32_t textPosition,
-    ComPtr<ID2D1DeviceContext> const& deviceContext)
+    ComPtr<ID2D1DeviceContext> const& deviceContext,
+    FrameArena* frameArena)
     : DWriteGlyphRun{}
     , DWriteGlyphRunDescription{}
 {
@@ -57,39 +69,41 @@ DrawGlyphRunHelper::DrawGlyphRunHelper(
     DWriteGlyphRun.fontEmSize = fontSize;
     DWriteGlyphRun.fontFace = As<ICanvasFontFaceInternal>(fontFace)->GetRealizedFontFace().Get();
 
-    GlyphAdvances.reserve(glyphCount);
-    GlyphIndices.reserve(glyphCount);
-    GlyphOffsets.reserve(glyphCount);
+    auto glyphAdvances = AllocateArray(frameArena, GlyphAdvances, glyphCount);
+    auto glyphIndices = AllocateArray(frameArena, GlyphIndices, glyphCount);
+    auto glyphOffsets = AllocateArray(frameArena, GlyphOffsets, glyphCount);
     for (uint32_t i = 0; i < glyphCount; ++i)
     {
-        GlyphAdvances.push_back(glyphs[i].Advance);
+        glyphAdvances[i] = glyphs[i].Advance;
 
-        GlyphIndices.push_back(CheckCastAsUShort(glyphs[i].Index));
+        glyphIndices[i] = CheckCastAsUShort(glyphs[i].Index);
 
         DWRITE_GLYPH_OFFSET offset;
         offset.advanceOffset = glyphs[i].AdvanceOffset;
         offset.ascenderOffset = glyphs[i].AscenderOffset;
-        GlyphOffsets.push_back(offset);
+        glyphOffsets[i] = offset;
     }
     DWriteGlyphRun.glyphCount = glyphCount;
-    DWriteGlyphRun.glyphAdvances = GlyphAdvances.data();
-    DWriteGlyphRun.glyphIndices = GlyphIndices.data();
-    DWriteGlyphRun.glyphOffsets = GlyphOffsets.data();
+    DWriteGlyphRun.glyphAdvances = glyphAdvances;
+    DWriteGlyphRun.glyphIndices = glyphIndices;
+    DWriteGlyphRun.glyphOffsets = glyphOffsets;
     DWriteGlyphRun.isSideways = isSideways;
 
     uint32_t textStringLength;
     wchar_t const* textString = WindowsGetStringRawBuffer(text, &textStringLength);
 
-    ClusterMapElements.reserve(textStringLength);
+    // The cluster map has room for the whole string even when fewer indices
+    // are given, with the rest zeroed.
+    uint32_t clusterMapCount = clusterMapIndices ? clusterMapIndicesCount : 0;
+    uint32_t clusterMapSize = std::max(textStringLength, clusterMapCount);
+    auto clusterMap = AllocateArray(frameArena, ClusterMapElements, clusterMapSize);
 
-    if (clusterMapIndices)
+    for (uint32_t i = 0; i < clusterMapSize; ++i)
     {
-        for (uint32_t i = 0; i < clusterMapIndicesCount; ++i)
-        {
-            ClusterMapElements.push_back(CheckCastAsUShort(clusterMapIndices[i]));
-        }
+        clusterMap[i] = (i < clusterMapCount) ? CheckCastAsUShort(clusterMapIndices[i]) : static_cast<unsigned short>(0);
     }
-    DWriteGlyphRunDescription.clusterMap = ClusterMapElements.data();
+
+    DWriteGlyphRunDescription.clusterMap = clusterMap;
 
     // This helper structure isn't intended to outlive the arguments used to create it.
     DWriteGlyphRunDescription.localeName = WindowsGetStringRawBuffer(localeName, nullptr);
@@ -4,8 +4,16 @@
 
 #pragma once
 
+class FrameArena;
+
 namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { namespace Text
 {
+    //
+    // Converts Win2D glyph run arguments to their DWrite equivalents.  The
+    // arrays are allocated from frameArena when one is given, so the arena
+    // must not be rewound until the helper is no longer in use; otherwise
+    // they are held in the vectors below.
+    //
     struct DrawGlyphRunHelper
     {
         DWRITE_GLYPH_RUN DWriteGlyphRun;
@@ -31,7 +39,8 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas { na
             uint32_t clusterMapIndicesCount,
             int* clusterMapIndices,
             uint32_t textPosition,
-            ComPtr<ID2D1DeviceContext> const& deviceContext);
+            ComPtr<ID2D1DeviceContext> const& deviceContext,
+            FrameArena* frameArena = nullptr);
 
         DrawGlyphRunHelper(
             ICanvasFontFace* fontFace,
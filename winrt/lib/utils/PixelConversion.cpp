@@ -0,0 +1,925 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "PixelConversion.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define PIXEL_CONVERSION_SSE2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define PIXEL_CONVERSION_NEON
+#include <arm_neon.h>
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define PIXEL_CONVERSION_NEON_A64
+#endif
+#endif
+
+// MSVC lets any function use any intrinsic.  GCC and Clang only allow
+// intrinsics beyond the baseline in functions that are marked for them.
+#if defined(_MSC_VER)
+#define PIXEL_CONVERSION_TARGET_AVX2
+#else
+#define PIXEL_CONVERSION_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#endif
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    static const float UnormToFloatScale = 1.0f / 255.0f;
+
+    //
+    // Scalar reference implementation.  The vector kernels fall back to these
+    // for whatever is left over after their last full block of pixels.
+    //
+
+    static void ReverseChannelOrderScalar(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        for (uint32_t i = 0; i < pixelCount; i++)
+        {
+            uint8_t b0 = source[0];
+            uint8_t b1 = source[1];
+            uint8_t b2 = source[2];
+            uint8_t b3 = source[3];
+
+            destination[0] = b3;
+            destination[1] = b2;
+            destination[2] = b1;
+            destination[3] = b0;
+
+            source += 4;
+            destination += 4;
+        }
+    }
+
+    static uint8_t PremultiplyChannel(uint32_t value, uint32_t alpha)
+    {
+        return static_cast<uint8_t>((value * alpha + 127) / 255);
+    }
+
+    static void PremultiplyScalar(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        for (uint32_t i = 0; i < pixelCount; i++)
+        {
+            uint8_t alpha = source[3];
+
+            destination[0] = PremultiplyChannel(source[0], alpha);
+            destination[1] = PremultiplyChannel(source[1], alpha);
+            destination[2] = PremultiplyChannel(source[2], alpha);
+            destination[3] = alpha;
+
+            source += 4;
+            destination += 4;
+        }
+    }
+
+    static uint8_t UnpremultiplyChannel(uint32_t value, uint32_t alpha)
+    {
+        if (alpha == 0)
+            return 0;
+
+        return static_cast<uint8_t>(std::min(255u, (value * 255 + alpha / 2) / alpha));
+    }
+
+    static void UnpremultiplyScalar(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        for (uint32_t i = 0; i < pixelCount; i++)
+        {
+            uint8_t alpha = source[3];
+
+            destination[0] = UnpremultiplyChannel(source[0], alpha);
+            destination[1] = UnpremultiplyChannel(source[1], alpha);
+            destination[2] = UnpremultiplyChannel(source[2], alpha);
+            destination[3] = alpha;
+
+            source += 4;
+            destination += 4;
+        }
+    }
+
+    static void UnormToFloatScalar(uint8_t const* source, float* destination, uint32_t valueCount)
+    {
+        for (uint32_t i = 0; i < valueCount; i++)
+        {
+            destination[i] = source[i] * UnormToFloatScale;
+        }
+    }
+
+    static uint8_t FloatToUnormValue(float value)
+    {
+        // Written so that NaN fails both comparisons and ends up as 0.
+        value = (value > 0.0f) ? value : 0.0f;
+        value = (value < 1.0f) ? value : 1.0f;
+
+        // The multiply and add are separate statements so they can't be
+        // contracted into a fused multiply-add, which the vector kernels
+        // don't use.
+        float scaled = value * 255.0f;
+        return static_cast<uint8_t>(static_cast<int>(scaled + 0.5f));
+    }
+
+    static void FloatToUnormScalar(float const* source, uint8_t* destination, uint32_t valueCount)
+    {
+        for (uint32_t i = 0; i < valueCount; i++)
+        {
+            destination[i] = FloatToUnormValue(source[i]);
+        }
+    }
+
+    // Rounds to the nearest half, ties to even, the same as the hardware
+    // conversions do in their default rounding mode.
+    static uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        uint32_t magnitude = bits & 0x7fffffff;
+
+        // Infinity, or NaN (which stays NaN, made quiet).
+        if (magnitude >= 0x7f800000)
+            return static_cast<uint16_t>(sign | 0x7c00 | ((magnitude > 0x7f800000) ? (0x200 | ((magnitude >> 13) & 0x3ff)) : 0));
+
+        // Too large for a half, once rounded.
+        if (magnitude >= 0x477ff000)
+            return static_cast<uint16_t>(sign | 0x7c00);
+
+        uint32_t result;
+        uint32_t remainder;
+        uint32_t halfway;
+
+        if (magnitude >= 0x38800000)
+        {
+            // Normal half: rebias the exponent and drop 13 mantissa bits.
+            result = (magnitude - 0x38000000) >> 13;
+            remainder = magnitude & 0x1fff;
+            halfway = 0x1000;
+        }
+        else
+        {
+            // Subnormal half (or zero): shift the mantissa, including its
+            // implicit leading bit, down to units of 2^-24.
+            uint32_t shift = 126 - (magnitude >> 23);
+
+            if (shift > 24)
+                return sign;
+
+            uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+
+            result = mantissa >> shift;
+            remainder = mantissa & ((1u << shift) - 1);
+            halfway = 1u << (shift - 1);
+        }
+
+        if (remainder > halfway || (remainder == halfway && (result & 1)))
+            result++;
+
+        return static_cast<uint16_t>(sign | result);
+    }
+
+    static float HalfToFloat(uint16_t value)
+    {
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1f;
+        uint32_t mantissa = value & 0x3ff;
+        uint32_t bits;
+
+        if (exponent == 0x1f)
+        {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else if (exponent != 0)
+        {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        else if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Subnormal half, which is a normal float once the mantissa is
+            // shifted up to its implicit leading bit.
+            exponent = 113;
+
+            while (!(mantissa & 0x400))
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+
+            bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+        }
+
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    // There are only 256 possible inputs, so converting each one every time
+    // would be wasted work.
+    struct UnormToHalfTable
+    {
+        uint16_t Values[256];
+
+        UnormToHalfTable()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                float value = i * UnormToFloatScale;
+                Values[i] = FloatToHalf(value);
+            }
+        }
+    };
+
+    static void UnormToHalfScalar(uint8_t const* source, uint16_t* destination, uint32_t valueCount)
+    {
+        static const UnormToHalfTable table;
+
+        for (uint32_t i = 0; i < valueCount; i++)
+        {
+            destination[i] = table.Values[source[i]];
+        }
+    }
+
+    static void HalfToUnormScalar(uint16_t const* source, uint8_t* destination, uint32_t valueCount)
+    {
+        for (uint32_t i = 0; i < valueCount; i++)
+        {
+            destination[i] = FloatToUnormValue(HalfToFloat(source[i]));
+        }
+    }
+
+    static const PixelConversionKernels ScalarKernels
+    {
+        L"Scalar",
+        ReverseChannelOrderScalar,
+        PremultiplyScalar,
+        UnpremultiplyScalar,
+        UnormToFloatScalar,
+        FloatToUnormScalar,
+        UnormToHalfScalar,
+        HalfToUnormScalar,
+    };
+
+    //
+    // None of these instruction sets can divide integers, so the vector
+    // Unpremultiply kernels divide in single precision instead.  The
+    // numerator is at most 255 * 255 + 127, and both operands are exact
+    // floats.  A quotient below 255 that isn't a whole number is at least
+    // 1 / 255 away from the next one up, which is far more than float
+    // rounding can cover.  So truncating the float quotient gives exactly
+    // the scalar integer result.
+    //
+
+#if defined(PIXEL_CONVERSION_SSE2)
+
+    static void ReverseChannelOrderSse2(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        uint32_t blockCount = pixelCount / 4;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source));
+
+            // Swap the bytes in each 16 bit word, then swap the words.
+            pixels = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+            pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+            pixels = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), pixels);
+
+            source += 16;
+            destination += 16;
+        }
+
+        ReverseChannelOrderScalar(source, destination, pixelCount % 4);
+    }
+
+    // Computes round(value * multiplier / 255) for eight 16 bit lanes.
+    static __m128i MultiplyAndDivideBy255(__m128i value, __m128i multiplier)
+    {
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(value, multiplier), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    // Expands the alpha of two pixels into every channel except alpha
+    // itself, which gets 255 so that multiplying leaves it unchanged.
+    static __m128i GetPremultiplyFactors(__m128i twoPixels)
+    {
+        __m128i alpha = _mm_shufflelo_epi16(twoPixels, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+        __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+        return _mm_or_si128(
+            _mm_andnot_si128(alphaLanes, alpha),
+            _mm_and_si128(alphaLanes, _mm_set1_epi16(255)));
+    }
+
+    static void PremultiplySse2(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        uint32_t blockCount = pixelCount / 4;
+        __m128i zero = _mm_setzero_si128();
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source));
+
+            __m128i low = _mm_unpacklo_epi8(pixels, zero);
+            __m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+            low = MultiplyAndDivideBy255(low, GetPremultiplyFactors(low));
+            high = MultiplyAndDivideBy255(high, GetPremultiplyFactors(high));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(low, high));
+
+            source += 16;
+            destination += 16;
+        }
+
+        PremultiplyScalar(source, destination, pixelCount % 4);
+    }
+
+    // Unpremultiplies one pixel, held as four 32 bit lanes.
+    static __m128i UnpremultiplyPixelSse2(__m128i pixel)
+    {
+        __m128i alpha = _mm_shuffle_epi32(pixel, _MM_SHUFFLE(3, 3, 3, 3));
+
+        // value * 255 + alpha / 2
+        __m128i numerator = _mm_add_epi32(
+            _mm_sub_epi32(_mm_slli_epi32(pixel, 8), pixel),
+            _mm_srli_epi32(alpha, 1));
+
+        __m128 quotient = _mm_div_ps(_mm_cvtepi32_ps(numerator), _mm_cvtepi32_ps(alpha));
+        quotient = _mm_min_ps(quotient, _mm_set1_ps(255.0f));
+
+        __m128i result = _mm_cvttps_epi32(quotient);
+
+        // Zero alpha divides by zero, so those results are replaced with 0.
+        result = _mm_andnot_si128(_mm_cmpeq_epi32(alpha, _mm_setzero_si128()), result);
+
+        __m128i alphaLane = _mm_set_epi32(-1, 0, 0, 0);
+
+        return _mm_or_si128(
+            _mm_andnot_si128(alphaLane, result),
+            _mm_and_si128(alphaLane, pixel));
+    }
+
+    static void UnpremultiplySse2(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        uint32_t blockCount = pixelCount / 4;
+        __m128i zero = _mm_setzero_si128();
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source));
+
+            __m128i low = _mm_unpacklo_epi8(pixels, zero);
+            __m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+            __m128i p0 = UnpremultiplyPixelSse2(_mm_unpacklo_epi16(low, zero));
+            __m128i p1 = UnpremultiplyPixelSse2(_mm_unpackhi_epi16(low, zero));
+            __m128i p2 = UnpremultiplyPixelSse2(_mm_unpacklo_epi16(high, zero));
+            __m128i p3 = UnpremultiplyPixelSse2(_mm_unpackhi_epi16(high, zero));
+
+            __m128i result = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), result);
+
+            source += 16;
+            destination += 16;
+        }
+
+        UnpremultiplyScalar(source, destination, pixelCount % 4);
+    }
+
+    static void UnormToFloatSse2(uint8_t const* source, float* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 16;
+        __m128i zero = _mm_setzero_si128();
+        __m128 scale = _mm_set1_ps(UnormToFloatScale);
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source));
+
+            __m128i words[] =
+            {
+                _mm_unpacklo_epi8(bytes, zero),
+                _mm_unpackhi_epi8(bytes, zero),
+            };
+
+            for (auto& word : words)
+            {
+                __m128 low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(word, zero));
+                __m128 high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(word, zero));
+
+                _mm_storeu_ps(destination, _mm_mul_ps(low, scale));
+                _mm_storeu_ps(destination + 4, _mm_mul_ps(high, scale));
+
+                destination += 8;
+            }
+
+            source += 16;
+        }
+
+        UnormToFloatScalar(source, destination, valueCount % 16);
+    }
+
+    static __m128i FloatToInt32Sse2(float const* source)
+    {
+        __m128 value = _mm_loadu_ps(source);
+
+        // maxps returns its second operand when the first is NaN.
+        value = _mm_max_ps(value, _mm_setzero_ps());
+        value = _mm_min_ps(value, _mm_set1_ps(1.0f));
+
+        value = _mm_mul_ps(value, _mm_set1_ps(255.0f));
+        value = _mm_add_ps(value, _mm_set1_ps(0.5f));
+
+        return _mm_cvttps_epi32(value);
+    }
+
+    static void FloatToUnormSse2(float const* source, uint8_t* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 16;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m128i low = _mm_packs_epi32(FloatToInt32Sse2(source), FloatToInt32Sse2(source + 4));
+            __m128i high = _mm_packs_epi32(FloatToInt32Sse2(source + 8), FloatToInt32Sse2(source + 12));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(low, high));
+
+            source += 16;
+            destination += 16;
+        }
+
+        FloatToUnormScalar(source, destination, valueCount % 16);
+    }
+
+    // Widens four halves, held in the low 16 bits of each 32 bit lane, to
+    // floats.  Shifting the exponent and mantissa into place and multiplying
+    // by 2^112 rebiases the exponent, and also normalizes subnormal halves.
+    // NaNs become 0, which is what FloatToUnorm would turn them into anyway.
+    static __m128 HalfToFloatSse2(__m128i halves)
+    {
+        __m128i magnitude = _mm_and_si128(halves, _mm_set1_epi32(0x7fff));
+        __m128i sign = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), 16);
+
+        __m128 value = _mm_mul_ps(
+            _mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)),
+            _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+
+        __m128i isNaN = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7c00));
+        value = _mm_andnot_ps(_mm_castsi128_ps(isNaN), value);
+
+        return _mm_or_ps(value, _mm_castsi128_ps(sign));
+    }
+
+    static __m128i HalfToInt32Sse2(__m128i halves)
+    {
+        __m128 value = HalfToFloatSse2(halves);
+
+        // The same steps as FloatToInt32Sse2.
+        value = _mm_max_ps(value, _mm_setzero_ps());
+        value = _mm_min_ps(value, _mm_set1_ps(1.0f));
+
+        value = _mm_mul_ps(value, _mm_set1_ps(255.0f));
+        value = _mm_add_ps(value, _mm_set1_ps(0.5f));
+
+        return _mm_cvttps_epi32(value);
+    }
+
+    static void HalfToUnormSse2(uint16_t const* source, uint8_t* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 16;
+        __m128i zero = _mm_setzero_si128();
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m128i first = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source));
+            __m128i second = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + 8));
+
+            __m128i low = _mm_packs_epi32(
+                HalfToInt32Sse2(_mm_unpacklo_epi16(first, zero)),
+                HalfToInt32Sse2(_mm_unpackhi_epi16(first, zero)));
+
+            __m128i high = _mm_packs_epi32(
+                HalfToInt32Sse2(_mm_unpacklo_epi16(second, zero)),
+                HalfToInt32Sse2(_mm_unpackhi_epi16(second, zero)));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(low, high));
+
+            source += 16;
+            destination += 16;
+        }
+
+        HalfToUnormScalar(source, destination, valueCount % 16);
+    }
+
+    // Narrowing to halves needs F16C, so this table uses the scalar lookup.
+    static const PixelConversionKernels Sse2Kernels
+    {
+        L"SSE2",
+        ReverseChannelOrderSse2,
+        PremultiplySse2,
+        UnpremultiplySse2,
+        UnormToFloatSse2,
+        FloatToUnormSse2,
+        UnormToHalfScalar,
+        HalfToUnormSse2,
+    };
+
+    PIXEL_CONVERSION_TARGET_AVX2
+    static void ReverseChannelOrderAvx2(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        uint32_t blockCount = pixelCount / 8;
+
+        __m256i shuffle = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m256i pixels = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(source));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), _mm256_shuffle_epi8(pixels, shuffle));
+
+            source += 32;
+            destination += 32;
+        }
+
+        // Avoid the penalty for mixing AVX and legacy SSE code.
+        _mm256_zeroupper();
+
+        ReverseChannelOrderSse2(source, destination, pixelCount % 8);
+    }
+
+    PIXEL_CONVERSION_TARGET_AVX2
+    static void UnormToHalfAvx2(uint8_t const* source, uint16_t* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 8;
+        __m256 scale = _mm256_set1_ps(UnormToFloatScale);
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(source)));
+            __m256 floats = _mm256_mul_ps(_mm256_cvtepi32_ps(values), scale);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm256_cvtps_ph(floats, _MM_FROUND_TO_NEAREST_INT));
+
+            source += 8;
+            destination += 8;
+        }
+
+        _mm256_zeroupper();
+
+        UnormToHalfScalar(source, destination, valueCount % 8);
+    }
+
+    PIXEL_CONVERSION_TARGET_AVX2
+    static void HalfToUnormAvx2(uint16_t const* source, uint8_t* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 8;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            __m256 value = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(source)));
+
+            // Same steps as FloatToInt32Sse2, eight lanes at a time.
+            value = _mm256_max_ps(value, _mm256_setzero_ps());
+            value = _mm256_min_ps(value, _mm256_set1_ps(1.0f));
+
+            value = _mm256_mul_ps(value, _mm256_set1_ps(255.0f));
+            value = _mm256_add_ps(value, _mm256_set1_ps(0.5f));
+
+            __m256i ints = _mm256_cvttps_epi32(value);
+            __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(ints), _mm256_extracti128_si256(ints, 1));
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(words, words));
+
+            source += 8;
+            destination += 8;
+        }
+
+        _mm256_zeroupper();
+
+        HalfToUnormScalar(source, destination, valueCount % 8);
+    }
+
+    // AVX2 pays off for the swizzle, which is memory bound and benefits from
+    // the wider loads, and brings the F16C half conversions.  The rest reuse
+    // the SSE2 kernels.
+    static const PixelConversionKernels Avx2Kernels
+    {
+        L"AVX2",
+        ReverseChannelOrderAvx2,
+        PremultiplySse2,
+        UnpremultiplySse2,
+        UnormToFloatSse2,
+        FloatToUnormSse2,
+        UnormToHalfAvx2,
+        HalfToUnormAvx2,
+    };
+
+    static void GetCpuId(int leaf, int info[4])
+    {
+#if defined(_MSC_VER)
+        __cpuidex(info, leaf, 0);
+#else
+        unsigned int registers[4];
+        __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+
+        for (int i = 0; i < 4; i++)
+            info[i] = static_cast<int>(registers[i]);
+#endif
+    }
+
+    static uint64_t GetEnabledXStateFeatures()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t low, high;
+        __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return (static_cast<uint64_t>(high) << 32) | low;
+#endif
+    }
+
+    // Also checks for F16C, which every AVX2 CPU has in practice.
+    static bool IsAvx2Supported()
+    {
+        int info[4];
+
+        GetCpuId(0, info);
+        if (info[0] < 7)
+            return false;
+
+        // AVX2 also needs the OS to save the YMM registers on context switch.
+        GetCpuId(1, info);
+        bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+        bool hasAvx = (info[2] & (1 << 28)) != 0;
+        bool hasF16c = (info[2] & (1 << 29)) != 0;
+
+        if (!hasOsxsave || !hasAvx || !hasF16c || (GetEnabledXStateFeatures() & 6) != 6)
+            return false;
+
+        GetCpuId(7, info);
+        return (info[1] & (1 << 5)) != 0;
+    }
+
+#elif defined(PIXEL_CONVERSION_NEON)
+
+    static void ReverseChannelOrderNeon(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        uint32_t blockCount = pixelCount / 4;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            vst1q_u8(destination, vrev32q_u8(vld1q_u8(source)));
+
+            source += 16;
+            destination += 16;
+        }
+
+        ReverseChannelOrderScalar(source, destination, pixelCount % 4);
+    }
+
+    // Computes round(value * alpha / 255) for eight channels.
+    static uint8x8_t PremultiplyChannelsNeon(uint8x8_t value, uint8x8_t alpha)
+    {
+        uint16x8_t t = vaddq_u16(vmull_u8(value, alpha), vdupq_n_u16(128));
+        return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+    }
+
+    static void PremultiplyNeon(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        uint32_t blockCount = pixelCount / 8;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            uint8x8x4_t pixels = vld4_u8(source);
+
+            pixels.val[0] = PremultiplyChannelsNeon(pixels.val[0], pixels.val[3]);
+            pixels.val[1] = PremultiplyChannelsNeon(pixels.val[1], pixels.val[3]);
+            pixels.val[2] = PremultiplyChannelsNeon(pixels.val[2], pixels.val[3]);
+
+            vst4_u8(destination, pixels);
+
+            source += 32;
+            destination += 32;
+        }
+
+        PremultiplyScalar(source, destination, pixelCount % 8);
+    }
+
+    static void UnormToFloatNeon(uint8_t const* source, float* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 8;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            uint16x8_t words = vmovl_u8(vld1_u8(source));
+
+            float32x4_t low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+            float32x4_t high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(words)));
+
+            vst1q_f32(destination, vmulq_n_f32(low, UnormToFloatScale));
+            vst1q_f32(destination + 4, vmulq_n_f32(high, UnormToFloatScale));
+
+            source += 8;
+            destination += 8;
+        }
+
+        UnormToFloatScalar(source, destination, valueCount % 8);
+    }
+
+    static uint32x4_t FloatToUint32Neon(float32x4_t value)
+    {
+        float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t one = vdupq_n_f32(1.0f);
+
+        // Compare and select rather than vmaxq/vminq, which propagate NaN.
+        value = vbslq_f32(vcgtq_f32(value, zero), value, zero);
+        value = vbslq_f32(vcltq_f32(value, one), value, one);
+
+        value = vmulq_n_f32(value, 255.0f);
+        value = vaddq_f32(value, vdupq_n_f32(0.5f));
+
+        return vcvtq_u32_f32(value);
+    }
+
+    static void FloatToUnormNeon(float const* source, uint8_t* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 8;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            uint16x8_t words = vcombine_u16(
+                vmovn_u32(FloatToUint32Neon(vld1q_f32(source))),
+                vmovn_u32(FloatToUint32Neon(vld1q_f32(source + 4))));
+
+            vst1_u8(destination, vmovn_u16(words));
+
+            source += 8;
+            destination += 8;
+        }
+
+        FloatToUnormScalar(source, destination, valueCount % 8);
+    }
+
+#if defined(PIXEL_CONVERSION_NEON_A64)
+
+    //
+    // Vector divide and half conversions are only in the 64 bit instruction
+    // set, so 32 bit ARM uses the scalar versions of these.
+    //
+
+    static uint32x4_t DivideAndClampNeon(uint16x4_t numerator, uint16x4_t alpha)
+    {
+        float32x4_t quotient = vdivq_f32(vcvtq_f32_u32(vmovl_u16(numerator)), vcvtq_f32_u32(vmovl_u16(alpha)));
+        return vcvtq_u32_f32(vminq_f32(quotient, vdupq_n_f32(255.0f)));
+    }
+
+    // Computes min(255, round(value * 255 / alpha)) for eight channels, or 0
+    // where alpha is 0.
+    static uint8x8_t UnpremultiplyChannelsNeon(uint8x8_t value, uint8x8_t alpha)
+    {
+        uint16x8_t alphaWords = vmovl_u8(alpha);
+        uint16x8_t numerator = vaddq_u16(vmull_u8(value, vdup_n_u8(255)), vshrq_n_u16(alphaWords, 1));
+
+        uint16x8_t result = vcombine_u16(
+            vmovn_u32(DivideAndClampNeon(vget_low_u16(numerator), vget_low_u16(alphaWords))),
+            vmovn_u32(DivideAndClampNeon(vget_high_u16(numerator), vget_high_u16(alphaWords))));
+
+        return vbic_u8(vmovn_u16(result), vceq_u8(alpha, vdup_n_u8(0)));
+    }
+
+    static void UnpremultiplyNeon(uint8_t const* source, uint8_t* destination, uint32_t pixelCount)
+    {
+        uint32_t blockCount = pixelCount / 8;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            uint8x8x4_t pixels = vld4_u8(source);
+
+            pixels.val[0] = UnpremultiplyChannelsNeon(pixels.val[0], pixels.val[3]);
+            pixels.val[1] = UnpremultiplyChannelsNeon(pixels.val[1], pixels.val[3]);
+            pixels.val[2] = UnpremultiplyChannelsNeon(pixels.val[2], pixels.val[3]);
+
+            vst4_u8(destination, pixels);
+
+            source += 32;
+            destination += 32;
+        }
+
+        UnpremultiplyScalar(source, destination, pixelCount % 8);
+    }
+
+    static void UnormToHalfNeon(uint8_t const* source, uint16_t* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 8;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            uint16x8_t words = vmovl_u8(vld1_u8(source));
+
+            float32x4_t low = vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(words))), UnormToFloatScale);
+            float32x4_t high = vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(words))), UnormToFloatScale);
+
+            vst1_u16(destination, vreinterpret_u16_f16(vcvt_f16_f32(low)));
+            vst1_u16(destination + 4, vreinterpret_u16_f16(vcvt_f16_f32(high)));
+
+            source += 8;
+            destination += 8;
+        }
+
+        UnormToHalfScalar(source, destination, valueCount % 8);
+    }
+
+    static void HalfToUnormNeon(uint16_t const* source, uint8_t* destination, uint32_t valueCount)
+    {
+        uint32_t blockCount = valueCount / 8;
+
+        for (uint32_t i = 0; i < blockCount; i++)
+        {
+            float32x4_t low = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source)));
+            float32x4_t high = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source + 4)));
+
+            uint16x8_t words = vcombine_u16(
+                vmovn_u32(FloatToUint32Neon(low)),
+                vmovn_u32(FloatToUint32Neon(high)));
+
+            vst1_u8(destination, vmovn_u16(words));
+
+            source += 8;
+            destination += 8;
+        }
+
+        HalfToUnormScalar(source, destination, valueCount % 8);
+    }
+
+#endif
+
+    static const PixelConversionKernels NeonKernels
+    {
+        L"NEON",
+        ReverseChannelOrderNeon,
+        PremultiplyNeon,
+#if defined(PIXEL_CONVERSION_NEON_A64)
+        UnpremultiplyNeon,
+#else
+        UnpremultiplyScalar,
+#endif
+        UnormToFloatNeon,
+        FloatToUnormNeon,
+#if defined(PIXEL_CONVERSION_NEON_A64)
+        UnormToHalfNeon,
+        HalfToUnormNeon,
+#else
+        UnormToHalfScalar,
+        HalfToUnormScalar,
+#endif
+    };
+
+#endif
+
+
+    PixelConversionKernels const& GetScalarPixelConversionKernels()
+    {
+        return ScalarKernels;
+    }
+
+
+    std::vector<PixelConversionKernels const*> GetSupportedPixelConversionKernels()
+    {
+        std::vector<PixelConversionKernels const*> kernels{ &ScalarKernels };
+
+#if defined(PIXEL_CONVERSION_SSE2)
+        kernels.push_back(&Sse2Kernels);
+
+        if (IsAvx2Supported())
+            kernels.push_back(&Avx2Kernels);
+#elif defined(PIXEL_CONVERSION_NEON)
+        kernels.push_back(&NeonKernels);
+#endif
+
+        return kernels;
+    }
+
+
+    PixelConversionKernels const& GetPixelConversionKernels()
+    {
+        static PixelConversionKernels const& best = *GetSupportedPixelConversionKernels().back();
+        return best;
+    }
+
+}}}}
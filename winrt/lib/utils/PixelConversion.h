@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // Conversion kernels for 8-bit-per-channel pixel data.
+    //
+    // Each instruction set gets its own table of kernels.  Every kernel
+    // produces exactly the same output as the scalar version, so callers can
+    // use whichever table GetPixelConversionKernels picks for this CPU
+    // without caring which one it was.
+    //
+    // This and PixelConversion.cpp use only the standard library and
+    // compiler intrinsics, so test.portable can build them without WRL.
+    //
+    struct PixelConversionKernels
+    {
+        wchar_t const* Name;
+
+        // Reverses the order of the bytes in each 4-byte pixel.  Windows.UI.Color
+        // is laid out as A,R,G,B and DXGI_FORMAT_B8G8R8A8_UNORM as B,G,R,A, so
+        // this converts in either direction.  source and destination may be
+        // the same, but must not otherwise overlap.
+        void (*ReverseChannelOrder)(uint8_t const* source, uint8_t* destination, uint32_t pixelCount);
+
+        // Converts straight alpha to premultiplied alpha, for pixels with
+        // alpha in the fourth byte (B8G8R8A8 or R8G8B8A8).  Each color channel
+        // becomes round(channel * alpha / 255).
+        void (*Premultiply)(uint8_t const* source, uint8_t* destination, uint32_t pixelCount);
+
+        // The inverse of Premultiply: each color channel becomes
+        // min(255, round(channel * 255 / alpha)), or 0 when alpha is 0.
+        void (*Unpremultiply)(uint8_t const* source, uint8_t* destination, uint32_t pixelCount);
+
+        // Converts UNORM bytes to floats in the range 0 to 1 (value * (1 / 255)).
+        void (*UnormToFloat)(uint8_t const* source, float* destination, uint32_t valueCount);
+
+        // Converts floats to UNORM bytes, clamping to the range 0 to 1 and
+        // rounding to nearest.  NaN converts to 0.
+        void (*FloatToUnorm)(float const* source, uint8_t* destination, uint32_t valueCount);
+
+        // Converts UNORM bytes to IEEE half precision floats.  The result is
+        // the float that UnormToFloat produces, rounded to the nearest half
+        // (ties to even), as DXGI_FORMAT_R16G16B16A16_FLOAT stores it.
+        void (*UnormToHalf)(uint8_t const* source, uint16_t* destination, uint32_t valueCount);
+
+        // Converts half precision floats to UNORM bytes.  Each half is widened
+        // to a float exactly, then converted as by FloatToUnorm.
+        void (*HalfToUnorm)(uint16_t const* source, uint8_t* destination, uint32_t valueCount);
+    };
+
+    // The fastest kernels supported by the current CPU.  This is decided once
+    // per process.
+    PixelConversionKernels const& GetPixelConversionKernels();
+
+    // The portable reference implementation.
+    PixelConversionKernels const& GetScalarPixelConversionKernels();
+
+    // Every set of kernels the current CPU can run, scalar first.  Used by
+    // the tests to check each implementation against the scalar one.
+    std::vector<PixelConversionKernels const*> GetSupportedPixelConversionKernels();
+
+}}}}
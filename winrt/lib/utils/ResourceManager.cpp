@@ -138,6 +138,16 @@ bool ResourceManager::TryUnregisterWrapper(IUnknown* resource)
     return result == 1;
 }
 
+// Used by CanvasEffect, to check that nobody else has wrapped a D2D effect it kept for reuse.
+bool ResourceManager::IsWrapperRegistered(IUnknown* resource)
+{
+    ComPtr<IUnknown> resourceIdentity = AsUnknown(resource);
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    return m_resources.find(resourceIdentity.Get()) != m_resources.end();
+}
+
 // Checks whether a given effect id is a valid effect id for an external factory
 inline static void ValidateEffectIdForExternalEffectFactory(REFIID effectId)
 {
@@ -30,6 +30,7 @@ namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
         static bool TryRegisterWrapper(IUnknown* resource, IInspectable* wrapper);
         static void UnregisterWrapper(IUnknown* resource);
         static bool TryUnregisterWrapper(IUnknown* resource);
+        static bool IsWrapperRegistered(IUnknown* resource);
         static bool RegisterEffectFactory(REFIID effectId, ICanvasEffectFactoryNative* factory);
         static bool UnregisterEffectFactory(REFIID effectId);
 
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "SkylinePacker.h"
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    SkylinePacker::SkylinePacker(uint32_t width, uint32_t height)
+        : m_width(width)
+        , m_height(height)
+        , m_usedArea(0)
+    {
+        m_skyline.push_back(Segment{ 0, 0, width });
+    }
+
+
+    bool SkylinePacker::TryInsert(uint32_t width, uint32_t height, Position* position)
+    {
+        assert(position);
+
+        if (width == 0 || height == 0 || width > m_width || height > m_height)
+            return false;
+
+        size_t bestIndex = 0;
+        uint32_t bestTop = std::numeric_limits<uint32_t>::max();
+        uint32_t bestSegmentWidth = std::numeric_limits<uint32_t>::max();
+        uint32_t bestY = 0;
+
+        for (size_t i = 0; i < m_skyline.size(); ++i)
+        {
+            uint32_t y;
+            if (!TryFit(i, width, height, &y))
+                continue;
+
+            // Prefer the position where the top of the rectangle is lowest,
+            // breaking ties with the narrowest segment so that wide segments
+            // are kept for wide rectangles.
+            uint32_t top = y + height;
+            uint32_t segmentWidth = m_skyline[i].Width;
+
+            if (top < bestTop || (top == bestTop && segmentWidth < bestSegmentWidth))
+            {
+                bestIndex = i;
+                bestTop = top;
+                bestSegmentWidth = segmentWidth;
+                bestY = y;
+            }
+        }
+
+        if (bestTop == std::numeric_limits<uint32_t>::max())
+            return false;
+
+        position->X = m_skyline[bestIndex].X;
+        position->Y = bestY;
+
+        AddLevel(bestIndex, position->X, bestY, width, height);
+
+        m_usedArea += static_cast<uint64_t>(width) * height;
+
+        return true;
+    }
+
+
+    // Works out where a rectangle starting at the given segment would rest:
+    // on top of the highest segment that it spans.
+    bool SkylinePacker::TryFit(size_t segmentIndex, uint32_t width, uint32_t height, uint32_t* y) const
+    {
+        uint32_t x = m_skyline[segmentIndex].X;
+
+        if (x + width > m_width)
+            return false;
+
+        uint32_t widthLeft = width;
+        uint32_t top = 0;
+
+        for (size_t i = segmentIndex; widthLeft > 0; ++i)
+        {
+            assert(i < m_skyline.size());
+
+            auto const& segment = m_skyline[i];
+
+            top = std::max(top, segment.Y);
+
+            if (top + height > m_height)
+                return false;
+
+            widthLeft -= std::min(widthLeft, segment.Width);
+        }
+
+        *y = top;
+        return true;
+    }
+
+
+    void SkylinePacker::AddLevel(size_t segmentIndex, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        m_skyline.insert(m_skyline.begin() + segmentIndex, Segment{ x, y + height, width });
+
+        // Trim or remove the segments that are now underneath the new one.
+        uint32_t right = x + width;
+
+        for (size_t i = segmentIndex + 1; i < m_skyline.size(); )
+        {
+            auto& segment = m_skyline[i];
+
+            if (segment.X >= right)
+                break;
+
+            uint32_t segmentRight = segment.X + segment.Width;
+
+            if (segmentRight <= right)
+            {
+                m_skyline.erase(m_skyline.begin() + i);
+                continue;
+            }
+
+            segment.Width = segmentRight - right;
+            segment.X = right;
+            break;
+        }
+
+        // Merge neighbouring segments at the same height.
+        for (size_t i = 0; i + 1 < m_skyline.size(); )
+        {
+            if (m_skyline[i].Y == m_skyline[i + 1].Y)
+            {
+                m_skyline[i].Width += m_skyline[i + 1].Width;
+                m_skyline.erase(m_skyline.begin() + i + 1);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+}}}}
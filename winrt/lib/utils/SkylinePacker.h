@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace ABI { namespace Microsoft { namespace Graphics { namespace Canvas
+{
+    //
+    // Packs rectangles into a fixed size bin using the skyline bottom-left
+    // heuristic.  The top edge of everything packed so far is tracked as a
+    // list of horizontal segments (the "skyline"), and each new rectangle is
+    // placed on the segment where its top edge ends up lowest.
+    //
+    // Packing is incremental: rectangles are placed as they are inserted and
+    // never moved, so callers can keep adding to a bin that's in use.
+    //
+    class SkylinePacker
+    {
+        struct Segment
+        {
+            uint32_t X;
+            uint32_t Y;
+            uint32_t Width;
+        };
+
+        uint32_t m_width;
+        uint32_t m_height;
+        uint64_t m_usedArea;
+        std::vector<Segment> m_skyline;
+
+    public:
+        struct Position
+        {
+            uint32_t X;
+            uint32_t Y;
+        };
+
+        SkylinePacker(uint32_t width, uint32_t height);
+
+        // Returns false, leaving the packer unchanged, if there's no room.
+        bool TryInsert(uint32_t width, uint32_t height, Position* position);
+
+        uint32_t Width() const { return m_width; }
+        uint32_t Height() const { return m_height; }
+
+        // The total area of the rectangles inserted so far.
+        uint64_t UsedArea() const { return m_usedArea; }
+
+    private:
+        bool TryFit(size_t segmentIndex, uint32_t width, uint32_t height, uint32_t* y) const;
+        void AddLevel(size_t segmentIndex, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+    };
+}}}}
@@ -14,6 +14,7 @@ STRING(AutoFileFormatNotAllowed, L"The option CanvasFileFormat.Auto is not allow
 STRING(BitmapFormatsDiffer, L"Bitmaps are not the same pixel format.")
 STRING(BlockCompressedDimensionsMustBeMultipleOf4, L"Block compressed image width & height must be a multiple of 4 pixels.")
 STRING(BlockCompressedSubRectangleMustBeAligned, L"Subrectangles from block compressed images must be aligned to a multiple of 4 pixels.")
+STRING(CachedGeometryHasNoSourceGeometry, L"This CanvasCachedGeometry was not created from a CanvasGeometry, so it cannot be hit tested.")
 STRING(CacheOnDemandNotSet, L"This method may only be called if the CanvasVirtualBitmap was created with CanvasVirtualBitmapOptions.CacheOnDemand.")
 STRING(CannotCreateDrawingSessionUntilPreviousOneClosed, L"The last drawing session returned by CreateDrawingSession must be disposed before a new one can be created.")
 STRING(CanOnlyAddPathDataWhileInFigure, L"This operation is only allowed after a successful call to CanvasPathBuilder.BeginFigure.")
@@ -28,18 +29,23 @@ STRING(CreateDrawingSessionCalledBeforeRegionsInvalidated, L"CreateDrawingSessio
 STRING(CustomEffectBadFeatureLevel, L"This shader requires a higher Direct3D feature level than is supported by the device. Check PixelShaderEffect.IsSupported before using it.")
 STRING(CustomEffectBadShader, L"Unable to load the specified shader. This should be a Direct3D pixel shader compiled for shader model 4.")
 STRING(CustomEffectBadPropertyType, L"Shader property '%S' is an unsupported type.")
+STRING(CustomEffectInvalidPropertyHandle, L"Invalid shader property handle. Use PixelShaderEffect.GetPropertyHandle to look one up.")
 STRING(CustomEffectMaxOffsetWithoutOffsetMapping, L"When PixelShaderEffect.MaxSamplerOffset is set, at least one source should be using SamplerCoordinateMapping.Offset.")
 STRING(CustomEffectOffsetMappingWithoutMaxOffset, L"When PixelShaderEffect.Source%dMapping is set to Offset, MaxSamplerOffset should also be set.")
 STRING(CustomEffectSourceOutOfRange, L"Source%d must be null when using this pixel shader (shader inputs: %d).")
 STRING(CustomEffectTooManyConstantBuffers, L"Unsupported constant buffer layout. There should be a single constant buffer bound to b0.")
 STRING(CustomEffectTooManyTextures, L"Shader has too many input textures.")
 STRING(CustomEffectUnknownProperty, L"Shader does not have a property named '%s'.")
+STRING(CustomEffectWrongConstantBufferSize, L"Wrong size. The shader constant buffer is %d bytes.")
 STRING(CustomEffectWrongPropertyArraySize, L"Wrong array size. Shader property '%s' is an array of %d elements.")
+STRING(CustomEffectWrongPropertyComponentCount, L"Wrong number of values. Shader property '%s' has %d components.")
 STRING(CustomEffectWrongPropertyType, L"Wrong type. Shader property '%s' is of type %s.")
 STRING(CustomEffectWrongPropertyTypeArray, L"Wrong type. Shader property '%s' is an array of %s.")
 STRING(DeviceExpectedToBeLost, L"This API was unexpectedly called when the Direct3D device is not lost.")
 STRING(DidNotPopLayer, L"After calling CanvasDrawingSession.CreateLayer, you must close the resulting CanvasActiveLayer before ending the CanvasDrawingSession.")
 STRING(DrawImageMinBlendNotSupported, L"This DrawImage overload is not valid when CanvasDrawingSession.Blend is set to CanvasBlend.Min.")
+STRING(DrawingRecordingInvalidData, L"The data passed to CanvasDrawingRecording.CreateFromBytes is not a valid saved recording.")
+STRING(DrawLinesOddPointCount, L"The points array passed to CanvasDrawingSession.DrawLines must contain a start and end point for each line; actual array was of size %d.")
 STRING(EffectNoSources, L"Effect Sources collection is empty.")
 STRING(EffectNullSource, L"Effect source #%d is null.")
 STRING(EffectWrongDevice, L"Effect source #%d is associated with a different device.")
@@ -47,6 +53,7 @@ STRING(EffectWrongSourceType, L"Effect source #%d is an unsupported type. To dra
 STRING(EndFigureWithoutBeginFigure, L"A call to CanvasPathBuilder.EndFigure occurred without a previous call to CanvasPathBuilder.BeginFigure.")
 STRING(ExpectedPositiveNonzero, L"A positive, non-zero number was expected for this method.")
 STRING(ExternalInlineObject, L"Attempted to retrieve an inline object which was not implemented as an ICanvasTextInlineObject.")
+STRING(FillCirclesWrongRadiusCount, L"The radii array passed to CanvasDrawingSession.FillCircles must contain either a single element or one element per circle (%d); actual array was of size %d.")
 STRING_A(GameLoopThreadName, "Win2D game loop thread")
 STRING(GetResourceNoDevice, L"To unwrap this resource type, a device parameter must be passed to GetWrappedResource.")
 STRING(ImageBrushRequiresSourceRectangle, L"When using image types other than CanvasBitmap, CanvasImageBrush.SourceRectangle must not be null.")
@@ -55,6 +62,8 @@ STRING(InvalidFontFamilyFileUri, L"The font URI specified is not a valid file UR
 STRING(InvalidFontFamilyUri, L"The font URI specified is not a valid application URI that can be opened by StorageFile.GetFileFromApplicationUriAsync.")
 STRING(InvalidFontFamilyUriScheme, L"The URI specified in the CanvasTextFormat's FontFamily has an invalid scheme; the scheme may be omitted, or must be one of ms-appx:// or ms-appdata://.")
 STRING(InvalidTypographyFeatureName, L"Attempted to add a typography feature without setting a valid feature name.")
+STRING(LookupTableFileInvalid, L"Invalid lookup table file (line %u).")
+STRING(LookupTableFileUnsupported, L"Unsupported lookup table file (line %u). Only 3D tables with an input range of 0 to 1 can be loaded.")
 STRING(MultipleAsyncCreateResourcesNotSupported, L"Only one asynchronous CreateResources action can be tracked at a time.")
 STRING(NotSupportedOnThisVersionOfWindows, L"This API is not supported on this version of Windows.")
 STRING(PathBuilderAddGeometryMidFigure, L"CanvasPathBuilder.AddGeometry may not be called in the middle of a figure.")
@@ -82,6 +91,8 @@ STRING(SvgStrokeDashArrayMismatchingArraySizes, L"The two arrays used for settin
 STRING(SvgTextShouldHaveNonZeroLength, L"The specified SVG string has length zero; a valid SVG string was expected.")
 STRING(SvgViewportSizeNotValid, L"The width and height of an SVG viewport must be positive, and nonzero.")
 STRING(TextRendererNotValid, L"The application called a method on a text renderer, but this text renderer is no longer valid.")
+STRING(TextureAtlasBitmapTooLarge, L"The bitmap is larger than the pages of this CanvasTextureAtlas.")
+STRING(TextureAtlasUnsupportedFormat, L"CanvasTextureAtlas only supports bitmaps with pixel format DirectXPixelFormat.B8G8R8A8UIntNormalized and CanvasAlphaMode.Premultiplied.")
 STRING(TwoBeginFigures, L"A call to CanvasPathBuilder.BeginFigure occurred, when the figure was already begun.")
 STRING(UnrecognizedImageFileExtension, L"When saving a CanvasBitmap without specifying a CanvasBitmapFileFormat, the file name must include a recognized file extension such as '.jpeg' or '.png'.")
 STRING(WrongArrayLength, L"The array was expected to be of size %d; actual array was of size %d.")
@@ -1236,6 +1236,142 @@ public:
             });    
     }
 
+    static Platform::Array<byte>^ BufferToArray(IBuffer^ buffer)
+    {
+        auto bytes = ref new Platform::Array<byte>(buffer->Length);
+        DataReader::FromBuffer(buffer)->ReadBytes(bytes);
+        return bytes;
+    }
+
+    static Platform::Array<Windows::UI::Color>^ VectorToArray(Windows::Foundation::Collections::IVectorView<Windows::UI::Color>^ colors)
+    {
+        auto array = ref new Platform::Array<Windows::UI::Color>(colors->Size);
+        colors->GetMany(0, array);
+        return array;
+    }
+
+    TEST_METHOD(CanvasBitmap_GetPixelBytesAsync_ReturnsSameDataAsGetPixelBytes)
+    {
+        const int width = 8;
+        const int height = 9;
+        Platform::Array<byte>^ imageData = ref new Platform::Array<byte>(width * height * 4);
+        WriteReferenceDataToArray(imageData);
+
+        auto canvasBitmap = CanvasBitmap::CreateFromBytes(
+            m_sharedDevice,
+            imageData,
+            width,
+            height,
+            DirectXPixelFormat::B8G8R8A8UIntNormalized,
+            DEFAULT_DPI,
+            CanvasAlphaMode::Premultiplied);
+
+        VerifyArraysEqual(imageData, BufferToArray(WaitExecution(canvasBitmap->GetPixelBytesAsync())));
+
+        SignedRect subrectangles[] = { SignedRect(1, 0, 1, 1), SignedRect(2, 2, 3, 4), SignedRect(0, 0, width, height) };
+
+        for (auto r : subrectangles)
+        {
+            VerifyArraysEqual(
+                canvasBitmap->GetPixelBytes(r.Left, r.Top, r.Width, r.Height),
+                BufferToArray(WaitExecution(canvasBitmap->GetPixelBytesAsync(r.Left, r.Top, r.Width, r.Height))));
+        }
+    }
+
+    TEST_METHOD(CanvasBitmap_GetPixelColorsAsync_ReturnsSameDataAsGetPixelColors)
+    {
+        const int width = 8;
+        const int height = 9;
+        Platform::Array<Windows::UI::Color>^ imageData = ref new Platform::Array<Windows::UI::Color>(width * height);
+        WriteReferenceDataToArray(imageData);
+
+        auto canvasBitmap = CanvasBitmap::CreateFromColors(
+            m_sharedDevice,
+            imageData,
+            width,
+            height,
+            DEFAULT_DPI,
+            CanvasAlphaMode::Premultiplied);
+
+        VerifyArraysEqual(imageData, VectorToArray(WaitExecution(canvasBitmap->GetPixelColorsAsync())));
+
+        SignedRect subrectangles[] = { SignedRect(1, 0, 1, 1), SignedRect(2, 2, 3, 4), SignedRect(0, 0, width, height) };
+
+        for (auto r : subrectangles)
+        {
+            VerifyArraysEqual(
+                canvasBitmap->GetPixelColors(r.Left, r.Top, r.Width, r.Height),
+                VectorToArray(WaitExecution(canvasBitmap->GetPixelColorsAsync(r.Left, r.Top, r.Width, r.Height))));
+        }
+    }
+
+    TEST_METHOD(CanvasBitmap_GetPixelBytesAsync_ReturnsPixelsAsOfTheCall)
+    {
+        auto rt = ref new CanvasRenderTarget(m_sharedDevice, 4, 4, DEFAULT_DPI);
+
+        Platform::Array<byte>^ before = ref new Platform::Array<byte>(4 * 4 * 4);
+        WriteReferenceDataToArray(before);
+        rt->SetPixelBytes(before);
+
+        auto operation = rt->GetPixelBytesAsync();
+
+        Platform::Array<byte>^ after = ref new Platform::Array<byte>(4 * 4 * 4);
+        rt->SetPixelBytes(after);
+
+        VerifyArraysEqual(before, BufferToArray(WaitExecution(operation)));
+    }
+
+    TEST_METHOD(CanvasBitmap_GetPixelBytesAndColorsAsync_InvalidArguments)
+    {
+        auto canvasBitmap = ref new CanvasRenderTarget(m_sharedDevice, 1, 1, DEFAULT_DPI);
+
+        SignedRect testCases[] = {
+            SignedRect(0, 0, 0, 0),
+            SignedRect(0, 0, 2, 2),
+            SignedRect(-2, 3, 5, 4),
+            SignedRect(2, -3, 5, 4),
+            SignedRect(0, 0, -1, 3),
+            SignedRect(0, 0, 1, -3),
+        };
+
+        for (SignedRect testCase : testCases)
+        {
+            Assert::ExpectException<Platform::InvalidArgumentException^>(
+                [&]
+                {
+                    canvasBitmap->GetPixelBytesAsync(testCase.Left, testCase.Top, testCase.Width, testCase.Height);
+                });
+
+            Assert::ExpectException<Platform::InvalidArgumentException^>(
+                [&]
+                {
+                    canvasBitmap->GetPixelColorsAsync(testCase.Left, testCase.Top, testCase.Width, testCase.Height);
+                });
+        }
+    }
+
+    TEST_METHOD(CanvasRenderTarget_GetPixelColorsAsync_InvalidPixelFormat_ThrowsDescriptiveException)
+    {
+        auto rt = ref new CanvasRenderTarget(m_sharedDevice, 1, 1, DEFAULT_DPI, DirectXPixelFormat::R8G8B8A8UIntNormalized, CanvasAlphaMode::Premultiplied);
+
+        const wchar_t* expectedMessage = L"This method only supports resources with pixel format DirectXPixelFormat.B8G8R8A8UIntNormalized.";
+
+        ExpectCOMException(E_INVALIDARG, expectedMessage,
+            [&]
+            {
+                rt->GetPixelColorsAsync();
+            });
+
+        ExpectCOMException(E_INVALIDARG, expectedMessage,
+            [&]
+            {
+                rt->GetPixelColorsAsync(0, 0, 1, 1);
+            });
+
+        // GetPixelBytesAsync works with any format.
+        Assert::AreEqual(4u, WaitExecution(rt->GetPixelBytesAsync())->Length);
+    }
+
     TEST_METHOD(CanvasBitmap_SetPixelBytesAndSetPixelColors_ZeroArrayOnZeroSizedBitmap)
     {
         //
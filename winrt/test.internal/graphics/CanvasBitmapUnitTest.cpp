@@ -99,6 +99,13 @@ TEST_CLASS(CanvasBitmapUnitTest)
         Assert::AreEqual(RO_E_CLOSED, canvasBitmap->CopyPixelsFromBitmap(otherBitmap.Get()));
         Assert::AreEqual(RO_E_CLOSED, canvasBitmap->CopyPixelsFromBitmapWithDestPoint(otherBitmap.Get(), 0, 0));
         Assert::AreEqual(RO_E_CLOSED, canvasBitmap->CopyPixelsFromBitmapWithDestPointAndSourceRect(otherBitmap.Get(), 0, 0, 0, 0, 0, 0));
+
+        ComPtr<IAsyncOperation<IBuffer*>> bytesOperation;
+        ComPtr<IAsyncOperation<ABI::Windows::Foundation::Collections::IVectorView<ABI::Windows::UI::Color>*>> colorsOperation;
+        Assert::AreEqual(RO_E_CLOSED, canvasBitmap->GetPixelBytesAsync(&bytesOperation));
+        Assert::AreEqual(RO_E_CLOSED, canvasBitmap->GetPixelBytesWithSubrectangleAsync(0, 0, 1, 1, &bytesOperation));
+        Assert::AreEqual(RO_E_CLOSED, canvasBitmap->GetPixelColorsAsync(&colorsOperation));
+        Assert::AreEqual(RO_E_CLOSED, canvasBitmap->GetPixelColorsWithSubrectangleAsync(0, 0, 1, 1, &colorsOperation));
     }
 
     TEST_METHOD_EX(CanvasBitmap_GetDevice)
@@ -142,4 +142,149 @@ TEST_CLASS(CanvasCachedGeometryTests)
         ExpectHResultException(E_INVALIDARG, [&]{ CanvasCachedGeometry::CreateNew(nullptr, f.CanvasRectangleGeometry.Get(), 0.0f, f.StrokeStyle.Get(), 0.0f); });
         ExpectHResultException(E_INVALIDARG, [&]{ CanvasCachedGeometry::CreateNew(f.Device.Get(), nullptr, 0.0f, f.StrokeStyle.Get(), 0.0f); });
     }
+
+    static void AddSquareToSink(ID2D1SimplifiedGeometrySink* sink, float left, float top, float size)
+    {
+        D2D1_POINT_2F points[] =
+        {
+            { left + size, top },
+            { left + size, top + size },
+            { left, top + size },
+        };
+
+        sink->BeginFigure(D2D1_POINT_2F{ left, top }, D2D1_FIGURE_BEGIN_FILLED);
+        sink->AddLines(points, _countof(points));
+        sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+    }
+
+    struct HitTestFixture : public GeometryObjectAccess_Fixture
+    {
+        HitTestFixture()
+        {
+            Device->CreateFilledGeometryRealizationMethod.AllowAnyCall(
+                [](ID2D1Geometry*, FLOAT)
+                {
+                    return Make<MockD2DGeometryRealization>();
+                });
+
+            Device->CreateStrokedGeometryRealizationMethod.AllowAnyCall(
+                [](ID2D1Geometry*, FLOAT, ID2D1StrokeStyle*, FLOAT)
+                {
+                    return Make<MockD2DGeometryRealization>();
+                });
+        }
+
+        void ExpectOneSimplifyCall()
+        {
+            D2DRectangleGeometry->SimplifyMethod.SetExpectedCalls(1,
+                [](D2D1_GEOMETRY_SIMPLIFICATION_OPTION simplification, CONST D2D1_MATRIX_3X2_F* transform, FLOAT tol, ID2D1SimplifiedGeometrySink* sink)
+                {
+                    Assert::AreEqual(D2D1_GEOMETRY_SIMPLIFICATION_OPTION_LINES, simplification);
+                    Assert::IsNull(transform);
+                    Assert::AreEqual(5.0f, tol);
+
+                    AddSquareToSink(sink, 0, 0, 10);
+                    return S_OK;
+                });
+        }
+    };
+
+    TEST_METHOD_EX(CanvasCachedGeometry_ContainsPoint_Fill)
+    {
+        HitTestFixture f;
+
+        auto cachedGeometry = CanvasCachedGeometry::CreateNew(f.Device.Get(), f.CanvasRectangleGeometry.Get(), 5.0f);
+
+        // The index is built on the first query, and then reused.
+        f.ExpectOneSimplifyCall();
+
+        boolean result;
+        Assert::AreEqual(S_OK, cachedGeometry->ContainsPoint(Vector2{ 5, 5 }, &result));
+        Assert::IsTrue(!!result);
+
+        Assert::AreEqual(S_OK, cachedGeometry->ContainsPoint(Vector2{ 15, 5 }, &result));
+        Assert::IsFalse(!!result);
+    }
+
+    TEST_METHOD_EX(CanvasCachedGeometry_IntersectsRectangle_Fill)
+    {
+        HitTestFixture f;
+
+        auto cachedGeometry = CanvasCachedGeometry::CreateNew(f.Device.Get(), f.CanvasRectangleGeometry.Get(), 5.0f);
+
+        f.ExpectOneSimplifyCall();
+
+        boolean result;
+        Assert::AreEqual(S_OK, cachedGeometry->IntersectsRectangle(Rect{ 8, 8, 10, 10 }, &result));
+        Assert::IsTrue(!!result);
+
+        Assert::AreEqual(S_OK, cachedGeometry->IntersectsRectangle(Rect{ 2, 2, 1, 1 }, &result));
+        Assert::IsTrue(!!result);
+
+        Assert::AreEqual(S_OK, cachedGeometry->IntersectsRectangle(Rect{ 20, 0, 10, 10 }, &result));
+        Assert::IsFalse(!!result);
+    }
+
+    TEST_METHOD_EX(CanvasCachedGeometry_ContainsPoint_Stroke)
+    {
+        HitTestFixture f;
+
+        auto cachedGeometry = CanvasCachedGeometry::CreateNew(f.Device.Get(), f.CanvasRectangleGeometry.Get(), 99.0f, f.StrokeStyle.Get(), 5.0f);
+
+        f.D2DRectangleGeometry->WidenMethod.SetExpectedCalls(1,
+            [](FLOAT strokeWidth, ID2D1StrokeStyle* strokeStyle, CONST D2D1_MATRIX_3X2_F* transform, FLOAT tol, ID2D1SimplifiedGeometrySink* sink)
+            {
+                Assert::AreEqual(99.0f, strokeWidth);
+                Assert::IsNotNull(strokeStyle);
+                Assert::IsNull(transform);
+                Assert::AreEqual(5.0f, tol);
+
+                // Stroke outlines overlap themselves, so the overlap must
+                // still count as inside.
+                sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
+                AddSquareToSink(sink, 0, 0, 10);
+                AddSquareToSink(sink, 5, 0, 10);
+                return S_OK;
+            });
+
+        boolean result;
+        Assert::AreEqual(S_OK, cachedGeometry->ContainsPoint(Vector2{ 7, 5 }, &result));
+        Assert::IsTrue(!!result);
+
+        Assert::AreEqual(S_OK, cachedGeometry->ContainsPoint(Vector2{ 20, 5 }, &result));
+        Assert::IsFalse(!!result);
+    }
+
+    TEST_METHOD_EX(CanvasCachedGeometry_HitTest_WhenNotCreatedFromCanvasGeometry_Fails)
+    {
+        SetupFixture f;
+        auto cachedGeometry = f.CreateCachedGeometry();
+
+        boolean result;
+        Assert::AreEqual(E_NOTIMPL, cachedGeometry->ContainsPoint(Vector2{}, &result));
+        ValidateStoredErrorState(E_NOTIMPL, Strings::CachedGeometryHasNoSourceGeometry);
+
+        Assert::AreEqual(E_NOTIMPL, cachedGeometry->IntersectsRectangle(Rect{}, &result));
+    }
+
+    TEST_METHOD_EX(CanvasCachedGeometry_HitTest_NullArgs)
+    {
+        SetupFixture f;
+        auto cachedGeometry = f.CreateCachedGeometry();
+
+        Assert::AreEqual(E_INVALIDARG, cachedGeometry->ContainsPoint(Vector2{}, nullptr));
+        Assert::AreEqual(E_INVALIDARG, cachedGeometry->IntersectsRectangle(Rect{}, nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasCachedGeometry_HitTest_Closed)
+    {
+        SetupFixture f;
+        auto cachedGeometry = f.CreateCachedGeometry();
+
+        Assert::AreEqual(S_OK, cachedGeometry->Close());
+
+        boolean result;
+        Assert::AreEqual(RO_E_CLOSED, cachedGeometry->ContainsPoint(Vector2{}, &result));
+        Assert::AreEqual(RO_E_CLOSED, cachedGeometry->IntersectsRectangle(Rect{}, &result));
+    }
 };
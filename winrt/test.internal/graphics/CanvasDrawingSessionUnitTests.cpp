@@ -4,15 +4,20 @@
 
 #include "pch.h"
 
+#include "utils/BenchmarkTimer.h"
+
 #include <lib/effects/generated/GaussianBlurEffect.h>
 #include <lib/geometry/CanvasCachedGeometry.h>
 #include <lib/images/CanvasCommandList.h>
 #include <lib/svg/CanvasSvgDocument.h>
+#include <lib/drawing/CanvasDrawingRecording.h>
 #include <lib/drawing/CanvasGradientMesh.h>
 
 #include "stubs/StubInkAdapter.h"
 
 #include "mocks/MockD2DGeometryRealization.h"
+#include "mocks/MockD2DGeometrySink.h"
+#include "mocks/MockD2DPathGeometry.h"
 #include "mocks/MockD2DRectangleGeometry.h"
 #include "mocks/MockDWriteRenderingParams.h"
 #include "mocks/MockGeometryAdapter.h"
@@ -170,43 +175,36 @@ class BrushValidator
 {
     bool m_isColorOverload;
     ID2D1Brush* m_expectedBrush;
-    bool m_gotColor2;
+    int m_createCount;
     int m_checkCount;
 
 public:
     BrushValidator(CanvasDrawingSessionFixture const& f, bool isColorOverload)
         : m_isColorOverload(isColorOverload),
           m_expectedBrush(nullptr),
-          m_gotColor2(false),
+          m_createCount(0),
           m_checkCount(0)
     {
         if (isColorOverload)
         {
             // When testing a WithColor overload, we expect to get two draw calls.
-            // The first draw uses ArbitraryMarkerColor1 and should trigger a call to CreateSolidColorBrush.
-            // The second uses ArbitraryMarkerColor2 and should call SetColor on the previously created brush.
+            // The first draw uses ArbitraryMarkerColor1 and the second uses ArbitraryMarkerColor2.
+            // Each color should get its own brush from CreateSolidColorBrush, rather than
+            // recoloring a shared brush, so SetColor is never expected.
 
             f.DeviceContext->CreateSolidColorBrushMethod.AllowAnyCall(
                 [&](const D2D1_COLOR_F* color, const D2D1_BRUSH_PROPERTIES* brushProperties, ID2D1SolidColorBrush** solidColorBrush)
                 {
-                    // First we should see a brush created using ArbitraryMarkerColor1.
-                    Assert::IsNull(m_expectedBrush);
-                    Assert::AreEqual(ToD2DColor(ArbitraryMarkerColor1), *color);
+                    Assert::IsTrue(m_createCount < 2);
+
+                    auto expectedColor = (m_createCount == 0) ? ArbitraryMarkerColor1 : ArbitraryMarkerColor2;
+                    Assert::AreEqual(ToD2DColor(expectedColor), *color);
 
                     auto brush = Make<MockD2DSolidColorBrush>();
                     m_expectedBrush = brush.Get();
-                    brush.CopyTo(solidColorBrush);
-
-                    // Then we should see SetColor called with ArbitraryMarkerColor2.
-                    brush->SetColorMethod.AllowAnyCall(
-                        [&](const D2D1_COLOR_F* color)
-                        {
-                            Assert::IsFalse(m_gotColor2);
-                            Assert::AreEqual(ToD2DColor(ArbitraryMarkerColor2), *color);
-                            m_gotColor2 = true;
-                        });
+                    m_createCount++;
 
-                    return S_OK;
+                    return brush.CopyTo(solidColorBrush);
                 });
         }
         else
@@ -223,14 +221,13 @@ public:
             switch (m_checkCount)
             {
             case 0:
-                // During the first draw call, our brush should have been created but its color not changed yet.
-                Assert::IsNotNull(m_expectedBrush);
-                Assert::IsFalse(m_gotColor2);
+                // During the first draw call, the brush for the first color should have been created.
+                Assert::AreEqual(1, m_createCount);
                 break;
 
             case 1:
-                // During the second draw call, the brush color should have been changed.
-                Assert::IsTrue(m_gotColor2);
+                // During the second draw call, a second brush should have been created for the new color.
+                Assert::AreEqual(2, m_createCount);
                 break;
 
             default:
@@ -1884,6 +1881,618 @@ public:
             });
     }
 
+    //
+    // Interleaves 100k FillRectangle and DrawLine calls in a handful of
+    // colors, checking that each color keeps its own brush (so D2D sees the
+    // same brush for every primitive of that color) rather than one brush
+    // being recolored per call.  Timings are reported to the test log.
+    //
+
+    TEST_METHOD_EX(CanvasDrawingSession_MixedColorPrimitives_Benchmark)
+    {
+        int const primitiveCount = 100000;
+        int const colorCount = 8;
+
+        CanvasDrawingSessionFixture f;
+
+        std::map<ID2D1Brush*, D2D1_COLOR_F> brushColors;
+
+        f.DeviceContext->CreateSolidColorBrushMethod.AllowAnyCall(
+            [&](D2D1_COLOR_F const* color, D2D1_BRUSH_PROPERTIES const*, ID2D1SolidColorBrush** result)
+            {
+                auto brush = Make<MockD2DSolidColorBrush>();
+                brushColors[brush.Get()] = *color;
+                return brush.CopyTo(result);
+            });
+
+        std::vector<Color> colors;
+
+        for (int i = 0; i < colorCount; i++)
+        {
+            colors.push_back(Color{ 255, static_cast<BYTE>(i * 32), 0, static_cast<BYTE>(255 - i * 32) });
+        }
+
+        auto checkBrush = [&](ID2D1Brush* brush, int i)
+        {
+            auto it = brushColors.find(brush);
+            Assert::IsTrue(it != brushColors.end());
+            Assert::AreEqual(ToD2DColor(colors[i % colorCount]), it->second);
+        };
+
+        int drawIndex = 0;
+
+        f.DeviceContext->FillRectangleMethod.AllowAnyCall(
+            [&](D2D1_RECT_F const*, ID2D1Brush* brush)
+            {
+                checkBrush(brush, drawIndex);
+            });
+
+        f.DeviceContext->DrawLineMethod.AllowAnyCall(
+            [&](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush* brush, float, ID2D1StrokeStyle*)
+            {
+                checkBrush(brush, drawIndex);
+            });
+
+        BenchmarkTimer timer;
+
+        for (drawIndex = 0; drawIndex < primitiveCount; drawIndex++)
+        {
+            auto& color = colors[drawIndex % colorCount];
+            auto x = static_cast<float>(drawIndex % 1000);
+
+            if (drawIndex & 1)
+                ThrowIfFailed(f.DS->FillRectangleAtCoordsWithColor(x, 0, 1, 1, color));
+            else
+                ThrowIfFailed(f.DS->DrawLineAtCoordsWithColor(x, 0, x, 1, color));
+        }
+
+        auto elapsed = timer.ElapsedMicroseconds();
+
+        Assert::AreEqual<size_t>(colorCount, brushColors.size());
+
+        wchar_t message[256];
+        swprintf_s(message, L"%d mixed color primitives: %lld us, %d brushes created\n", primitiveCount, elapsed, static_cast<int>(brushColors.size()));
+        Logger::WriteMessage(message);
+    }
+
+
+    //
+    // Batched primitives
+    //
+
+    TEST_METHOD_EX(CanvasDrawingSession_FillRectanglesWithBrush)
+    {
+        CanvasDrawingSessionFixture f;
+
+        Rect rects[] = { Rect{ 1, 2, 3, 4 }, Rect{ 5, 6, 7, 8 }, Rect{ 9, 10, 11, 12 } };
+
+        auto expectedBrush = f.Brush->GetD2DBrush(nullptr, GetBrushFlags::None);
+
+        int drawCount = 0;
+
+        f.DeviceContext->FillRectangleMethod.SetExpectedCalls(_countof(rects),
+            [&](D2D1_RECT_F const* rect, ID2D1Brush* brush)
+            {
+                Assert::AreEqual(ToD2DRect(rects[drawCount]), *rect);
+                Assert::AreEqual(expectedBrush.Get(), brush);
+                drawCount++;
+            });
+
+        ThrowIfFailed(f.DS->FillRectanglesWithBrush(_countof(rects), rects, f.Brush.Get()));
+
+        // Empty arrays can be null, but the brush cannot.
+        ThrowIfFailed(f.DS->FillRectanglesWithBrush(0, nullptr, f.Brush.Get()));
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillRectanglesWithBrush(1, nullptr, f.Brush.Get()));
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillRectanglesWithBrush(_countof(rects), rects, nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_FillRectanglesWithColors_SwitchesBrushOnlyWhenColorChanges)
+    {
+        CanvasDrawingSessionFixture f;
+
+        Rect rects[4] = {};
+        Color colors[] = { ArbitraryMarkerColor1, ArbitraryMarkerColor1, ArbitraryMarkerColor2, ArbitraryMarkerColor1 };
+
+        std::map<ID2D1Brush*, D2D1_COLOR_F> brushColors;
+
+        f.DeviceContext->CreateSolidColorBrushMethod.SetExpectedCalls(2,
+            [&](D2D1_COLOR_F const* color, D2D1_BRUSH_PROPERTIES const*, ID2D1SolidColorBrush** result)
+            {
+                auto brush = Make<MockD2DSolidColorBrush>();
+                brushColors[brush.Get()] = *color;
+                return brush.CopyTo(result);
+            });
+
+        int drawCount = 0;
+
+        f.DeviceContext->FillRectangleMethod.SetExpectedCalls(_countof(rects),
+            [&](D2D1_RECT_F const*, ID2D1Brush* brush)
+            {
+                Assert::AreEqual(ToD2DColor(colors[drawCount]), brushColors[brush]);
+                drawCount++;
+            });
+
+        ThrowIfFailed(f.DS->FillRectanglesWithColors(_countof(rects), rects, _countof(colors), colors));
+
+        // There must be exactly one color per rectangle.
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillRectanglesWithColors(_countof(rects), rects, 1, colors));
+        ValidateStoredErrorState(E_INVALIDARG, L"The array colors was expected to be of size 4; actual array was of size 1.");
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillRectanglesWithColors(_countof(rects), rects, _countof(colors), nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawLines)
+    {
+        CanvasDrawingSessionFixture f;
+
+        Vector2 points[] = { Vector2{ 1, 2 }, Vector2{ 3, 4 }, Vector2{ 5, 6 }, Vector2{ 7, 8 } };
+
+        int drawCount = 0;
+
+        f.DeviceContext->DrawLineMethod.SetExpectedCalls(2,
+            [&](D2D1_POINT_2F p0, D2D1_POINT_2F p1, ID2D1Brush* brush, float strokeWidth, ID2D1StrokeStyle* strokeStyle)
+            {
+                Assert::AreEqual(ToD2DPoint(points[drawCount * 2]), p0);
+                Assert::AreEqual(ToD2DPoint(points[drawCount * 2 + 1]), p1);
+                Assert::IsNotNull(brush);
+                Assert::AreEqual(1.0f, strokeWidth);
+                Assert::IsNull(strokeStyle);
+                drawCount++;
+            });
+
+        ThrowIfFailed(f.DS->DrawLinesWithColor(_countof(points), points, ArbitraryMarkerColor1));
+
+        // Each line needs a start and an end point.
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawLinesWithColor(3, points, ArbitraryMarkerColor1));
+        ValidateStoredErrorState(E_INVALIDARG, L"The points array passed to CanvasDrawingSession.DrawLines must contain a start and end point for each line; actual array was of size 3.");
+
+        // Per-line colors.
+        Color colors[] = { ArbitraryMarkerColor1, ArbitraryMarkerColor2 };
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawLinesWithColors(_countof(points), points, _countof(points), colors));
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawLinesWithStrokeWidthAndStrokeStyle)
+    {
+        CanvasDrawingSessionFixture f;
+
+        Vector2 points[] = { Vector2{ 1, 2 }, Vector2{ 3, 4 }, Vector2{ 5, 6 }, Vector2{ 7, 8 } };
+
+        auto strokeStyle = Make<CanvasStrokeStyle>();
+
+        ID2D1StrokeStyle* firstStrokeStyle = nullptr;
+
+        f.DeviceContext->DrawLineMethod.SetExpectedCalls(2,
+            [&](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle* d2dStrokeStyle)
+            {
+                Assert::AreEqual(5.0f, strokeWidth);
+                Assert::IsNotNull(d2dStrokeStyle);
+
+                // The stroke style is realized once for the whole batch.
+                if (firstStrokeStyle)
+                    Assert::AreEqual(firstStrokeStyle, d2dStrokeStyle);
+                else
+                    firstStrokeStyle = d2dStrokeStyle;
+            });
+
+        ThrowIfFailed(f.DS->DrawLinesWithBrushAndStrokeWidthAndStrokeStyle(_countof(points), points, f.Brush.Get(), 5.0f, strokeStyle.Get()));
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_FillCircles)
+    {
+        CanvasDrawingSessionFixture f;
+
+        Vector2 centers[] = { Vector2{ 1, 2 }, Vector2{ 3, 4 }, Vector2{ 5, 6 } };
+        float radii[] = { 7, 8, 9 };
+
+        std::vector<float> expectedRadii;
+        int drawCount = 0;
+
+        f.DeviceContext->FillEllipseMethod.AllowAnyCall(
+            [&](D2D1_ELLIPSE const* ellipse, ID2D1Brush*)
+            {
+                Assert::AreEqual(ToD2DPoint(centers[drawCount % _countof(centers)]), ellipse->point);
+                Assert::AreEqual(expectedRadii[drawCount], ellipse->radiusX);
+                Assert::AreEqual(expectedRadii[drawCount], ellipse->radiusY);
+                drawCount++;
+            });
+
+        // One radius per circle.
+        expectedRadii = { 7, 8, 9 };
+        ThrowIfFailed(f.DS->FillCirclesWithBrush(_countof(centers), centers, _countof(radii), radii, f.Brush.Get()));
+        Assert::AreEqual(3, drawCount);
+
+        // A single radius shared by all the circles.
+        expectedRadii = { 7, 8, 9, 7, 7, 7 };
+        ThrowIfFailed(f.DS->FillCirclesWithColor(_countof(centers), centers, 1, radii, ArbitraryMarkerColor1));
+        Assert::AreEqual(6, drawCount);
+
+        // Any other number of radii is an error.
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillCirclesWithBrush(_countof(centers), centers, 2, radii, f.Brush.Get()));
+        ValidateStoredErrorState(E_INVALIDARG, L"The radii array passed to CanvasDrawingSession.FillCircles must contain either a single element or one element per circle (3); actual array was of size 2.");
+
+        Color colors[] = { ArbitraryMarkerColor1, ArbitraryMarkerColor2 };
+        Assert::AreEqual(E_INVALIDARG, f.DS->FillCirclesWithColors(_countof(centers), centers, 1, radii, _countof(colors), colors));
+
+        Assert::AreEqual(6, drawCount);
+    }
+
+    class DrawPolylineFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        ComPtr<MockD2DPathGeometry> PathGeometry;
+        std::vector<D2D1_POINT_2F> DrawnPoints;
+
+        DrawPolylineFixture(D2D1_MATRIX_3X2_F const& transform)
+            : PathGeometry(Make<MockD2DPathGeometry>())
+        {
+            DeviceContext->GetTransformMethod.AllowAnyCall([=](D2D1_MATRIX_3X2_F* value) { *value = transform; });
+            DeviceContext->GetUnitModeMethod.AllowAnyCall([] { return D2D1_UNIT_MODE_DIPS; });
+            DeviceContext->GetDpiMethod.AllowAnyCall([](float* dpiX, float* dpiY) { *dpiX = *dpiY = DEFAULT_DPI; });
+
+            DeviceContext->m_factory->CreatePathGeometryMethod.SetExpectedCalls(1,
+                [=](ID2D1PathGeometry1** value)
+                {
+                    return PathGeometry.CopyTo(value);
+                });
+
+            PathGeometry->OpenMethod.SetExpectedCalls(1,
+                [=](ID2D1GeometrySink** value)
+                {
+                    auto geometrySink = Make<MockD2DGeometrySink>();
+
+                    geometrySink->BeginFigureMethod.SetExpectedCalls(1,
+                        [=](D2D1_POINT_2F point, D2D1_FIGURE_BEGIN)
+                        {
+                            DrawnPoints.push_back(point);
+                        });
+
+                    geometrySink->AddLinesMethod.AllowAnyCall(
+                        [=](D2D1_POINT_2F const* points, UINT32 count)
+                        {
+                            DrawnPoints.insert(DrawnPoints.end(), points, points + count);
+                        });
+
+                    geometrySink->EndFigureMethod.SetExpectedCalls(1,
+                        [](D2D1_FIGURE_END mode)
+                        {
+                            Assert::AreEqual(D2D1_FIGURE_END_OPEN, mode);
+                        });
+
+                    geometrySink->CloseMethod.SetExpectedCalls(1);
+
+                    return geometrySink.CopyTo(value);
+                });
+        }
+    };
+
+    // Several points in the first one DIP column, of which only the third isn't needed.
+    static std::vector<Vector2> GetPolylineTestPoints()
+    {
+        return { { 0, 0 }, { 0.2f, 5 }, { 0.4f, 2 }, { 0.6f, -5 }, { 0.8f, 1 }, { 1.5f, 2 } };
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_DecimatesToPixelColumns)
+    {
+        DrawPolylineFixture f(D2D1::Matrix3x2F::Translation(10, 20));
+
+        auto points = GetPolylineTestPoints();
+
+        f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1,
+            [&](ID2D1Geometry* geometry, ID2D1Brush* brush, float strokeWidth, ID2D1StrokeStyle* strokeStyle)
+            {
+                Assert::AreEqual<ID2D1Geometry*>(f.PathGeometry.Get(), geometry);
+                Assert::IsNotNull(brush);
+                Assert::AreEqual(1.0f, strokeWidth);
+                Assert::IsNull(strokeStyle);
+            });
+
+        ThrowIfFailed(f.DS->DrawPolylineWithColor(static_cast<uint32_t>(points.size()), points.data(), ArbitraryMarkerColor1));
+
+        std::vector<Vector2> expectedPoints{ points[0], points[1], points[3], points[4], points[5] };
+
+        Assert::AreEqual(expectedPoints.size(), f.DrawnPoints.size());
+
+        for (size_t i = 0; i < expectedPoints.size(); i++)
+        {
+            Assert::AreEqual(ToD2DPoint(expectedPoints[i]), f.DrawnPoints[i]);
+        }
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_ScaledTransformNarrowsColumns)
+    {
+        // At 10 pixels per DIP every point lands in a different column.
+        DrawPolylineFixture f(D2D1::Matrix3x2F::Scale(10, 10));
+
+        auto points = GetPolylineTestPoints();
+
+        auto strokeStyle = Make<CanvasStrokeStyle>();
+
+        f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1,
+            [&](ID2D1Geometry*, ID2D1Brush* brush, float strokeWidth, ID2D1StrokeStyle* d2dStrokeStyle)
+            {
+                Assert::AreEqual(f.Brush->GetD2DBrush(nullptr, GetBrushFlags::None).Get(), brush);
+                Assert::AreEqual(3.0f, strokeWidth);
+                Assert::IsNotNull(d2dStrokeStyle);
+            });
+
+        ThrowIfFailed(f.DS->DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(static_cast<uint32_t>(points.size()), points.data(), f.Brush.Get(), 3.0f, strokeStyle.Get()));
+
+        Assert::AreEqual(points.size(), f.DrawnPoints.size());
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_RotatedTransformDisablesDecimation)
+    {
+        DrawPolylineFixture f(D2D1::Matrix3x2F::Rotation(45));
+
+        auto points = GetPolylineTestPoints();
+
+        f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1);
+
+        ThrowIfFailed(f.DS->DrawPolylineWithBrush(static_cast<uint32_t>(points.size()), points.data(), f.Brush.Get()));
+
+        Assert::AreEqual(points.size(), f.DrawnPoints.size());
+
+        // Nothing is decimated, so no scratch memory is needed.
+        Assert::AreEqual<uint64_t>(0, f.DS->GetFrameArenaStatistics().HeapBytes);
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_TranslationShiftsColumns)
+    {
+        // Half a pixel of translation moves the column boundary to X = 0.5,
+        // splitting the points that were all in the first column.
+        DrawPolylineFixture f(D2D1::Matrix3x2F::Translation(10.5f, 0));
+
+        auto points = GetPolylineTestPoints();
+
+        f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1);
+
+        ThrowIfFailed(f.DS->DrawPolylineWithColor(static_cast<uint32_t>(points.size()), points.data(), ArbitraryMarkerColor1));
+
+        Assert::AreEqual(points.size(), f.DrawnPoints.size());
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_DashedStrokeStyleDisablesDecimation)
+    {
+        for (auto useCustomDashes : { false, true })
+        {
+            DrawPolylineFixture f(D2D1::Matrix3x2F::Identity());
+
+            auto points = GetPolylineTestPoints();
+
+            auto strokeStyle = Make<CanvasStrokeStyle>();
+
+            if (useCustomDashes)
+            {
+                float dashes[] = { 1, 2 };
+                ThrowIfFailed(strokeStyle->put_CustomDashStyle(_countof(dashes), dashes));
+            }
+            else
+            {
+                ThrowIfFailed(strokeStyle->put_DashStyle(CanvasDashStyle::Dash));
+            }
+
+            f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1);
+
+            ThrowIfFailed(f.DS->DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(static_cast<uint32_t>(points.size()), points.data(), f.Brush.Get(), 1.0f, strokeStyle.Get()));
+
+            Assert::AreEqual(points.size(), f.DrawnPoints.size());
+        }
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_AllowDecimationFalseKeepsEveryPoint)
+    {
+        for (auto allowDecimation : { false, true })
+        {
+            DrawPolylineFixture f(D2D1::Matrix3x2F::Identity());
+
+            auto points = GetPolylineTestPoints();
+
+            f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1);
+
+            ThrowIfFailed(f.DS->DrawPolylineWithColorAndStrokeWidthAndStrokeStyleAndDecimation(static_cast<uint32_t>(points.size()), points.data(), ArbitraryMarkerColor1, 1.0f, nullptr, allowDecimation));
+
+            Assert::AreEqual(allowDecimation ? points.size() - 1 : points.size(), f.DrawnPoints.size());
+        }
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_DecimatesIntoFrameArena)
+    {
+        DrawPolylineFixture f(D2D1::Matrix3x2F::Identity());
+
+        auto points = GetPolylineTestPoints();
+
+        f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1);
+
+        ThrowIfFailed(f.DS->DrawPolylineWithColor(static_cast<uint32_t>(points.size()), points.data(), ArbitraryMarkerColor1));
+
+        auto stats = f.DS->GetFrameArenaStatistics();
+
+        Assert::AreEqual<uint64_t>(points.size() * sizeof(D2D1_POINT_2F), stats.HeapBytes);
+        Assert::AreEqual<uint32_t>(1, stats.HeapAllocationCount);
+        Assert::AreEqual<size_t>(FrameArena::DefaultBlockSize, stats.ReservedBytes);
+
+        ThrowIfFailed(f.DS->Close());
+
+        stats = f.DS->GetFrameArenaStatistics();
+
+        Assert::AreEqual<uint64_t>(points.size() * sizeof(D2D1_POINT_2F), stats.HeapBytes);
+
+        // The block goes back to the device, ready for the next session.
+        auto& pool = f.CanvasDevice->GetFrameArenaPool();
+        Assert::AreEqual<size_t>(1, pool.GetIdleArenaCount());
+
+        auto lease = pool.TakeLease();
+        Assert::AreEqual<size_t>(FrameArena::DefaultBlockSize, lease->GetStatistics().ReservedBytes);
+        Assert::AreEqual<uint32_t>(0, lease->GetStatistics().HeapAllocationCount);
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_LeasesFrameArenaFromOwner)
+    {
+        DrawPolylineFixture f(D2D1::Matrix3x2F::Identity());
+
+        auto points = GetPolylineTestPoints();
+
+        f.CanvasDevice->LeaseFrameArenaMethod.SetExpectedCalls(1,
+            [&]
+            {
+                return f.CanvasDevice->GetFrameArenaPool().TakeLease();
+            });
+
+        f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1);
+
+        ThrowIfFailed(f.DS->DrawPolylineWithColor(static_cast<uint32_t>(points.size()), points.data(), ArbitraryMarkerColor1));
+
+        Assert::AreEqual<size_t>(0, f.CanvasDevice->GetFrameArenaPool().GetIdleArenaCount());
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawPolyline_InvalidArgs)
+    {
+        CanvasDrawingSessionFixture f;
+
+        Vector2 point{ 1, 2 };
+
+        // Nothing to draw.
+        ThrowIfFailed(f.DS->DrawPolylineWithBrush(0, nullptr, f.Brush.Get()));
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawPolylineWithBrush(1, nullptr, f.Brush.Get()));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawPolylineWithBrush(1, &point, nullptr));
+    }
+
+    class DrawRecordingFixture : public CanvasDrawingSessionFixture
+    {
+    public:
+        ComPtr<CanvasDrawingRecording> Recording;
+        std::vector<D2D1_RECT_F> FilledRects;
+
+        // The render target is 100x100 DIPs, and drawn to through the given transform.
+        DrawRecordingFixture(D2D1_MATRIX_3X2_F const& transform = D2D1::Matrix3x2F::Identity())
+            : Recording(Make<CanvasDrawingRecording>())
+        {
+            auto targetBitmap = Make<MockD2DBitmap>();
+
+            DeviceContext->GetTargetMethod.AllowAnyCall(
+                [=](ID2D1Image** target)
+                {
+                    targetBitmap.CopyTo(target);
+                });
+
+            DeviceContext->GetImageLocalBoundsMethod.AllowAnyCall(
+                [=](ID2D1Image* image, D2D1_RECT_F* bounds)
+                {
+                    Assert::IsTrue(IsSameInstance(targetBitmap.Get(), image));
+                    *bounds = D2D1_RECT_F{ 0, 0, 100, 100 };
+                    return S_OK;
+                });
+
+            DeviceContext->GetTransformMethod.AllowAnyCall([=](D2D1_MATRIX_3X2_F* value) { *value = transform; });
+
+            DeviceContext->FillRectangleMethod.AllowAnyCall(
+                [=](D2D1_RECT_F const* rect, ID2D1Brush* brush)
+                {
+                    Assert::IsNotNull(brush);
+                    FilledRects.push_back(*rect);
+                });
+        }
+
+        // One rectangle inside the target, one off to the right and one below.
+        void RecordRectangles()
+        {
+            ThrowIfFailed(Recording->FillRectangle(Rect{ 10, 10, 20, 20 }, ArbitraryMarkerColor1));
+            ThrowIfFailed(Recording->FillRectangle(Rect{ 150, 10, 20, 20 }, ArbitraryMarkerColor1));
+            ThrowIfFailed(Recording->FillRectangle(Rect{ 10, 150, 20, 20 }, ArbitraryMarkerColor2));
+        }
+    };
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawRecording_CullsCommandsOutsideTarget)
+    {
+        DrawRecordingFixture f;
+        f.RecordRectangles();
+
+        ThrowIfFailed(f.DS->DrawRecording(f.Recording.Get()));
+
+        Assert::AreEqual<size_t>(1, f.FilledRects.size());
+        Assert::AreEqual(D2D1_RECT_F{ 10, 10, 30, 30 }, f.FilledRects[0]);
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawRecording_CullRectFollowsSessionTransform)
+    {
+        // Scrolled down, so the first two rectangles are above the target and only the last is visible.
+        DrawRecordingFixture f(D2D1::Matrix3x2F::Translation(0, -100));
+        f.RecordRectangles();
+
+        ThrowIfFailed(f.DS->DrawRecording(f.Recording.Get()));
+
+        Assert::AreEqual<size_t>(1, f.FilledRects.size());
+        Assert::AreEqual(D2D1_RECT_F{ 10, 150, 30, 170 }, f.FilledRects[0]);
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawRecordingInRegion_CullsCommandsOutsideRegion)
+    {
+        DrawRecordingFixture f;
+        f.RecordRectangles();
+        ThrowIfFailed(f.Recording->FillRectangle(Rect{ 60, 60, 20, 20 }, ArbitraryMarkerColor2));
+
+        ThrowIfFailed(f.DS->DrawRecordingInRegion(f.Recording.Get(), Rect{ 50, 50, 50, 50 }));
+
+        Assert::AreEqual<size_t>(1, f.FilledRects.size());
+        Assert::AreEqual(D2D1_RECT_F{ 60, 60, 80, 80 }, f.FilledRects[0]);
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawRecordingRange)
+    {
+        DrawRecordingFixture f;
+
+        for (int i = 0; i < 4; i++)
+        {
+            ThrowIfFailed(f.Recording->FillRectangle(Rect{ static_cast<float>(i), 0, 1, 1 }, ArbitraryMarkerColor1));
+        }
+
+        ThrowIfFailed(f.DS->DrawRecordingRange(f.Recording.Get(), 1, 2));
+
+        Assert::AreEqual<size_t>(2, f.FilledRects.size());
+        Assert::AreEqual(1.0f, f.FilledRects[0].left);
+        Assert::AreEqual(2.0f, f.FilledRects[1].left);
+
+        ThrowIfFailed(f.DS->DrawRecordingRange(f.Recording.Get(), 4, 0));
+
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawRecordingRange(f.Recording.Get(), -1, 1));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawRecordingRange(f.Recording.Get(), 0, -1));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawRecordingRange(f.Recording.Get(), 3, 2));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawRecordingRange(f.Recording.Get(), 5, 0));
+        Assert::AreEqual(E_INVALIDARG, f.DS->DrawRecordingRange(nullptr, 0, 0));
+
+        Assert::AreEqual<size_t>(2, f.FilledRects.size());
+    }
+
+    TEST_METHOD_EX(CanvasDrawingSession_DrawRecording_AppliesRecordedTransformOnTopOfSessionTransform)
+    {
+        auto sessionTransform = D2D1::Matrix3x2F::Translation(5, 6);
+        auto recordedTransform = D2D1::Matrix3x2F::Scale(2, 3);
+
+        DrawRecordingFixture f(sessionTransform);
+
+        ThrowIfFailed(f.Recording->put_Transform(*ReinterpretAs<Matrix3x2*>(&recordedTransform)));
+        ThrowIfFailed(f.Recording->FillRectangle(Rect{ 1, 1, 1, 1 }, ArbitraryMarkerColor1));
+
+        std::vector<D2D1_MATRIX_3X2_F> setTransforms;
+
+        f.DeviceContext->SetTransformMethod.SetExpectedCalls(2,
+            [&](D2D1_MATRIX_3X2_F const* transform)
+            {
+                setTransforms.push_back(*transform);
+            });
+
+        ThrowIfFailed(f.DS->DrawRecording(f.Recording.Get()));
+
+        Assert::AreEqual<size_t>(1, f.FilledRects.size());
+
+        // The recorded transform while drawing, and then the session transform put back.
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(recordedTransform * sessionTransform, setTransforms[0]);
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(sessionTransform, setTransforms[1]);
+    }
+
     class FillOpacityMaskFixture : public CanvasDrawingSessionFixture
     {
     public:
@@ -4195,6 +4804,23 @@ public:
         ThrowIfFailed(drawingSession->put_EffectTileSize(expectedBitmapSize));
     }
 
+    TEST_METHOD_EX(CanvasDrawingSession_FoldColorEffects)
+    {
+        auto deviceContext = Make<StubD2DDeviceContextWithGetFactory>();
+        auto adapter = std::make_shared<StubCanvasDrawingSessionAdapter>();
+        auto drawingSession = CanvasDrawingSession::CreateNew(deviceContext.Get(), adapter);
+
+        Assert::AreEqual(E_INVALIDARG, drawingSession->get_FoldColorEffects(nullptr));
+
+        boolean value;
+        ThrowIfFailed(drawingSession->get_FoldColorEffects(&value));
+        Assert::IsFalse(!!value);
+
+        ThrowIfFailed(drawingSession->put_FoldColorEffects(true));
+        ThrowIfFailed(drawingSession->get_FoldColorEffects(&value));
+        Assert::IsTrue(!!value);
+    }
+
 #ifdef WINUI3_SUPPORTS_INKING
 
     TEST_METHOD_EX(CanvasDrawingSession_DrawInk_NullArg)
@@ -4937,6 +5563,30 @@ TEST_CLASS(CanvasDrawingSession_CloseTests)
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGlyphRunWithMeasuringMode(Vector2{}, nullptr, 0, 0, nullptr, false, 0u, nullptr, CanvasTextMeasuringMode::Natural));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawGlyphRunWithMeasuringModeAndDescription(Vector2{}, nullptr, 0, 0, nullptr, false, 0u, nullptr, CanvasTextMeasuringMode::Natural, nullptr, nullptr, 0, nullptr, 0));
 
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillRectanglesWithBrush(0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillRectanglesWithColor(0, nullptr, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillRectanglesWithColors(0, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLinesWithBrush(0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLinesWithColor(0, nullptr, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLinesWithColors(0, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLinesWithBrushAndStrokeWidthAndStrokeStyle(0, nullptr, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLinesWithColorAndStrokeWidthAndStrokeStyle(0, nullptr, Color{}, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawLinesWithColorsAndStrokeWidthAndStrokeStyle(0, nullptr, 0, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillCirclesWithBrush(0, nullptr, 0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillCirclesWithColor(0, nullptr, 0, nullptr, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->FillCirclesWithColors(0, nullptr, 0, nullptr, 0, nullptr));
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithBrush(0, nullptr, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithColor(0, nullptr, Color{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle(0, nullptr, nullptr, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithColorAndStrokeWidthAndStrokeStyle(0, nullptr, Color{}, 0, nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithBrushAndStrokeWidthAndStrokeStyleAndDecimation(0, nullptr, nullptr, 0, nullptr, true));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawPolylineWithColorAndStrokeWidthAndStrokeStyleAndDecimation(0, nullptr, Color{}, 0, nullptr, true));
+
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawRecording(nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawRecordingInRegion(nullptr, Rect{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawRecordingRange(nullptr, 0, 0));
+
 #if WINUI3_SUPPORTS_INKING
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->DrawInk(nullptr));
 #endif
@@ -4955,6 +5605,8 @@ TEST_CLASS(CanvasDrawingSession_CloseTests)
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_EffectBufferPrecision(nullptr));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_EffectTileSize(nullptr));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_EffectTileSize(BitmapSize{}));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_FoldColorEffects(nullptr));
+        EXPECT_OBJECT_CLOSED(canvasDrawingSession->put_FoldColorEffects(true));
         EXPECT_OBJECT_CLOSED(canvasDrawingSession->get_Device(&deviceVerify));
 
 
@@ -4,6 +4,8 @@
 
 #include "pch.h"
 
+#include "utils/BenchmarkTimer.h"
+
 #include <lib/images/CanvasCommandList.h>
 
 #include "stubs/TestEffect.h"
@@ -11,8 +13,12 @@
 
 #include <lib/effects/generated/AlphaMaskEffect.h>
 #include <lib/effects/generated/CrossFadeEffect.h>
+#include <lib/effects/generated/HueRotationEffect.h>
 #include <lib/effects/generated/OpacityEffect.h>
+#include <lib/effects/generated/SaturationEffect.h>
 #include <lib/effects/generated/TintEffect.h>
+#include <lib/effects/shader/PixelShaderEffectImpl.h>
+#include <lib/effects/ColorMatrixFolding.h>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -77,6 +83,24 @@ public:
         Assert::IsTrue(isGetPropertyCalled);
     }
 
+    TEST_METHOD_EX(CanvasEffect_GetProperty_BoxesStoredValue)
+    {
+        ThrowIfFailed(m_testEffect->put_BlurAmount(5.0f));
+
+        ComPtr<IPropertyValue> propertyValue;
+        ThrowIfFailed(m_testEffect->GetProperty(0, &propertyValue));
+
+        PropertyType propertyType;
+        ThrowIfFailed(propertyValue->get_Type(&propertyType));
+        Assert::AreEqual<int>(PropertyType_Single, propertyType);
+
+        float value;
+        ThrowIfFailed(propertyValue->GetSingle(&value));
+        Assert::AreEqual(5.0f, value);
+
+        Assert::AreEqual(E_BOUNDS, m_testEffect->GetProperty(m_realPropertiesSize, &propertyValue));
+    }
+
     TEST_METHOD_EX(CanvasEffect_Closed)
     {
         ABI::Windows::Foundation::Rect bounds;
@@ -287,6 +311,210 @@ public:
         }
     };
 
+    static ComPtr<MockD2DEffect> MakeMockEffectWithFloatProperty(float* value)
+    {
+        auto mockEffect = Make<MockD2DEffect>();
+
+        mockEffect->MockGetInputCount = [] { return 0; };
+        mockEffect->MockSetInputCount = [](UINT32) { return S_OK; };
+        mockEffect->MockGetType = [](UINT32) { return D2D1_PROPERTY_TYPE_FLOAT; };
+
+        mockEffect->MockSetValue =
+            [=](UINT32 index, D2D1_PROPERTY_TYPE, CONST BYTE* data, UINT32 dataSize)
+            {
+                if (index == 0)
+                {
+                    Assert::AreEqual<UINT32>(sizeof(float), dataSize);
+                    *value = *reinterpret_cast<float const*>(data);
+                }
+                return S_OK;
+            };
+
+        mockEffect->MockGetValue =
+            [=](UINT32 index, D2D1_PROPERTY_TYPE, BYTE* data, UINT32 dataSize)
+            {
+                Assert::AreEqual(0u, index);
+                Assert::AreEqual<UINT32>(sizeof(float), dataSize);
+                *reinterpret_cast<float*>(data) = *value;
+                return S_OK;
+            };
+
+        return mockEffect;
+    }
+
+    TEST_METHOD_EX(CanvasEffect_WhenSwitchingBackToDevice_CachedEffectIsReused)
+    {
+        auto testEffect = Make<TestEffect>(m_blurGuid, 1, 0, true);
+
+        Fixture deviceA;
+        Fixture deviceB;
+
+        float valueOnA = 0;
+        float valueOnB = 0;
+
+        deviceA.m_deviceContext->DrawImageMethod.AllowAnyCall();
+        deviceB.m_deviceContext->DrawImageMethod.AllowAnyCall();
+
+        // Each device only ever creates one D2D effect.
+        deviceA.m_deviceContext->CreateEffectMethod.SetExpectedCalls(1,
+            [&](IID const&, ID2D1Effect** effect)
+            {
+                return MakeMockEffectWithFloatProperty(&valueOnA).CopyTo(effect);
+            });
+
+        deviceB.m_deviceContext->CreateEffectMethod.SetExpectedCalls(1,
+            [&](IID const&, ID2D1Effect** effect)
+            {
+                return MakeMockEffectWithFloatProperty(&valueOnB).CopyTo(effect);
+            });
+
+        ThrowIfFailed(testEffect->put_BlurAmount(1));
+        ThrowIfFailed(deviceA.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+        Assert::AreEqual(1.0f, valueOnA);
+
+        ThrowIfFailed(deviceB.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+        Assert::AreEqual(1.0f, valueOnB);
+
+        // Changes made while realized on B must make it across to the reused effect on A.
+        ThrowIfFailed(testEffect->put_BlurAmount(2));
+        Assert::AreEqual(2.0f, valueOnB);
+
+        ThrowIfFailed(deviceA.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+        Assert::AreEqual(2.0f, valueOnA);
+
+        ThrowIfFailed(deviceB.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+
+        auto counters = testEffect->GetRealizationCounters();
+        Assert::AreEqual(2u, counters.EffectsCreated);
+        Assert::AreEqual(2u, counters.EffectsReused);
+        Assert::AreEqual(3u, counters.Unrealizations);
+        Assert::AreEqual(0u, counters.CacheEvictions);
+    }
+
+    TEST_METHOD_EX(CanvasEffect_CachedRealizationsAreBounded)
+    {
+        auto testEffect = Make<TestEffect>(m_blurGuid, 1, 0, true);
+
+        float value = 0;
+        std::vector<std::unique_ptr<Fixture>> devices;
+
+        // Draw on more devices than the cache holds, then go back to the first.
+        for (int i = 0; i < 4; i++)
+        {
+            devices.push_back(std::make_unique<Fixture>());
+
+            auto& deviceContext = devices.back()->m_deviceContext;
+
+            deviceContext->DrawImageMethod.AllowAnyCall();
+            deviceContext->CreateEffectMethod.AllowAnyCall(
+                [&](IID const&, ID2D1Effect** effect)
+                {
+                    return MakeMockEffectWithFloatProperty(&value).CopyTo(effect);
+                });
+
+            ThrowIfFailed(devices.back()->m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+        }
+
+        ThrowIfFailed(devices[0]->m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+
+        auto counters = testEffect->GetRealizationCounters();
+        Assert::AreEqual(5u, counters.EffectsCreated);
+        Assert::AreEqual(0u, counters.EffectsReused);
+        Assert::AreEqual(2u, counters.CacheEvictions);
+    }
+
+    void VerifyCachedRealizationIsPurgedWhen(std::function<void(StubCanvasDevice*)> const& killDevice)
+    {
+        auto testEffect = Make<TestEffect>(m_blurGuid, 1, 0, true);
+
+        Fixture deviceA;
+        Fixture deviceB;
+
+        float value = 0;
+
+        for (auto fixture : { &deviceA, &deviceB })
+        {
+            fixture->m_deviceContext->DrawImageMethod.AllowAnyCall();
+            fixture->m_deviceContext->CreateEffectMethod.AllowAnyCall(
+                [&](IID const&, ID2D1Effect** effect)
+                {
+                    return MakeMockEffectWithFloatProperty(&value).CopyTo(effect);
+                });
+        }
+
+        ThrowIfFailed(deviceA.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+        ThrowIfFailed(deviceB.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+
+        // A is still fine, so its effect stays cached.
+        Assert::AreEqual(0u, testEffect->GetRealizationCounters().StalePurges);
+
+        killDevice(deviceA.m_canvasDevice.Get());
+
+        // Moving back to A parks B's effect, and notices A's is no good.
+        ThrowIfFailed(deviceA.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+
+        auto counters = testEffect->GetRealizationCounters();
+        Assert::AreEqual(1u, counters.StalePurges);
+        Assert::AreEqual(3u, counters.EffectsCreated);
+        Assert::AreEqual(0u, counters.EffectsReused);
+    }
+
+    TEST_METHOD_EX(CanvasEffect_CachedRealizationForLostDevice_IsPurged)
+    {
+        VerifyCachedRealizationIsPurgedWhen(
+            [](StubCanvasDevice* device)
+            {
+                device->IsDeviceLost2Method.AllowAnyCall(
+                    [](boolean* value)
+                    {
+                        *value = true;
+                        return S_OK;
+                    });
+            });
+    }
+
+    TEST_METHOD_EX(CanvasEffect_CachedRealizationForClosedDevice_IsPurged)
+    {
+        VerifyCachedRealizationIsPurgedWhen(
+            [](StubCanvasDevice* device)
+            {
+                device->IsDeviceLost2Method.AllowAnyCall(
+                    [](boolean*)
+                    {
+                        return RO_E_CLOSED;
+                    });
+            });
+    }
+
+    TEST_METHOD_EX(CanvasEffect_CachedRealizationForReleasedDevice_IsPurged)
+    {
+        auto testEffect = Make<TestEffect>(m_blurGuid, 1, 0, true);
+
+        float value = 0;
+
+        auto drawOnNewDevice = [&]
+        {
+            Fixture f;
+
+            f.m_deviceContext->DrawImageMethod.AllowAnyCall();
+            f.m_deviceContext->CreateEffectMethod.AllowAnyCall(
+                [&](IID const&, ID2D1Effect** effect)
+                {
+                    return MakeMockEffectWithFloatProperty(&value).CopyTo(effect);
+                });
+
+            ThrowIfFailed(f.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+            ThrowIfFailed(f.m_drawingSession->Close());
+        };
+
+        drawOnNewDevice();
+        drawOnNewDevice();
+
+        // The first device's effect was parked when the second was drawn on,
+        // by which time nothing else referenced the first device.
+        Assert::AreEqual(1u, testEffect->GetRealizationCounters().StalePurges);
+    }
+
     class InvalidEffectSourceType : public RuntimeClass<IGraphicsEffectSource>
     {
         InspectableClass(L"InvalidEffectSourceType", BaseTrust);
@@ -567,6 +795,156 @@ public:
         Assert::IsTrue(IsSameInstance(mockEffects[3].Get(), As<ICanvasImageInternal>(dpiCompensationEffect)->GetD2DImage(f.m_canvasDevice.Get(), f.m_deviceContext.Get()).Get()));
     }
 
+    static D2D1_MATRIX_5X4_F GetColorMatrixProperty(MockD2DEffectThatCountsCalls* mockEffect)
+    {
+        Assert::IsTrue(mockEffect->m_properties.size() > D2D1_COLORMATRIX_PROP_COLOR_MATRIX);
+        Assert::AreEqual(sizeof(D2D1_MATRIX_5X4_F), mockEffect->m_properties[D2D1_COLORMATRIX_PROP_COLOR_MATRIX].size());
+
+        return *reinterpret_cast<D2D1_MATRIX_5X4_F*>(&mockEffect->m_properties[D2D1_COLORMATRIX_PROP_COLOR_MATRIX].front());
+    }
+
+    TEST_METHOD_EX(CanvasEffect_FoldColorTransforms)
+    {
+        Fixture f;
+
+        std::vector<ComPtr<MockD2DEffectThatCountsCalls>> mockEffects;
+
+        f.m_deviceContext->CreateEffectMethod.AllowAnyCall(
+            [&](IID const& effectId, ID2D1Effect** effect)
+            {
+                mockEffects.push_back(Make<MockD2DEffectThatCountsCalls>(effectId));
+                return mockEffects.back().CopyTo(effect);
+            });
+
+        f.m_canvasDevice->GetResourceCreationDeviceContextMethod.AllowAnyCall(
+            [&]
+            {
+                return DeviceContextLease(As<ID2D1DeviceContext1>(f.m_deviceContext));
+            });
+
+        // blur <- saturation <- hue rotation <- bitmap.
+        auto testBitmap = CreateStubCanvasBitmap(DEFAULT_DPI, f.m_canvasDevice.Get());
+        auto hueRotation = Make<HueRotationEffect>();
+        auto saturation = Make<SaturationEffect>();
+        auto testEffect = Make<TestEffect>(m_blurGuid, 0, 1, true);
+
+        ThrowIfFailed(hueRotation->put_Angle(DirectX::XM_PIDIV2));
+        ThrowIfFailed(hueRotation->put_Source(testBitmap.Get()));
+        ThrowIfFailed(saturation->put_Saturation(0.5f));
+        ThrowIfFailed(saturation->put_Source(As<IGraphicsEffectSource>(hueRotation).Get()));
+        ThrowIfFailed(testEffect->put_Source(As<IGraphicsEffectSource>(saturation).Get()));
+
+        auto getImage = [&](WIN2D_GET_D2D_IMAGE_FLAGS flags)
+        {
+            return As<ICanvasImageInternal>(testEffect)->GetD2DImage(f.m_canvasDevice.Get(), f.m_deviceContext.Get(), flags, DEFAULT_DPI);
+        };
+
+        // The two color effects are realized as a single D2D1ColorMatrix.
+        getImage(WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS);
+
+        Assert::AreEqual<size_t>(2, mockEffects.size());
+        CheckEffectTypeAndInput(mockEffects[0].Get(), m_blurGuid, mockEffects[1].Get());
+        CheckEffectTypeAndInput(mockEffects[1].Get(), CLSID_D2D1ColorMatrix, testBitmap.Get(), f.m_deviceContext.Get());
+
+        auto expected = CombineColorMatrices(MakeHueRotationColorMatrix(90), MakeSaturationColorMatrix(0.5f));
+        auto actual = GetColorMatrixProperty(mockEffects[1].Get());
+
+        for (int i = 0; i < 20; i++)
+        {
+            Assert::AreEqual((&expected._11)[i], (&actual._11)[i], 1e-5f);
+        }
+
+        // The folded effects are not realized, but are still reported as the source.
+        ComPtr<IGraphicsEffectSource> source;
+        ThrowIfFailed(testEffect->get_Source(&source));
+        Assert::IsTrue(IsSameInstance(saturation.Get(), source.Get()));
+
+        // Drawing again without changes doesn't touch the D2D graph.
+        int headSetInputCalls = mockEffects[0]->m_setInputCalls;
+        int headSetValueCalls = mockEffects[0]->m_setValueCalls;
+
+        getImage(WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS);
+
+        Assert::AreEqual(headSetInputCalls, mockEffects[0]->m_setInputCalls);
+        Assert::AreEqual(headSetValueCalls, mockEffects[0]->m_setValueCalls);
+        Assert::AreEqual(1, mockEffects[1]->m_setInputCalls);
+        Assert::AreEqual(3, mockEffects[1]->m_setValueCalls);
+
+        // When the transforms cancel out, the bitmap is used directly.
+        ThrowIfFailed(saturation->put_Saturation(1));
+        ThrowIfFailed(hueRotation->put_Angle(0));
+
+        getImage(WIN2D_GET_D2D_IMAGE_FLAGS_FOLD_COLOR_TRANSFORMS);
+
+        Assert::AreEqual<size_t>(2, mockEffects.size());
+        CheckEffectTypeAndInput(mockEffects[0].Get(), m_blurGuid, testBitmap.Get(), f.m_deviceContext.Get());
+
+        // Without the flag, each effect is realized separately.
+        getImage(WIN2D_GET_D2D_IMAGE_FLAGS_NONE);
+
+        Assert::AreEqual<size_t>(4, mockEffects.size());
+        CheckEffectTypeAndInput(mockEffects[0].Get(), m_blurGuid, mockEffects[2].Get());
+        CheckEffectTypeAndInput(mockEffects[2].Get(), CLSID_D2D1Saturation, mockEffects[3].Get());
+        CheckEffectTypeAndInput(mockEffects[3].Get(), CLSID_D2D1HueRotation, testBitmap.Get(), f.m_deviceContext.Get());
+    }
+
+    TEST_METHOD_EX(CanvasEffect_DrawImage_FoldsColorTransformsOnlyWhenSessionOptsIn)
+    {
+        Fixture f;
+
+        std::vector<ComPtr<MockD2DEffectThatCountsCalls>> mockEffects;
+
+        f.m_deviceContext->CreateEffectMethod.AllowAnyCall(
+            [&](IID const& effectId, ID2D1Effect** effect)
+            {
+                mockEffects.push_back(Make<MockD2DEffectThatCountsCalls>(effectId));
+                return mockEffects.back().CopyTo(effect);
+            });
+
+        f.m_deviceContext->DrawImageMethod.AllowAnyCall();
+
+        f.m_canvasDevice->GetResourceCreationDeviceContextMethod.AllowAnyCall(
+            [&]
+            {
+                return DeviceContextLease(As<ID2D1DeviceContext1>(f.m_deviceContext));
+            });
+
+        // blur <- saturation <- hue rotation <- bitmap.
+        auto testBitmap = CreateStubCanvasBitmap(DEFAULT_DPI, f.m_canvasDevice.Get());
+        auto hueRotation = Make<HueRotationEffect>();
+        auto saturation = Make<SaturationEffect>();
+        auto testEffect = Make<TestEffect>(m_blurGuid, 0, 1, true);
+
+        ThrowIfFailed(hueRotation->put_Angle(DirectX::XM_PIDIV2));
+        ThrowIfFailed(hueRotation->put_Source(testBitmap.Get()));
+        ThrowIfFailed(saturation->put_Saturation(0.5f));
+        ThrowIfFailed(saturation->put_Source(As<IGraphicsEffectSource>(hueRotation).Get()));
+        ThrowIfFailed(testEffect->put_Source(As<IGraphicsEffectSource>(saturation).Get()));
+
+        boolean foldColorEffects;
+        ThrowIfFailed(f.m_drawingSession->get_FoldColorEffects(&foldColorEffects));
+        Assert::IsFalse(!!foldColorEffects);
+
+        // By default each effect is realized separately.
+        ThrowIfFailed(f.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+
+        Assert::AreEqual<size_t>(3, mockEffects.size());
+        CheckEffectTypeAndInput(mockEffects[0].Get(), m_blurGuid, mockEffects[1].Get());
+        CheckEffectTypeAndInput(mockEffects[1].Get(), CLSID_D2D1Saturation, mockEffects[2].Get());
+        CheckEffectTypeAndInput(mockEffects[2].Get(), CLSID_D2D1HueRotation, testBitmap.Get(), f.m_deviceContext.Get());
+
+        // Once the session opts in, the two color effects are drawn as a single D2D1ColorMatrix.
+        ThrowIfFailed(f.m_drawingSession->put_FoldColorEffects(true));
+        ThrowIfFailed(f.m_drawingSession->get_FoldColorEffects(&foldColorEffects));
+        Assert::IsTrue(!!foldColorEffects);
+
+        ThrowIfFailed(f.m_drawingSession->DrawImageAtOrigin(testEffect.Get()));
+
+        Assert::AreEqual<size_t>(4, mockEffects.size());
+        CheckEffectTypeAndInput(mockEffects[0].Get(), m_blurGuid, mockEffects[3].Get());
+        CheckEffectTypeAndInput(mockEffects[3].Get(), CLSID_D2D1ColorMatrix, testBitmap.Get(), f.m_deviceContext.Get());
+    }
+
     struct CommandListFixture
     {
         ComPtr<StubCanvasDevice> CanvasDevice;
@@ -1308,6 +1686,65 @@ public:
         TestIsSupported<TintEffectFactory>(true);
     }
 
+    TEST_METHOD_EX(CanvasEffect_IsWin2DEffectId)
+    {
+        Assert::IsTrue(CanvasEffect::IsWin2DEffectId(CLSID_D2D1GaussianBlur));
+        Assert::IsTrue(CanvasEffect::IsWin2DEffectId(AlphaMaskEffect::EffectId()));
+        Assert::IsTrue(CanvasEffect::IsWin2DEffectId(TintEffect::EffectId()));
+        Assert::IsTrue(CanvasEffect::IsWin2DEffectId(CLSID_PixelShaderEffect));
+
+        Assert::IsFalse(CanvasEffect::IsWin2DEffectId(GUID_NULL));
+        Assert::IsFalse(CanvasEffect::IsWin2DEffectId(IID_IUnknown));
+        Assert::IsFalse(CanvasEffect::IsWin2DEffectId(__uuidof(ICanvasImage)));
+    }
+
+    TEST_METHOD_EX(CanvasEffect_EffectIdLookupPerformance)
+    {
+        const int lookupCount = 100000;
+
+        // A mix of ids from the start, middle and end of the generated table, plus ids
+        // that Win2D doesn't wrap (as is the case for effects with external factories).
+        IID knownIds[] =
+        {
+            CLSID_D2D1ArithmeticComposite,
+            CLSID_D2D1GaussianBlur,
+            CLSID_D2D1Vignette,
+            CLSID_PixelShaderEffect,
+        };
+
+        IID unknownIds[] =
+        {
+            GUID_NULL,
+            IID_IUnknown,
+            __uuidof(ICanvasImage),
+            __uuidof(IGraphicsEffectSource),
+        };
+
+        auto measure = [&](IID const* ids, size_t idCount, bool expected)
+        {
+            int matches = 0;
+
+            BenchmarkTimer timer;
+            for (int i = 0; i < lookupCount; i++)
+            {
+                if (CanvasEffect::IsWin2DEffectId(ids[i % idCount]))
+                    matches++;
+            }
+            auto nanosecondsPerLookup = timer.ElapsedNanoseconds() / lookupCount;
+
+            Assert::AreEqual(expected ? lookupCount : 0, matches);
+
+            return nanosecondsPerLookup;
+        };
+
+        auto knownTime = measure(knownIds, _countof(knownIds), true);
+        auto unknownTime = measure(unknownIds, _countof(unknownIds), false);
+
+        wchar_t message[256];
+        swprintf_s(message, L"Effect id lookup: %.1f ns per hit, %.1f ns per miss\n", knownTime, unknownTime);
+        Logger::WriteMessage(message);
+    }
+
     // DImage defines separate (but identical) enum types for different effects.
     // Effects codegen tool collapses this duplication in the WinRT projection.
     // Let's validate that the native enums really are the same!
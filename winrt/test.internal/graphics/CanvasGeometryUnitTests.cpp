@@ -14,6 +14,7 @@
 #include "mocks/MockD2DGeometryGroup.h"
 #include "mocks/MockDWriteFont.h"
 #include "mocks/MockGeometryAdapter.h"
+#include "stubs/StubBuffer.h"
 #include "stubs/StubGeometrySink.h"
 #include "stubs/StubCanvasTextLayoutAdapter.h"
 
@@ -216,6 +217,79 @@ public:
         ExpectHResultException(E_INVALIDARG, [&]{ CanvasGeometry::CreateNew(f.Device.Get(), 1, nullptr); });
     }
 
+    TEST_METHOD_EX(CanvasGeometry_CreatePolyline)
+    {
+        Vector2 testVertices[] =
+        {
+            { 1, 2 },
+            { 3, 4 },
+            { 5, 6 },
+        };
+
+        for (auto closed : { false, true })
+        {
+            Fixture f;
+
+            f.Adapter->CreatePathGeometryMethod.SetExpectedCalls(1,
+                [&]
+                {
+                    auto pathGeometry = Make<MockD2DPathGeometry>();
+
+                    pathGeometry->OpenMethod.SetExpectedCalls(1,
+                        [&](ID2D1GeometrySink** out)
+                        {
+                            auto geometrySink = Make<MockD2DGeometrySink>();
+
+                            geometrySink->BeginFigureMethod.SetExpectedCalls(1,
+                                [&](D2D1_POINT_2F point, D2D1_FIGURE_BEGIN)
+                                {
+                                    Assert::AreEqual(ToD2DPoint(testVertices[0]), point);
+                                });
+
+                            geometrySink->AddLinesMethod.SetExpectedCalls(1,
+                                [&](D2D1_POINT_2F const* points, UINT32 count)
+                                {
+                                    Assert::AreEqual(2u, count);
+                                    Assert::AreEqual(ToD2DPoint(testVertices[1]), points[0]);
+                                    Assert::AreEqual(ToD2DPoint(testVertices[2]), points[1]);
+                                });
+
+                            geometrySink->EndFigureMethod.SetExpectedCalls(1,
+                                [&](D2D1_FIGURE_END mode)
+                                {
+                                    Assert::AreEqual(closed ? D2D1_FIGURE_END_CLOSED : D2D1_FIGURE_END_OPEN, mode);
+                                });
+
+                            geometrySink->CloseMethod.SetExpectedCalls(1);
+
+                            return geometrySink.CopyTo(out);
+                        });
+
+                    return pathGeometry;
+                });
+
+            auto canvasGeometryFactory = Make<CanvasGeometryFactory>();
+
+            ComPtr<ICanvasGeometry> geometry;
+            ThrowIfFailed(canvasGeometryFactory->CreatePolyline(f.Device.Get(), _countof(testVertices), testVertices, closed, &geometry));
+        }
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_CreatePolyline_InvalidArgs)
+    {
+        Fixture f;
+
+        auto canvasGeometryFactory = Make<CanvasGeometryFactory>();
+
+        Vector2 testVertex{ 1, 2 };
+        ComPtr<ICanvasGeometry> geometry;
+
+        Assert::AreEqual(E_INVALIDARG, canvasGeometryFactory->CreatePolyline(f.Device.Get(), 1, nullptr, false, &geometry));
+        Assert::AreEqual(E_INVALIDARG, canvasGeometryFactory->CreatePolylineWithDecimationTolerance(f.Device.Get(), 1, &testVertex, false, -1, &geometry));
+        Assert::AreEqual(E_INVALIDARG, canvasGeometryFactory->CreatePolylineWithDecimationTolerance(f.Device.Get(), 1, &testVertex, false, NAN, &geometry));
+        Assert::AreEqual(E_INVALIDARG, canvasGeometryFactory->CreatePolyline(f.Device.Get(), 1, &testVertex, false, nullptr));
+    }
+
     class GeometryGroupFixture : public Fixture
     {
         struct Resource
@@ -1184,6 +1258,19 @@ public:
             Assert::AreEqual(sc_triangle2, *ReinterpretAs<D2D1_TRIANGLE const*>(&triangles[1]));
             Assert::AreEqual(sc_triangle3, *ReinterpretAs<D2D1_TRIANGLE const*>(&triangles[2]));
         }
+
+        void ValidateTessellatedTriangles(StubBuffer* buffer)
+        {
+            UINT32 length;
+            ThrowIfFailed(buffer->get_Length(&length));
+            Assert::AreEqual<size_t>(3 * sizeof(D2D1_TRIANGLE), length);
+
+            auto triangles = reinterpret_cast<D2D1_TRIANGLE const*>(buffer->GetData().data());
+
+            Assert::AreEqual(sc_triangle1, triangles[0]);
+            Assert::AreEqual(sc_triangle2, triangles[1]);
+            Assert::AreEqual(sc_triangle3, triangles[2]);
+        }
     };
 
     TEST_METHOD_EX(CanvasGeometry_Tessellate)
@@ -1212,16 +1299,387 @@ public:
         f.ValidateTessellatedTriangles(triangles);
     }
 
+    TEST_METHOD_EX(CanvasGeometry_TessellateWithBuffer)
+    {
+        TessellateFixture f;
+        auto buffer = Make<StubBuffer>(static_cast<uint32_t>(3 * sizeof(D2D1_TRIANGLE)));
+
+        f.ExpectOneTessellateCall(sc_identityD2DTransform, D2D1_DEFAULT_FLATTENING_TOLERANCE);
+
+        UINT32 count;
+        ThrowIfFailed(f.RectangleGeometry->TessellateWithBuffer(buffer.Get(), &count));
+
+        Assert::AreEqual(3u, count);
+        f.ValidateTessellatedTriangles(buffer.Get());
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_TessellateWithBufferAndTransformAndFlatteningTolerance)
+    {
+        TessellateFixture f;
+        auto buffer = Make<StubBuffer>(1000u);
+
+        const float expectedTolerance = 23;
+
+        f.ExpectOneTessellateCall(sc_someD2DTransform, expectedTolerance);
+
+        UINT32 count;
+        ThrowIfFailed(f.RectangleGeometry->TessellateWithBufferAndTransformAndFlatteningTolerance(buffer.Get(), sc_someTransform, expectedTolerance, &count));
+
+        Assert::AreEqual(3u, count);
+        f.ValidateTessellatedTriangles(buffer.Get());
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_TessellateWithBuffer_WhenBufferTooSmall_ReportsRequiredCountAndEmptiesBuffer)
+    {
+        TessellateFixture f;
+        auto buffer = Make<StubBuffer>(static_cast<uint32_t>(3 * sizeof(D2D1_TRIANGLE) - 1));
+        ThrowIfFailed(buffer->put_Length(10));
+
+        f.ExpectOneTessellateCall(sc_identityD2DTransform, D2D1_DEFAULT_FLATTENING_TOLERANCE);
+
+        UINT32 count;
+        ThrowIfFailed(f.RectangleGeometry->TessellateWithBuffer(buffer.Get(), &count));
+
+        Assert::AreEqual(3u, count);
+
+        UINT32 length;
+        ThrowIfFailed(buffer->get_Length(&length));
+        Assert::AreEqual(0u, length);
+    }
+
     TEST_METHOD_EX(CanvasGeometry_Tessellate_NullArgs)
     {
         GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
         ComArray<CanvasTriangleVertices> t;
+        auto buffer = Make<StubBuffer>(0u);
+        UINT32 count;
 
         Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->Tessellate(nullptr, t.GetAddressOfData()));
         Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->Tessellate(t.GetAddressOfSize(), nullptr));
 
         Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->TessellateWithTransformAndFlatteningTolerance(Matrix3x2{}, 0, nullptr, t.GetAddressOfData()));
         Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->TessellateWithTransformAndFlatteningTolerance(Matrix3x2{}, 0, t.GetAddressOfSize(), nullptr));
+
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->TessellateWithBuffer(nullptr, &count));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->TessellateWithBuffer(buffer.Get(), nullptr));
+
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->TessellateWithBufferAndTransformAndFlatteningTolerance(nullptr, Matrix3x2{}, 0, &count));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->TessellateWithBufferAndTransformAndFlatteningTolerance(buffer.Get(), Matrix3x2{}, 0, nullptr));
+    }
+
+    static void AddSquareToSink(ID2D1SimplifiedGeometrySink* sink, float left, float top, float size)
+    {
+        D2D1_POINT_2F points[] =
+        {
+            { left + size, top },
+            { left + size, top + size },
+            { left, top + size },
+        };
+
+        sink->BeginFigure(D2D1_POINT_2F{ left, top }, D2D1_FIGURE_BEGIN_FILLED);
+        sink->AddLines(points, _countof(points));
+        sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+    }
+
+    static void ExpectOneSimplifyCall(GeometryOperationsFixture_DoesNotOutputToTempPathBuilder& f, D2D1_MATRIX_3X2_F expectedTransform, float expectedFlatteningTolerance)
+    {
+        f.D2DRectangleGeometry->SimplifyMethod.SetExpectedCalls(1,
+            [=](D2D1_GEOMETRY_SIMPLIFICATION_OPTION simplification, CONST D2D1_MATRIX_3X2_F* transform, FLOAT tol, ID2D1SimplifiedGeometrySink* sink)
+            {
+                Assert::AreEqual(D2D1_GEOMETRY_SIMPLIFICATION_OPTION_LINES, simplification);
+                Assert::AreEqual(expectedTransform, *transform);
+                Assert::AreEqual(expectedFlatteningTolerance, tol);
+
+                AddSquareToSink(sink, 0, 0, 10);
+                return S_OK;
+            });
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_FillContainsPoints)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        ExpectOneSimplifyCall(f, sc_identityD2DTransform, D2D1_DEFAULT_FLATTENING_TOLERANCE);
+
+        Vector2 points[] = { { 5, 5 }, { 15, 5 }, { 1, 9 } };
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->FillContainsPoints(_countof(points), points, results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        Assert::AreEqual(3u, results.GetSize());
+        Assert::IsTrue(!!results[0]);
+        Assert::IsFalse(!!results[1]);
+        Assert::IsTrue(!!results[2]);
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_FillContainsPointsWithTransformAndFlatteningTolerance)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        ExpectOneSimplifyCall(f, sc_someD2DTransform, 2.0f);
+
+        Vector2 points[] = { { 5, 5 } };
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(_countof(points), points, sc_someTransform, 2.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        Assert::AreEqual(1u, results.GetSize());
+        Assert::IsTrue(!!results[0]);
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_FillContainsPoints_ReusesFlattenedGeometryForSameTransformAndTolerance)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        ExpectOneSimplifyCall(f, sc_someD2DTransform, 2.0f);
+
+        Vector2 points[] = { { 5, 5 } };
+        float distances[] = { 5 };
+
+        for (int i = 0; i < 3; i++)
+        {
+            ComArray<boolean> results;
+            Assert::AreEqual(S_OK, f.RectangleGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(_countof(points), points, sc_someTransform, 2.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+            Assert::IsTrue(!!results[0]);
+        }
+
+        // Path queries flatten the same way, so share the cached copy.
+        ComArray<Vector2> pathPoints;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->ComputePointsOnPathWithTransformAndFlatteningTolerance(_countof(distances), distances, sc_someTransform, 2.0f, pathPoints.GetAddressOfSize(), pathPoints.GetAddressOfData()));
+
+        // A different tolerance needs flattening again.
+        ExpectOneSimplifyCall(f, sc_someD2DTransform, 1.0f);
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(_countof(points), points, sc_someTransform, 1.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_FillContainsPoints_PointsWithinToleranceOfTheEdgeAreInside)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        ExpectOneSimplifyCall(f, sc_identityD2DTransform, 1.0f);
+
+        Vector2 points[] = { { 10.5f, 5 }, { 11.5f, 5 } };
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(_countof(points), points, Matrix3x2{ 1, 0, 0, 1, 0, 0 }, 1.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        Assert::IsTrue(!!results[0]);
+        Assert::IsFalse(!!results[1]);
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_FillContainsPoints_WhenNoPoints_DoesNotCallD2D)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->FillContainsPoints(0, nullptr, results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        Assert::AreEqual(0u, results.GetSize());
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_FillContainsPoints_NullArgs)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        Vector2 point{};
+        ComArray<boolean> results;
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->FillContainsPoints(1, nullptr, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->FillContainsPoints(1, &point, nullptr, results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->FillContainsPoints(1, &point, results.GetAddressOfSize(), nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(1, nullptr, Matrix3x2{}, 0, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(1, &point, Matrix3x2{}, 0, nullptr, results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(1, &point, Matrix3x2{}, 0, results.GetAddressOfSize(), nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_StrokeContainsPoints)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        f.D2DRectangleGeometry->WidenMethod.SetExpectedCalls(1,
+            [=](FLOAT strokeWidth, ID2D1StrokeStyle* strokeStyle, CONST D2D1_MATRIX_3X2_F* transform, FLOAT tol, ID2D1SimplifiedGeometrySink* sink)
+            {
+                Assert::AreEqual(5.0f, strokeWidth);
+                Assert::IsNull(strokeStyle);
+                Assert::IsNull(transform);
+                Assert::AreEqual(D2D1_DEFAULT_FLATTENING_TOLERANCE, tol);
+
+                // Widened outlines overlap themselves, so the overlap must
+                // still count as inside even if D2D asks for alternate fill.
+                sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
+                AddSquareToSink(sink, 0, 0, 10);
+                AddSquareToSink(sink, 5, 0, 10);
+                return S_OK;
+            });
+
+        Vector2 points[] = { { 2, 5 }, { 7, 5 }, { 20, 5 } };
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->StrokeContainsPoints(_countof(points), points, 5.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        Assert::AreEqual(3u, results.GetSize());
+        Assert::IsTrue(!!results[0]);
+        Assert::IsTrue(!!results[1]);
+        Assert::IsFalse(!!results[2]);
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_StrokeContainsPointsWithStrokeStyle)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        f.D2DRectangleGeometry->WidenMethod.SetExpectedCalls(1,
+            [=](FLOAT strokeWidth, ID2D1StrokeStyle* strokeStyle, CONST D2D1_MATRIX_3X2_F* transform, FLOAT tol, ID2D1SimplifiedGeometrySink* sink)
+            {
+                Assert::AreEqual(5.0f, strokeWidth);
+                Assert::IsNotNull(strokeStyle);
+                Assert::IsNull(transform);
+                Assert::AreEqual(D2D1_DEFAULT_FLATTENING_TOLERANCE, tol);
+
+                AddSquareToSink(sink, 0, 0, 10);
+                return S_OK;
+            });
+
+        Vector2 points[] = { { 5, 5 } };
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->StrokeContainsPointsWithStrokeStyle(_countof(points), points, 5.0f, f.StrokeStyle.Get(), results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        Assert::AreEqual(1u, results.GetSize());
+        Assert::IsTrue(!!results[0]);
+        f.VerifyStrokeStyle();
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_StrokeContainsPointsWithAllOptions)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        f.D2DRectangleGeometry->WidenMethod.SetExpectedCalls(1,
+            [=](FLOAT strokeWidth, ID2D1StrokeStyle* strokeStyle, CONST D2D1_MATRIX_3X2_F* transform, FLOAT tol, ID2D1SimplifiedGeometrySink* sink)
+            {
+                Assert::AreEqual(5.0f, strokeWidth);
+                Assert::IsNotNull(strokeStyle);
+                Assert::AreEqual(sc_someD2DTransform, *transform);
+                Assert::AreEqual(2.0f, tol);
+
+                AddSquareToSink(sink, 0, 0, 10);
+                return S_OK;
+            });
+
+        Vector2 points[] = { { 5, 5 } };
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->StrokeContainsPointsWithAllOptions(_countof(points), points, 5.0f, f.StrokeStyle.Get(), sc_someTransform, 2.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        Assert::AreEqual(1u, results.GetSize());
+        Assert::IsTrue(!!results[0]);
+        f.VerifyStrokeStyle();
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_StrokeContainsPoints_ReusesWidenedGeometryForSameArguments)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        auto expectOneWidenCall = [&](float expectedStrokeWidth)
+        {
+            f.D2DRectangleGeometry->WidenMethod.SetExpectedCalls(1,
+                [=](FLOAT strokeWidth, ID2D1StrokeStyle*, CONST D2D1_MATRIX_3X2_F*, FLOAT, ID2D1SimplifiedGeometrySink* sink)
+                {
+                    Assert::AreEqual(expectedStrokeWidth, strokeWidth);
+
+                    AddSquareToSink(sink, 0, 0, 10);
+                    return S_OK;
+                });
+        };
+
+        expectOneWidenCall(5.0f);
+
+        Vector2 points[] = { { 5, 5 } };
+
+        for (int i = 0; i < 3; i++)
+        {
+            ComArray<boolean> results;
+            Assert::AreEqual(S_OK, f.RectangleGeometry->StrokeContainsPoints(_countof(points), points, 5.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+            Assert::IsTrue(!!results[0]);
+        }
+
+        // Fill queries don't disturb the cached stroke.
+        ExpectOneSimplifyCall(f, sc_identityD2DTransform, D2D1_DEFAULT_FLATTENING_TOLERANCE);
+
+        ComArray<boolean> fillResults;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->FillContainsPoints(_countof(points), points, fillResults.GetAddressOfSize(), fillResults.GetAddressOfData()));
+
+        ComArray<boolean> results;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->StrokeContainsPoints(_countof(points), points, 5.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+
+        // A different stroke width needs widening again.
+        expectOneWidenCall(3.0f);
+
+        Assert::AreEqual(S_OK, f.RectangleGeometry->StrokeContainsPoints(_countof(points), points, 3.0f, results.GetAddressOfSize(), results.GetAddressOfData()));
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_StrokeContainsPoints_NullArgs)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        Vector2 point{};
+        ComArray<boolean> results;
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPoints(1, nullptr, 0, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPoints(1, &point, 0, nullptr, results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPoints(1, &point, 0, results.GetAddressOfSize(), nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPointsWithStrokeStyle(1, &point, 0, nullptr, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPointsWithStrokeStyle(1, nullptr, 0, f.StrokeStyle.Get(), results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPointsWithAllOptions(1, &point, 0, nullptr, Matrix3x2{}, 0, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPointsWithAllOptions(1, nullptr, 0, f.StrokeStyle.Get(), Matrix3x2{}, 0, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->StrokeContainsPointsWithAllOptions(1, &point, 0, f.StrokeStyle.Get(), Matrix3x2{}, 0, nullptr, results.GetAddressOfData()));
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_ComputePointsOnPath)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        ExpectOneSimplifyCall(f, sc_identityD2DTransform, D2D1_DEFAULT_FLATTENING_TOLERANCE);
+
+        float distances[] = { 0, 5, 15, 35, 100 };
+
+        ComArray<Vector2> points;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->ComputePointsOnPath(_countof(distances), distances, points.GetAddressOfSize(), points.GetAddressOfData()));
+
+        Assert::AreEqual(5u, points.GetSize());
+        Assert::AreEqual(Vector2{ 0, 0 }, points[0]);
+        Assert::AreEqual(Vector2{ 5, 0 }, points[1]);
+        Assert::AreEqual(Vector2{ 10, 5 }, points[2]);
+        Assert::AreEqual(Vector2{ 0, 5 }, points[3]);
+        Assert::AreEqual(Vector2{ 0, 0 }, points[4]);
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_ComputePointsOnPathWithTransformAndFlatteningTolerance)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        ExpectOneSimplifyCall(f, sc_someD2DTransform, 2.0f);
+
+        float distances[] = { 5 };
+
+        ComArray<Vector2> points;
+        Assert::AreEqual(S_OK, f.RectangleGeometry->ComputePointsOnPathWithTransformAndFlatteningTolerance(_countof(distances), distances, sc_someTransform, 2.0f, points.GetAddressOfSize(), points.GetAddressOfData()));
+
+        Assert::AreEqual(1u, points.GetSize());
+        Assert::AreEqual(Vector2{ 5, 0 }, points[0]);
+    }
+
+    TEST_METHOD_EX(CanvasGeometry_ComputePointsOnPath_NullArgs)
+    {
+        GeometryOperationsFixture_DoesNotOutputToTempPathBuilder f;
+
+        float distance = 0;
+        ComArray<Vector2> points;
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->ComputePointsOnPath(1, nullptr, points.GetAddressOfSize(), points.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->ComputePointsOnPath(1, &distance, nullptr, points.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->ComputePointsOnPath(1, &distance, points.GetAddressOfSize(), nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->ComputePointsOnPathWithTransformAndFlatteningTolerance(1, nullptr, Matrix3x2{}, 0, points.GetAddressOfSize(), points.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->ComputePointsOnPathWithTransformAndFlatteningTolerance(1, &distance, Matrix3x2{}, 0, nullptr, points.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, f.RectangleGeometry->ComputePointsOnPathWithTransformAndFlatteningTolerance(1, &distance, Matrix3x2{}, 0, points.GetAddressOfSize(), nullptr));
     }
 
     TEST_METHOD_EX(CanvasGeometry_Closure)
@@ -1289,6 +1747,23 @@ public:
         Assert::AreEqual(RO_E_CLOSED, canvasGeometry->Tessellate(t.GetAddressOfSize(), t.GetAddressOfData()));
         Assert::AreEqual(RO_E_CLOSED, canvasGeometry->TessellateWithTransformAndFlatteningTolerance(m, 0, t.GetAddressOfSize(), t.GetAddressOfData()));
 
+        auto buffer = Make<StubBuffer>(0u);
+        UINT32 count;
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->TessellateWithBuffer(buffer.Get(), &count));
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->TessellateWithBufferAndTransformAndFlatteningTolerance(buffer.Get(), m, 0, &count));
+
+        Vector2 points[] = { Vector2{} };
+        float distances[] = { 0 };
+        ComArray<boolean> results;
+        ComArray<Vector2> pointsOnPath;
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->FillContainsPoints(1, points, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->FillContainsPointsWithTransformAndFlatteningTolerance(1, points, m, 0, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->StrokeContainsPoints(1, points, 0, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->StrokeContainsPointsWithStrokeStyle(1, points, 0, strokeStyle.Get(), results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->StrokeContainsPointsWithAllOptions(1, points, 0, strokeStyle.Get(), m, 0, results.GetAddressOfSize(), results.GetAddressOfData()));
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->ComputePointsOnPath(1, distances, pointsOnPath.GetAddressOfSize(), pointsOnPath.GetAddressOfData()));
+        Assert::AreEqual(RO_E_CLOSED, canvasGeometry->ComputePointsOnPathWithTransformAndFlatteningTolerance(1, distances, m, 0, pointsOnPath.GetAddressOfSize(), pointsOnPath.GetAddressOfData()));
+
         auto geometrySink = Make<StubGeometrySink>();
         Assert::AreEqual(RO_E_CLOSED, canvasGeometry->SendPathTo(geometrySink.Get()));
 
@@ -0,0 +1,428 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <lib/drawing/CanvasRetainedSpriteBatch.h>
+#include "../mocks/MockD2DSpriteBatch.h"
+
+
+static ComPtr<ICanvasRetainedSpriteBatchFactory> GetRetainedSpriteBatchFactory()
+{
+    ComPtr<ICanvasRetainedSpriteBatchFactory> factory;
+    ThrowIfFailed(MakeAndInitialize<CanvasRetainedSpriteBatchFactory>(&factory));
+    return factory;
+}
+
+
+TEST_CLASS(CanvasRetainedSpriteBatchUnitTests)
+{
+public:
+
+    struct Fixture
+    {
+        ComPtr<StubCanvasDevice> Device;
+        ComPtr<MockD2DSpriteBatch> D2DSpriteBatch;
+        ComPtr<StubD2DBitmap> D2DBitmap;
+        ComPtr<CanvasBitmap> Bitmap;
+        ComPtr<MockD2DDeviceContext> DeviceContext;
+        ComPtr<CanvasDrawingSession> DrawingSession;
+
+        Fixture()
+            : Device(Make<StubCanvasDevice>())
+            , D2DSpriteBatch(Make<MockD2DSpriteBatch>())
+            , D2DBitmap(Make<StubD2DBitmap>(D2D1_BITMAP_OPTIONS_NONE, DEFAULT_DPI * 2))
+            , Bitmap(CreateStubCanvasBitmap(Device.Get(), D2DBitmap.Get()))
+            , DeviceContext(Make<MockD2DDeviceContext>())
+            , DrawingSession(Make<CanvasDrawingSession>(DeviceContext.Get(), nullptr, Device.Get()))
+        {
+            D2DBitmap->GetPixelSizeMethod.AllowAnyCall([] { return D2D1_SIZE_U{ 200U, 100U }; });
+
+            Device->CreateSpriteBatchMethod.AllowAnyCall([=] { return D2DSpriteBatch; });
+            Device->IsSpriteBatchQuirkRequiredMethod.AllowAnyCall([] { return false; });
+
+            DeviceContext->GetUnitModeMethod.AllowAnyCall([] { return D2D1_UNIT_MODE_DIPS; });
+            DeviceContext->GetAntialiasModeMethod.AllowAnyCall([] { return D2D1_ANTIALIAS_MODE_ALIASED; });
+        }
+
+        ComPtr<ICanvasRetainedSpriteBatch> Create(
+            CanvasImageInterpolation interpolation = CanvasImageInterpolation::Linear,
+            CanvasSpriteOptions options = CanvasSpriteOptions::None)
+        {
+            ComPtr<ICanvasRetainedSpriteBatch> spriteBatch;
+            ThrowIfFailed(GetRetainedSpriteBatchFactory()->CreateWithInterpolationAndOptions(Device.Get(), Bitmap.Get(), interpolation, options, &spriteBatch));
+            return spriteBatch;
+        }
+
+        void SetSpriteCount(uint32_t count)
+        {
+            D2DSpriteBatch->GetSpriteCountMethod.AllowAnyCall([=] { return count; });
+        }
+    };
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_Create_FailsWhenPassedNullParameters)
+    {
+        Fixture f;
+        auto factory = GetRetainedSpriteBatchFactory();
+
+        ComPtr<ICanvasRetainedSpriteBatch> spriteBatch;
+
+        Assert::AreEqual(E_INVALIDARG, factory->Create(nullptr, f.Bitmap.Get(), &spriteBatch));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(f.Device.Get(), nullptr, &spriteBatch));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(f.Device.Get(), f.Bitmap.Get(), nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_Create_FailsWhenPassedInvalidInterpolationOrOptions)
+    {
+        Fixture f;
+        auto factory = GetRetainedSpriteBatchFactory();
+
+        ComPtr<ICanvasRetainedSpriteBatch> spriteBatch;
+
+        Assert::AreEqual(E_INVALIDARG, factory->CreateWithInterpolationAndOptions(f.Device.Get(), f.Bitmap.Get(), CanvasImageInterpolation::HighQualityCubic, CanvasSpriteOptions::None, &spriteBatch));
+        ValidateStoredErrorState(E_INVALIDARG, Strings::SpriteBatchInvalidInterpolation);
+
+        Assert::AreEqual(E_INVALIDARG, factory->CreateWithInterpolationAndOptions(f.Device.Get(), f.Bitmap.Get(), CanvasImageInterpolation::Linear, static_cast<CanvasSpriteOptions>(2), &spriteBatch));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_Create_CreatesSpriteBatchFromDevice)
+    {
+        Fixture f;
+        f.Device->CreateSpriteBatchMethod.SetExpectedCalls(1, [&] { return f.D2DSpriteBatch; });
+
+        auto spriteBatch = f.Create();
+
+        ComPtr<ICanvasBitmap> bitmap;
+        ThrowIfFailed(spriteBatch->get_Bitmap(&bitmap));
+        Assert::IsTrue(IsSameInstance(f.Bitmap.Get(), bitmap.Get()));
+
+        ComPtr<ICanvasDevice> device;
+        ThrowIfFailed(spriteBatch->get_Device(&device));
+        Assert::IsTrue(IsSameInstance(f.Device.Get(), device.Get()));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_MethodsFail_AfterClosed)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+
+        ThrowIfFailed(As<IClosable>(spriteBatch)->Close());
+
+        Rect rect{};
+        int32_t count;
+        ComPtr<ICanvasBitmap> bitmap;
+        ComPtr<ICanvasDevice> device;
+
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->get_SpriteCount(&count));
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->get_Bitmap(&bitmap));
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->get_Device(&device));
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->AddSprites(1, &rect, 0, nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->SetSprites(0, 1, &rect, 0, nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->Clear());
+        Assert::AreEqual(RO_E_CLOSED, f.DrawingSession->DrawRetainedSpriteBatch(spriteBatch.Get()));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_AddSprites_FailsWhenArraySizesDoNotMatch)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+
+        Rect rects[2]{};
+        Vector4 tints[3]{};
+
+        Assert::AreEqual(E_INVALIDARG, spriteBatch->AddSprites(2, rects, 0, nullptr, 3, tints, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, spriteBatch->AddSprites(2, rects, 1, rects, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, spriteBatch->AddSprites(2, nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_AddSprites_PassesOnlyProvidedArraysToD2D)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+
+        Rect destRects[] = { Rect{ 1, 2, 3, 4 }, Rect{ 5, 6, 7, 8 } };
+        Vector4 tints[] = { Vector4{ 1, 0, 0, 1 }, Vector4{ 0, 1, 0, 1 } };
+
+        f.D2DSpriteBatch->AddSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32 count, D2D1_RECT_F const* d2dDestRects, D2D1_RECT_U const* sourceRects, D2D1_COLOR_F const* colors, D2D1_MATRIX_3X2_F const* transforms, UINT32, UINT32, UINT32, UINT32)
+            {
+                Assert::AreEqual(2U, count);
+                Assert::AreEqual(D2D1_RECT_F{ 1, 2, 4, 6 }, d2dDestRects[0]);
+                Assert::AreEqual(D2D1_RECT_F{ 5, 6, 12, 14 }, d2dDestRects[1]);
+                Assert::IsNull(sourceRects);
+                Assert::IsNull(transforms);
+                Assert::AreEqual(D2D1_COLOR_F{ 0, 1, 0, 1 }, colors[1]);
+                return S_OK;
+            });
+
+        ThrowIfFailed(spriteBatch->AddSprites(2, destRects, 0, nullptr, 2, tints, 0, nullptr, 0, nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_AddSprites_SourceRectsAreConvertedToPixelsAndFlipped)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+
+        Rect destRects[] = { Rect{}, Rect{} };
+        Rect sourceRects[] = { Rect{ 1, 2, 3, 4 }, Rect{ 1, 2, 3, 4 } };
+        CanvasSpriteFlip flips[] = { CanvasSpriteFlip::None, CanvasSpriteFlip::Horizontal };
+
+        f.D2DSpriteBatch->AddSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32, D2D1_RECT_F const*, D2D1_RECT_U const* d2dSourceRects, D2D1_COLOR_F const*, D2D1_MATRIX_3X2_F const*, UINT32, UINT32, UINT32, UINT32)
+            {
+                Assert::AreEqual(D2D1_RECT_U{ 2, 4, 8, 12 }, d2dSourceRects[0]);
+                Assert::AreEqual(D2D1_RECT_U{ 8, 4, 2, 12 }, d2dSourceRects[1]);
+                return S_OK;
+            });
+
+        ThrowIfFailed(spriteBatch->AddSprites(2, destRects, 2, sourceRects, 0, nullptr, 0, nullptr, 2, flips));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_AddSprites_FlipsWithoutSourceRectsUseWholeBitmap)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+
+        Rect destRects[] = { Rect{} };
+        CanvasSpriteFlip flips[] = { CanvasSpriteFlip::Vertical };
+
+        f.D2DSpriteBatch->AddSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32, D2D1_RECT_F const*, D2D1_RECT_U const* d2dSourceRects, D2D1_COLOR_F const*, D2D1_MATRIX_3X2_F const*, UINT32, UINT32, UINT32, UINT32)
+            {
+                Assert::AreEqual(D2D1_RECT_U{ 0, 100, 200, 0 }, d2dSourceRects[0]);
+                return S_OK;
+            });
+
+        ThrowIfFailed(spriteBatch->AddSprites(1, destRects, 0, nullptr, 0, nullptr, 0, nullptr, 1, flips));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_SetSprites_OnlyUpdatesProvidedArrays)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(10);
+
+        Matrix3x2 transforms[] = { Matrix3x2{ 1, 2, 3, 4, 5, 6 }, Matrix3x2{ 6, 5, 4, 3, 2, 1 } };
+
+        f.D2DSpriteBatch->SetSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32 startIndex, UINT32 count, D2D1_RECT_F const* destRects, D2D1_RECT_U const* sourceRects, D2D1_COLOR_F const* colors, D2D1_MATRIX_3X2_F const* d2dTransforms, UINT32, UINT32, UINT32, UINT32)
+            {
+                Assert::AreEqual(7U, startIndex);
+                Assert::AreEqual(2U, count);
+                Assert::IsNull(destRects);
+                Assert::IsNull(sourceRects);
+                Assert::IsNull(colors);
+                Assert::AreEqual(6.0f, d2dTransforms[1]._11);
+                return S_OK;
+            });
+
+        ThrowIfFailed(spriteBatch->SetSprites(7, 0, nullptr, 0, nullptr, 0, nullptr, 2, transforms, 0, nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_SetSprites_FlipsWithoutSourceRectsKeepCurrentSourceRects)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(10);
+
+        // The first sprite is currently horizontally flipped.
+        D2D1_RECT_U currentSourceRects[] = { { 8, 4, 2, 12 }, { 0, 0, 200, 100 } };
+
+        f.D2DSpriteBatch->GetSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32 startIndex, UINT32 count, D2D1_RECT_F* destRects, D2D1_RECT_U* sourceRects, D2D1_COLOR_F* colors, D2D1_MATRIX_3X2_F* transforms)
+            {
+                Assert::AreEqual(3U, startIndex);
+                Assert::AreEqual(2U, count);
+                Assert::IsNull(destRects);
+                Assert::IsNull(colors);
+                Assert::IsNull(transforms);
+                std::copy(currentSourceRects, currentSourceRects + count, sourceRects);
+                return S_OK;
+            });
+
+        CanvasSpriteFlip flips[] = { CanvasSpriteFlip::Vertical, CanvasSpriteFlip::Both };
+
+        f.D2DSpriteBatch->SetSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32, UINT32, D2D1_RECT_F const*, D2D1_RECT_U const* d2dSourceRects, D2D1_COLOR_F const*, D2D1_MATRIX_3X2_F const*, UINT32, UINT32, UINT32, UINT32)
+            {
+                Assert::AreEqual(D2D1_RECT_U{ 2, 12, 8, 4 }, d2dSourceRects[0]);
+                Assert::AreEqual(D2D1_RECT_U{ 200, 100, 0, 0 }, d2dSourceRects[1]);
+                return S_OK;
+            });
+
+        ThrowIfFailed(spriteBatch->SetSprites(3, 0, nullptr, 0, nullptr, 0, nullptr, 0, nullptr, 2, flips));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_SetSprites_SourceRectsWithoutFlipsKeepCurrentFlips)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(10);
+
+        D2D1_RECT_U currentSourceRects[] = { { 8, 4, 2, 12 }, { 0, 100, 200, 0 } };
+
+        f.D2DSpriteBatch->GetSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32, UINT32 count, D2D1_RECT_F*, D2D1_RECT_U* sourceRects, D2D1_COLOR_F*, D2D1_MATRIX_3X2_F*)
+            {
+                std::copy(currentSourceRects, currentSourceRects + count, sourceRects);
+                return S_OK;
+            });
+
+        Rect sourceRects[] = { Rect{ 0, 0, 5, 5 }, Rect{ 1, 2, 3, 4 } };
+
+        f.D2DSpriteBatch->SetSpritesMethod.SetExpectedCalls(1,
+            [&] (UINT32, UINT32, D2D1_RECT_F const*, D2D1_RECT_U const* d2dSourceRects, D2D1_COLOR_F const*, D2D1_MATRIX_3X2_F const*, UINT32, UINT32, UINT32, UINT32)
+            {
+                Assert::AreEqual(D2D1_RECT_U{ 10, 0, 0, 10 }, d2dSourceRects[0]);
+                Assert::AreEqual(D2D1_RECT_U{ 2, 12, 8, 4 }, d2dSourceRects[1]);
+                return S_OK;
+            });
+
+        ThrowIfFailed(spriteBatch->SetSprites(0, 0, nullptr, 2, sourceRects, 0, nullptr, 0, nullptr, 0, nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_SetSprites_FailsWhenRangeIsOutOfBounds)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(10);
+
+        Vector4 tints[2]{};
+
+        Assert::AreEqual(E_BOUNDS, spriteBatch->SetSprites(9, 0, nullptr, 0, nullptr, 2, tints, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_BOUNDS, spriteBatch->SetSprites(-1, 0, nullptr, 0, nullptr, 2, tints, 0, nullptr, 0, nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_Clear_ClearsD2DSpriteBatch)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+
+        f.D2DSpriteBatch->ClearMethod.SetExpectedCalls(1);
+
+        ThrowIfFailed(spriteBatch->Clear());
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_DrawRetainedSpriteBatch_CallsDrawSpriteBatch)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create(CanvasImageInterpolation::NearestNeighbor, CanvasSpriteOptions::ClampToSourceRect);
+        f.SetSpriteCount(5);
+
+        f.DeviceContext->DrawSpriteBatchMethod.SetExpectedCalls(1,
+            [&] (ID2D1SpriteBatch* batch, UINT32 startIndex, UINT32 count, ID2D1Bitmap* bitmap, D2D1_BITMAP_INTERPOLATION_MODE interpolation, D2D1_SPRITE_OPTIONS options)
+            {
+                Assert::IsTrue(IsSameInstance(f.D2DSpriteBatch.Get(), batch));
+                Assert::AreEqual(0U, startIndex);
+                Assert::AreEqual(5U, count);
+                Assert::IsTrue(IsSameInstance(f.D2DBitmap.Get(), bitmap));
+                Assert::AreEqual(D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR, interpolation);
+                Assert::AreEqual(D2D1_SPRITE_OPTIONS_CLAMP_TO_SOURCE_RECTANGLE, options);
+            });
+
+        ThrowIfFailed(f.DrawingSession->DrawRetainedSpriteBatch(spriteBatch.Get()));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_DrawRetainedSpriteBatchRange_ValidatesRange)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(5);
+
+        f.DeviceContext->DrawSpriteBatchMethod.SetExpectedCalls(1,
+            [&] (ID2D1SpriteBatch*, UINT32 startIndex, UINT32 count, ID2D1Bitmap*, D2D1_BITMAP_INTERPOLATION_MODE, D2D1_SPRITE_OPTIONS)
+            {
+                Assert::AreEqual(2U, startIndex);
+                Assert::AreEqual(3U, count);
+            });
+
+        ThrowIfFailed(f.DrawingSession->DrawRetainedSpriteBatchRange(spriteBatch.Get(), 2, 3));
+
+        Assert::AreEqual(E_BOUNDS, f.DrawingSession->DrawRetainedSpriteBatchRange(spriteBatch.Get(), 2, 4));
+        Assert::AreEqual(E_INVALIDARG, f.DrawingSession->DrawRetainedSpriteBatchRange(spriteBatch.Get(), -1, 1));
+        Assert::AreEqual(E_INVALIDARG, f.DrawingSession->DrawRetainedSpriteBatchRange(nullptr, 0, 1));
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_DrawRetainedSpriteBatch_FailsWhenDeviceDiffers)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(1);
+
+        auto otherDevice = Make<StubCanvasDevice>();
+        auto otherDrawingSession = Make<CanvasDrawingSession>(f.DeviceContext.Get(), nullptr, otherDevice.Get());
+
+        f.DeviceContext->DrawSpriteBatchMethod.SetExpectedCalls(0);
+
+        Assert::AreEqual(E_INVALIDARG, otherDrawingSession->DrawRetainedSpriteBatchRange(spriteBatch.Get(), 0, 1));
+        ValidateStoredErrorState(E_INVALIDARG, Strings::ResourceManagerWrongDevice);
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_DrawRetainedSpriteBatch_SetsAndRestoresDeviceContextState)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(1);
+
+        f.DeviceContext->GetUnitModeMethod.SetExpectedCalls(1, [] { return D2D1_UNIT_MODE_PIXELS; });
+        f.DeviceContext->GetAntialiasModeMethod.SetExpectedCalls(1, [] { return D2D1_ANTIALIAS_MODE_PER_PRIMITIVE; });
+
+        std::vector<D2D1_UNIT_MODE> unitModes;
+        std::vector<D2D1_ANTIALIAS_MODE> antialiasModes;
+
+        f.DeviceContext->SetUnitModeMethod.SetExpectedCalls(2, [&] (D2D1_UNIT_MODE mode) { unitModes.push_back(mode); });
+        f.DeviceContext->SetAntialiasModeMethod.SetExpectedCalls(2, [&] (D2D1_ANTIALIAS_MODE mode) { antialiasModes.push_back(mode); });
+        f.DeviceContext->DrawSpriteBatchMethod.SetExpectedCalls(1);
+
+        ThrowIfFailed(f.DrawingSession->DrawRetainedSpriteBatch(spriteBatch.Get()));
+
+        Assert::IsTrue(unitModes == std::vector<D2D1_UNIT_MODE>{ D2D1_UNIT_MODE_DIPS, D2D1_UNIT_MODE_PIXELS });
+        Assert::IsTrue(antialiasModes == std::vector<D2D1_ANTIALIAS_MODE>{ D2D1_ANTIALIAS_MODE_ALIASED, D2D1_ANTIALIAS_MODE_PER_PRIMITIVE });
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_WhenQuirkRequired_DrawsAreNotLargerThan256)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(1000);
+
+        f.Device->IsSpriteBatchQuirkRequiredMethod.AllowAnyCall([] { return true; });
+
+        std::vector<std::pair<UINT32, UINT32>> draws;
+
+        f.DeviceContext->DrawSpriteBatchMethod.SetExpectedCalls(3,
+            [&] (ID2D1SpriteBatch*, UINT32 startIndex, UINT32 count, ID2D1Bitmap*, D2D1_BITMAP_INTERPOLATION_MODE, D2D1_SPRITE_OPTIONS)
+            {
+                draws.emplace_back(startIndex, count);
+            });
+        f.DeviceContext->FlushMethod.SetExpectedCalls(3);
+
+        ThrowIfFailed(f.DrawingSession->DrawRetainedSpriteBatchRange(spriteBatch.Get(), 300, 700));
+
+        Assert::IsTrue(draws == std::vector<std::pair<UINT32, UINT32>>{ { 300, 256 }, { 556, 256 }, { 812, 188 } });
+    }
+
+    TEST_METHOD_EX(CanvasRetainedSpriteBatch_DrawRetainedSpriteBatch_FailsWhenSpriteBatchNotSupported)
+    {
+        Fixture f;
+        auto spriteBatch = f.Create();
+        f.SetSpriteCount(1);
+
+        struct DeviceContextWithoutSpriteBatch : public MockD2DDeviceContext
+        {
+            STDMETHOD(QueryInterface)(REFIID riid, _Outptr_result_nullonfailure_ void **ppvObject)
+            {
+                if (riid == __uuidof(ID2D1DeviceContext3))
+                    return E_NOINTERFACE;
+
+                return RuntimeClass::QueryInterface(riid, ppvObject);
+            }
+        };
+
+        auto drawingSession = Make<CanvasDrawingSession>(Make<DeviceContextWithoutSpriteBatch>().Get());
+
+        Assert::AreEqual(E_NOTIMPL, drawingSession->DrawRetainedSpriteBatch(spriteBatch.Get()));
+        ValidateStoredErrorState(E_NOTIMPL, Strings::SpriteBatchNotAvailable);
+    }
+};
@@ -7,6 +7,7 @@
 #include <WindowsNumerics.h>
 
 #include <lib/drawing/CanvasSpriteBatch.h>
+#include "utils/BenchmarkTimer.h"
 #include "../mocks/MockD2DSpriteBatch.h"
 
 using namespace Windows::Foundation::Numerics;
@@ -47,7 +48,10 @@ static ComPtr<CanvasDevice> MakeCanvasDeviceThatDoesNotSupportSpriteBatch()
 static CanvasSpriteSortMode gSortModes[] =
 {
     CanvasSpriteSortMode::None,
-    CanvasSpriteSortMode::Bitmap
+    CanvasSpriteSortMode::Bitmap,
+    CanvasSpriteSortMode::BackToFront,
+    CanvasSpriteSortMode::FrontToBack,
+    CanvasSpriteSortMode::BitmapAndDepth
 };
 
 
@@ -1374,6 +1378,26 @@ public:
             ThrowIfFailed(SpriteBatch->DrawAtOffset(bitmap.second.Get(), float2(id)));
         }
 
+        void Add(std::pair<ComPtr<StubD2DBitmap>, ComPtr<CanvasBitmap>> const& bitmap, float id, float depth)
+        {
+            ThrowIfFailed(SpriteBatch->put_Depth(depth));
+            Add(bitmap, id);
+        }
+
+        void AddDepthSortTestSprites()
+        {
+            // Ensure that Bitmaps is sorted by the D2D bitmap pointer, since
+            // sprites of equal depth are ordered by this.
+            std::sort(Bitmaps.begin(), Bitmaps.end());
+
+            Add(Bitmaps[1], 0, 1);
+            Add(Bitmaps[0], 1, 1);
+            Add(Bitmaps[2], 2, 3);
+            Add(Bitmaps[0], 3, 1);
+            Add(Bitmaps[3], 4, 2);
+            Add(Bitmaps[0], 5, 5);
+        }
+
         void Expect(float id)
         {
             ExpectedSprites.Expect(id);
@@ -1520,6 +1544,155 @@ public:
         f.Validate();
     }
 
+    TEST_METHOD_EX(CanvasSpriteBatch_WhenSortedBackToFront_SpritesOfEqualDepthAreGroupedByBitmap)
+    {
+        MultipleBitmapFixture f(CanvasSpriteSortMode::BackToFront);
+        f.AddDepthSortTestSprites();
+
+        for (auto id : { 5, 2, 4, 1, 3, 0 })
+            f.Expect((float)id);
+
+        f.ExpectBatches(
+        {
+            { f.Bitmaps[0], 0, 1 },
+            { f.Bitmaps[2], 1, 1 },
+            { f.Bitmaps[3], 2, 1 },
+            { f.Bitmaps[0], 3, 2 },
+            { f.Bitmaps[1], 5, 1 }
+        });
+
+        f.Validate();
+    }
+
+    TEST_METHOD_EX(CanvasSpriteBatch_WhenSortedFrontToBack_SpritesOfEqualDepthAreGroupedByBitmap)
+    {
+        MultipleBitmapFixture f(CanvasSpriteSortMode::FrontToBack);
+        f.AddDepthSortTestSprites();
+
+        for (auto id : { 1, 3, 0, 4, 2, 5 })
+            f.Expect((float)id);
+
+        f.ExpectBatches(
+        {
+            { f.Bitmaps[0], 0, 2 },
+            { f.Bitmaps[1], 2, 1 },
+            { f.Bitmaps[3], 3, 1 },
+            { f.Bitmaps[2], 4, 1 },
+            { f.Bitmaps[0], 5, 1 }
+        });
+
+        f.Validate();
+    }
+
+    TEST_METHOD_EX(CanvasSpriteBatch_WhenSortedByBitmapAndDepth_SpritesWithTheSameBitmapAreSortedBackToFront)
+    {
+        MultipleBitmapFixture f(CanvasSpriteSortMode::BitmapAndDepth);
+        f.AddDepthSortTestSprites();
+
+        for (auto id : { 5, 1, 3, 0, 2, 4 })
+            f.Expect((float)id);
+
+        f.ExpectBatches(
+        {
+            { f.Bitmaps[0], 0, 3 },
+            { f.Bitmaps[1], 3, 1 },
+            { f.Bitmaps[2], 4, 1 },
+            { f.Bitmaps[3], 5, 1 }
+        });
+
+        f.Validate();
+    }
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DepthSort_HandlesNegativeAndSignedZeroDepths)
+    {
+        MultipleBitmapFixture f(CanvasSpriteSortMode::FrontToBack);
+
+        f.Add(f.Bitmaps[0], 0, 0.5f);
+        f.Add(f.Bitmaps[0], 1, -2.0f);
+        f.Add(f.Bitmaps[0], 2, 0.0f);
+        f.Add(f.Bitmaps[0], 3, -1.0f);
+        f.Add(f.Bitmaps[0], 4, -0.0f);
+
+        // 0 and -0 are equal, so they stay in the order they were drawn
+        for (auto id : { 1, 3, 2, 4, 0 })
+            f.Expect((float)id);
+
+        f.ExpectBatches({ { f.Bitmaps[0], 0, 5 } });
+
+        f.Validate();
+    }
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DepthSort_MatchesStableSort)
+    {
+        MultipleBitmapFixture f(CanvasSpriteSortMode::BackToFront);
+        std::sort(f.Bitmaps.begin(), f.Bitmaps.end());
+
+        struct Entry
+        {
+            int Id;
+            int BitmapIndex;
+            float Depth;
+        };
+
+        std::vector<Entry> entries;
+        uint32_t seed = 12345;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            seed = seed * 1664525 + 1013904223;
+            auto depth = (static_cast<int>(seed >> 16) % 2000 - 1000) / 7.0f;
+            entries.push_back(Entry{ i, i % 3, depth });
+            f.Add(f.Bitmaps[i % 3], (float)i, depth);
+        }
+
+        std::stable_sort(entries.begin(), entries.end(),
+            [] (Entry const& a, Entry const& b)
+            {
+                if (a.Depth != b.Depth)
+                    return a.Depth > b.Depth;
+                return a.BitmapIndex < b.BitmapIndex;
+            });
+
+        for (auto const& entry : entries)
+            f.Expect((float)entry.Id);
+
+        f.DeviceContext->DrawSpriteBatchMethod.AllowAnyCall();
+
+        f.Validate();
+    }
+
+    TEST_METHOD_EX(CanvasSpriteBatch_CreateSpriteBatchWithSortMode_FailsWhenPassedInvalidSortMode)
+    {
+        Fixture f;
+
+        ComPtr<ICanvasSpriteBatch> spriteBatch;
+        Assert::AreEqual(E_INVALIDARG, f.DrawingSession->CreateSpriteBatchWithSortMode(static_cast<CanvasSpriteSortMode>(99), &spriteBatch));
+    }
+
+    TEST_METHOD_EX(CanvasSpriteBatch_Depth)
+    {
+        Fixture f;
+
+        ComPtr<ICanvasSpriteBatch> spriteBatch;
+        ThrowIfFailed(f.DrawingSession->CreateSpriteBatch(&spriteBatch));
+
+        float depth = -1;
+        ThrowIfFailed(spriteBatch->get_Depth(&depth));
+        Assert::AreEqual(0.0f, depth);
+
+        ThrowIfFailed(spriteBatch->put_Depth(23.0f));
+        ThrowIfFailed(spriteBatch->get_Depth(&depth));
+        Assert::AreEqual(23.0f, depth);
+
+        Assert::AreEqual(E_INVALIDARG, spriteBatch->get_Depth(nullptr));
+        Assert::AreEqual(E_INVALIDARG, spriteBatch->put_Depth(std::numeric_limits<float>::quiet_NaN()));
+
+        ThrowIfFailed(As<IClosable>(spriteBatch)->Close());
+
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->get_Depth(&depth));
+        Assert::AreEqual(RO_E_CLOSED, spriteBatch->put_Depth(1.0f));
+    }
+
     TEST_METHOD_EX(CanvasSpriteBatch_When_AntialiasingIsEnabled_ItMustBeDisabledAroundCallsToDrawSpriteBatch)
     {
         MultipleBitmapFixture f;
@@ -1610,4 +1783,250 @@ public:
             f.Validate();
         }
     }
+
+    //
+    // DrawSprites
+    //
+
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DrawSprites_FailWhenPassedNullParameters)
+    {
+        DrawFixture f;
+
+        Rect rects[1]{};
+        Matrix3x2 transforms[1]{};
+
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(nullptr, 1, rects, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 1, nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 1, rects, 1, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 1, rects, 0, nullptr, 1, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 1, rects, 0, nullptr, 0, nullptr, 1, nullptr));
+
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesWithTransforms(nullptr, 1, transforms, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesWithTransforms(f.Bitmap.Get(), 1, nullptr, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesWithTransforms(f.Bitmap.Get(), 1, transforms, 1, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesWithTransforms(f.Bitmap.Get(), 1, transforms, 0, nullptr, 1, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesWithTransforms(f.Bitmap.Get(), 1, transforms, 0, nullptr, 0, nullptr, 1, nullptr));
+    }
+
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DrawSprites_FailsWhenArraySizesDoNotMatch)
+    {
+        DrawFixture f;
+
+        Rect rects[3]{};
+        Vector4 tints[2]{};
+        CanvasSpriteFlip flips[4]{};
+
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 3, rects, 2, rects, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 3, rects, 0, nullptr, 2, tints, 0, nullptr));
+        Assert::AreEqual(E_INVALIDARG, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 3, rects, 0, nullptr, 0, nullptr, 4, flips));
+
+        // Nothing should have been added to the batch, so closing it must not
+        // create or draw a D2D sprite batch.
+        ThrowIfFailed(As<IClosable>(f.SpriteBatch)->Close());
+    }
+
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DrawSprites_MethodsFail_AfterClosed)
+    {
+        DrawFixture f;
+
+        ThrowIfFailed(As<IClosable>(f.SpriteBatch)->Close());
+
+        Rect rects[1]{};
+        Matrix3x2 transforms[1]{};
+
+        Assert::AreEqual(RO_E_CLOSED, f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), 1, rects, 0, nullptr, 0, nullptr, 0, nullptr));
+        Assert::AreEqual(RO_E_CLOSED, f.SpriteBatch->DrawSpritesWithTransforms(f.Bitmap.Get(), 1, transforms, 0, nullptr, 0, nullptr, 0, nullptr));
+    }
+
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DrawSpritesToRects_MatchesPerSpriteDraw)
+    {
+        DrawFixture f;
+
+        std::vector<Rect> rects;
+        std::vector<Vector4> tints;
+        std::vector<CanvasSpriteFlip> flips;
+
+        for (auto& t : GenerateFlipTestCases(f.FullBitmapSourceRect()))
+        {
+            for (auto rect : gRects)
+            {
+                auto tint = gTints[rects.size() % _countof(gTints)];
+
+                rects.push_back(rect);
+                tints.push_back(tint);
+                flips.push_back(t.first);
+
+                f.ExpectSprite(
+                    ToD2DRect(rect),
+                    t.second,
+                    *ReinterpretAs<D2D1_COLOR_F*>(&tint));
+            }
+        }
+
+        auto count = static_cast<uint32_t>(rects.size());
+        ThrowIfFailed(f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), count, rects.data(), 0, nullptr, count, tints.data(), count, flips.data()));
+
+        f.Validate();
+    }
+
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DrawSpritesWithTransforms_FromSpriteSheet)
+    {
+        DrawFixture f;
+
+        auto width = 30.0f;
+        auto height = 40.0f;
+        Rect sourceRect{ 10.0f, 20.0f, width, height };
+        D2D1_RECT_U s{ 20, 40, static_cast<uint32_t>(20 + width * 2), static_cast<uint32_t>(40 + height * 2) };
+
+        std::vector<Matrix3x2> transforms;
+        std::vector<Rect> sourceRects;
+
+        for (auto matrix : gMatrices)
+        {
+            transforms.push_back(matrix);
+            sourceRects.push_back(sourceRect);
+
+            f.ExpectSprite(
+                D2D1_RECT_F{ 0.0f, 0.0f, width, height },
+                s,
+                D2D1_COLOR_F{ 1.0f, 1.0f, 1.0f, 1.0f },
+                *ReinterpretAs<D2D1_MATRIX_3X2_F*>(&matrix));
+        }
+
+        auto count = static_cast<uint32_t>(transforms.size());
+        ThrowIfFailed(f.SpriteBatch->DrawSpritesWithTransforms(f.Bitmap.Get(), count, transforms.data(), count, sourceRects.data(), 0, nullptr, 0, nullptr));
+
+        f.Validate();
+    }
+
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DrawSprites_CanBeMixedWithPerSpriteDraw)
+    {
+        DrawFixture f;
+
+        ThrowIfFailed(f.SpriteBatch->DrawAtOffset(f.Bitmap.Get(), float2::zero()));
+        f.ExpectSprite(f.FullBitmapDestRect(float2::zero()), f.FullBitmapSourceRect());
+
+        Rect rects[] = { gRects[0], gRects[1] };
+        ThrowIfFailed(f.SpriteBatch->DrawSpritesToRects(f.Bitmap.Get(), _countof(rects), rects, 0, nullptr, 0, nullptr, 0, nullptr));
+        f.ExpectSprite(ToD2DRect(rects[0]), f.FullBitmapSourceRect());
+        f.ExpectSprite(ToD2DRect(rects[1]), f.FullBitmapSourceRect());
+
+        ThrowIfFailed(f.SpriteBatch->DrawToRect(f.Bitmap.Get(), gRects[2]));
+        f.ExpectSprite(ToD2DRect(gRects[2]), f.FullBitmapSourceRect());
+
+        f.Validate();
+    }
+
+
+    //
+    // Compares the CPU cost of adding sprites one at a time against adding
+    // them with a single DrawSprites call.  The device context and D2D sprite
+    // batch are test doubles, so this only measures Win2D's own overhead.
+    //
+    // Both paths must hand D2D exactly the same sprites, and the bulk path
+    // must be faster: it skips an ABI call, bitmap lookup and validation per
+    // sprite, which is a large enough margin that timing noise doesn't
+    // affect the result.  Timings are also written to the test log.
+    //
+
+    struct SubmittedSprites
+    {
+        std::vector<D2D1_RECT_F> DestRects;
+        std::vector<D2D1_COLOR_F> Colors;
+        long long ElapsedMicroseconds;
+    };
+
+    template<typename T>
+    static void AppendStrided(std::vector<T>& values, T const* first, uint32_t stride, uint32_t count)
+    {
+        auto bytes = reinterpret_cast<uint8_t const*>(first);
+
+        for (uint32_t i = 0; i < count; ++i)
+            values.push_back(*reinterpret_cast<T const*>(bytes + i * stride));
+    }
+
+    TEST_METHOD_EX(CanvasSpriteBatch_DrawSprites_Benchmark)
+    {
+        uint32_t const spriteCount = 50000;
+
+        std::vector<Rect> rects(spriteCount);
+        std::vector<Vector4> tints(spriteCount);
+
+        for (uint32_t i = 0; i < spriteCount; ++i)
+        {
+            auto x = static_cast<float>(i % 256);
+            auto y = static_cast<float>(i / 256);
+            rects[i] = Rect{ x, y, 16.0f, 16.0f };
+            tints[i] = Vector4{ x / 256.0f, 1.0f, 1.0f, 1.0f };
+        }
+
+        auto measure = [&] (wchar_t const* name, std::function<void(ICanvasSpriteBatch*, CanvasBitmap*)> addSprites)
+        {
+            DrawFixture f;
+            SubmittedSprites result;
+
+            auto d2dSpriteBatch = f.ExpectCreateSpriteBatch();
+            f.DeviceContext->DrawSpriteBatchMethod.AllowAnyCall();
+
+            d2dSpriteBatch->AddSpritesMethod.AllowAnyCall(
+                [&] (UINT32 count, D2D1_RECT_F const* destRects, D2D1_RECT_U const*, D2D1_COLOR_F const* colors, D2D1_MATRIX_3X2_F const*, UINT32 destRectsStride, UINT32, UINT32 colorsStride, UINT32)
+                {
+                    AppendStrided(result.DestRects, destRects, destRectsStride, count);
+                    AppendStrided(result.Colors, colors, colorsStride, count);
+                    return S_OK;
+                });
+
+            BenchmarkTimer timer;
+
+            addSprites(f.SpriteBatch.Get(), f.Bitmap.Get());
+
+            result.ElapsedMicroseconds = timer.ElapsedMicroseconds();
+
+            ThrowIfFailed(As<IClosable>(f.SpriteBatch)->Close());
+
+            wchar_t message[256];
+            swprintf_s(message, L"%s: %u sprites in %lld us\n", name, spriteCount, result.ElapsedMicroseconds);
+            Logger::WriteMessage(message);
+
+            return result;
+        };
+
+        auto perSprite = measure(L"Draw (per sprite)",
+            [&] (ICanvasSpriteBatch* spriteBatch, CanvasBitmap* bitmap)
+            {
+                for (uint32_t i = 0; i < spriteCount; ++i)
+                    ThrowIfFailed(spriteBatch->DrawToRectWithTint(bitmap, rects[i], tints[i]));
+            });
+
+        auto bulk = measure(L"DrawSprites (bulk)",
+            [&] (ICanvasSpriteBatch* spriteBatch, CanvasBitmap* bitmap)
+            {
+                ThrowIfFailed(spriteBatch->DrawSpritesToRects(bitmap, spriteCount, rects.data(), 0, nullptr, spriteCount, tints.data(), 0, nullptr));
+            });
+
+        // Timings are only logged, since wall-clock comparisons are too noisy
+        // to assert on.  What is checked is that both paths hand D2D the same
+        // sprites, matching what was drawn.
+        Assert::AreEqual<size_t>(spriteCount, perSprite.DestRects.size());
+        Assert::AreEqual<size_t>(spriteCount, bulk.DestRects.size());
+        Assert::AreEqual<size_t>(spriteCount, perSprite.Colors.size());
+        Assert::AreEqual<size_t>(spriteCount, bulk.Colors.size());
+
+        for (uint32_t i = 0; i < spriteCount; ++i)
+        {
+            auto expectedRect = ToD2DRect(rects[i]);
+            auto expectedColor = *ReinterpretAs<D2D1_COLOR_F*>(&tints[i]);
+
+            Assert::AreEqual(expectedRect, perSprite.DestRects[i]);
+            Assert::AreEqual(expectedRect, bulk.DestRects[i]);
+            Assert::AreEqual(expectedColor, perSprite.Colors[i]);
+            Assert::AreEqual(expectedColor, bulk.Colors[i]);
+        }
+    }
 };
@@ -0,0 +1,227 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <lib/images/CanvasTextureAtlas.h>
+
+
+static ComPtr<ICanvasTextureAtlasFactory> GetTextureAtlasFactory()
+{
+    ComPtr<ICanvasTextureAtlasFactory> factory;
+    ThrowIfFailed(MakeAndInitialize<CanvasTextureAtlasFactory>(&factory));
+    return factory;
+}
+
+
+static const int32_t PageSize = 64;
+
+
+TEST_CLASS(CanvasTextureAtlasUnitTests)
+{
+public:
+
+    struct Fixture
+    {
+        ComPtr<StubCanvasDevice> Device;
+        std::vector<ComPtr<StubD2DBitmap>> Pages;
+
+        Fixture()
+            : Device(Make<StubCanvasDevice>())
+        {
+            Device->CreateBitmapFromBytesMethod.AllowAnyCall(
+                [=](uint8_t* bytes, uint32_t pitch, int32_t width, int32_t height, float dpi, DirectXPixelFormat format, CanvasAlphaMode alpha)
+                {
+                    Assert::AreEqual<uint32_t>(PageSize * 4, pitch);
+                    Assert::AreEqual(PageSize, width);
+                    Assert::AreEqual(PageSize, height);
+                    Assert::AreEqual(DEFAULT_DPI * 2, dpi);
+                    Assert::AreEqual(PIXEL_FORMAT(B8G8R8A8UIntNormalized), format);
+                    Assert::AreEqual(CanvasAlphaMode::Premultiplied, alpha);
+
+                    // New pages should be fully transparent.
+                    Assert::IsTrue(std::all_of(bytes, bytes + pitch * height, [](uint8_t b) { return b == 0; }));
+
+                    auto page = Make<StubD2DBitmap>(D2D1_BITMAP_OPTIONS_NONE, dpi);
+                    page->CopyFromBitmapMethod.AllowAnyCall();
+                    Pages.push_back(page);
+                    return page;
+                });
+        }
+
+        ComPtr<ICanvasTextureAtlas> Create()
+        {
+            ComPtr<ICanvasTextureAtlas> atlas;
+            ThrowIfFailed(GetTextureAtlasFactory()->Create(Device.Get(), PageSize, PageSize, DEFAULT_DPI * 2, &atlas));
+            return atlas;
+        }
+
+        ComPtr<CanvasBitmap> CreateBitmap(uint32_t width, uint32_t height, DXGI_FORMAT format = DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE alphaMode = D2D1_ALPHA_MODE_PREMULTIPLIED)
+        {
+            auto d2dBitmap = Make<StubD2DBitmap>();
+            d2dBitmap->GetPixelSizeMethod.AllowAnyCall([=] { return D2D1_SIZE_U{ width, height }; });
+            d2dBitmap->GetPixelFormatMethod.AllowAnyCall([=] { return D2D1::PixelFormat(format, alphaMode); });
+            return CreateStubCanvasBitmap(Device.Get(), d2dBitmap.Get());
+        }
+    };
+
+    TEST_METHOD_EX(CanvasTextureAtlas_Create_FailsWhenPassedInvalidParameters)
+    {
+        Fixture f;
+        auto factory = GetTextureAtlasFactory();
+
+        ComPtr<ICanvasTextureAtlas> atlas;
+
+        Assert::AreEqual(E_INVALIDARG, factory->Create(nullptr, PageSize, PageSize, DEFAULT_DPI, &atlas));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(f.Device.Get(), PageSize, PageSize, DEFAULT_DPI, nullptr));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(f.Device.Get(), 0, PageSize, DEFAULT_DPI, &atlas));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(f.Device.Get(), PageSize, -1, DEFAULT_DPI, &atlas));
+        Assert::AreEqual(E_INVALIDARG, factory->Create(f.Device.Get(), PageSize, PageSize, 0, &atlas));
+    }
+
+    TEST_METHOD_EX(CanvasTextureAtlas_Create_DoesNotAllocatePagesUntilNeeded)
+    {
+        Fixture f;
+        auto atlas = f.Create();
+
+        int32_t pageCount = -1;
+        ThrowIfFailed(atlas->get_PageCount(&pageCount));
+        Assert::AreEqual(0, pageCount);
+
+        BitmapSize pageSize;
+        ThrowIfFailed(atlas->get_PageSize(&pageSize));
+        Assert::AreEqual<uint32_t>(PageSize, pageSize.Width);
+        Assert::AreEqual<uint32_t>(PageSize, pageSize.Height);
+
+        float dpi;
+        ThrowIfFailed(atlas->get_Dpi(&dpi));
+        Assert::AreEqual(DEFAULT_DPI * 2, dpi);
+
+        ComPtr<ICanvasDevice> device;
+        ThrowIfFailed(atlas->get_Device(&device));
+        Assert::IsTrue(IsSameInstance(f.Device.Get(), device.Get()));
+
+        Assert::IsTrue(f.Pages.empty());
+    }
+
+    TEST_METHOD_EX(CanvasTextureAtlas_Add_CopiesBitmapIntoPageAndReturnsRegion)
+    {
+        Fixture f;
+        auto atlas = f.Create();
+
+        auto bitmap1 = f.CreateBitmap(10, 20);
+        auto bitmap2 = f.CreateBitmap(30, 8);
+
+        ComPtr<ICanvasTextureAtlasRegion> region1;
+        ThrowIfFailed(atlas->Add(bitmap1.Get(), &region1));
+
+        Assert::AreEqual<size_t>(1, f.Pages.size());
+
+        f.Pages[0]->CopyFromBitmapMethod.SetExpectedCalls(1,
+            [&](D2D1_POINT_2U const* destPoint, ID2D1Bitmap* source, D2D1_RECT_U const* sourceRect)
+            {
+                // The second bitmap goes to the right of the first, past its padding.
+                Assert::AreEqual(11u, destPoint->x);
+                Assert::AreEqual(0u, destPoint->y);
+                Assert::IsTrue(IsSameInstance(GetWrappedResource<ID2D1Bitmap>(bitmap2).Get(), source));
+                Assert::IsNull(sourceRect);
+                return S_OK;
+            });
+
+        ComPtr<ICanvasTextureAtlasRegion> region2;
+        ThrowIfFailed(atlas->Add(bitmap2.Get(), &region2));
+
+        Assert::AreEqual<size_t>(1, f.Pages.size());
+
+        // Source rects are in DIPs, at the atlas DPI.
+        Rect sourceRect;
+        ThrowIfFailed(region1->get_SourceRect(&sourceRect));
+        Assert::AreEqual(Rect{ 0, 0, 5, 10 }, sourceRect);
+
+        ThrowIfFailed(region2->get_SourceRect(&sourceRect));
+        Assert::AreEqual(Rect{ 5.5f, 0, 15, 4 }, sourceRect);
+
+        int32_t pageIndex = -1;
+        ThrowIfFailed(region2->get_PageIndex(&pageIndex));
+        Assert::AreEqual(0, pageIndex);
+
+        ComPtr<ICanvasBitmap> regionBitmap;
+        ThrowIfFailed(region2->get_Bitmap(&regionBitmap));
+
+        ComPtr<ICanvasBitmap> page;
+        ThrowIfFailed(atlas->GetPage(0, &page));
+        Assert::IsTrue(IsSameInstance(page.Get(), regionBitmap.Get()));
+        Assert::IsTrue(IsSameInstance(f.Pages[0].Get(), GetWrappedResource<ID2D1Bitmap>(page).Get()));
+    }
+
+    TEST_METHOD_EX(CanvasTextureAtlas_Add_StartsNewPageWhenFull)
+    {
+        Fixture f;
+        auto atlas = f.Create();
+
+        ComPtr<ICanvasTextureAtlasRegion> region;
+        ThrowIfFailed(atlas->Add(f.CreateBitmap(PageSize, PageSize).Get(), &region));
+        ThrowIfFailed(atlas->Add(f.CreateBitmap(1, 1).Get(), &region));
+
+        int32_t pageIndex = -1;
+        ThrowIfFailed(region->get_PageIndex(&pageIndex));
+        Assert::AreEqual(1, pageIndex);
+
+        int32_t pageCount;
+        ThrowIfFailed(atlas->get_PageCount(&pageCount));
+        Assert::AreEqual(2, pageCount);
+
+        // Small bitmaps keep filling the newest page rather than starting another one.
+        ThrowIfFailed(atlas->Add(f.CreateBitmap(1, 1).Get(), &region));
+        ThrowIfFailed(region->get_PageIndex(&pageIndex));
+        Assert::AreEqual(1, pageIndex);
+        Assert::AreEqual<size_t>(2, f.Pages.size());
+
+        ComPtr<ICanvasBitmap> page;
+        Assert::AreEqual(E_BOUNDS, atlas->GetPage(2, &page));
+        Assert::AreEqual(E_BOUNDS, atlas->GetPage(-1, &page));
+    }
+
+    TEST_METHOD_EX(CanvasTextureAtlas_Add_FailsWhenBitmapIsInvalid)
+    {
+        Fixture f;
+        auto atlas = f.Create();
+
+        ComPtr<ICanvasTextureAtlasRegion> region;
+
+        Assert::AreEqual(E_INVALIDARG, atlas->Add(nullptr, &region));
+        Assert::AreEqual(E_INVALIDARG, atlas->Add(f.CreateBitmap(1, 1).Get(), nullptr));
+
+        Assert::AreEqual(E_INVALIDARG, atlas->Add(f.CreateBitmap(PageSize + 1, 1).Get(), &region));
+        ValidateStoredErrorState(E_INVALIDARG, Strings::TextureAtlasBitmapTooLarge);
+
+        Assert::AreEqual(E_INVALIDARG, atlas->Add(f.CreateBitmap(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM).Get(), &region));
+        ValidateStoredErrorState(E_INVALIDARG, Strings::TextureAtlasUnsupportedFormat);
+
+        Assert::AreEqual(E_INVALIDARG, atlas->Add(f.CreateBitmap(1, 1, DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE).Get(), &region));
+        ValidateStoredErrorState(E_INVALIDARG, Strings::TextureAtlasUnsupportedFormat);
+
+        Assert::IsTrue(f.Pages.empty());
+    }
+
+    TEST_METHOD_EX(CanvasTextureAtlas_Closed)
+    {
+        Fixture f;
+        auto atlas = f.Create();
+
+        ComPtr<ICanvasTextureAtlasRegion> region;
+        ThrowIfFailed(atlas->Add(f.CreateBitmap(4, 4).Get(), &region));
+
+        ThrowIfFailed(As<IClosable>(atlas)->Close());
+
+        int32_t pageCount;
+        ComPtr<ICanvasBitmap> page;
+        ComPtr<ICanvasDevice> device;
+
+        Assert::AreEqual(RO_E_CLOSED, atlas->Add(f.CreateBitmap(4, 4).Get(), &region));
+        Assert::AreEqual(RO_E_CLOSED, atlas->get_PageCount(&pageCount));
+        Assert::AreEqual(RO_E_CLOSED, atlas->GetPage(0, &page));
+        Assert::AreEqual(RO_E_CLOSED, atlas->get_Device(&device));
+    }
+};
@@ -0,0 +1,216 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <lib/effects/ColorMatrixFolding.h>
+
+using namespace ABI::Microsoft::Graphics::Canvas::Effects;
+
+TEST_CLASS(ColorMatrixFoldingTests)
+{
+    static D2D1_VECTOR_4F Apply(D2D1_MATRIX_5X4_F const& matrix, D2D1_VECTOR_4F const& color)
+    {
+        float in[] = { color.x, color.y, color.z, color.w, 1 };
+        float out[4];
+
+        for (int column = 0; column < 4; column++)
+        {
+            out[column] = 0;
+
+            for (int row = 0; row < 5; row++)
+            {
+                out[column] += in[row] * matrix.m[row][column];
+            }
+        }
+
+        return D2D1_VECTOR_4F{ out[0], out[1], out[2], out[3] };
+    }
+
+    static void AssertColorsEqual(D2D1_VECTOR_4F const& expected, D2D1_VECTOR_4F const& actual, float tolerance = 1e-5f)
+    {
+        Assert::AreEqual(expected.x, actual.x, tolerance);
+        Assert::AreEqual(expected.y, actual.y, tolerance);
+        Assert::AreEqual(expected.z, actual.z, tolerance);
+        Assert::AreEqual(expected.w, actual.w, tolerance);
+    }
+
+    static bool AreMatricesEqual(D2D1_MATRIX_5X4_F const& a, D2D1_MATRIX_5X4_F const& b)
+    {
+        return memcmp(&a, &b, sizeof(a)) == 0;
+    }
+
+    static D2D1_MATRIX_5X4_F MakeTestMatrix(float seed)
+    {
+        D2D1_MATRIX_5X4_F matrix;
+
+        for (int row = 0; row < 5; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                matrix.m[row][column] = sinf(seed + row * 4 + column);
+            }
+        }
+
+        return matrix;
+    }
+
+    static std::vector<D2D1_VECTOR_4F> GetTestColors()
+    {
+        return
+        {
+            { 0, 0, 0, 0 },
+            { 1, 1, 1, 1 },
+            { 1, 0, 0, 0.5f },
+            { 0.25f, 0.5f, 0.75f, 1 },
+            { 0.9f, 0.1f, 0.4f, 0.2f },
+        };
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_Combine_AppliesFirstThenSecond)
+    {
+        auto first = MakeTestMatrix(1);
+        auto second = MakeTestMatrix(2);
+
+        auto combined = CombineColorMatrices(first, second);
+
+        for (auto& color : GetTestColors())
+        {
+            AssertColorsEqual(Apply(second, Apply(first, color)), Apply(combined, color));
+        }
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_Combine_WithIdentity)
+    {
+        auto matrix = MakeTestMatrix(3);
+        auto identity = MakeIdentityColorMatrix();
+
+        Assert::IsTrue(AreMatricesEqual(matrix, CombineColorMatrices(matrix, identity)));
+        Assert::IsTrue(AreMatricesEqual(matrix, CombineColorMatrices(identity, matrix)));
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_IsIdentity)
+    {
+        Assert::IsTrue(IsIdentityColorMatrix(MakeIdentityColorMatrix()));
+        Assert::IsTrue(IsIdentityColorMatrix(MakeSaturationColorMatrix(1)));
+        Assert::IsTrue(IsIdentityColorMatrix(MakeHueRotationColorMatrix(0)));
+        Assert::IsTrue(IsIdentityColorMatrix(MakeScaleColorMatrix(1, 1, 1, 1)));
+
+        Assert::IsFalse(IsIdentityColorMatrix(MakeSaturationColorMatrix(0.5f)));
+        Assert::IsFalse(IsIdentityColorMatrix(MakeHueRotationColorMatrix(10)));
+        Assert::IsFalse(IsIdentityColorMatrix(MakeScaleColorMatrix(1, 1, 1, 0.5f)));
+
+        auto withOffset = MakeIdentityColorMatrix();
+        withOffset.m[4][2] = 0.1f;
+        Assert::IsFalse(IsIdentityColorMatrix(withOffset));
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_Saturation)
+    {
+        // Zero saturation produces grays, and nothing changes grays or alpha.
+        auto desaturate = MakeSaturationColorMatrix(0);
+
+        for (auto& color : GetTestColors())
+        {
+            auto result = Apply(desaturate, color);
+
+            Assert::AreEqual(result.x, result.y, 1e-5f);
+            Assert::AreEqual(result.x, result.z, 1e-5f);
+            Assert::AreEqual(color.w, result.w);
+        }
+
+        D2D1_VECTOR_4F gray{ 0.5f, 0.5f, 0.5f, 0.7f };
+        AssertColorsEqual(gray, Apply(MakeSaturationColorMatrix(0.3f), gray));
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_HueRotation)
+    {
+        D2D1_VECTOR_4F gray{ 0.5f, 0.5f, 0.5f, 0.7f };
+        AssertColorsEqual(gray, Apply(MakeHueRotationColorMatrix(123), gray));
+
+        // The D2D coefficients are only given to three decimal places, so
+        // rotations don't quite cancel out exactly.
+        auto roundTrip = CombineColorMatrices(MakeHueRotationColorMatrix(30), MakeHueRotationColorMatrix(-30));
+
+        for (auto& color : GetTestColors())
+        {
+            AssertColorsEqual(color, Apply(roundTrip, color), 1e-3f);
+        }
+    }
+
+    static std::vector<EffectPropertyValue> MakeColorMatrixProperties(D2D1_MATRIX_5X4_F const& matrix, uint32_t alphaMode, bool clampOutput)
+    {
+        std::vector<EffectPropertyValue> properties(3);
+
+        properties[D2D1_COLORMATRIX_PROP_COLOR_MATRIX].Set(20, &matrix._11);
+        properties[D2D1_COLORMATRIX_PROP_ALPHA_MODE].Set(alphaMode);
+        properties[D2D1_COLORMATRIX_PROP_CLAMP_OUTPUT].Set(static_cast<boolean>(clampOutput));
+
+        return properties;
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_TryGetEffectColorMatrix_ColorMatrix)
+    {
+        auto expected = MakeTestMatrix(4);
+
+        D2D1_MATRIX_5X4_F matrix;
+        bool clampOutput;
+
+        Assert::IsTrue(TryGetEffectColorMatrix(CLSID_D2D1ColorMatrix, MakeColorMatrixProperties(expected, D2D1_COLORMATRIX_ALPHA_MODE_PREMULTIPLIED, false), &matrix, &clampOutput));
+        Assert::IsTrue(AreMatricesEqual(expected, matrix));
+        Assert::IsFalse(clampOutput);
+
+        Assert::IsTrue(TryGetEffectColorMatrix(CLSID_D2D1ColorMatrix, MakeColorMatrixProperties(expected, D2D1_COLORMATRIX_ALPHA_MODE_PREMULTIPLIED, true), &matrix, &clampOutput));
+        Assert::IsTrue(clampOutput);
+
+        // Straight alpha mode works on premultiplied colors, so isn't a transform of the same kind.
+        Assert::IsFalse(TryGetEffectColorMatrix(CLSID_D2D1ColorMatrix, MakeColorMatrixProperties(expected, D2D1_COLORMATRIX_ALPHA_MODE_STRAIGHT, false), &matrix, &clampOutput));
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_TryGetEffectColorMatrix_OtherEffects)
+    {
+        D2D1_MATRIX_5X4_F matrix;
+        bool clampOutput;
+
+        std::vector<EffectPropertyValue> properties(1);
+        properties[0].Set(0.25f);
+
+        Assert::IsTrue(TryGetEffectColorMatrix(CLSID_D2D1Saturation, properties, &matrix, &clampOutput));
+        Assert::IsTrue(AreMatricesEqual(MakeSaturationColorMatrix(0.25f), matrix));
+
+        Assert::IsTrue(TryGetEffectColorMatrix(CLSID_D2D1HueRotation, properties, &matrix, &clampOutput));
+        Assert::IsTrue(AreMatricesEqual(MakeHueRotationColorMatrix(0.25f), matrix));
+
+        Assert::IsTrue(TryGetEffectColorMatrix(CLSID_D2D1Opacity, properties, &matrix, &clampOutput));
+        Assert::IsTrue(AreMatricesEqual(MakeScaleColorMatrix(1, 1, 1, 0.25f), matrix));
+
+        Assert::IsFalse(TryGetEffectColorMatrix(CLSID_D2D1GaussianBlur, properties, &matrix, &clampOutput));
+        Assert::IsFalse(IsColorTransformEffect(CLSID_D2D1GaussianBlur));
+
+        float tint[] = { 0.1f, 0.2f, 0.3f, 1.0f };
+        std::vector<EffectPropertyValue> tintProperties(2);
+        tintProperties[D2D1_TINT_PROP_COLOR].Set(4, tint);
+        tintProperties[D2D1_TINT_PROP_CLAMP_OUTPUT].Set(static_cast<boolean>(true));
+
+        Assert::IsTrue(TryGetEffectColorMatrix(CLSID_D2D1Tint, tintProperties, &matrix, &clampOutput));
+        Assert::IsTrue(AreMatricesEqual(MakeScaleColorMatrix(0.1f, 0.2f, 0.3f, 1), matrix));
+        Assert::IsTrue(clampOutput);
+    }
+
+    TEST_METHOD_EX(ColorMatrixFolding_TryGetEffectColorMatrix_TranslucentTintIsNotFolded)
+    {
+        D2D1_MATRIX_5X4_F matrix;
+        bool clampOutput;
+
+        for (float alpha : { 0.0f, 0.4f, 0.999f })
+        {
+            float tint[] = { 0.1f, 0.2f, 0.3f, alpha };
+            std::vector<EffectPropertyValue> tintProperties(2);
+            tintProperties[D2D1_TINT_PROP_COLOR].Set(4, tint);
+            tintProperties[D2D1_TINT_PROP_CLAMP_OUTPUT].Set(static_cast<boolean>(false));
+
+            Assert::IsFalse(TryGetEffectColorMatrix(CLSID_D2D1Tint, tintProperties, &matrix, &clampOutput));
+        }
+    }
+};
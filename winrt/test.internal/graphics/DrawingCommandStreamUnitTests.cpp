@@ -0,0 +1,751 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "utils/BenchmarkTimer.h"
+
+#include "../lib/drawing/CanvasDrawingRecording.h"
+#include "../lib/drawing/DrawingCommandStream.h"
+#include "mocks/MockD2DGeometrySink.h"
+#include "mocks/MockD2DPathGeometry.h"
+
+static Color const Red{ 255, 255, 0, 0 };
+static Color const Blue{ 255, 0, 0, 255 };
+
+TEST_CLASS(DrawingCommandStreamUnitTests)
+{
+public:
+    struct Fixture
+    {
+        ComPtr<StubD2DDeviceContextWithGetFactory> DeviceContext;
+        SolidColorBrushCache Brushes;
+
+        D2D1_MATRIX_3X2_F BaseTransform;
+
+        // Rectangles are identified by their left edge.
+        std::vector<float> FilledRects;
+        std::vector<ID2D1Brush*> FilledBrushes;
+        std::vector<D2D1_MATRIX_3X2_F> SetTransforms;
+
+        Fixture()
+            : DeviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+            , BaseTransform(D2D1::Matrix3x2F::Translation(1000, 2000))
+        {
+            DeviceContext->GetTransformMethod.AllowAnyCall([=](D2D1_MATRIX_3X2_F* value) { *value = BaseTransform; });
+            DeviceContext->SetTransformMethod.AllowAnyCall([=](D2D1_MATRIX_3X2_F const* value) { SetTransforms.push_back(*value); });
+
+            DeviceContext->FillRectangleMethod.AllowAnyCall(
+                [=](D2D1_RECT_F const* rect, ID2D1Brush* brush)
+                {
+                    Assert::IsNotNull(brush);
+                    FilledRects.push_back(rect->left);
+                    FilledBrushes.push_back(brush);
+                });
+        }
+
+        DrawingCommandStream::DrawStatistics Draw(DrawingCommandStream const& stream, D2D1_RECT_F const* cullRect = nullptr)
+        {
+            return stream.Draw(DeviceContext.Get(), Brushes, cullRect, 0, stream.GetCommandCount());
+        }
+    };
+
+    static void AssertRectsEqual(D2D1_RECT_F const& expected, D2D1_RECT_F const& actual)
+    {
+        Assert::AreEqual(expected, actual);
+    }
+
+    static void AssertFilledRects(std::vector<float> const& expected, std::vector<float> const& actual)
+    {
+        Assert::AreEqual(expected.size(), actual.size());
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            Assert::AreEqual(expected[i], actual[i]);
+        }
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_CommandBounds_IncludeStrokeWidth)
+    {
+        DrawingCommandStream stream;
+
+        stream.FillRectangle(D2D1_RECT_F{ 10, 20, 30, 40 }, Red);
+        stream.DrawRectangle(D2D1_RECT_F{ 10, 20, 30, 40 }, Red, 2);
+        stream.FillRectangle(D2D1_RECT_F{ 30, 40, 10, 20 }, Red);
+        stream.DrawRoundedRectangle(D2D1_ROUNDED_RECT{ { 10, 20, 30, 40 }, 3, 3 }, Red, 1);
+        stream.DrawEllipse(D2D1_ELLIPSE{ { 5, 5 }, 2, -3 }, Red, 1);
+        stream.DrawLine(D2D1_POINT_2F{ 10, 5 }, D2D1_POINT_2F{ 0, 0 }, Red, 2);
+
+        D2D1_POINT_2F points[] = { { 0, 0 }, { 10, -10 }, { 20, 5 } };
+        stream.DrawPolyline(_countof(points), points, Red, 1);
+
+        Assert::AreEqual(7u, stream.GetCommandCount());
+
+        AssertRectsEqual(D2D1_RECT_F{ 10, 20, 30, 40 }, stream.GetCommandBounds(0));
+        AssertRectsEqual(D2D1_RECT_F{ 8, 18, 32, 42 }, stream.GetCommandBounds(1));
+        AssertRectsEqual(D2D1_RECT_F{ 10, 20, 30, 40 }, stream.GetCommandBounds(2));
+        AssertRectsEqual(D2D1_RECT_F{ 9, 19, 31, 41 }, stream.GetCommandBounds(3));
+        AssertRectsEqual(D2D1_RECT_F{ 2, 1, 8, 9 }, stream.GetCommandBounds(4));
+        AssertRectsEqual(D2D1_RECT_F{ -2, -2, 12, 7 }, stream.GetCommandBounds(5));
+
+        // Polylines allow for miter joins.
+        AssertRectsEqual(D2D1_RECT_F{ -5, -15, 25, 10 }, stream.GetCommandBounds(6));
+
+        AssertRectsEqual(D2D1_RECT_F{ -5, -15, 32, 42 }, stream.GetBounds());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_EmptyStream_HasEmptyBounds)
+    {
+        DrawingCommandStream stream;
+
+        Assert::AreEqual(0u, stream.GetCommandCount());
+        AssertRectsEqual(D2D1_RECT_F{}, stream.GetBounds());
+
+        // Polylines with no points aren't recorded.
+        stream.DrawPolyline(0, nullptr, Red, 1);
+
+        Assert::AreEqual(0u, stream.GetCommandCount());
+        Assert::AreEqual<size_t>(0, stream.GetByteCount());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_CommandBounds_AreTransformed)
+    {
+        DrawingCommandStream stream;
+
+        stream.SetTransform(D2D1::Matrix3x2F::Scale(2, 3) * D2D1::Matrix3x2F::Translation(10, 0));
+        stream.FillRectangle(D2D1_RECT_F{ 1, 1, 2, 2 }, Red);
+
+        // Negative scale flips the rectangle, but the bounds are still normalized.
+        stream.SetTransform(D2D1::Matrix3x2F::Scale(-1, 1));
+        stream.FillRectangle(D2D1_RECT_F{ 1, 1, 2, 2 }, Red);
+
+        AssertRectsEqual(D2D1_RECT_F{ 12, 3, 14, 6 }, stream.GetCommandBounds(0));
+        AssertRectsEqual(D2D1_RECT_F{ -2, 1, -1, 2 }, stream.GetCommandBounds(1));
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_CullsCommandsOutsideCullRect)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        stream.FillRectangle(D2D1_RECT_F{ 0, 0, 10, 10 }, Red);
+        stream.FillRectangle(D2D1_RECT_F{ 50, 0, 60, 10 }, Blue);
+        stream.FillRectangle(D2D1_RECT_F{ 5, 200, 10, 210 }, Red);
+        stream.FillRectangle(D2D1_RECT_F{ 90, 90, 110, 110 }, Blue);
+
+        D2D1_RECT_F cullRect{ 0, 0, 100, 100 };
+
+        auto statistics = f.Draw(stream, &cullRect);
+
+        Assert::AreEqual(3u, statistics.Drawn);
+        Assert::AreEqual(1u, statistics.Culled);
+        AssertFilledRects({ 0, 50, 90 }, f.FilledRects);
+
+        // Without a cull rect, everything is drawn.
+        f.FilledRects.clear();
+        statistics = f.Draw(stream);
+
+        Assert::AreEqual(4u, statistics.Drawn);
+        Assert::AreEqual(0u, statistics.Culled);
+        Assert::AreEqual<size_t>(4, f.FilledRects.size());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_CoalescesSameColoredRuns)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        stream.FillRectangle(D2D1_RECT_F{ 0, 0, 1, 1 }, Red);
+        stream.FillRectangle(D2D1_RECT_F{ 1, 0, 2, 1 }, Red);
+        stream.FillRectangle(D2D1_RECT_F{ 2, 0, 3, 1 }, Blue);
+        stream.FillRectangle(D2D1_RECT_F{ 3, 0, 4, 1 }, Blue);
+        stream.FillRectangle(D2D1_RECT_F{ 500, 0, 501, 1 }, Red);
+        stream.FillRectangle(D2D1_RECT_F{ 4, 0, 5, 1 }, Blue);
+        stream.FillRectangle(D2D1_RECT_F{ 5, 0, 6, 1 }, Red);
+
+        D2D1_RECT_F cullRect{ 0, 0, 100, 100 };
+
+        auto statistics = f.Draw(stream, &cullRect);
+
+        // The culled red rectangle doesn't split the second blue run.
+        Assert::AreEqual(6u, statistics.Drawn);
+        Assert::AreEqual(1u, statistics.Culled);
+        Assert::AreEqual(3u, statistics.BrushChanges);
+
+        AssertFilledRects({ 0, 1, 2, 3, 4, 5 }, f.FilledRects);
+
+        Assert::AreEqual(f.FilledBrushes[0], f.FilledBrushes[1]);
+        Assert::AreEqual(f.FilledBrushes[2], f.FilledBrushes[3]);
+        Assert::AreEqual(f.FilledBrushes[2], f.FilledBrushes[4]);
+        Assert::AreEqual(f.FilledBrushes[0], f.FilledBrushes[5]);
+        Assert::AreNotEqual(f.FilledBrushes[0], f.FilledBrushes[2]);
+
+        // One cache lookup per run, rather than per command.
+        auto brushStatistics = f.Brushes.GetStatistics();
+        Assert::AreEqual<uint64_t>(3, brushStatistics.Hits + brushStatistics.Misses);
+    }
+
+    //
+    // Replays 100k FillRectangle and DrawLine commands in a handful of colors,
+    // once with the colors interleaved and once recorded in same-colored runs,
+    // counting how often D2D sees the brush change and how many cache lookups
+    // were made.  Timings are reported to the test log.
+    //
+
+    TEST_METHOD_EX(DrawingCommandStream_MixedColorPrimitives_Benchmark)
+    {
+        int const primitiveCount = 100000;
+        int const colorCount = 8;
+        int const runLength = 1000;
+
+        std::vector<Color> colors;
+
+        for (int i = 0; i < colorCount; i++)
+        {
+            colors.push_back(Color{ 255, static_cast<BYTE>(i * 32), 0, static_cast<BYTE>(255 - i * 32) });
+        }
+
+        auto record = [&](DrawingCommandStream& stream, std::function<int(int)> getColorIndex)
+        {
+            for (int i = 0; i < primitiveCount; i++)
+            {
+                auto& color = colors[getColorIndex(i)];
+                auto x = static_cast<float>(i % 1000);
+
+                if (i & 1)
+                    stream.FillRectangle(D2D1_RECT_F{ x, 0, x + 1, 1 }, color);
+                else
+                    stream.DrawLine(D2D1_POINT_2F{ x, 0 }, D2D1_POINT_2F{ x, 1 }, color, 1);
+            }
+        };
+
+        auto replay = [&](DrawingCommandStream const& stream, wchar_t const* name, uint32_t expectedRuns)
+        {
+            Fixture f;
+
+            ID2D1Brush* previousBrush = nullptr;
+            uint32_t brushSwitches = 0;
+
+            auto onDraw = [&](ID2D1Brush* brush)
+            {
+                if (brush != previousBrush)
+                    brushSwitches++;
+
+                previousBrush = brush;
+            };
+
+            f.DeviceContext->FillRectangleMethod.AllowAnyCall([&](D2D1_RECT_F const*, ID2D1Brush* brush) { onDraw(brush); });
+            f.DeviceContext->DrawLineMethod.AllowAnyCall([&](D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush* brush, float, ID2D1StrokeStyle*) { onDraw(brush); });
+
+            BenchmarkTimer timer;
+
+            auto statistics = f.Draw(stream);
+
+            auto elapsed = timer.ElapsedMicroseconds();
+
+            auto brushStatistics = f.Brushes.GetStatistics();
+
+            Assert::AreEqual<uint32_t>(primitiveCount, statistics.Drawn);
+            Assert::AreEqual(expectedRuns, statistics.BrushChanges);
+            Assert::AreEqual(expectedRuns, brushSwitches);
+            Assert::AreEqual<uint64_t>(expectedRuns, brushStatistics.Hits + brushStatistics.Misses);
+            Assert::AreEqual<uint64_t>(colorCount, brushStatistics.Misses);
+            Assert::AreEqual<uint64_t>(0, brushStatistics.Recolors);
+
+            wchar_t message[256];
+            swprintf_s(message, L"%d %s primitives: %lld us, %u brush changes\n", primitiveCount, name, elapsed, brushSwitches);
+            Logger::WriteMessage(message);
+        };
+
+        DrawingCommandStream interleaved;
+        record(interleaved, [=](int i) { return i % colorCount; });
+
+        DrawingCommandStream inRuns;
+        record(inRuns, [=](int i) { return (i / runLength) % colorCount; });
+
+        replay(interleaved, L"interleaved", primitiveCount);
+        replay(inRuns, L"same-colored run", primitiveCount / runLength);
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_Range)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        for (int i = 0; i < 5; i++)
+        {
+            stream.FillRectangle(D2D1_RECT_F{ static_cast<float>(i), 0, 10, 10 }, Red);
+        }
+
+        stream.Draw(f.DeviceContext.Get(), f.Brushes, nullptr, 1, 3);
+        AssertFilledRects({ 1, 2, 3 }, f.FilledRects);
+
+        stream.Draw(f.DeviceContext.Get(), f.Brushes, nullptr, 5, 0);
+        Assert::AreEqual<size_t>(3, f.FilledRects.size());
+
+        ExpectHResultException(E_INVALIDARG, [&] { stream.Draw(f.DeviceContext.Get(), f.Brushes, nullptr, 6, 0); });
+        ExpectHResultException(E_INVALIDARG, [&] { stream.Draw(f.DeviceContext.Get(), f.Brushes, nullptr, 4, 2); });
+        ExpectHResultException(E_INVALIDARG, [&] { stream.Draw(f.DeviceContext.Get(), f.Brushes, nullptr, 1, UINT32_MAX); });
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_AppliesRecordedTransformsOnTopOfBaseTransform)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        auto transform = D2D1::Matrix3x2F::Scale(2, 2);
+
+        stream.FillRectangle(D2D1_RECT_F{ 0, 0, 1, 1 }, Red);
+
+        // Only the last of several changes before a command is recorded.
+        stream.SetTransform(D2D1::Matrix3x2F::Rotation(30));
+        stream.SetTransform(transform);
+        stream.FillRectangle(D2D1_RECT_F{ 1, 0, 1, 1 }, Red);
+        stream.FillRectangle(D2D1_RECT_F{ 2, 0, 1, 1 }, Red);
+
+        stream.SetTransform(D2D1::Matrix3x2F::Identity());
+        stream.FillRectangle(D2D1_RECT_F{ 3, 0, 1, 1 }, Red);
+
+        // Setting a transform with nothing drawn afterwards has no effect.
+        stream.SetTransform(transform);
+
+        f.Draw(stream);
+
+        AssertFilledRects({ 0, 1, 2, 3 }, f.FilledRects);
+
+        // The transform is set once for the two scaled rectangles, then put
+        // back for the last, after which it is already the base transform.
+        Assert::AreEqual<size_t>(2, f.SetTransforms.size());
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(transform * *D2D1::Matrix3x2F::ReinterpretBaseType(&f.BaseTransform), f.SetTransforms[0]);
+        Assert::AreEqual(f.BaseTransform, f.SetTransforms[1]);
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_RestoresBaseTransform)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        stream.SetTransform(D2D1::Matrix3x2F::Scale(2, 2));
+        stream.FillRectangle(D2D1_RECT_F{ 0, 0, 1, 1 }, Red);
+
+        f.Draw(stream);
+
+        Assert::AreEqual<size_t>(2, f.SetTransforms.size());
+        Assert::AreEqual(f.BaseTransform, f.SetTransforms.back());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_CulledCommandsDontChangeTransform)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        stream.SetTransform(D2D1::Matrix3x2F::Translation(500, 0));
+        stream.FillRectangle(D2D1_RECT_F{ 0, 0, 1, 1 }, Red);
+
+        D2D1_RECT_F cullRect{ 0, 0, 100, 100 };
+
+        auto statistics = f.Draw(stream, &cullRect);
+
+        Assert::AreEqual(0u, statistics.Drawn);
+        Assert::AreEqual(1u, statistics.Culled);
+        Assert::IsTrue(f.SetTransforms.empty());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_EachCommandType)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        stream.FillRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Red);
+        stream.DrawRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Red, 5);
+        stream.FillRoundedRectangle(D2D1_ROUNDED_RECT{ { 1, 2, 3, 4 }, 6, 7 }, Red);
+        stream.DrawRoundedRectangle(D2D1_ROUNDED_RECT{ { 1, 2, 3, 4 }, 6, 7 }, Red, 5);
+        stream.FillEllipse(D2D1_ELLIPSE{ { 1, 2 }, 3, 4 }, Blue);
+        stream.DrawEllipse(D2D1_ELLIPSE{ { 1, 2 }, 3, 4 }, Blue, 5);
+        stream.DrawLine(D2D1_POINT_2F{ 1, 2 }, D2D1_POINT_2F{ 3, 4 }, Blue, 5);
+
+        f.DeviceContext->DrawRectangleMethod.SetExpectedCalls(1,
+            [](D2D1_RECT_F const* rect, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle* strokeStyle)
+            {
+                Assert::AreEqual(D2D1_RECT_F{ 1, 2, 3, 4 }, *rect);
+                Assert::AreEqual(5.0f, strokeWidth);
+                Assert::IsNull(strokeStyle);
+            });
+
+        f.DeviceContext->FillRoundedRectangleMethod.SetExpectedCalls(1,
+            [](D2D1_ROUNDED_RECT const* roundedRect, ID2D1Brush*)
+            {
+                Assert::AreEqual(D2D1_RECT_F{ 1, 2, 3, 4 }, roundedRect->rect);
+                Assert::AreEqual(6.0f, roundedRect->radiusX);
+                Assert::AreEqual(7.0f, roundedRect->radiusY);
+            });
+
+        f.DeviceContext->DrawRoundedRectangleMethod.SetExpectedCalls(1,
+            [](D2D1_ROUNDED_RECT const*, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle*)
+            {
+                Assert::AreEqual(5.0f, strokeWidth);
+            });
+
+        f.DeviceContext->FillEllipseMethod.SetExpectedCalls(1,
+            [](D2D1_ELLIPSE const* ellipse, ID2D1Brush*)
+            {
+                Assert::AreEqual(D2D1_POINT_2F{ 1, 2 }, ellipse->point);
+                Assert::AreEqual(3.0f, ellipse->radiusX);
+                Assert::AreEqual(4.0f, ellipse->radiusY);
+            });
+
+        f.DeviceContext->DrawEllipseMethod.SetExpectedCalls(1,
+            [](D2D1_ELLIPSE const*, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle*)
+            {
+                Assert::AreEqual(5.0f, strokeWidth);
+            });
+
+        f.DeviceContext->DrawLineMethod.SetExpectedCalls(1,
+            [](D2D1_POINT_2F p0, D2D1_POINT_2F p1, ID2D1Brush*, float strokeWidth, ID2D1StrokeStyle*)
+            {
+                Assert::AreEqual(D2D1_POINT_2F{ 1, 2 }, p0);
+                Assert::AreEqual(D2D1_POINT_2F{ 3, 4 }, p1);
+                Assert::AreEqual(5.0f, strokeWidth);
+            });
+
+        f.Draw(stream);
+
+        Assert::AreEqual<size_t>(1, f.FilledRects.size());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Draw_Polyline)
+    {
+        Fixture f;
+        DrawingCommandStream stream;
+
+        D2D1_POINT_2F points[] = { { 0, 0 }, { 10, -10 }, { 20, 5 } };
+        stream.DrawPolyline(_countof(points), points, Red, 3);
+
+        auto pathGeometry = Make<MockD2DPathGeometry>();
+        std::vector<D2D1_POINT_2F> drawnPoints;
+
+        f.DeviceContext->m_factory->CreatePathGeometryMethod.SetExpectedCalls(1,
+            [&](ID2D1PathGeometry1** value)
+            {
+                return pathGeometry.CopyTo(value);
+            });
+
+        pathGeometry->OpenMethod.SetExpectedCalls(1,
+            [&](ID2D1GeometrySink** value)
+            {
+                auto geometrySink = Make<MockD2DGeometrySink>();
+
+                geometrySink->BeginFigureMethod.SetExpectedCalls(1,
+                    [&](D2D1_POINT_2F point, D2D1_FIGURE_BEGIN)
+                    {
+                        drawnPoints.push_back(point);
+                    });
+
+                geometrySink->AddLinesMethod.SetExpectedCalls(1,
+                    [&](D2D1_POINT_2F const* linePoints, UINT32 count)
+                    {
+                        drawnPoints.insert(drawnPoints.end(), linePoints, linePoints + count);
+                    });
+
+                geometrySink->EndFigureMethod.SetExpectedCalls(1,
+                    [](D2D1_FIGURE_END mode)
+                    {
+                        Assert::AreEqual(D2D1_FIGURE_END_OPEN, mode);
+                    });
+
+                geometrySink->CloseMethod.SetExpectedCalls(1);
+
+                return geometrySink.CopyTo(value);
+            });
+
+        f.DeviceContext->DrawGeometryMethod.SetExpectedCalls(1,
+            [&](ID2D1Geometry* geometry, ID2D1Brush* brush, float strokeWidth, ID2D1StrokeStyle*)
+            {
+                Assert::IsTrue(IsSameInstance(pathGeometry.Get(), geometry));
+                Assert::IsNotNull(brush);
+                Assert::AreEqual(3.0f, strokeWidth);
+            });
+
+        f.Draw(stream);
+
+        Assert::AreEqual<size_t>(_countof(points), drawnPoints.size());
+
+        for (size_t i = 0; i < drawnPoints.size(); i++)
+        {
+            Assert::AreEqual(points[i], drawnPoints[i]);
+        }
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Clear)
+    {
+        DrawingCommandStream stream;
+
+        stream.SetTransform(D2D1::Matrix3x2F::Scale(2, 2));
+        stream.FillRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Red);
+
+        stream.Clear();
+
+        Assert::AreEqual(0u, stream.GetCommandCount());
+        Assert::AreEqual<size_t>(0, stream.GetByteCount());
+        AssertRectsEqual(D2D1_RECT_F{}, stream.GetBounds());
+        Assert::IsTrue(D2D1::Matrix3x2F::ReinterpretBaseType(&stream.GetTransform())->IsIdentity());
+
+        stream.FillRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Red);
+
+        AssertRectsEqual(D2D1_RECT_F{ 1, 2, 3, 4 }, stream.GetBounds());
+    }
+
+    static void RecordEverything(DrawingCommandStream& stream)
+    {
+        D2D1_POINT_2F points[] = { { 0, 0 }, { 10, -10 }, { 20, 5 } };
+
+        stream.FillRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Red);
+        stream.SetTransform(D2D1::Matrix3x2F::Scale(2, 2));
+        stream.DrawRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Blue, 5);
+        stream.DrawPolyline(_countof(points), points, Red, 1);
+        stream.SetTransform(D2D1::Matrix3x2F::Identity());
+        stream.FillEllipse(D2D1_ELLIPSE{ { 1, 2 }, 3, 4 }, Blue);
+        stream.DrawLine(D2D1_POINT_2F{ 1, 2 }, D2D1_POINT_2F{ 3, 4 }, Blue, 5);
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_SaveAndLoad_RoundTrips)
+    {
+        DrawingCommandStream stream;
+        RecordEverything(stream);
+
+        auto bytes = stream.Save();
+
+        DrawingCommandStream loaded;
+        loaded.Load(bytes.data(), bytes.size());
+
+        Assert::AreEqual(stream.GetCommandCount(), loaded.GetCommandCount());
+        Assert::AreEqual(stream.GetByteCount(), loaded.GetByteCount());
+        AssertRectsEqual(stream.GetBounds(), loaded.GetBounds());
+
+        for (uint32_t i = 0; i < stream.GetCommandCount(); i++)
+        {
+            AssertRectsEqual(stream.GetCommandBounds(i), loaded.GetCommandBounds(i));
+        }
+
+        Assert::IsTrue(bytes == loaded.Save());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_SaveAndLoad_PreservesTransforms)
+    {
+        DrawingCommandStream stream;
+
+        stream.SetTransform(D2D1::Matrix3x2F::Scale(2, 2));
+        stream.FillRectangle(D2D1_RECT_F{ 0, 0, 1, 1 }, Red);
+        stream.SetTransform(D2D1::Matrix3x2F::Identity());
+        stream.FillRectangle(D2D1_RECT_F{ 1, 0, 1, 1 }, Red);
+
+        auto bytes = stream.Save();
+
+        DrawingCommandStream loaded;
+        loaded.Load(bytes.data(), bytes.size());
+
+        Fixture f;
+        f.Draw(loaded);
+
+        // Scaled for the first rectangle, and back to the base transform for the second.
+        Assert::AreEqual<size_t>(2, f.SetTransforms.size());
+        Assert::AreEqual<D2D1_MATRIX_3X2_F>(D2D1::Matrix3x2F::Scale(2, 2) * *D2D1::Matrix3x2F::ReinterpretBaseType(&f.BaseTransform), f.SetTransforms[0]);
+        Assert::AreEqual(f.BaseTransform, f.SetTransforms[1]);
+
+        // Commands recorded after loading use the last transform in the data.
+        Assert::IsTrue(D2D1::Matrix3x2F::ReinterpretBaseType(&loaded.GetTransform())->IsIdentity());
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Load_RecomputesBoundsFromCommandData)
+    {
+        DrawingCommandStream stream;
+
+        stream.SetTransform(D2D1::Matrix3x2F::Translation(100, 0));
+        stream.FillRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Red);
+
+        auto bytes = stream.Save();
+
+        // Saved header, transform command, then the rectangle command's
+        // header, color and stroke width come before its rect.
+        size_t const rectOffset = 16 + 32 + 16;
+
+        float const movedLeft = -50;
+        memcpy(bytes.data() + rectOffset, &movedLeft, sizeof(movedLeft));
+
+        DrawingCommandStream loaded;
+        loaded.Load(bytes.data(), bytes.size());
+
+        // The bounds follow the data that will actually be drawn, under the
+        // transform that will be applied to it.
+        AssertRectsEqual(D2D1_RECT_F{ 50, 2, 103, 4 }, loaded.GetCommandBounds(0));
+        AssertRectsEqual(D2D1_RECT_F{ 50, 2, 103, 4 }, loaded.GetBounds());
+
+        // So a cull rect over the moved part still draws it.
+        Fixture f;
+        D2D1_RECT_F cullRect{ 0, 0, 60, 10 };
+
+        Assert::AreEqual(1u, f.Draw(loaded, &cullRect).Drawn);
+    }
+
+    TEST_METHOD_EX(DrawingCommandStream_Load_RejectsInvalidData)
+    {
+        DrawingCommandStream stream;
+        RecordEverything(stream);
+
+        auto validBytes = stream.Save();
+
+        // Offsets within the saved data.
+        size_t const headerSize = 16;
+        size_t const firstCommandType = headerSize;
+        size_t const firstCommandSize = headerSize + 4;
+
+        auto expectInvalid = [&](std::vector<uint8_t> const& bytes)
+        {
+            DrawingCommandStream loaded;
+            loaded.FillRectangle(D2D1_RECT_F{ 1, 2, 3, 4 }, Red);
+
+            ExpectHResultException(E_INVALIDARG, [&] { loaded.Load(bytes.data(), bytes.size()); });
+
+            // Failed loads leave the stream empty.
+            Assert::AreEqual(0u, loaded.GetCommandCount());
+            Assert::AreEqual<size_t>(0, loaded.GetByteCount());
+        };
+
+        expectInvalid(std::vector<uint8_t>());
+        expectInvalid(std::vector<uint8_t>(validBytes.begin(), validBytes.begin() + headerSize - 1));
+        expectInvalid(std::vector<uint8_t>(validBytes.begin(), validBytes.end() - 1));
+
+        auto corrupt = [&](size_t offset, uint32_t value, size_t valueSize)
+        {
+            auto bytes = validBytes;
+            memcpy(bytes.data() + offset, &value, valueSize);
+            return bytes;
+        };
+
+        expectInvalid(corrupt(0, 0, 4));                                    // Magic
+        expectInvalid(corrupt(4, 1, 4));                                    // Version (1 stored bounds in the data)
+        expectInvalid(corrupt(8, stream.GetCommandCount() + 1, 4));         // Command count
+        expectInvalid(corrupt(12, 0, 4));                                   // Byte count
+        expectInvalid(corrupt(firstCommandType, 100, 2));                   // Command type
+        expectInvalid(corrupt(firstCommandSize, 0, 4));                     // Command size
+        expectInvalid(corrupt(firstCommandSize, 1000000, 4));
+        expectInvalid(corrupt(firstCommandSize, 50, 4));
+
+        // Changing the type of a fixed size command makes its size wrong.
+        expectInvalid(corrupt(firstCommandType, 8, 2));
+
+        // The original data still loads.
+        DrawingCommandStream loaded;
+        loaded.Load(validBytes.data(), validBytes.size());
+        Assert::AreEqual(stream.GetCommandCount(), loaded.GetCommandCount());
+    }
+};
+
+TEST_CLASS(CanvasDrawingRecordingUnitTests)
+{
+public:
+    TEST_METHOD_EX(CanvasDrawingRecording_Implements_Expected_Interfaces)
+    {
+        auto recording = Make<CanvasDrawingRecording>();
+
+        ASSERT_IMPLEMENTS_INTERFACE(recording, ICanvasDrawingRecording);
+        ASSERT_IMPLEMENTS_INTERFACE(recording, ABI::Windows::Foundation::IClosable);
+    }
+
+    TEST_METHOD_EX(CanvasDrawingRecording_Transform)
+    {
+        auto recording = Make<CanvasDrawingRecording>();
+
+        Matrix3x2 transform;
+        ThrowIfFailed(recording->get_Transform(&transform));
+        Assert::AreEqual(Matrix3x2{ 1, 0, 0, 1, 0, 0 }, transform);
+
+        Matrix3x2 scale{ 2, 0, 0, 3, 10, 20 };
+        ThrowIfFailed(recording->put_Transform(scale));
+        ThrowIfFailed(recording->get_Transform(&transform));
+        Assert::AreEqual(scale, transform);
+
+        ThrowIfFailed(recording->FillRectangle(Rect{ 1, 1, 1, 1 }, Red));
+
+        Rect bounds;
+        ThrowIfFailed(recording->get_Bounds(&bounds));
+        Assert::AreEqual(Rect{ 12, 23, 2, 3 }, bounds);
+    }
+
+    TEST_METHOD_EX(CanvasDrawingRecording_GetBytesAndCreateFromBytes_RoundTrip)
+    {
+        auto recording = Make<CanvasDrawingRecording>();
+
+        Vector2 points[] = { { 0, 0 }, { 10, 10 }, { 20, 0 } };
+
+        ThrowIfFailed(recording->FillRectangle(Rect{ 1, 2, 3, 4 }, Red));
+        ThrowIfFailed(recording->DrawEllipse(Vector2{ 5, 6 }, 7, 8, Blue, 2));
+        ThrowIfFailed(recording->DrawPolyline(_countof(points), points, Blue, 1));
+
+        ComArray<BYTE> bytes;
+        ThrowIfFailed(recording->GetBytes(bytes.GetAddressOfSize(), bytes.GetAddressOfData()));
+
+        auto factory = Make<CanvasDrawingRecordingFactory>();
+
+        ComPtr<ICanvasDrawingRecording> loaded;
+        ThrowIfFailed(factory->CreateFromBytes(bytes.GetSize(), bytes.GetData(), &loaded));
+
+        int32_t commandCount;
+        ThrowIfFailed(loaded->get_CommandCount(&commandCount));
+        Assert::AreEqual(3, commandCount);
+
+        Rect originalBounds, loadedBounds;
+        ThrowIfFailed(recording->get_Bounds(&originalBounds));
+        ThrowIfFailed(loaded->get_Bounds(&loadedBounds));
+        Assert::AreEqual(originalBounds, loadedBounds);
+
+        // Corrupted data is rejected.
+        bytes.GetData()[0] ^= 1;
+        Assert::AreEqual(E_INVALIDARG, factory->CreateFromBytes(bytes.GetSize(), bytes.GetData(), &loaded));
+        Assert::IsNull(loaded.Get());
+
+        Assert::AreEqual(E_INVALIDARG, factory->CreateFromBytes(0, nullptr, &loaded));
+    }
+
+    TEST_METHOD_EX(CanvasDrawingRecording_InvalidArgs)
+    {
+        auto recording = Make<CanvasDrawingRecording>();
+
+        Assert::AreEqual(E_INVALIDARG, recording->get_Transform(nullptr));
+        Assert::AreEqual(E_INVALIDARG, recording->get_CommandCount(nullptr));
+        Assert::AreEqual(E_INVALIDARG, recording->get_Bounds(nullptr));
+        Assert::AreEqual(E_INVALIDARG, recording->DrawPolyline(1, nullptr, Red, 1));
+
+        ComArray<BYTE> bytes;
+        Assert::AreEqual(E_INVALIDARG, recording->GetBytes(nullptr, bytes.GetAddressOfData()));
+        Assert::AreEqual(E_INVALIDARG, recording->GetBytes(bytes.GetAddressOfSize(), nullptr));
+    }
+
+    TEST_METHOD_EX(CanvasDrawingRecording_Closed)
+    {
+        auto recording = Make<CanvasDrawingRecording>();
+
+        Assert::AreEqual(S_OK, recording->Close());
+
+        Matrix3x2 transform;
+        int32_t commandCount;
+        Rect bounds;
+        ComArray<BYTE> bytes;
+
+        Assert::AreEqual(RO_E_CLOSED, recording->get_Transform(&transform));
+        Assert::AreEqual(RO_E_CLOSED, recording->put_Transform(transform));
+        Assert::AreEqual(RO_E_CLOSED, recording->get_CommandCount(&commandCount));
+        Assert::AreEqual(RO_E_CLOSED, recording->get_Bounds(&bounds));
+        Assert::AreEqual(RO_E_CLOSED, recording->FillRectangle(Rect{}, Red));
+        Assert::AreEqual(RO_E_CLOSED, recording->DrawRectangle(Rect{}, Red, 1));
+        Assert::AreEqual(RO_E_CLOSED, recording->FillRoundedRectangle(Rect{}, 1, 1, Red));
+        Assert::AreEqual(RO_E_CLOSED, recording->DrawRoundedRectangle(Rect{}, 1, 1, Red, 1));
+        Assert::AreEqual(RO_E_CLOSED, recording->FillEllipse(Vector2{}, 1, 1, Red));
+        Assert::AreEqual(RO_E_CLOSED, recording->DrawEllipse(Vector2{}, 1, 1, Red, 1));
+        Assert::AreEqual(RO_E_CLOSED, recording->DrawLine(Vector2{}, Vector2{}, Red, 1));
+        Assert::AreEqual(RO_E_CLOSED, recording->DrawPolyline(0, nullptr, Red, 1));
+        Assert::AreEqual(RO_E_CLOSED, recording->Clear());
+        Assert::AreEqual(RO_E_CLOSED, recording->GetBytes(bytes.GetAddressOfSize(), bytes.GetAddressOfData()));
+    }
+};
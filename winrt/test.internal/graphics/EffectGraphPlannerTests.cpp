@@ -0,0 +1,379 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <lib/effects/EffectGraphPlanner.h>
+
+#include "stubs/TestEffect.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas::Effects;
+
+TEST_CLASS(EffectGraphPlannerTests)
+{
+    struct Fixture
+    {
+        ComPtr<StubD2DDevice> StubDevice;
+        ComPtr<StubD2DDeviceContextWithGetFactory> DeviceContext;
+        ComPtr<StubCanvasDevice> CanvasDevice;
+        ComPtr<CanvasDrawingSession> DrawingSession;
+        ComPtr<CanvasBitmap> Bitmap;
+        float Dpi;
+
+        std::vector<ComPtr<MockD2DEffectThatCountsCalls>> MockEffects;
+
+        // GetImageWorldBounds results, looked up by the effect ID of the realized D2D effect.
+        std::vector<std::pair<IID, D2D1_RECT_F>> Bounds;
+
+        Fixture()
+            : StubDevice(Make<StubD2DDevice>())
+            , DeviceContext(Make<StubD2DDeviceContextWithGetFactory>())
+            , Dpi(DEFAULT_DPI)
+        {
+            CanvasDevice = Make<StubCanvasDevice>(StubDevice);
+            DrawingSession = CanvasDrawingSession::CreateNew(DeviceContext.Get(), std::make_shared<StubCanvasDrawingSessionAdapter>(), CanvasDevice.Get());
+            Bitmap = CreateStubCanvasBitmap(DEFAULT_DPI, CanvasDevice.Get());
+
+            DeviceContext->GetDeviceMethod.AllowAnyCallAlwaysCopyValueToParam(StubDevice);
+            DeviceContext->GetPrimitiveBlendMethod.AllowAnyCall();
+            DeviceContext->GetTransformMethod.AllowAnyCall();
+            DeviceContext->SetTransformMethod.AllowAnyCall();
+
+            DeviceContext->GetDpiMethod.AllowAnyCall(
+                [=](float* dpiX, float* dpiY)
+                {
+                    *dpiX = Dpi;
+                    *dpiY = Dpi;
+                });
+
+            DeviceContext->GetTargetMethod.AllowAnyCall(
+                [](ID2D1Image** target)
+                {
+                    *target = nullptr;
+                });
+
+            DeviceContext->CreateEffectMethod.AllowAnyCall(
+                [=](IID const& effectId, ID2D1Effect** effect)
+                {
+                    MockEffects.push_back(Make<MockD2DEffectThatCountsCalls>(effectId));
+                    return MockEffects.back().CopyTo(effect);
+                });
+
+            DeviceContext->GetImageWorldBoundsMethod.AllowAnyCall(
+                [=](ID2D1Image* image, D2D1_RECT_F* bounds)
+                {
+                    auto effectId = FindMockEffect(image)->m_effectId;
+
+                    auto it = std::find_if(Bounds.begin(), Bounds.end(), [&](std::pair<IID, D2D1_RECT_F> const& b) { return IsEqualGUID(b.first, effectId); });
+                    Assert::IsTrue(it != Bounds.end());
+
+                    *bounds = it->second;
+                    return S_OK;
+                });
+        }
+
+        ComPtr<TestEffect> MakeEffect(IID const& effectId, D2D1_RECT_F const& bounds, std::vector<IGraphicsEffectSource*> const& sources)
+        {
+            auto effect = Make<TestEffect>(effectId, 0, static_cast<int>(sources.size()), true);
+
+            for (unsigned int i = 0; i < sources.size(); i++)
+            {
+                effect->SetSource(i, sources[i]);
+            }
+
+            Bounds.push_back(std::make_pair(effectId, bounds));
+
+            return effect;
+        }
+
+        MockD2DEffectThatCountsCalls* FindMockEffect(ID2D1Image* image)
+        {
+            auto it = std::find_if(MockEffects.begin(), MockEffects.end(), [&](ComPtr<MockD2DEffectThatCountsCalls> const& e) { return IsSameInstance(e.Get(), image); });
+            Assert::IsTrue(it != MockEffects.end());
+            return it->Get();
+        }
+
+        MockD2DEffectThatCountsCalls* FindMockEffect(IID const& effectId)
+        {
+            auto it = std::find_if(MockEffects.begin(), MockEffects.end(), [&](ComPtr<MockD2DEffectThatCountsCalls> const& e) { return IsEqualGUID(e->m_effectId, effectId); });
+            Assert::IsTrue(it != MockEffects.end());
+            return it->Get();
+        }
+    };
+
+    template<typename T>
+    static T GetSystemProperty(MockD2DEffectThatCountsCalls* mockEffect, D2D1_PROPERTY index)
+    {
+        auto it = mockEffect->m_systemProperties.find(index);
+
+        if (it == mockEffect->m_systemProperties.end())
+            return T{};
+
+        Assert::AreEqual(sizeof(T), it->second.size());
+        return *reinterpret_cast<T const*>(it->second.data());
+    }
+
+    static bool GetCacheOutput(ComPtr<TestEffect> const& effect)
+    {
+        boolean value;
+        ThrowIfFailed(effect->get_CacheOutput(&value));
+        return !!value;
+    }
+
+    // Diamond shaped graph: blend <- (blur, shadow) <- saturation <- bitmap.
+    struct DiamondGraph
+    {
+        ComPtr<TestEffect> Shared;
+        ComPtr<TestEffect> Left;
+        ComPtr<TestEffect> Right;
+        ComPtr<TestEffect> Root;
+
+        DiamondGraph(Fixture& f)
+        {
+            Shared = f.MakeEffect(CLSID_D2D1Saturation, D2D1_RECT_F{ 0, 0, 50, 50 }, { f.Bitmap.Get() });
+            Left   = f.MakeEffect(CLSID_D2D1GaussianBlur, D2D1_RECT_F{ -25, -25, 75, 75 }, { As<IGraphicsEffectSource>(Shared).Get() });
+            Right  = f.MakeEffect(CLSID_D2D1Shadow, D2D1_RECT_F{ -25, -25, 75, 75 }, { As<IGraphicsEffectSource>(Shared).Get() });
+            Root   = f.MakeEffect(CLSID_D2D1Blend, D2D1_RECT_F{ -25, -25, 75, 75 }, { As<IGraphicsEffectSource>(Left).Get(), As<IGraphicsEffectSource>(Right).Get() });
+        }
+    };
+
+    TEST_METHOD_EX(EffectGraphPlanner_Analyze)
+    {
+        Fixture f;
+        DiamondGraph graph(f);
+
+        EffectGraphPlanner planner;
+
+        planner.Analyze(As<ICanvasEffect>(graph.Root).Get(), f.DrawingSession.Get());
+
+        // Nodes are discovered depth first, and shared sources are only listed once.
+        auto& nodes = planner.Nodes();
+
+        Assert::AreEqual<size_t>(4, nodes.size());
+
+        Assert::IsTrue(IsSameInstance(graph.Root.Get(), nodes[0].Effect.Get()));
+        Assert::IsTrue(IsSameInstance(graph.Left.Get(), nodes[1].Effect.Get()));
+        Assert::IsTrue(IsSameInstance(graph.Shared.Get(), nodes[2].Effect.Get()));
+        Assert::IsTrue(IsSameInstance(graph.Right.Get(), nodes[3].Effect.Get()));
+
+        Assert::IsTrue(nodes[0].Sources == std::vector<size_t>{ 1, 3 });
+        Assert::IsTrue(nodes[2].Sources.empty());
+        Assert::IsTrue(nodes[2].Consumers == std::vector<size_t>{ 1, 3 });
+        Assert::IsTrue(nodes[0].Consumers.empty());
+
+        Assert::AreEqual(4u, nodes[0].SubgraphSize);
+        Assert::AreEqual(2u, nodes[1].SubgraphSize);
+        Assert::AreEqual(1u, nodes[2].SubgraphSize);
+        Assert::AreEqual(2u, nodes[3].SubgraphSize);
+
+        Assert::AreEqual(-25.0f, nodes[0].Bounds.X);
+        Assert::AreEqual(100.0f, nodes[0].Bounds.Width);
+
+        for (auto& node : nodes)
+        {
+            Assert::IsTrue(node.IsBounded);
+            Assert::AreEqual<uint64_t>(node.Effect == nodes[2].Effect ? 2500 : 10000, node.PixelCount);
+            Assert::AreEqual(D2D1_BUFFER_PRECISION_UNKNOWN, node.Precision);
+            Assert::IsFalse(node.CacheOutput);
+        }
+
+        // Pixel counts follow the DPI of the resource creator.
+        f.Dpi = DEFAULT_DPI * 2;
+
+        planner.Analyze(As<ICanvasEffect>(graph.Root).Get(), f.DrawingSession.Get());
+
+        Assert::AreEqual<uint64_t>(40000, planner.Nodes()[0].PixelCount);
+        Assert::AreEqual<uint64_t>(10000, planner.Nodes()[2].PixelCount);
+    }
+
+    TEST_METHOD_EX(EffectGraphPlanner_PlanStaysWithinBudget)
+    {
+        Fixture f;
+        DiamondGraph graph(f);
+
+        EffectGraphPlanner planner;
+
+        planner.Analyze(As<ICanvasEffect>(graph.Root).Get(), f.DrawingSession.Get());
+
+        EffectGraphPlanOptions options;
+
+        // Nothing fits in an empty budget.
+        auto plan = planner.Plan(options);
+
+        Assert::AreEqual<size_t>(4, plan.Entries.size());
+        Assert::AreEqual<uint64_t>(0, plan.CachedBytes);
+        Assert::AreEqual<uint64_t>(40000 * 3 + 10000, plan.IntermediateBytes);
+
+        for (auto& entry : plan.Entries)
+        {
+            Assert::IsFalse(entry.CacheOutput);
+        }
+
+        // The shared effect is the best value for money.
+        options.ByteBudget = 30000;
+
+        plan = planner.Plan(options);
+
+        Assert::AreEqual<uint64_t>(10000, plan.CachedBytes);
+        Assert::IsFalse(plan.Entries[0].CacheOutput);
+        Assert::IsFalse(plan.Entries[1].CacheOutput);
+        Assert::IsTrue(plan.Entries[2].CacheOutput);
+        Assert::IsFalse(plan.Entries[3].CacheOutput);
+
+        // When the root fits, caching anything below it would be wasted memory.
+        options.ByteBudget = 100000;
+
+        plan = planner.Plan(options);
+
+        Assert::AreEqual<uint64_t>(40000, plan.CachedBytes);
+        Assert::IsTrue(plan.Entries[0].CacheOutput);
+        Assert::IsFalse(plan.Entries[1].CacheOutput);
+        Assert::IsFalse(plan.Entries[2].CacheOutput);
+        Assert::IsFalse(plan.Entries[3].CacheOutput);
+
+        // A higher default precision makes everything bigger.
+        options.ByteBudget = 30000;
+        options.DefaultPrecision = D2D1_BUFFER_PRECISION_16BPC_FLOAT;
+
+        plan = planner.Plan(options);
+
+        Assert::AreEqual<uint64_t>(20000, plan.CachedBytes);
+        Assert::IsTrue(plan.Entries[2].CacheOutput);
+        Assert::AreEqual<uint64_t>(80000 * 3 + 20000, plan.IntermediateBytes);
+    }
+
+    TEST_METHOD_EX(EffectGraphPlanner_ApplySetsCacheOutputOnD2DEffects)
+    {
+        Fixture f;
+        DiamondGraph graph(f);
+
+        EffectGraphPlanner planner;
+
+        planner.Analyze(As<ICanvasEffect>(graph.Root).Get(), f.DrawingSession.Get());
+
+        Assert::AreEqual<size_t>(4, f.MockEffects.size());
+
+        EffectGraphPlanOptions options;
+        options.ByteBudget = 30000;
+
+        planner.Apply(planner.Plan(options));
+
+        Assert::AreEqual<BOOL>(TRUE, GetSystemProperty<BOOL>(f.FindMockEffect(CLSID_D2D1Saturation), D2D1_PROPERTY_CACHED));
+        Assert::AreEqual<BOOL>(FALSE, GetSystemProperty<BOOL>(f.FindMockEffect(CLSID_D2D1Blend), D2D1_PROPERTY_CACHED));
+        Assert::IsTrue(GetCacheOutput(graph.Shared));
+        Assert::IsFalse(GetCacheOutput(graph.Root));
+
+        // Replanning with a bigger budget moves the cache up to the root.
+        options.ByteBudget = 100000;
+
+        planner.Apply(planner.Plan(options));
+
+        Assert::AreEqual<BOOL>(FALSE, GetSystemProperty<BOOL>(f.FindMockEffect(CLSID_D2D1Saturation), D2D1_PROPERTY_CACHED));
+        Assert::AreEqual<BOOL>(TRUE, GetSystemProperty<BOOL>(f.FindMockEffect(CLSID_D2D1Blend), D2D1_PROPERTY_CACHED));
+        Assert::IsFalse(GetCacheOutput(graph.Shared));
+        Assert::IsTrue(GetCacheOutput(graph.Root));
+
+        // Applying the same plan again leaves the D2D effects alone.
+        auto setValueCalls = f.FindMockEffect(CLSID_D2D1Blend)->m_setValueCalls;
+
+        planner.Apply(planner.Plan(options));
+
+        Assert::AreEqual(setValueCalls, f.FindMockEffect(CLSID_D2D1Blend)->m_setValueCalls);
+        Assert::AreEqual<size_t>(4, f.MockEffects.size());
+    }
+
+    TEST_METHOD_EX(EffectGraphPlanner_CanvasImageOptimizeEffectCaching)
+    {
+        Fixture f;
+        DiamondGraph graph(f);
+
+        f.DeviceContext->GetRenderingControlsMethod.AllowAnyCall(
+            [](D2D1_RENDERING_CONTROLS* renderingControls)
+            {
+                *renderingControls = D2D1_RENDERING_CONTROLS{ D2D1_BUFFER_PRECISION_UNKNOWN, { 1024, 1024 } };
+            });
+
+        auto factory = Make<CanvasImageFactory>();
+        auto root = As<ICanvasEffect>(graph.Root);
+        uint64_t cachedBytes;
+
+        Assert::AreEqual(E_INVALIDARG, factory->OptimizeEffectCaching(nullptr, f.DrawingSession.Get(), 0, &cachedBytes));
+        Assert::AreEqual(E_INVALIDARG, factory->OptimizeEffectCaching(root.Get(), nullptr, 0, &cachedBytes));
+        Assert::AreEqual(E_INVALIDARG, factory->OptimizeEffectCaching(root.Get(), f.DrawingSession.Get(), 0, nullptr));
+
+        ThrowIfFailed(factory->OptimizeEffectCaching(root.Get(), f.DrawingSession.Get(), 30000, &cachedBytes));
+
+        Assert::AreEqual<uint64_t>(10000, cachedBytes);
+        Assert::IsTrue(GetCacheOutput(graph.Shared));
+        Assert::IsFalse(GetCacheOutput(graph.Root));
+
+        ThrowIfFailed(factory->OptimizeEffectCachingWithPrecisionReduction(root.Get(), f.DrawingSession.Get(), 100000, true, &cachedBytes));
+
+        Assert::AreEqual<uint64_t>(40000, cachedBytes);
+        Assert::IsFalse(GetCacheOutput(graph.Shared));
+        Assert::IsTrue(GetCacheOutput(graph.Root));
+
+        // The drawing session's default effect precision is used for effects that don't specify one.
+        f.DeviceContext->GetRenderingControlsMethod.AllowAnyCall(
+            [](D2D1_RENDERING_CONTROLS* renderingControls)
+            {
+                *renderingControls = D2D1_RENDERING_CONTROLS{ D2D1_BUFFER_PRECISION_16BPC_FLOAT, { 1024, 1024 } };
+            });
+
+        ThrowIfFailed(factory->OptimizeEffectCaching(root.Get(), f.DrawingSession.Get(), 30000, &cachedBytes));
+
+        Assert::AreEqual<uint64_t>(20000, cachedBytes);
+        Assert::IsTrue(GetCacheOutput(graph.Shared));
+    }
+
+    TEST_METHOD_EX(EffectGraphPlanner_ReducesPrecisionToFitBudget)
+    {
+        Fixture f;
+
+        // Root with infinite bounds <- high precision blur <- bitmap.
+        auto child = f.MakeEffect(CLSID_D2D1GaussianBlur, D2D1_RECT_F{ 0, 0, 100, 100 }, { f.Bitmap.Get() });
+        auto root = f.MakeEffect(CLSID_D2D1Border, D2D1_RECT_F{ -FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX }, { As<IGraphicsEffectSource>(child).Get() });
+
+        auto precision = Make<Nullable<CanvasBufferPrecision>>(CanvasBufferPrecision::Precision32Float);
+        ThrowIfFailed(child->put_BufferPrecision(precision.Get()));
+
+        EffectGraphPlanner planner;
+
+        planner.Analyze(As<ICanvasEffect>(root).Get(), f.DrawingSession.Get());
+
+        auto& nodes = planner.Nodes();
+
+        Assert::IsFalse(nodes[0].IsBounded);
+        Assert::AreEqual<uint64_t>(0, nodes[0].PixelCount);
+        Assert::AreEqual(D2D1_BUFFER_PRECISION_32BPC_FLOAT, nodes[1].Precision);
+
+        // 160000 bytes at full precision doesn't fit.
+        EffectGraphPlanOptions options;
+        options.ByteBudget = 40000;
+
+        auto plan = planner.Plan(options);
+
+        Assert::AreEqual<uint64_t>(160000, plan.Entries[1].Bytes);
+        Assert::IsFalse(plan.Entries[0].CacheOutput);
+        Assert::IsFalse(plan.Entries[1].CacheOutput);
+
+        // But does at 8 bits per channel.
+        options.AllowPrecisionReduction = true;
+
+        plan = planner.Plan(options);
+
+        Assert::IsFalse(plan.Entries[0].CacheOutput);
+        Assert::IsTrue(plan.Entries[1].CacheOutput);
+        Assert::AreEqual(D2D1_BUFFER_PRECISION_8BPC_UNORM, plan.Entries[1].Precision);
+        Assert::AreEqual<uint64_t>(40000, plan.CachedBytes);
+
+        planner.Apply(plan);
+
+        auto mockChild = f.FindMockEffect(CLSID_D2D1GaussianBlur);
+
+        Assert::AreEqual(D2D1_BUFFER_PRECISION_8BPC_UNORM, GetSystemProperty<D2D1_BUFFER_PRECISION>(mockChild, D2D1_PROPERTY_PRECISION));
+        Assert::AreEqual<BOOL>(TRUE, GetSystemProperty<BOOL>(mockChild, D2D1_PROPERTY_CACHED));
+        Assert::AreEqual<BOOL>(FALSE, GetSystemProperty<BOOL>(f.FindMockEffect(CLSID_D2D1Border), D2D1_PROPERTY_CACHED));
+    }
+};
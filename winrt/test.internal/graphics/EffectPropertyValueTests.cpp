@@ -0,0 +1,205 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas::Effects;
+
+TEST_CLASS(EffectPropertyValueTests)
+{
+    typedef EffectPropertyValue::Type Type;
+
+    static std::vector<float> GetArray(EffectPropertyValue const& value)
+    {
+        uint32_t valueCount;
+        auto data = value.GetSingleArray(&valueCount);
+        return std::vector<float>(data, data + valueCount);
+    }
+
+    static std::vector<float> MakeArray(uint32_t valueCount)
+    {
+        std::vector<float> result;
+
+        for (uint32_t i = 0; i < valueCount; i++)
+        {
+            result.push_back(static_cast<float>(i));
+        }
+
+        return result;
+    }
+
+    static ComPtr<IPropertyValueStatics> GetPropertyValueFactory()
+    {
+        ComPtr<IPropertyValueStatics> factory;
+        ThrowIfFailed(GetActivationFactory(HStringReference(RuntimeClass_Windows_Foundation_PropertyValue).Get(), &factory));
+        return factory;
+    }
+
+    TEST_METHOD_EX(EffectPropertyValue_DefaultIsEmpty)
+    {
+        EffectPropertyValue value;
+
+        Assert::IsTrue(value.GetType() == Type::Empty);
+        Assert::IsNull(value.Box(GetPropertyValueFactory().Get()).Get());
+
+        float result;
+        ExpectHResultException(TYPE_E_TYPEMISMATCH, [&] { value.Get(&result); });
+    }
+
+    TEST_METHOD_EX(EffectPropertyValue_Scalars)
+    {
+        EffectPropertyValue value;
+
+        value.Set(static_cast<boolean>(true));
+        Assert::IsTrue(value.GetType() == Type::Boolean);
+        boolean booleanResult;
+        value.Get(&booleanResult);
+        Assert::IsTrue(!!booleanResult);
+
+        value.Set(-3);
+        Assert::IsTrue(value.GetType() == Type::Int32);
+        int32_t int32Result;
+        value.Get(&int32Result);
+        Assert::AreEqual(-3, int32Result);
+
+        value.Set(7u);
+        Assert::IsTrue(value.GetType() == Type::UInt32);
+        uint32_t uint32Result;
+        value.Get(&uint32Result);
+        Assert::AreEqual(7u, uint32Result);
+
+        value.Set(1.5f);
+        Assert::IsTrue(value.GetType() == Type::Single);
+        float floatResult;
+        value.Get(&floatResult);
+        Assert::AreEqual(1.5f, floatResult);
+
+        ExpectHResultException(TYPE_E_TYPEMISMATCH, [&] { value.Get(&booleanResult); });
+        ExpectHResultException(TYPE_E_TYPEMISMATCH, [&] { value.Get(&uint32Result); });
+    }
+
+    TEST_METHOD_EX(EffectPropertyValue_IntegersAreCoerced)
+    {
+        // D2D reports UINT32 properties as Int32 when read back, but they
+        // must still be readable as uint32_t.
+        EffectPropertyValue value;
+        uint32_t uint32Result;
+        int32_t int32Result;
+        float floatResult;
+
+        value.Set(5);
+        value.Get(&uint32Result);
+        Assert::AreEqual(5u, uint32Result);
+        value.Get(&floatResult);
+        Assert::AreEqual(5.0f, floatResult);
+
+        value.Set(-1);
+        ExpectHResultException(E_BOUNDS, [&] { value.Get(&uint32Result); });
+
+        value.Set(6u);
+        value.Get(&int32Result);
+        Assert::AreEqual(6, int32Result);
+
+        value.Set(0x80000000u);
+        ExpectHResultException(E_BOUNDS, [&] { value.Get(&int32Result); });
+    }
+
+    TEST_METHOD_EX(EffectPropertyValue_Arrays)
+    {
+        for (uint32_t valueCount : { 0u, 2u, EffectPropertyValue::InlineArrayCapacity, EffectPropertyValue::InlineArrayCapacity + 1, 100u })
+        {
+            auto expected = MakeArray(valueCount);
+
+            EffectPropertyValue value;
+            value.Set(valueCount, expected.data());
+
+            Assert::IsTrue(value.GetType() == Type::SingleArray);
+            Assert::IsTrue(expected == GetArray(value));
+
+            // Copies are independent.
+            float other = -1;
+            auto copy = value;
+            value.Set(1, &other);
+            Assert::IsTrue(expected == GetArray(copy));
+        }
+    }
+
+    TEST_METHOD_EX(EffectPropertyValue_ResizeSingleArray_PreservesContents)
+    {
+        auto expected = MakeArray(100);
+
+        EffectPropertyValue value;
+
+        // Heap to inline.
+        value.Set(100, expected.data());
+        value.ResizeSingleArray(3);
+        Assert::IsTrue(MakeArray(3) == GetArray(value));
+
+        // Inline to heap.
+        auto data = value.ResizeSingleArray(100);
+        std::copy(expected.begin() + 3, expected.end(), data + 3);
+        Assert::IsTrue(expected == GetArray(value));
+
+        // From a different type.
+        value.Set(1.0f);
+        value.ResizeSingleArray(4);
+        Assert::IsTrue(value.GetType() == Type::SingleArray);
+        Assert::AreEqual<size_t>(4, GetArray(value).size());
+    }
+
+    TEST_METHOD_EX(EffectPropertyValue_Inspectable)
+    {
+        auto device = Make<StubCanvasDevice>();
+
+        EffectPropertyValue value;
+        value.Set(As<IInspectable>(device).Get());
+
+        Assert::IsTrue(value.GetType() == Type::Inspectable);
+        Assert::IsTrue(IsSameInstance(device.Get(), value.GetInspectable()));
+
+        ComPtr<ICanvasDevice> result;
+        value.Get(result.GetAddressOf());
+        Assert::IsTrue(IsSameInstance(device.Get(), result.Get()));
+
+        // Clearing releases the reference.
+        value.Clear();
+        Assert::IsTrue(value.GetType() == Type::Empty);
+
+        value.Set(static_cast<IInspectable*>(nullptr));
+        value.Get(result.ReleaseAndGetAddressOf());
+        Assert::IsNull(result.Get());
+    }
+
+    TEST_METHOD_EX(EffectPropertyValue_Box)
+    {
+        auto factory = GetPropertyValueFactory();
+
+        EffectPropertyValue value;
+        PropertyType propertyType;
+
+        value.Set(7u);
+        ThrowIfFailed(value.Box(factory.Get())->get_Type(&propertyType));
+        Assert::AreEqual<int>(PropertyType_UInt32, propertyType);
+
+        value.Set(7);
+        ThrowIfFailed(value.Box(factory.Get())->get_Type(&propertyType));
+        Assert::AreEqual<int>(PropertyType_Int32, propertyType);
+
+        float array[] = { 1, 2, 3 };
+        value.Set(3, array);
+        auto boxedArray = value.Box(factory.Get());
+        ThrowIfFailed(boxedArray->get_Type(&propertyType));
+        Assert::AreEqual<int>(PropertyType_SingleArray, propertyType);
+
+        ComArray<float> unboxedArray;
+        ThrowIfFailed(boxedArray->GetSingleArray(unboxedArray.GetAddressOfSize(), unboxedArray.GetAddressOfData()));
+        Assert::AreEqual(3u, unboxedArray.GetSize());
+        Assert::AreEqual(3.0f, unboxedArray[2]);
+
+        // Interfaces are boxed as a single element inspectable array.
+        value.Set(static_cast<IInspectable*>(nullptr));
+        ThrowIfFailed(value.Box(factory.Get())->get_Type(&propertyType));
+        Assert::AreEqual<int>(PropertyType_InspectableArray, propertyType);
+    }
+};
@@ -5,8 +5,13 @@
 #include "pch.h"
 
 #include <lib/effects/EffectTransferTable3D.h>
+#include <lib/effects/LookupTableFileParser.h>
+
+#include <DirectXPackedVector.h>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace DirectX;
+using namespace DirectX::PackedVector;
 
 TEST_CLASS(EffectTransferTable3DUnitTests)
 {
@@ -169,4 +174,325 @@ TEST_CLASS(EffectTransferTable3DUnitTests)
         // Invalid pixel format.
         ExpectHResultException(WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT, [&] { EffectTransferTable3D::CreateNew(device.Get(), 32, bytes, 2, 2, 2, PIXEL_FORMAT(B8G8R8A8UIntNormalized)); });
     }
+
+
+    // Returns the data passed to D2D when creating a table.
+    template<typename TValue, typename TCreator>
+    static std::vector<TValue> CaptureTableData(D2D1_BUFFER_PRECISION expectedPrecision, int expectedSize[3], TCreator&& createTable)
+    {
+        auto canvasDevice = Make<StubCanvasDevice>();
+        auto d2dContext = Make<StubD2DDeviceContext>();
+
+        canvasDevice->GetResourceCreationDeviceContextMethod.AllowAnyCall([&] { return DeviceContextLease(d2dContext); });
+
+        std::vector<TValue> capturedData;
+
+        d2dContext->CreateLookupTable3DMethod.SetExpectedCalls(1, [&](D2D1_BUFFER_PRECISION precision, UINT32 const* sizes, BYTE const* data, UINT32 dataSize, UINT32 const*, ID2D1LookupTable3D** result)
+        {
+            Assert::AreEqual(expectedPrecision, precision);
+
+            for (int i = 0; i < 3; i++)
+            {
+                Assert::AreEqual(expectedSize[i], static_cast<int>(sizes[i]));
+            }
+
+            Assert::AreEqual<size_t>(0, dataSize % sizeof(TValue));
+
+            auto values = reinterpret_cast<TValue const*>(data);
+            capturedData.assign(values, values + dataSize / sizeof(TValue));
+
+            *result = nullptr;
+            return S_OK;
+        });
+
+        createTable(canvasDevice.Get());
+
+        return capturedData;
+    }
+
+
+    template<typename TChannel, typename TConvert>
+    static void TestCreateFromPackedRgb(DirectXPixelFormat channelFormat, D2D1_BUFFER_PRECISION expectedPrecision, EffectTransferTable3DAxisOrder axisOrder, TConvert&& convert)
+    {
+        const int sizeB = 2;
+        const int sizeG = 3;
+        const int sizeR = 4;
+
+        // Each entry holds its own r, g and b indices.
+        std::vector<TChannel> rgb(sizeB * sizeG * sizeR * 3);
+
+        for (int r = 0; r < sizeR; r++)
+        {
+            for (int g = 0; g < sizeG; g++)
+            {
+                for (int b = 0; b < sizeB; b++)
+                {
+                    auto i = (axisOrder == EffectTransferTable3DAxisOrder::RedFastest) ? (b * sizeG + g) * sizeR + r
+                                                                                       : (r * sizeG + g) * sizeB + b;
+
+                    rgb[i * 3 + 0] = convert(static_cast<float>(r));
+                    rgb[i * 3 + 1] = convert(static_cast<float>(g));
+                    rgb[i * 3 + 2] = convert(static_cast<float>(b));
+                }
+            }
+        }
+
+        auto byteCount = static_cast<uint32_t>(rgb.size() * sizeof(TChannel));
+        auto bytes = reinterpret_cast<BYTE*>(rgb.data());
+
+        int expectedSize[3] = { sizeB, sizeG, sizeR };
+
+        auto rgba = CaptureTableData<TChannel>(expectedPrecision, expectedSize, [&](ICanvasResourceCreator* device)
+        {
+            EffectTransferTable3D::CreateNew(device, byteCount, bytes, sizeB, sizeG, sizeR, channelFormat, axisOrder);
+        });
+
+        Assert::AreEqual<size_t>(sizeB * sizeG * sizeR * 4, rgba.size());
+
+        size_t i = 0;
+
+        for (int r = 0; r < sizeR; r++)
+        {
+            for (int g = 0; g < sizeG; g++)
+            {
+                for (int b = 0; b < sizeB; b++)
+                {
+                    Assert::AreEqual(convert(static_cast<float>(r)), rgba[i++]);
+                    Assert::AreEqual(convert(static_cast<float>(g)), rgba[i++]);
+                    Assert::AreEqual(convert(static_cast<float>(b)), rgba[i++]);
+                    Assert::AreEqual(convert(1.0f), rgba[i++]);
+                }
+            }
+        }
+
+        // Providing too small a buffer should fail.
+        auto device = Make<StubCanvasDevice>();
+
+        ExpectHResultException(E_INVALIDARG, [&] { EffectTransferTable3D::CreateNew(device.Get(), byteCount - 1, bytes, sizeB, sizeG, sizeR, channelFormat, axisOrder); });
+    }
+
+
+    TEST_METHOD_EX(EffectTransferTable3D_CreateFromPackedRgb)
+    {
+        auto toFloat = [](float value) { return value; };
+        auto toHalf = [](float value) { return XMConvertFloatToHalf(value); };
+
+        for (auto axisOrder : { EffectTransferTable3DAxisOrder::BlueFastest, EffectTransferTable3DAxisOrder::RedFastest })
+        {
+            TestCreateFromPackedRgb<float>(PIXEL_FORMAT(R32Float), D2D1_BUFFER_PRECISION_32BPC_FLOAT, axisOrder, toFloat);
+            TestCreateFromPackedRgb<HALF>(PIXEL_FORMAT(R16Float), D2D1_BUFFER_PRECISION_16BPC_FLOAT, axisOrder, toHalf);
+        }
+    }
+
+
+    TEST_METHOD_EX(EffectTransferTable3D_CreateFromPackedRgb_InvalidArgs)
+    {
+        auto device = Make<StubCanvasDevice>();
+
+        float rgb[24] = { 0 };
+        auto bytes = reinterpret_cast<BYTE*>(rgb);
+
+        ExpectHResultException(E_INVALIDARG, [&] { EffectTransferTable3D::CreateNew(nullptr, sizeof(rgb), bytes, 2, 2, 2, PIXEL_FORMAT(R32Float), EffectTransferTable3DAxisOrder::BlueFastest); });
+        ExpectHResultException(E_INVALIDARG, [&] { EffectTransferTable3D::CreateNew(device.Get(), sizeof(rgb), nullptr, 2, 2, 2, PIXEL_FORMAT(R32Float), EffectTransferTable3DAxisOrder::BlueFastest); });
+        ExpectHResultException(E_INVALIDARG, [&] { EffectTransferTable3D::CreateNew(device.Get(), sizeof(rgb), bytes, 1, 2, 2, PIXEL_FORMAT(R32Float), EffectTransferTable3DAxisOrder::BlueFastest); });
+        ExpectHResultException(E_INVALIDARG, [&] { EffectTransferTable3D::CreateNew(device.Get(), INT_MAX, bytes, 2, 2, 257, PIXEL_FORMAT(R32Float), EffectTransferTable3DAxisOrder::BlueFastest); });
+        ExpectHResultException(E_INVALIDARG, [&] { EffectTransferTable3D::CreateNew(device.Get(), sizeof(rgb), bytes, 2, 2, 2, PIXEL_FORMAT(R32Float), static_cast<EffectTransferTable3DAxisOrder>(2)); });
+
+        // Only single channel float formats describe packed RGB data.
+        ExpectHResultException(WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT, [&] { EffectTransferTable3D::CreateNew(device.Get(), sizeof(rgb), bytes, 2, 2, 2, PIXEL_FORMAT(R32G32B32A32Float), EffectTransferTable3DAxisOrder::BlueFastest); });
+        ExpectHResultException(WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT, [&] { EffectTransferTable3D::CreateNew(device.Get(), sizeof(rgb), bytes, 2, 2, 2, PIXEL_FORMAT(R8UIntNormalized), EffectTransferTable3DAxisOrder::BlueFastest); });
+    }
+
+
+    static std::vector<XMFLOAT4> ParseLookupTable(std::string const& text, int expectedSize, size_t chunkSize = SIZE_MAX)
+    {
+        LookupTableFileParser parser;
+
+        for (size_t i = 0; i < text.size(); i += chunkSize)
+        {
+            parser.Parse(text.data() + i, std::min(chunkSize, text.size() - i));
+        }
+
+        parser.Finish();
+
+        Assert::AreEqual(expectedSize, parser.Size());
+
+        return parser.Table();
+    }
+
+
+    static void AssertTableEntry(std::vector<XMFLOAT4> const& table, int size, int r, int g, int b, float expectedR, float expectedG, float expectedB)
+    {
+        auto& entry = table[(r * size + g) * size + b];
+
+        const float tolerance = 0.000001f;
+
+        Assert::AreEqual(expectedR, entry.x, tolerance);
+        Assert::AreEqual(expectedG, entry.y, tolerance);
+        Assert::AreEqual(expectedB, entry.z, tolerance);
+        Assert::AreEqual(1.0f, entry.w);
+    }
+
+
+    static const char* CubeFile()
+    {
+        return
+            "# Created by a test\r\n"
+            "TITLE \"Test table\"\r\n"
+            "LUT_3D_SIZE 2\r\n"
+            "DOMAIN_MIN 0 0 0\r\n"
+            "DOMAIN_MAX 1.0 1.0 1.0\r\n"
+            "\r\n"
+            "0 0 0\r\n"
+            "1 0 0\r\n"
+            "0 0.5 0 # comment\r\n"
+            "1 0.5 0\r\n"
+            "0 0 0.25\r\n"
+            "1 0 0.25\r\n"
+            "0 0.5 0.25\r\n"
+            "1e0 +0.5 2.5E-1";
+    }
+
+
+    TEST_METHOD_EX(LookupTableFileParser_Cube)
+    {
+        auto table = ParseLookupTable(CubeFile(), 2);
+
+        // Red changes fastest in the file, but blue fastest in the table.
+        for (int r = 0; r < 2; r++)
+        {
+            for (int g = 0; g < 2; g++)
+            {
+                for (int b = 0; b < 2; b++)
+                {
+                    AssertTableEntry(table, 2, r, g, b, r * 1.0f, g * 0.5f, b * 0.25f);
+                }
+            }
+        }
+
+        // Splitting the text into chunks gives the same result.
+        for (size_t chunkSize : { 1, 3, 7 })
+        {
+            auto chunkedTable = ParseLookupTable(CubeFile(), 2, chunkSize);
+
+            Assert::IsTrue(memcmp(table.data(), chunkedTable.data(), table.size() * sizeof(XMFLOAT4)) == 0);
+        }
+    }
+
+
+    TEST_METHOD_EX(LookupTableFileParser_3dl)
+    {
+        // 10 bit output, inferred from the largest value.
+        auto table = ParseLookupTable(
+            "3DMESH\n"
+            "0 1023\n"
+            "0 0 0\n"
+            "0 0 1023\n"
+            "0 1023 0\n"
+            "0 1023 1023\n"
+            "1023 0 0\n"
+            "1023 0 1023\n"
+            "1023 1023 0\n"
+            "1023 1023 1023\n",
+            2);
+
+        // .3dl files already list entries with blue changing fastest.
+        for (int r = 0; r < 2; r++)
+        {
+            for (int g = 0; g < 2; g++)
+            {
+                for (int b = 0; b < 2; b++)
+                {
+                    AssertTableEntry(table, 2, r, g, b, static_cast<float>(r), static_cast<float>(g), static_cast<float>(b));
+                }
+            }
+        }
+
+        // 12 bit output, inferred from the largest value.
+        table = ParseLookupTable("0 4095\n" "0 0 0\n" "0 0 0\n" "0 0 0\n" "0 0 0\n" "0 0 0\n" "0 0 0\n" "0 0 0\n" "4095 2048 0\n", 2);
+        AssertTableEntry(table, 2, 1, 1, 1, 1.0f, 2048.0f / 4095, 0.0f);
+
+        // Bit depth and size given by a Mesh keyword.
+        std::string text = "Mesh 1 8\n0 255 511\n";
+
+        for (int i = 0; i < 26; i++)
+        {
+            text += "0 0 0\n";
+        }
+
+        text += "255 0 51\n";
+
+        table = ParseLookupTable(text, 3);
+        AssertTableEntry(table, 3, 2, 2, 2, 1.0f, 0.0f, 0.2f);
+    }
+
+
+    TEST_METHOD_EX(LookupTableFileParser_InvalidFiles)
+    {
+        auto expectFailure = [](char const* text)
+        {
+            ExpectHResultException(E_INVALIDARG, [&] { ParseLookupTable(text, 2); });
+        };
+
+        // Missing size.
+        expectFailure("0 0 0\n1 1 1\n");
+        expectFailure("TITLE \"Empty\"\n");
+
+        // Wrong number of entries.
+        expectFailure("LUT_3D_SIZE 2\n0 0 0\n");
+        expectFailure("LUT_3D_SIZE 2\n0 0 0\n0 0 0\n0 0 0\n0 0 0\n0 0 0\n0 0 0\n0 0 0\n0 0 0\n0 0 0\n");
+
+        // Wrong number of channels, or numbers that don't parse.
+        expectFailure("LUT_3D_SIZE 2\n0 0\n");
+        expectFailure("LUT_3D_SIZE 2\n0 0 x\n");
+        expectFailure("LUT_3D_SIZE 2\n0 0 0.5f\n");
+        expectFailure("LUT_3D_SIZE 2\n0 0 nan\n");
+
+        // Size out of range.
+        expectFailure("LUT_3D_SIZE 1\n");
+        expectFailure("LUT_3D_SIZE 257\n");
+        expectFailure("LUT_3D_SIZE 2.5\n");
+
+        // Unsupported features.
+        expectFailure("LUT_1D_SIZE 2\n");
+        expectFailure("LUT_3D_SIZE 2\nDOMAIN_MIN -1 -1 -1\n");
+        expectFailure("LUT_3D_SIZE 2\nDOMAIN_MAX 2 2 2\n");
+        expectFailure("LUT_3D_SIZE 2\nLUT_3D_INPUT_RANGE 0 4\n");
+
+        // Negative .3dl values.
+        expectFailure("0 1023\n-1 0 0\n");
+    }
+
+
+    TEST_METHOD_EX(EffectTransferTable3D_CreateFromStream)
+    {
+        std::string text = CubeFile();
+
+        auto stream = Make<MockStream>();
+
+        size_t position = 0;
+
+        stream->ReadMethod.AllowAnyCall([&](void* buffer, ULONG size, ULONG* bytesRead)
+        {
+            auto count = std::min(static_cast<size_t>(size), text.size() - position);
+            memcpy(buffer, text.data() + position, count);
+
+            position += count;
+            *bytesRead = static_cast<ULONG>(count);
+
+            return count ? S_OK : S_FALSE;
+        });
+
+        int expectedSize[3] = { 2, 2, 2 };
+
+        auto table = CaptureTableData<XMFLOAT4>(D2D1_BUFFER_PRECISION_32BPC_FLOAT, expectedSize, [&](ICanvasResourceCreator* device)
+        {
+            EffectTransferTable3D::CreateNew(device, stream.Get());
+        });
+
+        Assert::AreEqual<size_t>(8, table.size());
+
+        AssertTableEntry(table, 2, 1, 0, 1, 1.0f, 0.0f, 0.25f);
+        AssertTableEntry(table, 2, 0, 1, 0, 0.0f, 0.5f, 0.0f);
+    }
 };
@@ -0,0 +1,298 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+#include "../lib/geometry/FlattenedGeometry.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas::Geometry;
+
+TEST_CLASS(FlattenedGeometryTests)
+{
+    static void AddPolygon(FlattenedGeometry& geometry, std::vector<D2D1_POINT_2F> const& points, bool isFilled = true)
+    {
+        geometry.BeginFigure(points.front(), isFilled);
+
+        for (size_t i = 1; i < points.size(); i++)
+        {
+            geometry.AddLine(points[i]);
+        }
+
+        geometry.EndFigure(true);
+    }
+
+    static void AddSquare(FlattenedGeometry& geometry, float left, float top, float size, bool clockwise = true)
+    {
+        if (clockwise)
+            AddPolygon(geometry, { { left, top }, { left + size, top }, { left + size, top + size }, { left, top + size } });
+        else
+            AddPolygon(geometry, { { left, top }, { left, top + size }, { left + size, top + size }, { left + size, top } });
+    }
+
+    static void AssertPointsEqual(D2D1_POINT_2F const& expected, D2D1_POINT_2F const& actual, float tolerance = 0.0001f)
+    {
+        Assert::AreEqual(expected.x, actual.x, tolerance);
+        Assert::AreEqual(expected.y, actual.y, tolerance);
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_Empty)
+    {
+        FlattenedGeometry geometry;
+        geometry.Seal();
+
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(0, 0)));
+        Assert::AreEqual(0.0f, geometry.GetLength());
+
+        D2D1_POINT_2F point, tangent;
+        geometry.ComputePointAtLength(10, &point, &tangent);
+
+        AssertPointsEqual(D2D1::Point2F(0, 0), point);
+        AssertPointsEqual(D2D1::Point2F(0, 0), tangent);
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_Square)
+    {
+        FlattenedGeometry geometry;
+        AddSquare(geometry, 10, 20, 100);
+        geometry.Seal();
+
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(50, 50)));
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(11, 21)));
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(109, 119)));
+
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(5, 50)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(115, 50)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(50, 15)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(50, 125)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(NAN, 50)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(50, NAN)));
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_PointsWithinToleranceOfAnEdgeAreInside)
+    {
+        FlattenedGeometry geometry;
+        AddSquare(geometry, 10, 20, 100);
+        geometry.Seal();
+
+        // Left and right edges.
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(9.8f, 50), 0.25f));
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(110.2f, 50), 0.25f));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(9.7f, 50), 0.25f));
+
+        // Top and bottom edges are horizontal, so play no part in the
+        // winding test.
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(50, 19.8f), 0.25f));
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(50, 120.2f), 0.25f));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(50, 19.7f), 0.25f));
+
+        // Corners are measured by distance, not per axis.
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(9.9f, 19.9f), 0.25f));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(9.8f, 19.8f), 0.25f));
+
+        // Without a tolerance only the fill itself counts.
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(9.8f, 50)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(9.8f, 50), -1));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(9.8f, NAN), 0.25f));
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_ToleranceAppliesToHollowHoles)
+    {
+        FlattenedGeometry geometry;
+        geometry.SetFillMode(D2D1_FILL_MODE_ALTERNATE);
+        AddSquare(geometry, 0, 0, 100);
+        AddSquare(geometry, 40, 40, 20);
+        geometry.Seal();
+
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(50, 50), 0.25f));
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(40.2f, 50), 0.25f));
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_OpenFiguresAreFilledAsIfClosed)
+    {
+        FlattenedGeometry geometry;
+        geometry.BeginFigure(D2D1::Point2F(0, 0), true);
+        geometry.AddLine(D2D1::Point2F(10, 0));
+        geometry.AddLine(D2D1::Point2F(10, 10));
+        geometry.AddLine(D2D1::Point2F(0, 10));
+        geometry.EndFigure(false);
+        geometry.Seal();
+
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(5, 5)));
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_HollowFiguresAreNotFilled)
+    {
+        FlattenedGeometry geometry;
+        AddPolygon(geometry, { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } }, false);
+        geometry.Seal();
+
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(5, 5)));
+        Assert::AreEqual(40.0f, geometry.GetLength());
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_FillModes)
+    {
+        for (auto fillMode : { D2D1_FILL_MODE_ALTERNATE, D2D1_FILL_MODE_WINDING })
+        {
+            bool isWinding = (fillMode == D2D1_FILL_MODE_WINDING);
+
+            // Nested squares with the same orientation.
+            FlattenedGeometry sameDirection;
+            sameDirection.SetFillMode(fillMode);
+            AddSquare(sameDirection, 0, 0, 100);
+            AddSquare(sameDirection, 25, 25, 50);
+            sameDirection.Seal();
+
+            Assert::AreEqual(isWinding, sameDirection.FillContainsPoint(D2D1::Point2F(50, 50)));
+            Assert::IsTrue(sameDirection.FillContainsPoint(D2D1::Point2F(10, 10)));
+
+            // Nested squares with opposite orientations.
+            FlattenedGeometry oppositeDirection;
+            oppositeDirection.SetFillMode(fillMode);
+            AddSquare(oppositeDirection, 0, 0, 100);
+            AddSquare(oppositeDirection, 25, 25, 50, false);
+            oppositeDirection.Seal();
+
+            Assert::IsFalse(oppositeDirection.FillContainsPoint(D2D1::Point2F(50, 50)));
+            Assert::IsTrue(oppositeDirection.FillContainsPoint(D2D1::Point2F(10, 10)));
+        }
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_RayThroughVertexIsCountedOnce)
+    {
+        // A diamond, tested along the row through its left and right corners.
+        FlattenedGeometry geometry;
+        AddPolygon(geometry, { { 50, 0 }, { 100, 50 }, { 50, 100 }, { 0, 50 } });
+        geometry.Seal();
+
+        Assert::IsTrue(geometry.FillContainsPoint(D2D1::Point2F(50, 50)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(-10, 50)));
+        Assert::IsFalse(geometry.FillContainsPoint(D2D1::Point2F(110, 50)));
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_FillContainsPoint_ManyEdgesMatchesBruteForce)
+    {
+        // A star with enough edges to be split into many bands.
+        const int pointCount = 400;
+        std::vector<D2D1_POINT_2F> points;
+
+        for (int i = 0; i < pointCount; i++)
+        {
+            float angle = i * 6.2831853f / pointCount;
+            float radius = (i % 2) ? 100.0f : 40.0f;
+            points.push_back(D2D1::Point2F(radius * cosf(angle), radius * sinf(angle)));
+        }
+
+        FlattenedGeometry geometry;
+        AddPolygon(geometry, points);
+        geometry.Seal();
+
+        for (float y = -110; y <= 110; y += 7.3f)
+        {
+            for (float x = -110; x <= 110; x += 7.3f)
+            {
+                // Crossing number test against every edge.
+                bool expected = false;
+
+                for (int i = 0; i < pointCount; i++)
+                {
+                    auto& a = points[i];
+                    auto& b = points[(i + 1) % pointCount];
+
+                    if ((a.y <= y) != (b.y <= y))
+                    {
+                        float crossingX = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+
+                        if (crossingX > x)
+                            expected = !expected;
+                    }
+                }
+
+                Assert::AreEqual(expected, geometry.FillContainsPoint(D2D1::Point2F(x, y)));
+            }
+        }
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_ComputePointAtLength)
+    {
+        FlattenedGeometry geometry;
+        AddSquare(geometry, 0, 0, 10);
+        geometry.Seal();
+
+        Assert::AreEqual(40.0f, geometry.GetLength());
+
+        D2D1_POINT_2F point, tangent;
+
+        geometry.ComputePointAtLength(5, &point, &tangent);
+        AssertPointsEqual(D2D1::Point2F(5, 0), point);
+        AssertPointsEqual(D2D1::Point2F(1, 0), tangent);
+
+        geometry.ComputePointAtLength(15, &point, &tangent);
+        AssertPointsEqual(D2D1::Point2F(10, 5), point);
+        AssertPointsEqual(D2D1::Point2F(0, 1), tangent);
+
+        // The closing segment counts towards the length.
+        geometry.ComputePointAtLength(35, &point, &tangent);
+        AssertPointsEqual(D2D1::Point2F(0, 5), point);
+        AssertPointsEqual(D2D1::Point2F(0, -1), tangent);
+
+        // Distances outside the path are clamped.
+        geometry.ComputePointAtLength(-5, &point, &tangent);
+        AssertPointsEqual(D2D1::Point2F(0, 0), point);
+
+        geometry.ComputePointAtLength(100, &point, &tangent);
+        AssertPointsEqual(D2D1::Point2F(0, 0), point);
+        AssertPointsEqual(D2D1::Point2F(0, -1), tangent);
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_ComputePointAtLength_SkipsGapsBetweenFigures)
+    {
+        FlattenedGeometry geometry;
+
+        geometry.BeginFigure(D2D1::Point2F(0, 0), false);
+        geometry.AddLine(D2D1::Point2F(10, 0));
+        geometry.EndFigure(false);
+
+        geometry.BeginFigure(D2D1::Point2F(0, 100), false);
+        geometry.AddLine(D2D1::Point2F(0, 110));
+        geometry.EndFigure(false);
+
+        geometry.Seal();
+
+        Assert::AreEqual(20.0f, geometry.GetLength());
+
+        D2D1_POINT_2F point, tangent;
+        geometry.ComputePointAtLength(15, &point, &tangent);
+        AssertPointsEqual(D2D1::Point2F(0, 105), point);
+    }
+
+    TEST_METHOD_EX(FlattenedGeometry_AddBezier_StaysWithinTolerance)
+    {
+        // A quarter circle approximated by a cubic bezier.
+        const float radius = 100;
+        const float k = 0.5522847f * radius;
+        const float tolerance = 0.25f;
+
+        FlattenedGeometry geometry;
+        geometry.BeginFigure(D2D1::Point2F(radius, 0), false);
+        geometry.AddBezier(D2D1::BezierSegment(D2D1::Point2F(radius, k), D2D1::Point2F(k, radius), D2D1::Point2F(0, radius)), tolerance);
+        geometry.EndFigure(false);
+        geometry.Seal();
+
+        float expectedLength = 3.14159265f * radius / 2;
+        Assert::AreEqual(expectedLength, geometry.GetLength(), 0.5f);
+
+        D2D1_POINT_2F point, tangent;
+
+        geometry.ComputePointAtLength(geometry.GetLength(), &point, &tangent);
+        AssertPointsEqual(D2D1::Point2F(0, radius), point);
+
+        for (float length = 0; length < geometry.GetLength(); length += 3)
+        {
+            geometry.ComputePointAtLength(length, &point, &tangent);
+
+            float distanceFromCenter = sqrtf(point.x * point.x + point.y * point.y);
+            Assert::AreEqual(radius, distanceFromCenter, tolerance + 0.05f);
+        }
+    }
+};
@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "../lib/drawing/FrameArena.h"
+
+TEST_CLASS(FrameArenaUnitTests)
+{
+public:
+    TEST_METHOD_EX(FrameArena_Allocate_ReturnsAlignedNonOverlappingMemory)
+    {
+        FrameArena arena;
+
+        auto bytes = arena.Allocate<uint8_t>(3);
+        auto doubles = arena.Allocate<double>(4);
+        auto points = arena.Allocate<D2D1_POINT_2F>(5);
+
+        Assert::IsNotNull(bytes);
+        Assert::AreEqual<uintptr_t>(0, reinterpret_cast<uintptr_t>(doubles) % alignof(double));
+        Assert::AreEqual<uintptr_t>(0, reinterpret_cast<uintptr_t>(points) % alignof(D2D1_POINT_2F));
+
+        Assert::IsTrue(reinterpret_cast<uint8_t*>(doubles) >= bytes + 3);
+        Assert::IsTrue(reinterpret_cast<uint8_t*>(points) >= reinterpret_cast<uint8_t*>(doubles + 4));
+
+        auto stats = arena.GetStatistics();
+        Assert::AreEqual<uint64_t>(3, stats.HeapBytes);
+        Assert::AreEqual<uint64_t>(4 * sizeof(double) + 5 * sizeof(D2D1_POINT_2F), stats.ArenaBytes);
+        Assert::AreEqual<uint32_t>(1, stats.HeapAllocationCount);
+        Assert::AreEqual<size_t>(FrameArena::DefaultBlockSize, stats.ReservedBytes);
+    }
+
+    TEST_METHOD_EX(FrameArena_Allocate_ZeroBytesReturnsNull)
+    {
+        FrameArena arena;
+
+        Assert::IsNull(arena.Allocate<float>(0));
+        Assert::AreEqual<size_t>(0, arena.GetStatistics().ReservedBytes);
+    }
+
+    TEST_METHOD_EX(FrameArena_Allocate_TooLargeThrows)
+    {
+        FrameArena arena;
+
+        ExpectHResultException(E_OUTOFMEMORY, [&] { arena.Allocate<D2D1_POINT_2F>(SIZE_MAX / 2); });
+    }
+
+    TEST_METHOD_EX(FrameArena_WhenBlockIsFull_StartsANewOne)
+    {
+        FrameArena arena(16);
+
+        auto a = arena.Allocate<uint32_t>(3);
+        auto b = arena.Allocate<uint32_t>(2);
+
+        Assert::AreNotEqual(a + 3, b);
+
+        auto stats = arena.GetStatistics();
+        Assert::AreEqual<uint32_t>(2, stats.HeapAllocationCount);
+        Assert::AreEqual<size_t>(32, stats.ReservedBytes);
+    }
+
+    TEST_METHOD_EX(FrameArena_OversizedAllocation_DoesNotWasteCurrentBlock)
+    {
+        FrameArena arena(16);
+
+        auto a = arena.Allocate<uint32_t>(1);
+        auto big = arena.Allocate<uint32_t>(100);
+        auto b = arena.Allocate<uint32_t>(1);
+
+        Assert::IsNotNull(big);
+        Assert::AreEqual(a + 1, b);
+
+        auto stats = arena.GetStatistics();
+        Assert::AreEqual<uint32_t>(2, stats.HeapAllocationCount);
+        Assert::AreEqual<size_t>(16 + 400, stats.ReservedBytes);
+    }
+
+    TEST_METHOD_EX(FrameArena_Rewind_ReusesMemoryWithoutTheHeap)
+    {
+        FrameArena arena;
+
+        auto first = arena.Allocate<float>(100);
+
+        arena.Rewind();
+
+        auto second = arena.Allocate<float>(100);
+
+        Assert::AreEqual(first, second);
+
+        auto stats = arena.GetStatistics();
+        Assert::AreEqual<uint64_t>(400, stats.HeapBytes);
+        Assert::AreEqual<uint64_t>(400, stats.ArenaBytes);
+        Assert::AreEqual<uint32_t>(1, stats.HeapAllocationCount);
+    }
+
+    TEST_METHOD_EX(FrameArena_Rewind_KeepsTheLargestBlock)
+    {
+        FrameArena arena(16);
+
+        arena.Allocate<uint8_t>(8);
+        auto big = arena.Allocate<uint8_t>(1000);
+
+        arena.Rewind();
+
+        Assert::AreEqual<size_t>(1000, arena.GetStatistics().ReservedBytes);
+
+        // The next call needing that much is served without the heap.
+        Assert::AreEqual(big, arena.Allocate<uint8_t>(1000));
+        Assert::AreEqual<uint32_t>(2, arena.GetStatistics().HeapAllocationCount);
+    }
+
+    TEST_METHOD_EX(FrameArena_Clear_ReleasesMemoryButKeepsStatistics)
+    {
+        FrameArena arena;
+
+        arena.Allocate<uint8_t>(10);
+        arena.Allocate<uint8_t>(20);
+
+        arena.Clear();
+
+        auto stats = arena.GetStatistics();
+        Assert::AreEqual<size_t>(0, stats.ReservedBytes);
+        Assert::AreEqual<uint64_t>(10, stats.HeapBytes);
+        Assert::AreEqual<uint64_t>(20, stats.ArenaBytes);
+
+        // The arena is still usable afterwards.
+        Assert::IsNotNull(arena.Allocate<uint8_t>(1));
+        Assert::AreEqual<uint32_t>(2, arena.GetStatistics().HeapAllocationCount);
+    }
+
+    TEST_METHOD_EX(FrameArena_ResetStatistics_KeepsReservedBytes)
+    {
+        FrameArena arena;
+
+        arena.Allocate<uint8_t>(10);
+        arena.Allocate<uint8_t>(20);
+
+        arena.ResetStatistics();
+
+        auto stats = arena.GetStatistics();
+        Assert::AreEqual<uint64_t>(0, stats.HeapBytes);
+        Assert::AreEqual<uint64_t>(0, stats.ArenaBytes);
+        Assert::AreEqual<uint32_t>(0, stats.HeapAllocationCount);
+        Assert::AreEqual<size_t>(FrameArena::DefaultBlockSize, stats.ReservedBytes);
+    }
+
+    TEST_METHOD_EX(FrameArenaPool_ReturnedArena_IsReusedWithoutTheHeap)
+    {
+        FrameArenaPool pool;
+
+        uint8_t* first;
+
+        {
+            auto lease = pool.TakeLease();
+            first = lease->Allocate<uint8_t>(100);
+        }
+
+        Assert::AreEqual<size_t>(1, pool.GetIdleArenaCount());
+
+        auto lease = pool.TakeLease();
+
+        Assert::AreEqual<size_t>(0, pool.GetIdleArenaCount());
+        Assert::AreEqual(first, lease->Allocate<uint8_t>(100));
+
+        auto stats = lease->GetStatistics();
+        Assert::AreEqual<uint64_t>(100, stats.ArenaBytes);
+        Assert::AreEqual<uint64_t>(0, stats.HeapBytes);
+        Assert::AreEqual<uint32_t>(0, stats.HeapAllocationCount);
+    }
+
+    TEST_METHOD_EX(FrameArenaPool_Trim_ReleasesIdleArenas)
+    {
+        FrameArenaPool pool;
+
+        pool.TakeLease()->Allocate<uint8_t>(1);
+
+        pool.Trim();
+
+        Assert::AreEqual<size_t>(0, pool.GetIdleArenaCount());
+        Assert::AreEqual<size_t>(0, pool.TakeLease()->GetStatistics().ReservedBytes);
+    }
+
+    TEST_METHOD_EX(FrameArenaPool_WhenClosed_DiscardsArenasAndFailsToLease)
+    {
+        FrameArenaPool pool;
+
+        auto lease = pool.TakeLease();
+        lease->Allocate<uint8_t>(1);
+
+        pool.Close();
+
+        lease = FrameArenaLease();
+
+        Assert::AreEqual<size_t>(0, pool.GetIdleArenaCount());
+        ExpectHResultException(RO_E_CLOSED, [&] { pool.TakeLease(); });
+    }
+
+    TEST_METHOD_EX(FrameArenaLease_Unpooled_OwnsItsArena)
+    {
+        FrameArenaLease lease(std::make_unique<FrameArena>());
+
+        Assert::IsTrue(static_cast<bool>(lease));
+        Assert::IsNotNull(lease->Allocate<uint8_t>(1));
+
+        lease = FrameArenaLease();
+
+        Assert::IsFalse(static_cast<bool>(lease));
+    }
+};
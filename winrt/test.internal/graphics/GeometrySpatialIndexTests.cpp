@@ -0,0 +1,269 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "utils/BenchmarkTimer.h"
+#include "../lib/geometry/GeometrySpatialIndex.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas::Geometry;
+
+TEST_CLASS(GeometrySpatialIndexTests)
+{
+    static void AddPolygon(FlattenedGeometry& geometry, std::vector<D2D1_POINT_2F> const& points)
+    {
+        geometry.BeginFigure(points.front(), true);
+
+        for (size_t i = 1; i < points.size(); i++)
+        {
+            geometry.AddLine(points[i]);
+        }
+
+        geometry.EndFigure(true);
+    }
+
+    static void AddRectangle(FlattenedGeometry& geometry, float left, float top, float right, float bottom)
+    {
+        AddPolygon(geometry, { { left, top }, { right, top }, { right, bottom }, { left, bottom } });
+    }
+
+    static void AddStar(FlattenedGeometry& geometry, float centerX, float centerY, float radius, int pointCount)
+    {
+        std::vector<D2D1_POINT_2F> points;
+
+        for (int i = 0; i < pointCount; i++)
+        {
+            float angle = i * 6.2831853f / pointCount;
+            float r = (i % 2) ? radius : radius * 0.4f;
+            points.push_back(D2D1::Point2F(centerX + r * cosf(angle), centerY + r * sinf(angle)));
+        }
+
+        AddPolygon(geometry, points);
+    }
+
+    // Many small overlapping shapes, like the contents of a busy drawing.
+    static void AddScene(FlattenedGeometry& geometry, uint32_t shapeCount)
+    {
+        uint32_t seed = 12345;
+
+        auto random = [&](float range)
+        {
+            seed = seed * 1103515245 + 12345;
+            return static_cast<float>((seed >> 16) & 0x7FFF) / 0x7FFF * range;
+        };
+
+        for (uint32_t i = 0; i < shapeCount; i++)
+        {
+            float x = random(1000);
+            float y = random(1000);
+            float size = 2 + random(10);
+
+            if (i % 2)
+                AddRectangle(geometry, x, y, x + size, y + size);
+            else
+                AddStar(geometry, x, y, size, 10);
+        }
+    }
+
+    static bool SegmentsCross(D2D1_POINT_2F a, D2D1_POINT_2F b, D2D1_POINT_2F c, D2D1_POINT_2F d)
+    {
+        auto cross = [](D2D1_POINT_2F o, D2D1_POINT_2F p, D2D1_POINT_2F q)
+        {
+            return (p.x - o.x) * (q.y - o.y) - (p.y - o.y) * (q.x - o.x);
+        };
+
+        float d1 = cross(c, d, a);
+        float d2 = cross(c, d, b);
+        float d3 = cross(a, b, c);
+        float d4 = cross(a, b, d);
+
+        return ((d1 <= 0 && d2 >= 0) || (d1 >= 0 && d2 <= 0)) &&
+               ((d3 <= 0 && d4 >= 0) || (d3 >= 0 && d4 <= 0));
+    }
+
+    // Checks every edge against every side of the rectangle.
+    static bool BruteForceIntersectsRect(FlattenedGeometry const& geometry, D2D1_RECT_F const& rect)
+    {
+        D2D1_POINT_2F corners[] =
+        {
+            { rect.left, rect.top },
+            { rect.right, rect.top },
+            { rect.right, rect.bottom },
+            { rect.left, rect.bottom },
+        };
+
+        auto isInside = [&](D2D1_POINT_2F p)
+        {
+            return p.x >= rect.left && p.x <= rect.right && p.y >= rect.top && p.y <= rect.bottom;
+        };
+
+        for (auto& edge : geometry.GetEdges())
+        {
+            if (isInside(edge.Start) || isInside(edge.End))
+                return true;
+
+            for (int i = 0; i < 4; i++)
+            {
+                if (SegmentsCross(edge.Start, edge.End, corners[i], corners[(i + 1) % 4]))
+                    return true;
+            }
+        }
+
+        return geometry.FillContainsPoint(corners[0]);
+    }
+
+    TEST_METHOD_EX(GeometrySpatialIndex_Empty)
+    {
+        FlattenedGeometry geometry;
+        geometry.Seal();
+
+        GeometrySpatialIndex index(geometry);
+
+        Assert::AreEqual(0u, index.GetNodeCount());
+        Assert::IsFalse(index.ContainsPoint(D2D1::Point2F(0, 0)));
+        Assert::IsFalse(index.IntersectsRect(D2D1::RectF(-100, -100, 100, 100)));
+    }
+
+    TEST_METHOD_EX(GeometrySpatialIndex_ContainsPoint_MatchesFlattenedGeometry)
+    {
+        for (auto fillMode : { D2D1_FILL_MODE_ALTERNATE, D2D1_FILL_MODE_WINDING })
+        {
+            FlattenedGeometry geometry;
+            geometry.SetFillMode(fillMode);
+            AddStar(geometry, 0, 0, 100, 200);
+            AddStar(geometry, 30, 20, 60, 50);
+            AddRectangle(geometry, -50, -10, 50, 10);
+            geometry.Seal();
+
+            GeometrySpatialIndex index(geometry);
+
+            Assert::IsTrue(index.GetNodeCount() > 1);
+
+            for (float y = -110; y <= 110; y += 3.7f)
+            {
+                for (float x = -110; x <= 110; x += 3.7f)
+                {
+                    auto point = D2D1::Point2F(x, y);
+                    Assert::AreEqual(geometry.FillContainsPoint(point), index.ContainsPoint(point));
+                }
+            }
+
+            Assert::IsFalse(index.ContainsPoint(D2D1::Point2F(NAN, 0)));
+            Assert::IsFalse(index.ContainsPoint(D2D1::Point2F(0, NAN)));
+        }
+    }
+
+    TEST_METHOD_EX(GeometrySpatialIndex_IntersectsRect)
+    {
+        FlattenedGeometry geometry;
+        AddRectangle(geometry, 0, 0, 100, 100);
+        geometry.Seal();
+
+        GeometrySpatialIndex index(geometry);
+
+        // Crosses an edge.
+        Assert::IsTrue(index.IntersectsRect(D2D1::RectF(-10, 40, 10, 60)));
+
+        // Entirely inside the area.
+        Assert::IsTrue(index.IntersectsRect(D2D1::RectF(40, 40, 60, 60)));
+
+        // Entirely contains the area.
+        Assert::IsTrue(index.IntersectsRect(D2D1::RectF(-10, -10, 110, 110)));
+
+        // Only touches a corner.
+        Assert::IsTrue(index.IntersectsRect(D2D1::RectF(100, 100, 110, 110)));
+
+        // Not normalized.
+        Assert::IsTrue(index.IntersectsRect(D2D1::RectF(60, 60, 40, 40)));
+
+        // Outside.
+        Assert::IsFalse(index.IntersectsRect(D2D1::RectF(101, 0, 110, 100)));
+        Assert::IsFalse(index.IntersectsRect(D2D1::RectF(-20, -20, -10, -10)));
+    }
+
+    TEST_METHOD_EX(GeometrySpatialIndex_IntersectsRect_ThroughHorizontalEdgesOnly)
+    {
+        // A wide, thin strip crossed by a tall, narrow rectangle: only the
+        // strip's horizontal edges cross the rectangle.
+        FlattenedGeometry geometry;
+        AddRectangle(geometry, 0, 45, 100, 55);
+        geometry.Seal();
+
+        GeometrySpatialIndex index(geometry);
+
+        Assert::IsTrue(index.IntersectsRect(D2D1::RectF(40, 0, 60, 100)));
+        Assert::IsFalse(index.IntersectsRect(D2D1::RectF(40, 0, 60, 40)));
+    }
+
+    TEST_METHOD_EX(GeometrySpatialIndex_IntersectsRect_MatchesBruteForce)
+    {
+        FlattenedGeometry geometry;
+        AddScene(geometry, 500);
+        geometry.Seal();
+
+        GeometrySpatialIndex index(geometry);
+
+        for (float y = 0; y < 1000; y += 37)
+        {
+            for (float x = 0; x < 1000; x += 37)
+            {
+                auto rect = D2D1::RectF(x, y, x + 5, y + 3);
+                Assert::AreEqual(BruteForceIntersectsRect(geometry, rect), index.IntersectsRect(rect));
+            }
+        }
+    }
+
+    //
+    // Compares hit testing with and without the index on a scene of many
+    // small shapes.  Timings are reported to the test log rather than
+    // asserted on.
+    //
+
+    TEST_METHOD_EX(GeometrySpatialIndex_Benchmark)
+    {
+        uint32_t const shapeCount = 10000;
+        uint32_t const queryCount = 10000;
+
+        FlattenedGeometry geometry;
+        AddScene(geometry, shapeCount);
+        geometry.Seal();
+
+        std::vector<D2D1_POINT_2F> points;
+        for (uint32_t i = 0; i < queryCount; i++)
+        {
+            points.push_back(D2D1::Point2F(static_cast<float>(i % 100) * 10 + 0.5f, static_cast<float>(i / 100) * 10 + 0.5f));
+        }
+
+        BenchmarkTimer timer;
+        GeometrySpatialIndex index(geometry);
+        auto buildTime = timer.ElapsedMicroseconds();
+
+        uint32_t hitsWithIndex = 0;
+        timer.Restart();
+        for (auto& point : points)
+        {
+            if (index.ContainsPoint(point))
+                hitsWithIndex++;
+        }
+        auto indexedQueryTime = timer.ElapsedMicroseconds();
+
+        uint32_t hitsWithBands = 0;
+        timer.Restart();
+        for (auto& point : points)
+        {
+            if (geometry.FillContainsPoint(point))
+                hitsWithBands++;
+        }
+        auto bandedQueryTime = timer.ElapsedMicroseconds();
+
+        Assert::AreEqual(hitsWithBands, hitsWithIndex);
+
+        wchar_t message[256];
+        swprintf_s(message, L"%u edges: index built in %lld us\n", index.GetEdgeCount(), buildTime);
+        Logger::WriteMessage(message);
+
+        swprintf_s(message, L"%u point queries: %lld us with index, %lld us without\n", queryCount, indexedQueryTime, bandedQueryTime);
+        Logger::WriteMessage(message);
+    }
+};
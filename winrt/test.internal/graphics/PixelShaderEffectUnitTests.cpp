@@ -4,11 +4,14 @@
 
 #include "pch.h"
 
+#include "utils/BenchmarkTimer.h"
+
 #include <lib/effects/shader/PixelShaderEffect.h>
 #include <lib/effects/shader/PixelShaderEffectImpl.h>
 #include <lib/effects/shader/PixelShaderTransform.h>
 #include <lib/effects/shader/ClipTransform.h>
 #include <lib/effects/shader/SharedShaderState.h>
+#include <lib/effects/shader/ShaderDescriptionFile.h>
 
 #include "mocks/MockD2DDrawInfo.h"
 #include "mocks/MockD2DEffectContext.h"
@@ -273,6 +276,54 @@ TEST_CLASS(PixelShaderEffectUnitTests)
     }
 
 
+    TEST_METHOD_EX(PixelShaderEffect_PropertyHandleChangesArePassedThroughToD2D)
+    {
+        Fixture f;
+
+        // Construct a shader description containing one integer variable.
+        D3D11_SHADER_VARIABLE_DESC variableDesc = { "foo", 0, sizeof(int) };
+        D3D11_SHADER_TYPE_DESC variableType = { D3D_SVC_SCALAR, D3D_SVT_INT, 1, 1 };
+
+        ShaderVariable variable(variableDesc, variableType);
+
+        ShaderDescription desc;
+        desc.Variables.push_back(variable);
+
+        auto sharedState = MakeSharedShaderState(desc, std::vector<BYTE>(sizeof(int)));
+        auto effect = Make<PixelShaderEffect>(nullptr, nullptr, sharedState.Get());
+
+        int32_t handle;
+        ThrowIfFailed(effect->GetPropertyHandle(HStringReference(L"foo").Get(), &handle));
+
+        uint32_t size;
+        ThrowIfFailed(effect->get_ConstantBufferSize(&size));
+        Assert::AreEqual<uint32_t>(sizeof(int), size);
+
+        // Change the property value to 3.
+        int32_t value = 3;
+        ThrowIfFailed(effect->SetPropertyIntegers(handle, 1, &value));
+
+        // Realize the effect.
+        effect->GetD2DImage(f.CanvasDevice.Get(), f.DeviceContext.Get(), WIN2D_GET_D2D_IMAGE_FLAGS_NONE, 0, nullptr);
+
+        auto& d2dConstants = f.GetEffectPropertyValue<int>(PixelShaderEffectProperty::Constants);
+        Assert::AreEqual(3, d2dConstants);
+
+        // Changes by handle, or to the whole buffer, should immediately be passed along to D2D.
+        value = 5;
+        ThrowIfFailed(effect->SetPropertyIntegers(handle, 1, &value));
+        Assert::AreEqual(5, d2dConstants);
+
+        value = 7;
+        ThrowIfFailed(effect->SetConstantBuffer(sizeof(int), reinterpret_cast<BYTE*>(&value)));
+        Assert::AreEqual(7, d2dConstants);
+
+        // Using a float setter for an integer property is an error.
+        float floatValue = 1;
+        Assert::AreEqual(E_INVALIDARG, effect->SetPropertyFloats(handle, 1, &floatValue));
+    }
+
+
     TEST_METHOD_EX(PixelShaderEffect_CoordinateMappingChangesArePassedThroughToD2D)
     {
         Fixture f;
@@ -1419,7 +1470,9 @@ TEST_CLASS(SharedShaderStateUnitTests)
         Assert::AreEqual(coordinateMapping.MaxOffset, clone->CoordinateMapping().MaxOffset);
         Assert::AreEqual<int>(sourceInterpolation.Filter[0], clone->SourceInterpolation().Filter[0]);
 
-        Assert::AreNotEqual<void const*>(&originalState->Shader(), &clone->Shader());
+        // The shader description is immutable, so is shared rather than copied.
+        Assert::AreEqual<void const*>(&originalState->Shader(), &clone->Shader());
+
         Assert::AreNotEqual<void const*>(&originalState->Constants(), &clone->Constants());
         Assert::AreNotEqual<void const*>(&originalState->CoordinateMapping(), &clone->CoordinateMapping());
         Assert::AreNotEqual<void const*>(&originalState->SourceInterpolation(), &clone->SourceInterpolation());
@@ -1441,6 +1494,190 @@ TEST_CLASS(SharedShaderStateUnitTests)
     };
 
 
+    TEST_METHOD_EX(SharedShaderState_DescriptionCache)
+    {
+        SharedShaderState::ClearDescriptionCache();
+
+        auto counters = SharedShaderState::GetDescriptionCacheCounters();
+
+        // First use of a shader reflects over it.
+        auto state1a = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+
+        Assert::AreEqual(counters.Misses + 1, SharedShaderState::GetDescriptionCacheCounters().Misses);
+        Assert::AreEqual(counters.Hits, SharedShaderState::GetDescriptionCacheCounters().Hits);
+
+        // Using it again shares the same description.
+        auto state1b = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+
+        Assert::AreEqual(counters.Misses + 1, SharedShaderState::GetDescriptionCacheCounters().Misses);
+        Assert::AreEqual(counters.Hits + 1, SharedShaderState::GetDescriptionCacheCounters().Hits);
+
+        Assert::AreEqual<void const*>(&state1a->Shader(), &state1b->Shader());
+
+        // But each state has its own constant buffer.
+        Assert::AreNotEqual<void const*>(&state1a->Constants(), &state1b->Constants());
+
+        state1a->SetProperty(HStringReference(L"f").Get(), Make<Nullable<float>>(23.0f).Get());
+
+        Assert::AreEqual(23.0f, reinterpret_cast<float const*>(state1a->Constants().data())[0]);
+        Assert::AreEqual(0.0f, reinterpret_cast<float const*>(state1b->Constants().data())[0]);
+
+        // Different code gets a different description.
+        auto state2 = Make<SharedShaderState>(compiledShader2.data(), static_cast<unsigned>(compiledShader2.size()));
+
+        Assert::AreEqual(counters.Misses + 2, SharedShaderState::GetDescriptionCacheCounters().Misses);
+        Assert::AreNotEqual<void const*>(&state1a->Shader(), &state2->Shader());
+
+        // Clearing the cache doesn't affect existing states, but new ones reflect over the shader again.
+        SharedShaderState::ClearDescriptionCache();
+
+        auto state1c = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+
+        Assert::AreEqual(counters.Misses + 3, SharedShaderState::GetDescriptionCacheCounters().Misses);
+        Assert::AreNotEqual<void const*>(&state1a->Shader(), &state1c->Shader());
+        Assert::AreEqual(state1a->Shader().Hash, state1c->Shader().Hash);
+        Assert::AreEqual(state1a->Shader().Variables.size(), state1c->Shader().Variables.size());
+        Assert::AreEqual(compiledShader1, state1a->Shader().Code);
+    };
+
+
+    static void AssertDescriptionsEqual(ShaderDescription const& expected, ShaderDescription const& actual)
+    {
+        Assert::AreEqual(expected.Code, actual.Code);
+        Assert::AreEqual(expected.Hash, actual.Hash);
+        Assert::AreEqual(expected.InputCount, actual.InputCount);
+        Assert::AreEqual(expected.InstructionCount, actual.InstructionCount);
+        Assert::AreEqual<int>(expected.MinFeatureLevel, actual.MinFeatureLevel);
+        Assert::AreEqual(expected.SimpleInputs, actual.SimpleInputs);
+        Assert::AreEqual(expected.DefaultConstants, actual.DefaultConstants);
+        Assert::AreEqual(expected.Variables.size(), actual.Variables.size());
+
+        for (size_t i = 0; i < expected.Variables.size(); i++)
+        {
+            auto& variable = expected.Variables[i];
+
+            ValidateVariable(actual.Variables[i], static_cast<wchar_t const*>(variable.Name), variable.Class, variable.Type, variable.Rows, variable.Columns, variable.Elements, variable.Size, variable.Offset);
+
+            Assert::AreEqual(variable.IsContiguous, actual.Variables[i].IsContiguous);
+        }
+    }
+
+
+    TEST_METHOD_EX(ShaderDescriptionFile_RoundTrip)
+    {
+        auto state = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+        auto& shader = state->Shader();
+
+        auto data = SerializeShaderDescription(shader);
+
+        ShaderDescription result;
+        Assert::IsTrue(TryDeserializeShaderDescription(data.data(), data.size(), shader.Hash, compiledShader1.data(), static_cast<uint32_t>(compiledShader1.size()), &result));
+
+        AssertDescriptionsEqual(shader, result);
+    };
+
+
+    TEST_METHOD_EX(ShaderDescriptionFile_RejectsBadData)
+    {
+        auto state = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+        auto& shader = state->Shader();
+
+        auto data = SerializeShaderDescription(shader);
+        auto codeSize = static_cast<uint32_t>(compiledShader1.size());
+
+        ShaderDescription result;
+
+        // Wrong shader.
+        Assert::IsFalse(TryDeserializeShaderDescription(data.data(), data.size(), GUID_NULL, compiledShader1.data(), codeSize, &result));
+        Assert::IsFalse(TryDeserializeShaderDescription(data.data(), data.size(), shader.Hash, compiledShader1.data(), codeSize - 1, &result));
+
+        // Truncated or extended.
+        Assert::IsFalse(TryDeserializeShaderDescription(data.data(), 0, shader.Hash, compiledShader1.data(), codeSize, &result));
+        Assert::IsFalse(TryDeserializeShaderDescription(data.data(), data.size() - 1, shader.Hash, compiledShader1.data(), codeSize, &result));
+
+        auto extended = data;
+        extended.push_back(0);
+        Assert::IsFalse(TryDeserializeShaderDescription(extended.data(), extended.size(), shader.Hash, compiledShader1.data(), codeSize, &result));
+
+        // Corrupting any byte (including the version stamp and checksum) should be detected.
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            auto corrupted = data;
+            corrupted[i] ^= 0x10;
+
+            Assert::IsFalse(TryDeserializeShaderDescription(corrupted.data(), corrupted.size(), shader.Hash, compiledShader1.data(), codeSize, &result));
+        }
+
+        // Failures leave the result untouched.
+        Assert::IsTrue(result.Code.empty());
+        Assert::IsTrue(result.Variables.empty());
+    };
+
+
+    TEST_METHOD_EX(SharedShaderState_DescriptionCacheFolder)
+    {
+        wchar_t tempPath[MAX_PATH];
+        Assert::AreNotEqual(0ul, GetTempPathW(MAX_PATH, tempPath));
+
+        auto compiledShader = CompileShader("float4 main() : SV_Target { return 0.25; }");
+        auto codeSize = static_cast<unsigned>(compiledShader.size());
+
+        SharedShaderState::SetDescriptionCacheFolder(tempPath);
+        SharedShaderState::ClearDescriptionCache();
+
+        auto counters = SharedShaderState::GetDescriptionCacheCounters();
+
+        // The first use reflects over the shader, and writes out a cache file.
+        auto state1 = Make<SharedShaderState>(compiledShader.data(), codeSize);
+
+        Assert::AreEqual(counters.Misses + 1, SharedShaderState::GetDescriptionCacheCounters().Misses);
+
+        // Once that's gone from the in-memory cache (as if the app restarted), the file is used.
+        SharedShaderState::ClearDescriptionCache();
+
+        auto state2 = Make<SharedShaderState>(compiledShader.data(), codeSize);
+
+        Assert::AreEqual(counters.Misses + 2, SharedShaderState::GetDescriptionCacheCounters().Misses);
+        Assert::AreEqual(counters.DiskHits + 1, SharedShaderState::GetDescriptionCacheCounters().DiskHits);
+
+        AssertDescriptionsEqual(state1->Shader(), state2->Shader());
+
+        // Clean up.
+        SharedShaderState::SetDescriptionCacheFolder(L"");
+        SharedShaderState::ClearDescriptionCache();
+
+        wchar_t hashString[39];
+        Assert::AreNotEqual(0, StringFromGUID2(state1->Shader().Hash, hashString, _countof(hashString)));
+        DeleteFileW((std::wstring(tempPath) + hashString + L".win2dshader").c_str());
+    };
+
+
+    TEST_METHOD_EX(SharedShaderState_DescriptionCacheBenchmark)
+    {
+        const int stateCount = 1000;
+
+        auto measure = [&](bool clearCache)
+        {
+            BenchmarkTimer timer;
+            for (int i = 0; i < stateCount; i++)
+            {
+                if (clearCache)
+                    SharedShaderState::ClearDescriptionCache();
+
+                Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+            }
+            return timer.ElapsedNanoseconds() / stateCount / 1000;
+        };
+
+        auto uncachedTime = measure(true);
+        auto cachedTime = measure(false);
+
+        wchar_t message[256];
+        swprintf_s(message, L"SharedShaderState construction: %.2f us uncached, %.2f us cached\n", uncachedTime, cachedTime);
+        Logger::WriteMessage(message);
+    };
+
+
     TEST_METHOD_EX(SharedShaderState_ShaderReflection)
     {
         auto state = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
@@ -1616,4 +1853,112 @@ TEST_CLASS(SharedShaderStateUnitTests)
         Assert::AreEqual(4, constants->icols[12]);
         Assert::AreEqual(8, constants->icols[13]);
     };
+
+
+    TEST_METHOD_EX(SharedShaderState_PropertyHandles_MatchBoxedProperties)
+    {
+        // Setting values by handle should produce exactly the same constant buffer as boxed properties.
+        auto boxedState = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+        auto handleState = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+
+        std::vector<float> floats = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+        std::vector<int> ints = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+        auto setFloats = [&](wchar_t const* name, unsigned count)
+        {
+            auto handle = handleState->GetPropertyHandle(HStringReference(name).Get());
+
+            Assert::AreEqual(FindVariable(*handleState, name).Offset, handleState->GetPropertyOffset(handle));
+
+            handleState->SetPropertyValues(handle, floats.data(), count);
+        };
+
+        auto setInts = [&](wchar_t const* name, int const* values, unsigned count)
+        {
+            auto handle = handleState->GetPropertyHandle(HStringReference(name).Get());
+
+            handleState->SetPropertyValues(handle, values, count);
+        };
+
+        // Scalars.
+        boxedState->SetProperty(HStringReference(L"f").Get(), Make<Nullable<float>>(1.0f).Get());
+        setFloats(L"f", 1);
+
+        boxedState->SetProperty(HStringReference(L"i").Get(), Make<Nullable<int>>(1).Get());
+        setInts(L"i", ints.data(), 1);
+
+        // Booleans are normalized to 0 or 1.
+        int seven = 7;
+        boxedState->SetProperty(HStringReference(L"b").Get(), Make<Nullable<bool>>(true).Get());
+        setInts(L"b", &seven, 1);
+
+        // Matrices, which cover both the contiguous and padded/transposed layouts.
+        Matrix4x4 floatMatrix = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+
+        boxedState->SetProperty(HStringReference(L"rows").Get(), Make<Nullable<Matrix4x4>>(floatMatrix).Get());
+        setFloats(L"rows", 16);
+
+        boxedState->SetProperty(HStringReference(L"cols").Get(), Make<Nullable<Matrix4x4>>(floatMatrix).Get());
+        setFloats(L"cols", 16);
+
+        boxedState->SetProperty(HStringReference(L"irows").Get(), Make<ReferenceArray<int>>(ints).Get());
+        setInts(L"irows", ints.data(), 8);
+
+        boxedState->SetProperty(HStringReference(L"icols").Get(), Make<ReferenceArray<int>>(ints).Get());
+        setInts(L"icols", ints.data(), 8);
+
+        Assert::AreEqual(boxedState->Constants(), handleState->Constants());
+    };
+
+
+    static ShaderVariable const& FindVariable(SharedShaderState& state, wchar_t const* name)
+    {
+        auto& variables = state.Shader().Variables;
+
+        auto it = std::find_if(variables.begin(), variables.end(), [=](ShaderVariable const& variable) { return wcscmp(static_cast<wchar_t const*>(variable.Name), name) == 0; });
+
+        Assert::IsTrue(it != variables.end());
+
+        return *it;
+    }
+
+
+    TEST_METHOD_EX(SharedShaderState_PropertyHandles_Validation)
+    {
+        auto state = Make<SharedShaderState>(compiledShader1.data(), static_cast<unsigned>(compiledShader1.size()));
+
+        float floats[16] = {};
+        int ints[16] = {};
+
+        // Unknown names and handles.
+        ExpectHResultException(E_INVALIDARG, [&] { state->GetPropertyHandle(HStringReference(L"unknown").Get()); });
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(-1, floats, 1); });
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(7, floats, 1); });
+        ExpectHResultException(E_INVALIDARG, [&] { state->GetPropertyOffset(7); });
+
+        // Wrong type.
+        auto f = state->GetPropertyHandle(HStringReference(L"f").Get());
+        auto i = state->GetPropertyHandle(HStringReference(L"i").Get());
+        auto b = state->GetPropertyHandle(HStringReference(L"b").Get());
+
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(f, ints, 1); });
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(i, floats, 1); });
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(b, floats, 1); });
+
+        // Wrong number of values.
+        auto rows = state->GetPropertyHandle(HStringReference(L"rows").Get());
+
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(f, floats, 2); });
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(rows, floats, 15); });
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetPropertyValues(b, ints, 0); });
+
+        // Raw constant buffer writes must be the right size.
+        std::vector<BYTE> constants(state->Constants().size(), 0x42);
+
+        ExpectHResultException(E_INVALIDARG, [&] { state->SetConstants(constants.data(), static_cast<uint32_t>(constants.size() - 1)); });
+
+        state->SetConstants(constants.data(), static_cast<uint32_t>(constants.size()));
+
+        Assert::AreEqual(constants, state->Constants());
+    };
 };
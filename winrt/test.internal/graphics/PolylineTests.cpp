@@ -0,0 +1,177 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "utils/BenchmarkTimer.h"
+
+#include "../lib/geometry/Polyline.h"
+#include "mocks/MockD2DGeometrySink.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas::Geometry;
+
+TEST_CLASS(PolylineTests)
+{
+    static void AssertPoints(std::vector<Vector2> const& expected, std::vector<D2D1_POINT_2F> const& actual)
+    {
+        Assert::AreEqual(expected.size(), actual.size());
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            Assert::AreEqual(ToD2DPoint(expected[i]), actual[i]);
+        }
+    }
+
+    TEST_METHOD_EX(Polyline_Decimate_ZeroColumnWidthKeepsEveryPoint)
+    {
+        std::vector<Vector2> points{ { 0, 0 }, { 0.1f, 5 }, { 0.2f, -5 }, { 0.3f, 1 }, { 0.4f, 2 } };
+
+        AssertPoints(points, DecimatePolyline(static_cast<uint32_t>(points.size()), points.data(), 0));
+    }
+
+    TEST_METHOD_EX(Polyline_Decimate_KeepsFirstLowestHighestAndLastOfEachColumn)
+    {
+        std::vector<Vector2> points
+        {
+            // Column 0: first, highest, lowest, last.
+            { 0.0f, 1 }, { 0.2f, 9 }, { 0.4f, 3 }, { 0.6f, -4 }, { 0.8f, 2 },
+
+            // Column 1: the first point is also the lowest, and the last also the highest.
+            { 1.0f, 0 }, { 1.5f, 1 }, { 1.9f, 8 },
+
+            // Column 2: a single point.
+            { 2.5f, 6 },
+        };
+
+        auto result = DecimatePolyline(static_cast<uint32_t>(points.size()), points.data(), 1);
+
+        AssertPoints(
+            {
+                { 0.0f, 1 }, { 0.2f, 9 }, { 0.6f, -4 }, { 0.8f, 2 },
+                { 1.0f, 0 }, { 1.9f, 8 },
+                { 2.5f, 6 },
+            },
+            result);
+    }
+
+    TEST_METHOD_EX(Polyline_Decimate_LineReturningToAColumnStartsANewRun)
+    {
+        std::vector<Vector2> points{ { 0.1f, 0 }, { 0.2f, 1 }, { 1.5f, 2 }, { 0.3f, 3 }, { 0.4f, 4 }, { 0.5f, 5 } };
+
+        auto result = DecimatePolyline(static_cast<uint32_t>(points.size()), points.data(), 1);
+
+        AssertPoints({ { 0.1f, 0 }, { 0.2f, 1 }, { 1.5f, 2 }, { 0.3f, 3 }, { 0.5f, 5 } }, result);
+    }
+
+    TEST_METHOD_EX(Polyline_Decimate_NegativeCoordinates)
+    {
+        // Columns round down, so -0.1 and 0.1 are in different columns.
+        std::vector<Vector2> points{ { -0.9f, 0 }, { -0.5f, 7 }, { -0.3f, 3 }, { -0.1f, 0 }, { 0.1f, 0 } };
+
+        auto result = DecimatePolyline(static_cast<uint32_t>(points.size()), points.data(), 1);
+
+        AssertPoints({ { -0.9f, 0 }, { -0.5f, 7 }, { -0.1f, 0 }, { 0.1f, 0 } }, result);
+    }
+
+    TEST_METHOD_EX(Polyline_Decimate_ColumnOriginShiftsColumns)
+    {
+        std::vector<Vector2> points{ { 0.1f, 0 }, { 0.3f, 5 }, { 0.4f, 1 }, { 0.6f, 2 }, { 0.9f, 3 } };
+
+        // Unshifted, all five points are in column 0, which keeps just three of them.
+        AssertPoints({ { 0.1f, 0 }, { 0.3f, 5 }, { 0.9f, 3 } }, DecimatePolyline(static_cast<uint32_t>(points.size()), points.data(), 1));
+
+        // Shifted by half a column, the boundary falls between 0.4 and 0.6.
+        AssertPoints(points, DecimatePolyline(static_cast<uint32_t>(points.size()), points.data(), 1, 0.5f));
+    }
+
+    TEST_METHOD_EX(Polyline_AddToSink)
+    {
+        std::vector<Vector2> points{ { 1, 2 }, { 3, 4 }, { 5, 6 } };
+
+        for (auto closed : { false, true })
+        {
+            auto sink = Make<MockD2DGeometrySink>();
+
+            sink->BeginFigureMethod.SetExpectedCalls(1,
+                [&](D2D1_POINT_2F point, D2D1_FIGURE_BEGIN mode)
+                {
+                    Assert::AreEqual(ToD2DPoint(points[0]), point);
+                    Assert::AreEqual(D2D1_FIGURE_BEGIN_FILLED, mode);
+                });
+
+            // Everything after the first point is added in a single call.
+            sink->AddLinesMethod.SetExpectedCalls(1,
+                [&](D2D1_POINT_2F const* d2dPoints, UINT32 count)
+                {
+                    Assert::AreEqual(2u, count);
+                    Assert::AreEqual(ToD2DPoint(points[1]), d2dPoints[0]);
+                    Assert::AreEqual(ToD2DPoint(points[2]), d2dPoints[1]);
+                });
+
+            sink->EndFigureMethod.SetExpectedCalls(1,
+                [&](D2D1_FIGURE_END mode)
+                {
+                    Assert::AreEqual(closed ? D2D1_FIGURE_END_CLOSED : D2D1_FIGURE_END_OPEN, mode);
+                });
+
+            AddPolylineToSink(sink.Get(), static_cast<uint32_t>(points.size()), points.data(), closed, 0, 0);
+        }
+    }
+
+    TEST_METHOD_EX(Polyline_AddToSink_SinglePoint)
+    {
+        Vector2 point{ 1, 2 };
+
+        auto sink = Make<MockD2DGeometrySink>();
+
+        sink->BeginFigureMethod.SetExpectedCalls(1);
+        sink->EndFigureMethod.SetExpectedCalls(1);
+
+        AddPolylineToSink(sink.Get(), 1, &point, false, 0, 0);
+    }
+
+    TEST_METHOD_EX(Polyline_AddToSink_NoPoints)
+    {
+        auto sink = Make<MockD2DGeometrySink>();
+
+        AddPolylineToSink(sink.Get(), 0, nullptr, false, 0, 0);
+    }
+
+    TEST_METHOD_EX(Polyline_CheckColumnWidth)
+    {
+        CheckPolylineColumnWidth(0);
+        CheckPolylineColumnWidth(0.5f);
+
+        ExpectHResultException(E_INVALIDARG, [] { CheckPolylineColumnWidth(-1); });
+        ExpectHResultException(E_INVALIDARG, [] { CheckPolylineColumnWidth(NAN); });
+        ExpectHResultException(E_INVALIDARG, [] { CheckPolylineColumnWidth(INFINITY); });
+    }
+
+    TEST_METHOD_EX(Polyline_Decimate_Benchmark)
+    {
+        // A million samples of a noisy signal, drawn into a 2000 pixel wide chart.
+        uint32_t const pointCount = 1000000;
+        float const chartWidth = 2000;
+
+        std::vector<Vector2> points;
+        points.reserve(pointCount);
+
+        for (uint32_t i = 0; i < pointCount; i++)
+        {
+            float x = i * chartWidth / pointCount;
+            float y = 100 * sinf(i * 0.0001f) + static_cast<float>((i * 7919) % 37);
+            points.push_back(Vector2{ x, y });
+        }
+
+        BenchmarkTimer timer;
+        auto result = DecimatePolyline(pointCount, points.data(), 1);
+        auto decimateTime = timer.ElapsedMicroseconds();
+
+        Assert::IsTrue(result.size() <= chartWidth * 4);
+
+        wchar_t message[256];
+        swprintf_s(message, L"%u points decimated to %u in %lld us\n", pointCount, static_cast<uint32_t>(result.size()), decimateTime);
+        Logger::WriteMessage(message);
+    }
+};
@@ -0,0 +1,198 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include "utils/BenchmarkTimer.h"
+
+static Color const Red{ 255, 255, 0, 0 };
+static Color const Green{ 255, 0, 255, 0 };
+static Color const Blue{ 255, 0, 0, 255 };
+static Color const TransparentBlue{ 0, 0, 0, 255 };
+
+
+TEST_CLASS(SolidColorBrushCacheUnitTests)
+{
+public:
+    struct Fixture
+    {
+        ComPtr<MockD2DDeviceContext> DeviceContext;
+
+        int CreateCount;
+        int SetColorCount;
+
+        Fixture()
+            : DeviceContext(Make<MockD2DDeviceContext>())
+            , CreateCount(0)
+            , SetColorCount(0)
+        {
+            DeviceContext->CreateSolidColorBrushMethod.AllowAnyCall(
+                [=] (D2D1_COLOR_F const* color, D2D1_BRUSH_PROPERTIES const*, ID2D1SolidColorBrush** result)
+                {
+                    auto brush = Make<MockD2DSolidColorBrush>();
+
+                    auto currentColor = std::make_shared<D2D1_COLOR_F>(*color);
+
+                    brush->SetColorMethod.AllowAnyCall(
+                        [=] (D2D1_COLOR_F const* newColor)
+                        {
+                            *currentColor = *newColor;
+                            SetColorCount++;
+                        });
+
+                    brush->GetColorMethod.AllowAnyCall([=] { return *currentColor; });
+
+                    CreateCount++;
+
+                    return brush.CopyTo(result);
+                });
+        }
+    };
+
+    TEST_METHOD_EX(SolidColorBrushCache_SameColor_ReturnsSameBrush)
+    {
+        Fixture f;
+        SolidColorBrushCache cache;
+
+        auto brush1 = cache.GetBrush(f.DeviceContext.Get(), Red);
+        auto brush2 = cache.GetBrush(f.DeviceContext.Get(), Red);
+
+        Assert::IsNotNull(brush1);
+        Assert::AreEqual(brush1, brush2);
+        Assert::AreEqual(ToD2DColor(Red), brush1->GetColor());
+
+        Assert::AreEqual(1, f.CreateCount);
+        Assert::AreEqual(0, f.SetColorCount);
+
+        auto stats = cache.GetStatistics();
+        Assert::AreEqual<uint64_t>(1, stats.Hits);
+        Assert::AreEqual<uint64_t>(1, stats.Misses);
+        Assert::AreEqual<size_t>(1, stats.BrushCount);
+    }
+
+    TEST_METHOD_EX(SolidColorBrushCache_InterleavedColors_EachGetTheirOwnBrush)
+    {
+        Fixture f;
+        SolidColorBrushCache cache;
+
+        auto red = cache.GetBrush(f.DeviceContext.Get(), Red);
+        auto green = cache.GetBrush(f.DeviceContext.Get(), Green);
+        auto blue = cache.GetBrush(f.DeviceContext.Get(), Blue);
+
+        // Colors that only differ in alpha are different brushes.
+        auto transparentBlue = cache.GetBrush(f.DeviceContext.Get(), TransparentBlue);
+
+        Assert::AreNotEqual(red, green);
+        Assert::AreNotEqual(green, blue);
+        Assert::AreNotEqual(blue, transparentBlue);
+
+        for (int i = 0; i < 10; i++)
+        {
+            Assert::AreEqual(red, cache.GetBrush(f.DeviceContext.Get(), Red));
+            Assert::AreEqual(green, cache.GetBrush(f.DeviceContext.Get(), Green));
+            Assert::AreEqual(blue, cache.GetBrush(f.DeviceContext.Get(), Blue));
+            Assert::AreEqual(transparentBlue, cache.GetBrush(f.DeviceContext.Get(), TransparentBlue));
+        }
+
+        Assert::AreEqual(4, f.CreateCount);
+        Assert::AreEqual(0, f.SetColorCount);
+    }
+
+    TEST_METHOD_EX(SolidColorBrushCache_WhenFull_RecolorsLeastRecentlyUsedBrush)
+    {
+        Fixture f;
+        SolidColorBrushCache cache(2);
+
+        auto red = cache.GetBrush(f.DeviceContext.Get(), Red);
+        auto green = cache.GetBrush(f.DeviceContext.Get(), Green);
+
+        // Touching red makes green the least recently used.
+        cache.GetBrush(f.DeviceContext.Get(), Red);
+
+        auto blue = cache.GetBrush(f.DeviceContext.Get(), Blue);
+
+        Assert::AreEqual(green, blue);
+        Assert::AreEqual(ToD2DColor(Blue), blue->GetColor());
+
+        Assert::AreEqual(red, cache.GetBrush(f.DeviceContext.Get(), Red));
+        Assert::AreEqual(ToD2DColor(Red), red->GetColor());
+
+        Assert::AreEqual(2, f.CreateCount);
+        Assert::AreEqual(1, f.SetColorCount);
+
+        auto stats = cache.GetStatistics();
+        Assert::AreEqual<uint64_t>(1, stats.Recolors);
+        Assert::AreEqual<size_t>(2, stats.BrushCount);
+    }
+
+    TEST_METHOD_EX(SolidColorBrushCache_Clear_ReleasesBrushes)
+    {
+        Fixture f;
+        SolidColorBrushCache cache;
+
+        ComPtr<ID2D1SolidColorBrush> brush = cache.GetBrush(f.DeviceContext.Get(), Red);
+
+        cache.Clear();
+
+        Assert::AreEqual<size_t>(0, cache.GetStatistics().BrushCount);
+
+        // We now hold the only reference.
+        Assert::AreEqual(0ul, brush.Reset());
+
+        cache.GetBrush(f.DeviceContext.Get(), Red);
+
+        Assert::AreEqual(2, f.CreateCount);
+    }
+
+    //
+    // Draws 100k primitives cycling through a handful of colors, comparing the
+    // default cache against a single recolored brush (the previous behavior).
+    // Timings are reported to the test log rather than asserted on.
+    //
+
+    TEST_METHOD_EX(SolidColorBrushCache_MixedColors_Benchmark)
+    {
+        int const primitiveCount = 100000;
+        int const colorCount = 8;
+
+        std::vector<Color> colors;
+
+        for (int i = 0; i < colorCount; i++)
+        {
+            colors.push_back(Color{ 255, static_cast<BYTE>(i * 32), static_cast<BYTE>(255 - i * 32), 128 });
+        }
+
+        auto run = [&](size_t capacity, Fixture& f)
+        {
+            SolidColorBrushCache cache(capacity);
+
+            BenchmarkTimer timer;
+
+            for (int i = 0; i < primitiveCount; i++)
+            {
+                // Short runs of the same color, as when drawing eg. a legend or a grid.
+                cache.GetBrush(f.DeviceContext.Get(), colors[(i / 3) % colorCount]);
+            }
+
+            return timer.ElapsedMicroseconds();
+        };
+
+        Fixture cached;
+        auto cachedTime = run(SolidColorBrushCache::DefaultCapacity, cached);
+
+        Fixture single;
+        auto singleTime = run(1, single);
+
+        Assert::AreEqual(colorCount, cached.CreateCount);
+        Assert::AreEqual(0, cached.SetColorCount);
+
+        Assert::AreEqual(1, single.CreateCount);
+        Assert::IsTrue(single.SetColorCount > primitiveCount / 4);
+
+        wchar_t message[256];
+        swprintf_s(message, L"%d primitives, %d colors: %lld us with %d brushes, %lld us with one brush (%d SetColor calls)\n",
+            primitiveCount, colorCount, cachedTime, cached.CreateCount, singleTime, single.SetColorCount);
+        Logger::WriteMessage(message);
+    }
+};
@@ -0,0 +1,266 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+static size_t const BytesPer64x64Bitmap = 64 * 64 * 4;
+
+
+TEST_CLASS(StagingBitmapPoolUnitTests)
+{
+public:
+    struct Fixture
+    {
+        ComPtr<MockD2DDevice> Device;
+        ComPtr<MockD2DDeviceContext> DeviceContext;
+        DeviceContextPool ContextPool;
+        StagingBitmapPool Pool;
+
+        Fixture(size_t budgetInBytes = StagingBitmapPool::DefaultBudgetInBytes)
+            : Device(Make<MockD2DDevice>())
+            , DeviceContext(Make<MockD2DDeviceContext>())
+            , ContextPool(Device.Get())
+            , Pool(&ContextPool, budgetInBytes)
+        {
+            Device->MockCreateDeviceContext =
+                [=] (D2D1_DEVICE_CONTEXT_OPTIONS, ID2D1DeviceContext1** deviceContext)
+                {
+                    ThrowIfFailed(DeviceContext.CopyTo(deviceContext));
+                };
+
+            DeviceContext->GetMaximumBitmapSizeMethod.AllowAnyCall([] { return 4000U; });
+        }
+
+        void ExpectCreateBitmap(int expectedCalls, D2D1_SIZE_U expectedSize = D2D1_SIZE_U{ 64, 64 }, DXGI_FORMAT expectedFormat = DXGI_FORMAT_B8G8R8A8_UNORM)
+        {
+            DeviceContext->CreateBitmapMethod.SetExpectedCalls(expectedCalls,
+                [=] (D2D1_SIZE_U size, void const* sourceData, UINT32 pitch, D2D1_BITMAP_PROPERTIES1 const* bitmapProperties, ID2D1Bitmap1** bitmap)
+                {
+                    Assert::AreEqual(expectedSize.width, size.width);
+                    Assert::AreEqual(expectedSize.height, size.height);
+                    Assert::IsNull(sourceData);
+                    Assert::AreEqual(0U, pitch);
+                    Assert::AreEqual(D2D1_BITMAP_OPTIONS_CPU_READ | D2D1_BITMAP_OPTIONS_CANNOT_DRAW, bitmapProperties->bitmapOptions);
+                    Assert::AreEqual(expectedFormat, bitmapProperties->pixelFormat.format);
+                    return Make<MockD2DBitmap>().CopyTo(bitmap);
+                });
+        }
+
+        StagingBitmapLease TakeLease(uint32_t width, uint32_t height, DXGI_FORMAT format = DXGI_FORMAT_B8G8R8A8_UNORM)
+        {
+            return Pool.TakeLease(D2D1_SIZE_U{ width, height }, D2D1::PixelFormat(format, D2D1_ALPHA_MODE_PREMULTIPLIED));
+        }
+    };
+
+    TEST_METHOD_EX(StagingBitmapPool_GetBucketSize)
+    {
+        Assert::AreEqual(4U, StagingBitmapPool::GetBucketSize(1));
+        Assert::AreEqual(4U, StagingBitmapPool::GetBucketSize(4));
+        Assert::AreEqual(8U, StagingBitmapPool::GetBucketSize(5));
+        Assert::AreEqual(64U, StagingBitmapPool::GetBucketSize(33));
+        Assert::AreEqual(256U, StagingBitmapPool::GetBucketSize(256));
+        Assert::AreEqual(512U, StagingBitmapPool::GetBucketSize(257));
+        Assert::AreEqual(1280U, StagingBitmapPool::GetBucketSize(1080));
+        Assert::AreEqual(2048U, StagingBitmapPool::GetBucketSize(1920));
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_Creation_DoesNotCreateBitmaps)
+    {
+        Fixture f;
+
+        auto stats = f.Pool.GetStatistics();
+        Assert::AreEqual(0ULL, stats.Hits);
+        Assert::AreEqual(0ULL, stats.Misses);
+        Assert::AreEqual<size_t>(0, stats.IdleBitmapCount);
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_ReturnedBitmapIsReusedForRequestsInTheSameBucket)
+    {
+        Fixture f;
+        f.ExpectCreateBitmap(1);
+
+        ID2D1Bitmap1* firstBitmap;
+
+        {
+            auto lease = f.TakeLease(50, 60);
+            firstBitmap = lease.Get();
+        }
+
+        auto stats = f.Pool.GetStatistics();
+        Assert::AreEqual<size_t>(1, stats.IdleBitmapCount);
+        Assert::AreEqual(BytesPer64x64Bitmap, stats.IdleBytes);
+
+        for (int i = 0; i < 10; i++)
+        {
+            auto lease = f.TakeLease(33 + i, 64 - i);
+            Assert::AreEqual(firstBitmap, lease.Get());
+        }
+
+        stats = f.Pool.GetStatistics();
+        Assert::AreEqual(10ULL, stats.Hits);
+        Assert::AreEqual(1ULL, stats.Misses);
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_DifferentBucketsOrFormatsDoNotShareBitmaps)
+    {
+        Fixture f;
+
+        f.ExpectCreateBitmap(1);
+        f.TakeLease(64, 64);
+
+        f.ExpectCreateBitmap(1, D2D1_SIZE_U{ 64, 128 });
+        f.TakeLease(64, 65);
+
+        f.ExpectCreateBitmap(1, D2D1_SIZE_U{ 64, 64 }, DXGI_FORMAT_R8G8B8A8_UNORM);
+        f.TakeLease(64, 64, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+        auto stats = f.Pool.GetStatistics();
+        Assert::AreEqual(0ULL, stats.Hits);
+        Assert::AreEqual(3ULL, stats.Misses);
+        Assert::AreEqual<size_t>(3, stats.IdleBitmapCount);
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_SizesBeyondMaximumBitmapSizeAreNotRoundedUp)
+    {
+        Fixture f;
+
+        f.ExpectCreateBitmap(1, D2D1_SIZE_U{ 3900, 64 });
+        f.TakeLease(3900, 64);
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_SimultaneousLeasesGetDifferentBitmaps)
+    {
+        Fixture f;
+        f.ExpectCreateBitmap(2);
+
+        auto lease1 = f.TakeLease(64, 64);
+        auto lease2 = f.TakeLease(64, 64);
+
+        Assert::AreNotEqual(lease1.Get(), lease2.Get());
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_WhenOverBudget_LeastRecentlyUsedBitmapsAreReleased)
+    {
+        Fixture f(BytesPer64x64Bitmap * 2);
+        f.ExpectCreateBitmap(3);
+
+        ID2D1Bitmap1* bitmaps[3];
+
+        {
+            StagingBitmapLease leases[3];
+
+            for (int i = 0; i < 3; i++)
+            {
+                leases[i] = f.TakeLease(64, 64);
+                bitmaps[i] = leases[i].Get();
+            }
+
+            for (int i = 0; i < 3; i++)
+            {
+                leases[i] = StagingBitmapLease();
+            }
+        }
+
+        auto stats = f.Pool.GetStatistics();
+        Assert::AreEqual<size_t>(2, stats.IdleBitmapCount);
+        Assert::AreEqual(BytesPer64x64Bitmap * 2, stats.IdleBytes);
+
+        // The most recently returned bitmap is reused first; the one
+        // returned first has been released.
+        auto lease2 = f.TakeLease(64, 64);
+        auto lease1 = f.TakeLease(64, 64);
+
+        Assert::AreEqual(bitmaps[2], lease2.Get());
+        Assert::AreEqual(bitmaps[1], lease1.Get());
+
+        f.ExpectCreateBitmap(1);
+        auto lease0 = f.TakeLease(64, 64);
+        Assert::AreNotEqual(bitmaps[0], lease0.Get());
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_BitmapLargerThanBudget_IsKeptUntilAnotherIsReturned)
+    {
+        Fixture f(BytesPer64x64Bitmap);
+        f.ExpectCreateBitmap(1, D2D1_SIZE_U{ 128, 128 });
+
+        ID2D1Bitmap1* largeBitmap;
+
+        {
+            auto lease = f.TakeLease(128, 128);
+            largeBitmap = lease.Get();
+        }
+
+        auto stats = f.Pool.GetStatistics();
+        Assert::AreEqual<size_t>(1, stats.IdleBitmapCount);
+        Assert::AreEqual(BytesPer64x64Bitmap * 4, stats.IdleBytes);
+
+        {
+            auto lease = f.TakeLease(128, 128);
+            Assert::AreEqual(largeBitmap, lease.Get());
+        }
+
+        // Returning a bitmap that fits the budget evicts the large one.
+        f.ExpectCreateBitmap(1);
+
+        {
+            auto lease = f.TakeLease(64, 64);
+        }
+
+        stats = f.Pool.GetStatistics();
+        Assert::AreEqual<size_t>(1, stats.IdleBitmapCount);
+        Assert::AreEqual(BytesPer64x64Bitmap, stats.IdleBytes);
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_SetBudget_TrimsIdleBitmaps)
+    {
+        Fixture f;
+        f.ExpectCreateBitmap(2);
+
+        {
+            auto lease1 = f.TakeLease(64, 64);
+            auto lease2 = f.TakeLease(64, 64);
+        }
+
+        f.Pool.SetBudget(BytesPer64x64Bitmap);
+        Assert::AreEqual<size_t>(1, f.Pool.GetStatistics().IdleBitmapCount);
+
+        f.Pool.SetBudget(0);
+        Assert::AreEqual<size_t>(0, f.Pool.GetStatistics().IdleBitmapCount);
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_Trim_ReleasesIdleBitmaps_ButOutstandingLeasesAreStillReturned)
+    {
+        Fixture f;
+        f.ExpectCreateBitmap(2);
+
+        {
+            auto lease = f.TakeLease(64, 64);
+        }
+
+        auto outstandingLease = f.TakeLease(64, 64);
+        auto otherLease = f.TakeLease(64, 64);
+        otherLease = StagingBitmapLease();
+
+        f.Pool.Trim();
+        Assert::AreEqual<size_t>(0, f.Pool.GetStatistics().IdleBitmapCount);
+
+        outstandingLease = StagingBitmapLease();
+        Assert::AreEqual<size_t>(1, f.Pool.GetStatistics().IdleBitmapCount);
+    }
+
+    TEST_METHOD_EX(StagingBitmapPool_WhenClosed_ReturnedBitmapsAreDiscarded_AndTakeLeaseFails)
+    {
+        Fixture f;
+        f.ExpectCreateBitmap(1);
+
+        {
+            auto lease = f.TakeLease(64, 64);
+            f.Pool.Close();
+        }
+
+        Assert::AreEqual<size_t>(0, f.Pool.GetStatistics().IdleBitmapCount);
+
+        ExpectHResultException(RO_E_CLOSED, [&] { f.TakeLease(64, 64); });
+    }
+};
@@ -53,6 +53,8 @@ namespace canvas
         CALL_COUNTER_WITH_MOCK(CreatePrintControlMethod, ComPtr<ID2D1PrintControl>(IPrintDocumentPackageTarget*, float));
         
         CALL_COUNTER_WITH_MOCK(GetResourceCreationDeviceContextMethod, DeviceContextLease());
+        CALL_COUNTER_WITH_MOCK(LeaseStagingBitmapMethod, StagingBitmapLease(D2D1_SIZE_U, D2D1_PIXEL_FORMAT));
+        CALL_COUNTER_WITH_MOCK(LeaseFrameArenaMethod, FrameArenaLease());
 
         CALL_COUNTER_WITH_MOCK(GetPrimaryDisplayOutputMethod, ComPtr<IDXGIOutput>());
 
@@ -75,6 +77,7 @@ namespace canvas
         CALL_COUNTER_WITH_MOCK(GetDeviceLostReasonMethod, HRESULT(int*));
 
         CALL_COUNTER_WITH_MOCK(CreateGradientMeshMethod, ComPtr<ID2D1GradientMesh>(D2D1_GRADIENT_MESH_PATCH const*, UINT32));
+        CALL_COUNTER_WITH_MOCK(CreateSpriteBatchMethod, ComPtr<ID2D1SpriteBatch>());
         CALL_COUNTER_WITH_MOCK(IsSpriteBatchQuirkRequiredMethod, bool());
 
         CALL_COUNTER_WITH_MOCK(CreateSvgDocumentMethod, ComPtr<ID2D1SvgDocument>(IStream*));
@@ -409,6 +412,16 @@ namespace canvas
             return GetResourceCreationDeviceContextMethod.WasCalled();
         }
 
+        virtual StagingBitmapLease LeaseStagingBitmap(D2D1_SIZE_U const& size, D2D1_PIXEL_FORMAT const& format) override
+        {
+            return LeaseStagingBitmapMethod.WasCalled(size, format);
+        }
+
+        virtual FrameArenaLease LeaseFrameArena() override
+        {
+            return LeaseFrameArenaMethod.WasCalled();
+        }
+
         virtual ComPtr<IDXGIOutput> GetPrimaryDisplayOutput() override
         {
             return GetPrimaryDisplayOutputMethod.WasCalled();
@@ -436,6 +449,11 @@ namespace canvas
             return CreateGradientMeshMethod.WasCalled(patches, patchCount);
         }
 
+        virtual ComPtr<ID2D1SpriteBatch> CreateSpriteBatch() override
+        {
+            return CreateSpriteBatchMethod.WasCalled();
+        }
+
         virtual bool IsSpriteBatchQuirkRequired()
         {
             return IsSpriteBatchQuirkRequiredMethod.WasCalled();
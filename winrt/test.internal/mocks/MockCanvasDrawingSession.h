@@ -231,6 +231,8 @@ namespace canvas
         DONT_EXPECT(put_EffectBufferPrecision   , IReference<CanvasBufferPrecision>*);
         DONT_EXPECT(get_EffectTileSize          , BitmapSize*);
         DONT_EXPECT(put_EffectTileSize          , BitmapSize);
+        DONT_EXPECT(get_FoldColorEffects        , boolean*);
+        DONT_EXPECT(put_FoldColorEffects        , boolean);
 
         DONT_EXPECT(CreateLayerWithOpacity                                , float, ICanvasActiveLayer**);
         DONT_EXPECT(CreateLayerWithOpacityBrush                           , ICanvasBrush*, ICanvasActiveLayer**);
@@ -246,6 +248,31 @@ namespace canvas
         DONT_EXPECT(CreateSpriteBatchWithSortMode                           , CanvasSpriteSortMode, ICanvasSpriteBatch**);
         DONT_EXPECT(CreateSpriteBatchWithSortModeAndInterpolation           , CanvasSpriteSortMode, CanvasImageInterpolation, ICanvasSpriteBatch**);
         DONT_EXPECT(CreateSpriteBatchWithSortModeAndInterpolationAndOptions , CanvasSpriteSortMode, CanvasImageInterpolation, CanvasSpriteOptions, ICanvasSpriteBatch**);
+        DONT_EXPECT(DrawRetainedSpriteBatch                                 , ICanvasRetainedSpriteBatch*);
+        DONT_EXPECT(DrawRetainedSpriteBatchRange                            , ICanvasRetainedSpriteBatch*, int32_t, int32_t);
+
+        DONT_EXPECT(FillRectanglesWithBrush                                 , uint32_t, Rect*, ICanvasBrush*);
+        DONT_EXPECT(FillRectanglesWithColor                                 , uint32_t, Rect*, Color);
+        DONT_EXPECT(FillRectanglesWithColors                                , uint32_t, Rect*, uint32_t, Color*);
+        DONT_EXPECT(DrawLinesWithBrush                                      , uint32_t, Vector2*, ICanvasBrush*);
+        DONT_EXPECT(DrawLinesWithColor                                      , uint32_t, Vector2*, Color);
+        DONT_EXPECT(DrawLinesWithColors                                     , uint32_t, Vector2*, uint32_t, Color*);
+        DONT_EXPECT(DrawLinesWithBrushAndStrokeWidthAndStrokeStyle          , uint32_t, Vector2*, ICanvasBrush*, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(DrawLinesWithColorAndStrokeWidthAndStrokeStyle          , uint32_t, Vector2*, Color, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(DrawLinesWithColorsAndStrokeWidthAndStrokeStyle         , uint32_t, Vector2*, uint32_t, Color*, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(FillCirclesWithBrush                                    , uint32_t, Vector2*, uint32_t, float*, ICanvasBrush*);
+        DONT_EXPECT(FillCirclesWithColor                                    , uint32_t, Vector2*, uint32_t, float*, Color);
+        DONT_EXPECT(FillCirclesWithColors                                   , uint32_t, Vector2*, uint32_t, float*, uint32_t, Color*);
+        DONT_EXPECT(DrawPolylineWithBrush                                   , uint32_t, Vector2*, ICanvasBrush*);
+        DONT_EXPECT(DrawPolylineWithColor                                   , uint32_t, Vector2*, Color);
+        DONT_EXPECT(DrawPolylineWithBrushAndStrokeWidthAndStrokeStyle       , uint32_t, Vector2*, ICanvasBrush*, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(DrawPolylineWithColorAndStrokeWidthAndStrokeStyle       , uint32_t, Vector2*, Color, float, ICanvasStrokeStyle*);
+        DONT_EXPECT(DrawPolylineWithBrushAndStrokeWidthAndStrokeStyleAndDecimation, uint32_t, Vector2*, ICanvasBrush*, float, ICanvasStrokeStyle*, boolean);
+        DONT_EXPECT(DrawPolylineWithColorAndStrokeWidthAndStrokeStyleAndDecimation, uint32_t, Vector2*, Color, float, ICanvasStrokeStyle*, boolean);
+
+        DONT_EXPECT(DrawRecording                                           , ICanvasDrawingRecording*);
+        DONT_EXPECT(DrawRecordingInRegion                                   , ICanvasDrawingRecording*, Rect);
+        DONT_EXPECT(DrawRecordingRange                                      , ICanvasDrawingRecording*, int32_t, int32_t);
 
         DONT_EXPECT(DrawSvgAtOrigin, ICanvasSvgDocument*, Size);
         DONT_EXPECT(DrawSvgAtPoint, ICanvasSvgDocument*, Size, Vector2);
@@ -232,6 +232,9 @@ namespace canvas
         std::vector<ComPtr<ID2D1Image>> m_inputs;
         std::vector<std::vector<byte>> m_properties;
 
+        // System properties (eg. D2D1_PROPERTY_CACHED) have indices too large to store in m_properties.
+        std::map<UINT32, std::vector<byte>> m_systemProperties;
+
         MockD2DEffectThatCountsCalls(IID const& effectId = CLSID_D2D1GaussianBlur)
           : m_effectId(effectId)
           , m_inputCount(0)
@@ -268,6 +271,12 @@ namespace canvas
             {
                 m_setValueCalls++;
 
+                if (index >= static_cast<UINT32>(D2D1_PROPERTY_CLSID))
+                {
+                    m_systemProperties[index] = std::vector<byte>(data, data + dataSize);
+                    return S_OK;
+                }
+
                 if (index >= m_properties.size())
                     m_properties.resize(index + 1);
 
@@ -275,6 +284,28 @@ namespace canvas
 
                 return S_OK;
             };
+
+            MockGetValue = [&](UINT32 index, D2D1_PROPERTY_TYPE type, BYTE* data, UINT32 dataSize)
+            {
+                if (index < static_cast<UINT32>(D2D1_PROPERTY_CLSID))
+                {
+                    Assert::Fail(L"Unexpected call to GetValue");
+                    return E_NOTIMPL;
+                }
+
+                // System properties that were never set read back as zero (ie. FALSE, or D2D1_BUFFER_PRECISION_UNKNOWN).
+                memset(data, 0, dataSize);
+
+                auto it = m_systemProperties.find(index);
+
+                if (it != m_systemProperties.end())
+                {
+                    Assert::AreEqual<size_t>(dataSize, it->second.size());
+                    memcpy(data, it->second.data(), dataSize);
+                }
+
+                return S_OK;
+            };
         }
     };
 }
@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+namespace canvas
+{
+    class StubBuffer : public RuntimeClass<
+        RuntimeClassFlags<WinRtClassicComMix>,
+        ABI::Windows::Storage::Streams::IBuffer,
+        ::Windows::Storage::Streams::IBufferByteAccess>
+    {
+        InspectableClass(L"StubBuffer", BaseTrust);
+
+        std::vector<uint8_t> m_data;
+        uint32_t m_length;
+
+    public:
+        StubBuffer(uint32_t capacity)
+            : m_data(capacity)
+            , m_length(0)
+        {
+        }
+
+        std::vector<uint8_t> const& GetData() const
+        {
+            return m_data;
+        }
+
+        IFACEMETHODIMP get_Capacity(UINT32* value) override
+        {
+            *value = static_cast<UINT32>(m_data.size());
+            return S_OK;
+        }
+
+        IFACEMETHODIMP get_Length(UINT32* value) override
+        {
+            *value = m_length;
+            return S_OK;
+        }
+
+        IFACEMETHODIMP put_Length(UINT32 value) override
+        {
+            if (value > m_data.size())
+                return E_INVALIDARG;
+
+            m_length = value;
+            return S_OK;
+        }
+
+        IFACEMETHODIMP Buffer(byte** value) override
+        {
+            *value = m_data.data();
+            return S_OK;
+        }
+    };
+}
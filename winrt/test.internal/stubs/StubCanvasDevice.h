@@ -21,6 +21,7 @@ namespace canvas
         ComPtr<MockD3D11Device> m_d3dDevice;
         ComPtr<MockEventSource<DeviceLostHandlerType>> m_deviceLostEventSource;
         DeviceContextPool m_deviceContextPool;
+        FrameArenaPool m_frameArenaPool;
         
     public:
         StubCanvasDevice(ComPtr<ID2D1Device1> device = Make<StubD2DDevice>(), ComPtr<MockD3D11Device> d3dDevice = nullptr)
@@ -57,6 +58,12 @@ namespace canvas
                     return m_deviceContextPool.TakeLease();
                 });
 
+            LeaseFrameArenaMethod.AllowAnyCall(
+                [=]
+                {
+                    return m_frameArenaPool.TakeLease();
+                });
+
             GetPrimaryDisplayOutputMethod.AllowAnyCall(
                 [=]
                 {
@@ -90,6 +97,13 @@ namespace canvas
                     return S_OK;
                 });
 
+            IsDeviceLost2Method.AllowAnyCall(
+                [=](boolean* out)
+                {
+                    *out = false;
+                    return S_OK;
+                });
+
             CreateGradientMeshMethod.AllowAnyCall(
                 [=](D2D1_GRADIENT_MESH_PATCH const*, UINT32)
                 {
@@ -103,6 +117,11 @@ namespace canvas
                 });
         }
 
+        FrameArenaPool& GetFrameArenaPool()
+        {
+            return m_frameArenaPool;
+        }
+
         void MarkAsLost()
         {
             auto d3dDevice = GetDXGIInterfaceFromResourceCreator<ID3D11Device>(this);
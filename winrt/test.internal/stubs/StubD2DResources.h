@@ -28,6 +28,16 @@ public:
         _Outptr_ ID2D1StrokeStyle1 **strokeStyle
         );
 
+    // Lets tests see geometry that the drawing session builds for itself (eg. DrawPolyline).
+    CALL_COUNTER_WITH_MOCK(CreatePathGeometryMethod, HRESULT(ID2D1PathGeometry1**));
+
+    STDMETHOD(CreatePathGeometry)(
+        _Outptr_ ID2D1PathGeometry1 **pathGeometry
+        ) override
+    {
+        return CreatePathGeometryMethod.WasCalled(pathGeometry);
+    }
+
     int m_numCallsToCreateStrokeStyle;
     D2D1_CAP_STYLE m_startCap;
     D2D1_CAP_STYLE m_endCap;
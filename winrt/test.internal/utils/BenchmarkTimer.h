@@ -0,0 +1,40 @@
+﻿// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#pragma once
+
+#include <chrono>
+
+//
+// Wall-clock timer shared by the benchmark tests.  It starts when
+// constructed.  Timings vary with the machine and its load, so benchmarks
+// only log them.  Correctness is asserted separately.
+//
+class BenchmarkTimer
+{
+    typedef std::chrono::high_resolution_clock Clock;
+
+    Clock::time_point m_start;
+
+public:
+    BenchmarkTimer()
+        : m_start(Clock::now())
+    {
+    }
+
+    void Restart()
+    {
+        m_start = Clock::now();
+    }
+
+    long long ElapsedMicroseconds() const
+    {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_start).count());
+    }
+
+    double ElapsedNanoseconds() const
+    {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count());
+    }
+};
@@ -20,6 +20,18 @@ TEST_CLASS(ComArrayTests)
             return p;
         }
         
+        static void* CoTaskMemRealloc(void* p, size_t bytes)
+        {
+            if (p)
+            {
+                Assert::AreEqual<size_t>(1U, GetAllocations()->count(p));
+                GetAllocations()->erase(p);
+            }
+            auto newP = ::CoTaskMemRealloc(p, bytes);
+            GetAllocations()->insert(newP);
+            return newP;
+        }
+
         static void CoTaskMemFree(void* p)
         {
             if (p)
@@ -122,6 +134,29 @@ TEST_CLASS(ComArrayTests)
         Tracker::CoTaskMemFree(data);
     }
 
+    TEST_METHOD_EX(ComArray_Resize_KeepsExistingElements)
+    {
+        ComArray<float, Tracker> array(3);
+        array[0] = 1;
+        array[1] = 2;
+        array[2] = 3;
+
+        array.Resize(1000);
+        Assert::AreEqual(1000U, array.GetSize());
+        Assert::AreEqual(1.0f, array[0]);
+        Assert::AreEqual(2.0f, array[1]);
+        Assert::AreEqual(3.0f, array[2]);
+
+        array.Resize(2);
+        Assert::AreEqual(2U, array.GetSize());
+        Assert::AreEqual(1.0f, array[0]);
+        Assert::AreEqual(2.0f, array[1]);
+
+        array.Resize(0);
+        Assert::AreEqual(0U, array.GetSize());
+        Assert::IsNotNull(array.GetData());
+    }
+
     TEST_METHOD_EX(ComArray_GetAddressOfData_ReleasesAndTracksNewValue)
     {
         ComArray<float, Tracker> array(100);
@@ -183,6 +183,7 @@ namespace Microsoft
             TO_STRING(ABI::Windows::UI::Core::ICoreCursor);
             TO_STRING(ICanvasDevice);
             TO_STRING(ID2D1Brush);
+            TO_STRING(ID2D1SolidColorBrush);
             TO_STRING(ID2D1Image);
             TO_STRING(ID2D1Device);
             TO_STRING(ID2D1Device1);
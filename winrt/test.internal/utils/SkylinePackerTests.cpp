@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+#include "../lib/utils/SkylinePacker.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas;
+
+TEST_CLASS(SkylinePackerTests)
+{
+    struct PackedRect
+    {
+        uint32_t X, Y, Width, Height;
+    };
+
+    static bool Overlaps(PackedRect const& a, PackedRect const& b)
+    {
+        return a.X < b.X + b.Width && b.X < a.X + a.Width &&
+               a.Y < b.Y + b.Height && b.Y < a.Y + a.Height;
+    }
+
+    static void ValidateNoOverlaps(SkylinePacker const& packer, std::vector<PackedRect> const& rects)
+    {
+        for (size_t i = 0; i < rects.size(); i++)
+        {
+            Assert::IsTrue(rects[i].X + rects[i].Width <= packer.Width());
+            Assert::IsTrue(rects[i].Y + rects[i].Height <= packer.Height());
+
+            for (size_t j = i + 1; j < rects.size(); j++)
+            {
+                Assert::IsFalse(Overlaps(rects[i], rects[j]));
+            }
+        }
+    }
+
+    TEST_METHOD_EX(SkylinePacker_FirstRectangleGoesInTheCorner)
+    {
+        SkylinePacker packer(100, 100);
+        SkylinePacker::Position position{ 123, 456 };
+
+        Assert::IsTrue(packer.TryInsert(10, 20, &position));
+
+        Assert::AreEqual(0u, position.X);
+        Assert::AreEqual(0u, position.Y);
+        Assert::AreEqual(200ull, packer.UsedArea());
+    }
+
+    TEST_METHOD_EX(SkylinePacker_FillsRowsBeforeStartingANewOne)
+    {
+        SkylinePacker packer(30, 30);
+        SkylinePacker::Position position;
+
+        for (uint32_t y = 0; y < 30; y += 10)
+        {
+            for (uint32_t x = 0; x < 30; x += 10)
+            {
+                Assert::IsTrue(packer.TryInsert(10, 10, &position));
+                Assert::AreEqual(x, position.X);
+                Assert::AreEqual(y, position.Y);
+            }
+        }
+
+        Assert::AreEqual(900ull, packer.UsedArea());
+        Assert::IsFalse(packer.TryInsert(1, 1, &position));
+    }
+
+    TEST_METHOD_EX(SkylinePacker_PrefersTheLowestGap)
+    {
+        SkylinePacker packer(30, 100);
+        SkylinePacker::Position position;
+
+        Assert::IsTrue(packer.TryInsert(10, 50, &position));
+        Assert::IsTrue(packer.TryInsert(10, 10, &position));
+        Assert::IsTrue(packer.TryInsert(10, 30, &position));
+
+        // The lowest point of the skyline is now on top of the second rectangle.
+        Assert::IsTrue(packer.TryInsert(10, 10, &position));
+        Assert::AreEqual(10u, position.X);
+        Assert::AreEqual(10u, position.Y);
+    }
+
+    TEST_METHOD_EX(SkylinePacker_WhenRectangleDoesNotFit_ReturnsFalseAndLeavesPackerUnchanged)
+    {
+        SkylinePacker packer(50, 50);
+        SkylinePacker::Position position{ 123, 456 };
+
+        Assert::IsFalse(packer.TryInsert(51, 1, &position));
+        Assert::IsFalse(packer.TryInsert(1, 51, &position));
+        Assert::IsFalse(packer.TryInsert(0, 1, &position));
+        Assert::IsFalse(packer.TryInsert(1, 0, &position));
+
+        Assert::AreEqual(123u, position.X);
+        Assert::AreEqual(456u, position.Y);
+        Assert::AreEqual(0ull, packer.UsedArea());
+
+        Assert::IsTrue(packer.TryInsert(50, 50, &position));
+        Assert::AreEqual(0u, position.X);
+        Assert::AreEqual(0u, position.Y);
+    }
+
+    TEST_METHOD_EX(SkylinePacker_RandomRectangles_DoNotOverlapAndPackEfficiently)
+    {
+        const uint32_t binSize = 1024;
+
+        SkylinePacker packer(binSize, binSize);
+        std::vector<PackedRect> rects;
+
+        // Fixed seed, so the test is deterministic.
+        uint32_t seed = 42;
+        auto random = [&](uint32_t range) { seed = seed * 1664525 + 1013904223; return (seed >> 8) % range; };
+
+        int failedInserts = 0;
+
+        while (failedInserts < 100)
+        {
+            uint32_t width = 8 + random(57);
+            uint32_t height = 8 + random(57);
+            SkylinePacker::Position position;
+
+            if (packer.TryInsert(width, height, &position))
+                rects.push_back(PackedRect{ position.X, position.Y, width, height });
+            else
+                failedInserts++;
+        }
+
+        ValidateNoOverlaps(packer, rects);
+
+        double efficiency = static_cast<double>(packer.UsedArea()) / (binSize * binSize);
+
+        wchar_t message[256];
+        swprintf_s(message, L"Packed %u rectangles into %ux%u with %.1f%% efficiency\n", static_cast<uint32_t>(rects.size()), binSize, binSize, efficiency * 100);
+        Logger::WriteMessage(message);
+
+        Assert::IsTrue(efficiency > 0.8);
+    }
+};
@@ -0,0 +1,174 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "../lib/utils/PixelConversion.h"
+#include "../test.internal/utils/BenchmarkTimer.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas;
+
+//
+// Times each set of conversion kernels on a 4K frame.  The readback case
+// mirrors GetPixelColors: a mapped B8G8R8A8 surface, whose rows are padded
+// out to a larger pitch, is converted row by row into a packed array of
+// Windows.UI.Color.  The per-pixel loop that GetPixelColors used before the
+// kernels existed is timed alongside for comparison.
+//
+// Usage: PixelConversionBenchmark [iterations]
+//
+
+static const uint32_t FrameWidth = 3840;
+static const uint32_t FrameHeight = 2160;
+static const uint32_t FramePixelCount = FrameWidth * FrameHeight;
+
+// Staging textures are typically mapped with some padding after each row.
+static const uint32_t SourcePitch = FrameWidth * 4 + 256;
+
+// Laid out the same as Windows.UI.Color.
+struct Color
+{
+    uint8_t A;
+    uint8_t R;
+    uint8_t G;
+    uint8_t B;
+};
+
+// Runs the function several times and reports the fastest, which is the
+// least disturbed by whatever else the machine is doing.
+template<typename Fn>
+static double MeasureMilliseconds(int iterations, Fn&& fn)
+{
+    double fastest = 0;
+
+    for (int i = 0; i < iterations; i++)
+    {
+        BenchmarkTimer timer;
+        fn();
+        double milliseconds = timer.ElapsedNanoseconds() / 1000000;
+
+        if (i == 0 || milliseconds < fastest)
+            fastest = milliseconds;
+    }
+
+    return fastest;
+}
+
+static void Report(char const* operation, wchar_t const* kernelsName, double milliseconds, double bytesPerFrame)
+{
+    printf("%-24s %-8ls %8.2f ms  %8.2f GB/s\n", operation, kernelsName, milliseconds, bytesPerFrame / (milliseconds * 1000000));
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = (argc > 1) ? std::max(1, atoi(argv[1])) : 10;
+
+    printf("%u x %u frame, fastest of %d runs\n\n", FrameWidth, FrameHeight, iterations);
+
+    std::vector<uint8_t> mapped(SourcePitch * FrameHeight);
+    uint32_t seed = 12345;
+
+    for (auto& value : mapped)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = static_cast<uint8_t>(seed >> 16);
+    }
+
+    std::vector<Color> colors(FramePixelCount);
+    std::vector<Color> expectedColors(FramePixelCount);
+
+    // The loop GetPixelColors had before it used ReverseChannelOrder.
+    auto perPixelTime = MeasureMilliseconds(iterations, [&]
+    {
+        uint8_t const* sourceRowStart = mapped.data();
+
+        for (uint32_t y = 0; y < FrameHeight; y++)
+        {
+            for (uint32_t x = 0; x < FrameWidth; x++)
+            {
+                uint32_t sourcePixel;
+                memcpy(&sourcePixel, &sourceRowStart[x * 4], sizeof(sourcePixel));
+
+                Color& destColor = expectedColors[y * FrameWidth + x];
+                destColor.B = (sourcePixel >> 0) & 0xFF;
+                destColor.G = (sourcePixel >> 8) & 0xFF;
+                destColor.R = (sourcePixel >> 16) & 0xFF;
+                destColor.A = (sourcePixel >> 24) & 0xFF;
+            }
+
+            sourceRowStart += SourcePitch;
+        }
+    });
+
+    Report("GetPixelColors readback", L"Loop", perPixelTime, FramePixelCount * 4.0);
+
+    for (auto kernels : GetSupportedPixelConversionKernels())
+    {
+        auto time = MeasureMilliseconds(iterations, [&]
+        {
+            uint8_t const* sourceRowStart = mapped.data();
+
+            for (uint32_t y = 0; y < FrameHeight; y++)
+            {
+                kernels->ReverseChannelOrder(sourceRowStart, reinterpret_cast<uint8_t*>(colors.data() + y * FrameWidth), FrameWidth);
+                sourceRowStart += SourcePitch;
+            }
+        });
+
+        if (memcmp(colors.data(), expectedColors.data(), colors.size() * sizeof(Color)) != 0)
+        {
+            printf("%ls readback does not match the per-pixel loop\n", kernels->Name);
+            return 1;
+        }
+
+        Report("GetPixelColors readback", kernels->Name, time, FramePixelCount * 4.0);
+    }
+
+    printf("\n");
+
+    // The remaining kernels, each over a whole packed frame.
+    std::vector<uint8_t> pixels(mapped.begin(), mapped.begin() + FramePixelCount * 4);
+    std::vector<uint8_t> bytes(FramePixelCount * 4);
+    std::vector<float> floats(FramePixelCount * 4);
+    std::vector<uint16_t> halves(FramePixelCount * 4);
+
+    GetScalarPixelConversionKernels().UnormToFloat(pixels.data(), floats.data(), FramePixelCount * 4);
+    GetScalarPixelConversionKernels().UnormToHalf(pixels.data(), halves.data(), FramePixelCount * 4);
+
+    for (auto kernels : GetSupportedPixelConversionKernels())
+    {
+        uint32_t valueCount = FramePixelCount * 4;
+
+        Report("Premultiply", kernels->Name,
+            MeasureMilliseconds(iterations, [&] { kernels->Premultiply(pixels.data(), bytes.data(), FramePixelCount); }),
+            valueCount * 2.0);
+
+        Report("Unpremultiply", kernels->Name,
+            MeasureMilliseconds(iterations, [&] { kernels->Unpremultiply(pixels.data(), bytes.data(), FramePixelCount); }),
+            valueCount * 2.0);
+
+        Report("UnormToFloat", kernels->Name,
+            MeasureMilliseconds(iterations, [&] { kernels->UnormToFloat(pixels.data(), floats.data(), valueCount); }),
+            valueCount * 5.0);
+
+        Report("FloatToUnorm", kernels->Name,
+            MeasureMilliseconds(iterations, [&] { kernels->FloatToUnorm(floats.data(), bytes.data(), valueCount); }),
+            valueCount * 5.0);
+
+        Report("UnormToHalf", kernels->Name,
+            MeasureMilliseconds(iterations, [&] { kernels->UnormToHalf(pixels.data(), halves.data(), valueCount); }),
+            valueCount * 3.0);
+
+        Report("HalfToUnorm", kernels->Name,
+            MeasureMilliseconds(iterations, [&] { kernels->HalfToUnorm(halves.data(), bytes.data(), valueCount); }),
+            valueCount * 3.0);
+
+        printf("\n");
+    }
+
+    return 0;
+}
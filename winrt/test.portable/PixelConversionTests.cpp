@@ -0,0 +1,330 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// Licensed under the MIT License. See LICENSE.txt in the project root for license information.
+
+#include "pch.h"
+
+#include <cstdio>
+
+#include "../lib/utils/PixelConversion.h"
+
+using namespace ABI::Microsoft::Graphics::Canvas;
+
+//
+// Checks that every set of conversion kernels the CPU supports gives exactly
+// the same output as the scalar ones, and that the scalar ones give the
+// documented results.
+//
+
+static int g_failureCount = 0;
+
+static void Check(bool condition, char const* test, wchar_t const* kernelsName)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s (%ls)\n", test, kernelsName);
+        g_failureCount++;
+    }
+}
+
+template<typename T>
+static bool AreBitwiseEqual(std::vector<T> const& expected, std::vector<T> const& actual)
+{
+    return expected.size() == actual.size() &&
+           memcmp(expected.data(), actual.data(), expected.size() * sizeof(T)) == 0;
+}
+
+// Long enough to cover several full vector blocks followed by every
+// possible length of leftover tail.
+static const uint32_t MaxPixelCount = 67;
+
+static std::vector<uint8_t> MakeTestBytes(uint32_t count)
+{
+    std::vector<uint8_t> bytes(count);
+    uint32_t seed = 12345;
+
+    for (auto& value : bytes)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = static_cast<uint8_t>(seed >> 16);
+    }
+
+    return bytes;
+}
+
+static std::vector<float> MakeTestFloats(uint32_t count)
+{
+    float const interestingValues[] =
+    {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 2.0f, 1e-20f, 0.99999f,
+        0.5f / 255.0f, 1.5f / 255.0f, 254.5f / 255.0f,
+        std::numeric_limits<float>::infinity(),
+        -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN(),
+    };
+
+    auto bytes = MakeTestBytes(count);
+    std::vector<float> values(count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i % 3 == 0)
+            values[i] = interestingValues[(i / 3) % (sizeof(interestingValues) / sizeof(interestingValues[0]))];
+        else
+            values[i] = bytes[i] / 200.0f - 0.1f;
+    }
+
+    return values;
+}
+
+// Every combination of color value and alpha.
+static std::vector<uint8_t> MakeEveryColorAndAlpha()
+{
+    std::vector<uint8_t> pixels;
+
+    for (uint32_t value = 0; value < 256; value++)
+    {
+        for (uint32_t alpha = 0; alpha < 256; alpha++)
+        {
+            pixels.push_back(static_cast<uint8_t>(value));
+            pixels.push_back(static_cast<uint8_t>(255 - value));
+            pixels.push_back(static_cast<uint8_t>(value / 2));
+            pixels.push_back(static_cast<uint8_t>(alpha));
+        }
+    }
+
+    return pixels;
+}
+
+typedef void (*ByteKernel)(uint8_t const*, uint8_t*, uint32_t);
+
+static void CheckPixelKernelMatchesScalar(char const* test, ByteKernel PixelConversionKernels::* kernel)
+{
+    auto& scalar = GetScalarPixelConversionKernels();
+
+    for (auto kernels : GetSupportedPixelConversionKernels())
+    {
+        for (uint32_t pixelCount = 0; pixelCount <= MaxPixelCount; pixelCount++)
+        {
+            auto source = MakeTestBytes(pixelCount * 4);
+            std::vector<uint8_t> expected(source.size());
+            std::vector<uint8_t> actual(source.size());
+
+            (scalar.*kernel)(source.data(), expected.data(), pixelCount);
+            (kernels->*kernel)(source.data(), actual.data(), pixelCount);
+
+            Check(expected == actual, test, kernels->Name);
+
+            // Converting in place must give the same result.
+            (kernels->*kernel)(source.data(), source.data(), pixelCount);
+
+            Check(expected == source, test, kernels->Name);
+        }
+
+        auto source = MakeEveryColorAndAlpha();
+        auto pixelCount = static_cast<uint32_t>(source.size() / 4);
+
+        std::vector<uint8_t> expected(source.size());
+        std::vector<uint8_t> actual(source.size());
+
+        (scalar.*kernel)(source.data(), expected.data(), pixelCount);
+        (kernels->*kernel)(source.data(), actual.data(), pixelCount);
+
+        Check(expected == actual, test, kernels->Name);
+    }
+}
+
+template<typename Source, typename Destination>
+static void CheckValueKernelMatchesScalar(
+    char const* test,
+    void (*PixelConversionKernels::* kernel)(Source const*, Destination*, uint32_t),
+    std::vector<Source> const& values)
+{
+    auto& scalar = GetScalarPixelConversionKernels();
+
+    for (auto kernels : GetSupportedPixelConversionKernels())
+    {
+        // Every length up to MaxPixelCount, to cover each tail length, then
+        // all of the values at once.
+        std::vector<size_t> counts;
+
+        for (size_t count = 0; count <= std::min<size_t>(MaxPixelCount, values.size()); count++)
+            counts.push_back(count);
+
+        counts.push_back(values.size());
+
+        for (auto count : counts)
+        {
+            std::vector<Source> source(values.begin(), values.begin() + count);
+            std::vector<Destination> expected(source.size());
+            std::vector<Destination> actual(source.size());
+
+            (scalar.*kernel)(source.data(), expected.data(), static_cast<uint32_t>(source.size()));
+            (kernels->*kernel)(source.data(), actual.data(), static_cast<uint32_t>(source.size()));
+
+            // Compare bit patterns rather than values, so that this really is
+            // checking for identical output.
+            Check(AreBitwiseEqual(expected, actual), test, kernels->Name);
+        }
+    }
+}
+
+static std::vector<uint8_t> MakeEveryByte()
+{
+    std::vector<uint8_t> values;
+
+    for (uint32_t i = 0; i < 256; i++)
+        values.push_back(static_cast<uint8_t>(i));
+
+    return values;
+}
+
+// Every half bit pattern, including subnormals, infinities and NaNs.
+static std::vector<uint16_t> MakeEveryHalf()
+{
+    std::vector<uint16_t> values;
+
+    for (uint32_t i = 0; i < 65536; i++)
+        values.push_back(static_cast<uint16_t>(i));
+
+    return values;
+}
+
+static void ScalarIsAlwaysSupported()
+{
+    auto kernels = GetSupportedPixelConversionKernels();
+
+    Check(!kernels.empty(), __FUNCTION__, L"");
+    Check(kernels.front() == &GetScalarPixelConversionKernels(), __FUNCTION__, L"");
+    Check(kernels.back() == &GetPixelConversionKernels(), __FUNCTION__, L"");
+}
+
+static void ScalarKernelsGiveExpectedValues()
+{
+    auto& scalar = GetScalarPixelConversionKernels();
+
+    std::vector<uint8_t> pixel{ 1, 2, 3, 4 };
+    scalar.ReverseChannelOrder(pixel.data(), pixel.data(), 1);
+    Check(pixel == std::vector<uint8_t>{ 4, 3, 2, 1 }, __FUNCTION__, scalar.Name);
+
+    std::vector<uint8_t> straight{ 255, 128, 0, 128, 200, 100, 50, 0 };
+    std::vector<uint8_t> premultiplied(8);
+    scalar.Premultiply(straight.data(), premultiplied.data(), 2);
+    Check(premultiplied == std::vector<uint8_t>{ 128, 64, 0, 128, 0, 0, 0, 0 }, __FUNCTION__, scalar.Name);
+
+    std::vector<uint8_t> unpremultiplied(8);
+    scalar.Unpremultiply(premultiplied.data(), unpremultiplied.data(), 2);
+    Check(unpremultiplied == std::vector<uint8_t>{ 255, 128, 0, 128, 0, 0, 0, 0 }, __FUNCTION__, scalar.Name);
+
+    std::vector<uint8_t> unorm{ 0, 255 };
+    std::vector<float> floats(2);
+    scalar.UnormToFloat(unorm.data(), floats.data(), 2);
+    Check(floats == std::vector<float>{ 0.0f, 1.0f }, __FUNCTION__, scalar.Name);
+
+    std::vector<float> outOfRange{ -1.0f, 2.0f, std::numeric_limits<float>::quiet_NaN(), 0.5f };
+    std::vector<uint8_t> clamped(4);
+    scalar.FloatToUnorm(outOfRange.data(), clamped.data(), 4);
+    Check(clamped == std::vector<uint8_t>{ 0, 255, 0, 128 }, __FUNCTION__, scalar.Name);
+
+    // 51 / 255 is 0.2, which is 0x3266 as a half.  128 / 255 lies just
+    // beyond the fourth half above 0.5.
+    std::vector<uint8_t> halfSource{ 0, 51, 128, 255 };
+    std::vector<uint16_t> halves(4);
+    scalar.UnormToHalf(halfSource.data(), halves.data(), 4);
+    Check(halves == std::vector<uint16_t>{ 0x0000, 0x3266, 0x3804, 0x3c00 }, __FUNCTION__, scalar.Name);
+
+    // 0.5, -2, 1 and 2^-24 (the smallest subnormal), +infinity, NaN.
+    std::vector<uint16_t> halfValues{ 0x3800, 0xc000, 0x3c00, 0x0001, 0x7c00, 0x7e00 };
+    std::vector<uint8_t> fromHalves(6);
+    scalar.HalfToUnorm(halfValues.data(), fromHalves.data(), 6);
+    Check(fromHalves == std::vector<uint8_t>{ 128, 0, 255, 0, 255, 0 }, __FUNCTION__, scalar.Name);
+}
+
+static void ReverseChannelOrderMatchesScalar()
+{
+    CheckPixelKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::ReverseChannelOrder);
+}
+
+static void PremultiplyMatchesScalar()
+{
+    CheckPixelKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::Premultiply);
+}
+
+static void UnpremultiplyMatchesScalar()
+{
+    CheckPixelKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::Unpremultiply);
+}
+
+static void UnormToFloatMatchesScalar()
+{
+    CheckValueKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::UnormToFloat, MakeEveryByte());
+    CheckValueKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::UnormToFloat, MakeTestBytes(1000));
+}
+
+static void FloatToUnormMatchesScalar()
+{
+    CheckValueKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::FloatToUnorm, MakeTestFloats(1000));
+}
+
+static void UnormToHalfMatchesScalar()
+{
+    CheckValueKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::UnormToHalf, MakeEveryByte());
+    CheckValueKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::UnormToHalf, MakeTestBytes(1000));
+}
+
+static void HalfToUnormMatchesScalar()
+{
+    CheckValueKernelMatchesScalar(__FUNCTION__, &PixelConversionKernels::HalfToUnorm, MakeEveryHalf());
+}
+
+static void UnormRoundTripsThroughFloatAndHalf()
+{
+    auto source = MakeEveryByte();
+
+    for (auto kernels : GetSupportedPixelConversionKernels())
+    {
+        std::vector<float> floats(256);
+        std::vector<uint16_t> halves(256);
+        std::vector<uint8_t> result(256);
+
+        kernels->UnormToFloat(source.data(), floats.data(), 256);
+        kernels->FloatToUnorm(floats.data(), result.data(), 256);
+
+        Check(source == result, __FUNCTION__, kernels->Name);
+
+        kernels->UnormToHalf(source.data(), halves.data(), 256);
+        kernels->HalfToUnorm(halves.data(), result.data(), 256);
+
+        Check(source == result, __FUNCTION__, kernels->Name);
+    }
+}
+
+int main()
+{
+    printf("Kernels:");
+
+    for (auto kernels : GetSupportedPixelConversionKernels())
+        printf(" %ls", kernels->Name);
+
+    printf("\n");
+
+    ScalarIsAlwaysSupported();
+    ScalarKernelsGiveExpectedValues();
+    ReverseChannelOrderMatchesScalar();
+    PremultiplyMatchesScalar();
+    UnpremultiplyMatchesScalar();
+    UnormToFloatMatchesScalar();
+    FloatToUnormMatchesScalar();
+    UnormToHalfMatchesScalar();
+    HalfToUnormMatchesScalar();
+    UnormRoundTripsThroughFloatAndHalf();
+
+    if (g_failureCount)
+    {
+        printf("%d checks failed\n", g_failureCount);
+        return 1;
+    }
+
+    printf("All checks passed\n");
+    return 0;
+}